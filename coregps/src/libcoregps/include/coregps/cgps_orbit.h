@@ -0,0 +1,300 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Satellite position, velocity and clock from the broadcast
+ * ephemeris and clock parameters (LNAV).
+ *
+ * Reference:
+ *
+ * IS-GPS-200G, 20.3.3.4.3 User Algorithm for Ephemeris Determination,
+ * Table 20-IV, and 20.3.3.3.3.1 User Algorithm for SV Clock Correction.
+ *
+ * The parameters of a batch of satellites are kept as a structure
+ * of arrays, so that four satellites (or four epochs of a satellite)
+ * are evaluated at once with AVX2 when the processor supports it.
+ * Otherwise the algorithm is evaluated one satellite at a time,
+ * as written in the reference. In both paths, the terms which depend
+ * only on the ephemeris are computed once, when the ephemeris is put
+ * into the batch. The results of the two paths
+ * agree to within a few micrometres and picoseconds.
+ */
+
+#ifndef CGPS_ORBIT_H
+#define CGPS_ORBIT_H
+
+#include "cgps.h"
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/** WGS 84 value of the earth's gravitational constant [m^3/s^2]. */
+#define CGPS_GM 3.986005e14
+
+/** WGS 84 value of the earth's rotation rate [rad/s]. */
+#define CGPS_OMEGA_E 7.2921151467e-5
+
+/** Relativistic correction constant F [s/m^(1/2)]. */
+#define CGPS_F -4.442807633e-10
+
+/** Value of pi for the orbit computations. */
+#define CGPS_PI 3.1415926535898
+
+/** Seconds in a GPS week. */
+#define CGPS_SECONDS_IN_WEEK 604800.0
+
+/**
+ * Largest eccentricity for which cgps_kepler_solve() is accurate.
+ * IS-GPS-200 gives 0.03 as the maximum eccentricity of the orbits.
+ */
+#define CGPS_KEPLER_MAX_E 0.03
+
+/**
+ * Number of Newton iterations done by cgps_kepler_solve().
+ */
+#define CGPS_KEPLER_ITERATIONS 2
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+/**
+ * Ephemeris and clock parameters of a batch of satellites as a structure
+ * of arrays. The element i of every array belongs to the satellite i.
+ * The meaning and the units are those of cgps_ephemeris and cgps_clock.
+ */
+struct cgps_orbit_batch {
+	/** Number of satellites in the batch. */
+	size_t count;
+
+	/** Number of satellites the arrays have room for. */
+	size_t capacity;
+
+	/** Satellite PRN numbers. */
+	int *sat_id;
+
+	// EPHEMERIS
+	//===========
+
+	double *toe;
+	double *sqrtA;
+	double *e;
+	double *M0;
+	double *OMEGA0;
+	double *i0;
+	double *w;
+	double *delta_n;
+	double *OMEGADOT;
+	double *idot;
+	double *Crc;
+	double *Crs;
+	double *Cuc;
+	double *Cus;
+	double *Cic;
+	double *Cis;
+
+	// CLOCK
+	//=======
+
+	double *toc;
+	double *af0;
+	double *af1;
+	double *af2;
+
+	/** Estimated group delay differential [s]. */
+	double *tgd;
+
+	// PREPARED INVARIANTS
+	//=====================
+
+	/**
+	 * Issues of data of the ephemeris and of the clock. Together with
+	 * sat_id, toe and toc, tell whether the invariants below are valid.
+	 */
+	int *IODE;
+	int *IODC;
+
+	/** Semi-major axis A [m]. */
+	double *A;
+
+	/** Corrected mean motion n = sqrt(GM/A^3) + delta_n [rad/s]. */
+	double *n;
+
+	/** Factor sqrt(1 - e^2) of the true anomaly. */
+	double *sqrt1me2;
+
+	/** Longitude of the ascending node at toe, OMEGA0 - OMEGA_E toe. */
+	double *OMEGA_toe;
+
+	/** Rate of the corrected longitude, OMEGADOT - OMEGA_E [rad/s]. */
+	double *OMEGA_rate;
+
+	/** Sine and cosine of the argument of perigee. */
+	double *sinw;
+	double *cosw;
+
+	/** Coefficient of the relativistic correction, F e sqrtA [s]. */
+	double *Fe;
+};
+
+typedef struct cgps_orbit_batch cgps_orbit_batch;
+
+/**
+ * Positions, velocities and clocks of satellites as a structure
+ * of arrays. Filled in by the propagation functions.
+ */
+struct cgps_satstate {
+	/** Number of elements the arrays have room for. */
+	size_t capacity;
+
+	/** ECEF position (WGS 84) [m]. */
+	double *x;
+	double *y;
+	double *z;
+
+	/** ECEF velocity [m/s]. */
+	double *vx;
+	double *vy;
+	double *vz;
+
+	/**
+	 * SV clock bias [s], including the relativistic correction,
+	 * and the group delay (Tgd) for a single-frequency L1 user.
+	 */
+	double *clock_bias;
+
+	/** SV clock drift [s/s], including the relativistic correction. */
+	double *clock_drift;
+};
+
+typedef struct cgps_satstate cgps_satstate;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+cgps_orbit_batch *cgps_orbit_batch_alloc(size_t capacity);
+void cgps_orbit_batch_free(cgps_orbit_batch *batch);
+
+cgps_satstate *cgps_satstate_alloc(size_t capacity);
+void cgps_satstate_free(cgps_satstate *state);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Append the parameters of a navigation message to the batch,
+ * and compute the invariants of the ephemeris.
+ * Returns the index of the satellite, or -1 if the batch is full.
+ */
+long cgps_orbit_batch_add(cgps_orbit_batch *batch, const cgps_navmsg *msg);
+
+/**
+ * Put the parameters of a navigation message into the element index
+ * (< batch->count) of the batch. If the element already holds the same
+ * ephemeris and clock (the same sat_id, IODE, toe, IODC and toc),
+ * nothing is done and 0 is returned. Otherwise the parameters are replaced, the invariants are
+ * recomputed, and 1 is returned. This is meant to be called for every
+ * satellite on every epoch with its current navigation message.
+ */
+int cgps_orbit_batch_set(
+    cgps_orbit_batch *batch,
+    size_t index,
+    const cgps_navmsg *msg
+);
+
+/**
+ * Remove all satellites from the batch.
+ */
+void cgps_orbit_batch_clear(cgps_orbit_batch *batch);
+
+/**
+ * Compute the state of every satellite of the batch at the GPS time
+ * of week t [s]. The state of the satellite i is written into the
+ * element i of state, which must have room for batch->count elements.
+ * Times on the adjacent weeks are accounted for (the week crossover).
+ */
+void cgps_orbit_propagate(
+    const cgps_orbit_batch *batch,
+    double t,
+    cgps_satstate *state
+);
+
+/**
+ * Compute the state of the satellite index of the batch at the GPS
+ * times of week t[0] .. t[count-1]. The state at t[k] is written into
+ * the element k of state.
+ */
+void cgps_orbit_propagate_times(
+    const cgps_orbit_batch *batch,
+    size_t index,
+    const double *t,
+    size_t count,
+    cgps_satstate *state
+);
+
+/**
+ * Solve Kepler's equation E - e sin E = M for count pairs of the mean
+ * anomaly M[k] [rad] and the eccentricity e[k]. The eccentric anomaly
+ * is written into E[k], reduced into [-pi, pi] together with M.
+ * Its sine and cosine are written into sinE[k] and cosE[k], unless
+ * these are NULL.
+ *
+ * Every element takes the same fixed amount of work: the third-order
+ * starter E0 = M + e sin M (1 + e cos M), and CGPS_KEPLER_ITERATIONS
+ * Newton steps. The sine and cosine are computed only for M; they are
+ * carried along the steps with the angle-sum formulas.
+ *
+ * Error bound: for 0 <= e <= CGPS_KEPLER_MAX_E, the starter is within
+ * e^3 / 2 (1.4e-5 rad) of the solution. The Newton step squares the error
+ * and multiplies it by at most e / (2 (1-e)) < 0.016, so one step leaves
+ * less than 3e-12 rad, and the second one leaves only the rounding
+ * errors: |E - E*| < 1e-15 rad, and the same holds for sinE and cosE.
+ * Larger eccentricities are not rejected, but the bound does not hold.
+ */
+void cgps_kepler_solve(
+    const double *M,
+    const double *e,
+    double *E,
+    double *sinE,
+    double *cosE,
+    size_t count
+);
+
+/**
+ * Enable or disable the vectorized path. It is enabled by default,
+ * when the processor supports AVX2 and FMA; the default is decided
+ * when the program is loaded. The setting is global and unsynchronized:
+ * call this only before starting the threads which use the library.
+ * Returns 1 if the vectorized path is in use, and 0 otherwise.
+ */
+int cgps_orbit_set_simd(int enabled);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,229 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Chebyshev interpolation of the satellite orbits and clocks.
+ *
+ * For simulations at high rates, evaluating the broadcast ephemeris
+ * on every epoch is wasteful: the orbits are smooth over minutes.
+ * The cache fits, for every satellite of a cgps_orbit_batch,
+ * Chebyshev polynomials to the position and the clock bias over a time
+ * window, and evaluates them with Clenshaw's recurrence. The velocity
+ * and the clock drift are evaluated from the derivatives of the same
+ * polynomials. A window is fitted only when a satellite is evaluated
+ * outside of its current window, or when its ephemeris has changed.
+ *
+ * Error estimate: with every fit p of n coefficients c_k, a reference
+ * fit r of 2n coefficients r_k is made over the same window. Since
+ * |T_k| <= 1, the distance |p - r| is at most sum |c_k - r_k| over
+ * k < 2n. The error of r is taken from its last two coefficients, and
+ * a term for the rounding of the evaluation is added. This assumes that
+ * the coefficients of a smooth orbit decay geometrically, so it is an
+ * estimate, not a guaranteed bound. It is checked against the direct
+ * propagation at the 2n nodes of the reference fit, which lie between
+ * the nodes of p: the larger of the two is multiplied by
+ * CGPS_OC_SAFETY_FACTOR. The estimate is computed for every quantity
+ * and its derivative.
+ *
+ * Only the position is held to the tolerance. If its estimate exceeds
+ * the tolerance, the window of the satellite is halved and fitted
+ * again. If the tolerance cannot be met with a window of
+ * CGPS_OC_MIN_WINDOW, the satellite is propagated directly over that
+ * window instead. The velocity and the clock are not held to a
+ * tolerance. Their estimates are only kept in the cache, with the
+ * largest position estimate.
+ */
+
+#ifndef CGPS_ORBITCACHE_H
+#define CGPS_ORBITCACHE_H
+
+#include "cgps_orbit.h"
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/** Default length of the fit window [s]. */
+#define CGPS_OC_DEFAULT_WINDOW 300.0
+
+/** Default number of Chebyshev coefficients per fit. */
+#define CGPS_OC_DEFAULT_COEFFS 8
+
+/** Largest number of Chebyshev coefficients per fit. */
+#define CGPS_OC_MAX_COEFFS 32
+
+/** Default tolerance of the position error [m]. */
+#define CGPS_OC_DEFAULT_TOLERANCE 1e-3
+
+/**
+ * The window is not halved below this length [s]; the satellite is
+ * propagated directly instead.
+ */
+#define CGPS_OC_MIN_WINDOW 1.0
+
+/**
+ * Factor of the error estimate, over the larger of the series estimate
+ * and the error measured at the nodes of the reference fit.
+ */
+#define CGPS_OC_SAFETY_FACTOR 2.0
+
+/** Number of interpolated quantities: x, y, z, and the clock bias. */
+#define CGPS_OC_QUANTITIES 4
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+/**
+ * The fit of a single satellite.
+ */
+struct cgps_oc_fit {
+	/** Whether the fit holds anything. */
+	int valid;
+
+	/**
+	 * Whether the tolerance could not be met, so that the satellite
+	 * is propagated directly within the window.
+	 */
+	int direct;
+
+	/** The ephemeris and the clock the fit was made from. */
+	int sat_id;
+	int IODE;
+	double toe;
+	int IODC;
+	double toc;
+
+	/** The window is [t0, t1). */
+	double t0;
+	double t1;
+
+	/** Middle of the window, and the inverse of its half-length. */
+	double mid;
+	double scale;
+
+	/**
+	 * Chebyshev coefficients of the values (the first CGPS_OC_QUANTITIES)
+	 * and of the derivatives (the next CGPS_OC_QUANTITIES), interleaved:
+	 * the coefficient k of the quantity q is coeffs[k*2*QUANTITIES + q].
+	 * The derivatives are with respect to the time [1/s].
+	 */
+	double *coeffs;
+};
+
+typedef struct cgps_oc_fit cgps_oc_fit;
+
+/**
+ * Orbit interpolation cache.
+ */
+struct cgps_orbitcache {
+	/** The ephemerides. The cache follows their changes. */
+	const cgps_orbit_batch *batch;
+
+	/** Length of the fit window [s]. */
+	double window;
+
+	/** Number of Chebyshev coefficients per fit. */
+	int coeffs;
+
+	/** Tolerance of the position error [m]. */
+	double tolerance;
+
+	/** Fits, one for each element of the batch. */
+	cgps_oc_fit *fits;
+
+	/** Number of fits made. */
+	size_t refits;
+
+	/** Number of fits which fell back to the direct propagation. */
+	size_t fallbacks;
+
+	/**
+	 * Largest error estimates of the fits: position [m],
+	 * velocity [m/s]. These are estimates, not guaranteed bounds.
+	 */
+	double max_est_pos;
+	double max_est_vel;
+
+	/** Largest error estimates of the fits: clock bias [s], drift [s/s]. */
+	double max_est_clock;
+	double max_est_drift;
+
+	/** Coefficients of the reference fit, which has 2*coeffs. */
+	double *ref_coeffs;
+
+	/**
+	 * Cosines cos(pi k (j + 1/2) / m) at [k*m + j] for the fit,
+	 * m = coeffs, and for the reference fit, m = 2*coeffs.
+	 */
+	double *cos_fit;
+	double *cos_ref;
+
+	/** Times and states of the nodes. */
+	double *times;
+	cgps_satstate *scratch;
+};
+
+typedef struct cgps_orbitcache cgps_orbitcache;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+/**
+ * Allocate a cache for the batch, with room for batch->capacity
+ * satellites. Returns NULL if out of memory, or if coeffs is not
+ * within [2, CGPS_OC_MAX_COEFFS].
+ */
+cgps_orbitcache *cgps_oc_alloc(
+    const cgps_orbit_batch *batch,
+    double window,
+    int coeffs,
+    double tolerance
+);
+
+void cgps_oc_free(cgps_orbitcache *cache);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Compute the state of every satellite of the batch at the GPS time
+ * of week t [s] from the fits, making new fits where needed.
+ * The results correspond to those of cgps_orbit_propagate(), within
+ * the tolerance for the position.
+ */
+void cgps_oc_eval(cgps_orbitcache *cache, double t, cgps_satstate *state);
+
+/**
+ * Drop all fits, and reset the statistics.
+ */
+void cgps_oc_invalidate(cgps_orbitcache *cache);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
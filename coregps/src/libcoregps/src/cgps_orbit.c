@@ -0,0 +1,795 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#include "coregps/cgps_orbit.h"
+#include "cgps_simd.h"
+
+#include <stdlib.h> // malloc, free
+#include <math.h> // sqrt, sin, cos, atan2, floor
+
+
+//--- internal constants ---------------------------------------------------//
+
+/** Half a week; time differences are wrapped into +-HALF_WEEK. */
+#define HALF_WEEK 302400.0
+
+/** Number of arrays in cgps_orbit_batch and cgps_satstate. */
+#define BATCH_ARRAYS 29
+#define STATE_ARRAYS 8
+
+//--- internal helpers -----------------------------------------------------//
+
+/**
+ * Whether the vectorized path is used. Decided before main() by
+ * init_simd(), and changed only by cgps_orbit_set_simd().
+ */
+static int use_simd = 0;
+
+/**
+ * Accounts for the beginning or the end of the week crossover.
+ */
+static double wrap_week(double dt) {
+	if (dt > HALF_WEEK) {
+		dt -= CGPS_SECONDS_IN_WEEK;
+	} else if (dt < -HALF_WEEK) {
+		dt += CGPS_SECONDS_IN_WEEK;
+	}
+	return dt;
+}
+
+/**
+ * Rotates the sine s and the cosine c of an angle by a small angle d
+ * (|d| < 0.04), with the Taylor series of sin d and cos d. The omitted
+ * terms are below 1e-19.
+ */
+static void rotate_small(double *s, double *c, double d) {
+	double d2 = d * d;
+	double sind = d * (1.0 - d2/6.0 * (1.0 - d2/20.0 * (1.0 - d2/42.0)));
+	double cosd = 1.0 - d2/2.0 * (1.0 - d2/12.0 * (1.0 - d2/30.0
+	    * (1.0 - d2/56.0)));
+	double s0 = *s;
+	*s = s0 * cosd + *c * sind;
+	*c = *c * cosd - s0 * sind;
+}
+
+/**
+ * Solves Kepler's equation with a fixed amount of work;
+ * see cgps_kepler_solve().
+ */
+static void kepler_scalar(
+    double M,
+    double e,
+    double *E,
+    double *sinE,
+    double *cosE
+) {
+	M -= 2.0 * CGPS_PI * floor((M + CGPS_PI) / (2.0 * CGPS_PI));
+
+	double s = sin(M);
+	double c = cos(M);
+
+	// Third-order starter
+	double d = e * s * (1.0 + e * c);
+	double Ek = M + d;
+	rotate_small(&s, &c, d);
+
+	for (int i = 0; i < CGPS_KEPLER_ITERATIONS; i++) {
+		d = (M - Ek + e * s) / (1.0 - e * c);
+		Ek += d;
+		rotate_small(&s, &c, d);
+	}
+
+	*E = Ek;
+	*sinE = s;
+	*cosE = c;
+}
+
+/**
+ * Evaluates the satellite i of the batch at the time t, and writes
+ * the results into the element k of the state. Follows Table 20-IV.
+ */
+static void propagate_scalar(
+    const cgps_orbit_batch *b,
+    size_t i,
+    double t,
+    cgps_satstate *s,
+    size_t k
+) {
+	double A = b->A[i];
+	double n = b->n[i];
+	double tk = wrap_week(t - b->toe[i]);
+	double Mk = b->M0[i] + n * tk;
+	double e = b->e[i];
+
+	double Ek, sinE, cosE;
+	kepler_scalar(Mk, e, &Ek, &sinE, &cosE);
+	double den = 1.0 - e * cosE;
+	double sqrt1me2 = b->sqrt1me2[i];
+
+	double vk = atan2(sqrt1me2 * sinE, cosE - e);
+	double Phik = vk + b->w[i];
+	double sin2Phi = sin(2.0 * Phik);
+	double cos2Phi = cos(2.0 * Phik);
+
+	double duk = b->Cus[i] * sin2Phi + b->Cuc[i] * cos2Phi;
+	double drk = b->Crs[i] * sin2Phi + b->Crc[i] * cos2Phi;
+	double dik = b->Cis[i] * sin2Phi + b->Cic[i] * cos2Phi;
+
+	double uk = Phik + duk;
+	double rk = A * den + drk;
+	double ik = b->i0[i] + dik + b->idot[i] * tk;
+
+	double sinu = sin(uk);
+	double cosu = cos(uk);
+	double xp = rk * cosu;
+	double yp = rk * sinu;
+
+	double OMEGAk = b->OMEGA_toe[i] + b->OMEGA_rate[i] * tk;
+	double sinO = sin(OMEGAk);
+	double cosO = cos(OMEGAk);
+	double sini = sin(ik);
+	double cosi = cos(ik);
+
+	double x = xp * cosO - yp * cosi * sinO;
+	double y = xp * sinO + yp * cosi * cosO;
+	double z = yp * sini;
+
+	// Rates
+	double Edot = n / den;
+	double vdot = Edot * sqrt1me2 / den;
+	double idotk = b->idot[i]
+	    + 2.0 * vdot * (b->Cis[i] * cos2Phi - b->Cic[i] * sin2Phi);
+	double udot = vdot
+	    + 2.0 * vdot * (b->Cus[i] * cos2Phi - b->Cuc[i] * sin2Phi);
+	double rdot = e * A * Edot * sinE
+	    + 2.0 * vdot * (b->Crs[i] * cos2Phi - b->Crc[i] * sin2Phi);
+	double OMEGAdot = b->OMEGA_rate[i];
+
+	double xpdot = rdot * cosu - yp * udot;
+	double ypdot = rdot * sinu + xp * udot;
+
+	s->x[k] = x;
+	s->y[k] = y;
+	s->z[k] = z;
+	s->vx[k] = xpdot * cosO - ypdot * cosi * sinO
+	    + yp * idotk * sini * sinO - OMEGAdot * y;
+	s->vy[k] = xpdot * sinO + ypdot * cosi * cosO
+	    - yp * idotk * sini * cosO + OMEGAdot * x;
+	s->vz[k] = ypdot * sini + yp * idotk * cosi;
+
+	// Clock (20.3.3.3.3.1)
+	double dt = wrap_week(t - b->toc[i]);
+	double dtr = b->Fe[i] * sinE;
+	double dtrdot = b->Fe[i] * cosE * Edot;
+	s->clock_bias[k] = b->af0[i] + b->af1[i] * dt + b->af2[i] * dt * dt
+	    + dtr - b->tgd[i];
+	s->clock_drift[k] = b->af1[i] + 2.0 * b->af2[i] * dt + dtrdot;
+}
+
+#ifdef CGPS_HAVE_AVX2
+
+//--- vectorized path ------------------------------------------------------//
+
+// Cody-Waite reduction by pi/4 and the polynomials of sin and cos
+// in [-pi/4, pi/4], from the Cephes library.
+#define FOUR_OVER_PI 1.27323954473516268615
+#define DP1 7.85398125648498535156E-1
+#define DP2 3.77489470793079817668E-8
+#define DP3 2.69515142907905952645E-15
+
+static const double SINCOF[6] = {
+	 1.58962301576546568060E-10,
+	-2.50507477628578072866E-8,
+	 2.75573136213857245213E-6,
+	-1.98412698295895385996E-4,
+	 8.33333333332211858878E-3,
+	-1.66666666666666307295E-1
+};
+
+static const double COSCOF[6] = {
+	-1.13585365213876817300E-11,
+	 2.08757008419747316778E-9,
+	-2.75573141792967388112E-7,
+	 2.48015872888517045348E-5,
+	-1.38888888888730564116E-3,
+	 4.16666666666665929218E-2
+};
+
+#define V(x) _mm256_set1_pd(x)
+
+CGPS_TARGET_AVX2
+static inline __m256d v_poly5(__m256d x, const double *c) {
+	__m256d y = V(c[0]);
+	for (int i = 1; i < 6; i++) {
+		y = _mm256_fmadd_pd(y, x, V(c[i]));
+	}
+	return y;
+}
+
+/**
+ * Sine and cosine of four angles.
+ */
+CGPS_TARGET_AVX2
+static inline void v_sincos(__m256d x, __m256d *s, __m256d *c) {
+	const __m256d sign_mask = V(-0.0);
+	__m256d sign_x = _mm256_and_pd(x, sign_mask);
+	__m256d ax = _mm256_andnot_pd(sign_mask, x);
+
+	// Octant, rounded up to even
+	__m256d y = _mm256_floor_pd(_mm256_mul_pd(ax, V(FOUR_OVER_PI)));
+	__m128i j = _mm256_cvttpd_epi32(y);
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)),
+	    _mm_set1_epi32(~1));
+	y = _mm256_cvtepi32_pd(j);
+
+	__m256i j64 = _mm256_cvtepi32_epi64(j);
+	__m256i two = _mm256_set1_epi64x(2);
+	__m256i four = _mm256_set1_epi64x(4);
+	__m256d bit2 = _mm256_castsi256_pd(
+	    _mm256_cmpeq_epi64(_mm256_and_si256(j64, two), two));
+	__m256d bit4 = _mm256_castsi256_pd(
+	    _mm256_cmpeq_epi64(_mm256_and_si256(j64, four), four));
+
+	__m256d z = _mm256_fnmadd_pd(y, V(DP1), ax);
+	z = _mm256_fnmadd_pd(y, V(DP2), z);
+	z = _mm256_fnmadd_pd(y, V(DP3), z);
+	__m256d zz = _mm256_mul_pd(z, z);
+
+	__m256d ps = _mm256_fmadd_pd(
+	    _mm256_mul_pd(z, zz), v_poly5(zz, SINCOF), z);
+	__m256d pc = _mm256_fmadd_pd(
+	    _mm256_mul_pd(zz, zz), v_poly5(zz, COSCOF),
+	    _mm256_fnmadd_pd(V(0.5), zz, V(1.0)));
+
+	__m256d sin_sign = _mm256_xor_pd(_mm256_and_pd(bit4, sign_mask), sign_x);
+	__m256d cos_sign = _mm256_and_pd(_mm256_xor_pd(bit4, bit2), sign_mask);
+
+	*s = _mm256_xor_pd(_mm256_blendv_pd(ps, pc, bit2), sin_sign);
+	*c = _mm256_xor_pd(_mm256_blendv_pd(pc, ps, bit2), cos_sign);
+}
+
+CGPS_TARGET_AVX2
+static inline __m256d v_wrap_week(__m256d dt) {
+	__m256d hi = _mm256_cmp_pd(dt, V(HALF_WEEK), _CMP_GT_OQ);
+	__m256d lo = _mm256_cmp_pd(dt, V(-HALF_WEEK), _CMP_LT_OQ);
+	dt = _mm256_sub_pd(dt, _mm256_and_pd(hi, V(CGPS_SECONDS_IN_WEEK)));
+	dt = _mm256_add_pd(dt, _mm256_and_pd(lo, V(CGPS_SECONDS_IN_WEEK)));
+	return dt;
+}
+
+/**
+ * Loads four consecutive values, or broadcasts one if stride is 0.
+ */
+CGPS_TARGET_AVX2
+static inline __m256d v_load(const double *p, size_t stride) {
+	return stride ? _mm256_loadu_pd(p) : _mm256_broadcast_sd(p);
+}
+
+/**
+ * Vectorized rotate_small().
+ */
+CGPS_TARGET_AVX2
+static inline void v_rotate_small(__m256d *s, __m256d *c, __m256d d) {
+	__m256d d2 = _mm256_mul_pd(d, d);
+	__m256d one = V(1.0);
+
+	__m256d sind = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/42.0)), one, one);
+	sind = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/20.0)), sind, one);
+	sind = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/6.0)), sind, one);
+	sind = _mm256_mul_pd(d, sind);
+
+	__m256d cosd = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/56.0)), one, one);
+	cosd = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/30.0)), cosd, one);
+	cosd = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/12.0)), cosd, one);
+	cosd = _mm256_fnmadd_pd(_mm256_mul_pd(d2, V(1.0/2.0)), cosd, one);
+
+	__m256d s0 = *s;
+	*s = _mm256_fmadd_pd(s0, cosd, _mm256_mul_pd(*c, sind));
+	*c = _mm256_fmsub_pd(*c, cosd, _mm256_mul_pd(s0, sind));
+}
+
+/**
+ * Vectorized kepler_scalar(). There are no data-dependent branches.
+ */
+CGPS_TARGET_AVX2
+static inline void v_kepler(
+    __m256d M,
+    __m256d e,
+    __m256d *E,
+    __m256d *sinE,
+    __m256d *cosE
+) {
+	__m256d turns = _mm256_floor_pd(_mm256_div_pd(
+	    _mm256_add_pd(M, V(CGPS_PI)), V(2.0 * CGPS_PI)));
+	M = _mm256_fnmadd_pd(turns, V(2.0 * CGPS_PI), M);
+
+	__m256d s, c;
+	v_sincos(M, &s, &c);
+
+	// Third-order starter
+	__m256d d = _mm256_mul_pd(_mm256_mul_pd(e, s),
+	    _mm256_fmadd_pd(e, c, V(1.0)));
+	__m256d Ek = _mm256_add_pd(M, d);
+	v_rotate_small(&s, &c, d);
+
+	for (int i = 0; i < CGPS_KEPLER_ITERATIONS; i++) {
+		__m256d f = _mm256_fmadd_pd(e, s, _mm256_sub_pd(M, Ek));
+		d = _mm256_div_pd(f, _mm256_fnmadd_pd(e, c, V(1.0)));
+		Ek = _mm256_add_pd(Ek, d);
+		v_rotate_small(&s, &c, d);
+	}
+
+	*E = Ek;
+	*sinE = s;
+	*cosE = c;
+}
+
+/**
+ * Evaluates four elements: the parameters are taken from the batch
+ * at i, i+1, .. (or at i only, if eph_stride is 0), and the times from
+ * t, t+1, .. (or from t only, if t_stride is 0). The results are written
+ * into the elements k .. k+3 of the state.
+ *
+ * Unlike the scalar path, the true anomaly and the argument of latitude
+ * are not formed as angles; their sines and cosines are composed from
+ * those of the eccentric anomaly, the argument of perigee, and the
+ * correction, which is small enough for a short series (|du| < 1e-4).
+ */
+CGPS_TARGET_AVX2
+static void propagate_avx2(
+    const cgps_orbit_batch *b,
+    size_t i,
+    size_t eph_stride,
+    const double *t,
+    size_t t_stride,
+    cgps_satstate *s,
+    size_t k
+) {
+	__m256d tt = v_load(t, t_stride);
+	__m256d toe = v_load(&b->toe[i], eph_stride);
+	__m256d e = v_load(&b->e[i], eph_stride);
+	__m256d A = v_load(&b->A[i], eph_stride);
+	__m256d n = v_load(&b->n[i], eph_stride);
+	__m256d tk = v_wrap_week(_mm256_sub_pd(tt, toe));
+	__m256d Mk = _mm256_fmadd_pd(n, tk, v_load(&b->M0[i], eph_stride));
+
+	__m256d Ek, sinE, cosE;
+	v_kepler(Mk, e, &Ek, &sinE, &cosE);
+
+	__m256d den = _mm256_fnmadd_pd(e, cosE, V(1.0));
+	__m256d sqrt1me2 = v_load(&b->sqrt1me2[i], eph_stride);
+
+	// True anomaly
+	__m256d sinv = _mm256_div_pd(_mm256_mul_pd(sqrt1me2, sinE), den);
+	__m256d cosv = _mm256_div_pd(_mm256_sub_pd(cosE, e), den);
+
+	// Argument of latitude
+	__m256d sinw = v_load(&b->sinw[i], eph_stride);
+	__m256d cosw = v_load(&b->cosw[i], eph_stride);
+	__m256d sinPhi = _mm256_fmadd_pd(sinv, cosw, _mm256_mul_pd(cosv, sinw));
+	__m256d cosPhi = _mm256_fmsub_pd(cosv, cosw, _mm256_mul_pd(sinv, sinw));
+	__m256d sin2Phi = _mm256_mul_pd(V(2.0), _mm256_mul_pd(sinPhi, cosPhi));
+	__m256d cos2Phi = _mm256_fmsub_pd(cosPhi, cosPhi,
+	    _mm256_mul_pd(sinPhi, sinPhi));
+
+	__m256d Cus = v_load(&b->Cus[i], eph_stride);
+	__m256d Cuc = v_load(&b->Cuc[i], eph_stride);
+	__m256d Crs = v_load(&b->Crs[i], eph_stride);
+	__m256d Crc = v_load(&b->Crc[i], eph_stride);
+	__m256d Cis = v_load(&b->Cis[i], eph_stride);
+	__m256d Cic = v_load(&b->Cic[i], eph_stride);
+
+	__m256d duk = _mm256_fmadd_pd(Cus, sin2Phi, _mm256_mul_pd(Cuc, cos2Phi));
+	__m256d drk = _mm256_fmadd_pd(Crs, sin2Phi, _mm256_mul_pd(Crc, cos2Phi));
+	__m256d dik = _mm256_fmadd_pd(Cis, sin2Phi, _mm256_mul_pd(Cic, cos2Phi));
+
+	__m256d du2 = _mm256_mul_pd(duk, duk);
+	__m256d sindu = _mm256_fnmadd_pd(_mm256_mul_pd(duk, du2), V(1.0/6.0), duk);
+	__m256d cosdu = _mm256_fmadd_pd(_mm256_mul_pd(du2, du2), V(1.0/24.0),
+	    _mm256_fnmadd_pd(du2, V(0.5), V(1.0)));
+	__m256d sinu = _mm256_fmadd_pd(sinPhi, cosdu, _mm256_mul_pd(cosPhi, sindu));
+	__m256d cosu = _mm256_fmsub_pd(cosPhi, cosdu, _mm256_mul_pd(sinPhi, sindu));
+
+	__m256d rk = _mm256_fmadd_pd(A, den, drk);
+	__m256d idot = v_load(&b->idot[i], eph_stride);
+	__m256d ik = _mm256_fmadd_pd(idot, tk,
+	    _mm256_add_pd(v_load(&b->i0[i], eph_stride), dik));
+
+	__m256d xp = _mm256_mul_pd(rk, cosu);
+	__m256d yp = _mm256_mul_pd(rk, sinu);
+
+	__m256d OMEGAdot = v_load(&b->OMEGA_rate[i], eph_stride);
+	__m256d OMEGAk = _mm256_fmadd_pd(OMEGAdot, tk,
+	    v_load(&b->OMEGA_toe[i], eph_stride));
+
+	__m256d sinO, cosO, sini, cosi;
+	v_sincos(OMEGAk, &sinO, &cosO);
+	v_sincos(ik, &sini, &cosi);
+
+	__m256d ypcosi = _mm256_mul_pd(yp, cosi);
+	__m256d x = _mm256_fmsub_pd(xp, cosO, _mm256_mul_pd(ypcosi, sinO));
+	__m256d y = _mm256_fmadd_pd(xp, sinO, _mm256_mul_pd(ypcosi, cosO));
+	__m256d z = _mm256_mul_pd(yp, sini);
+
+	// Rates
+	__m256d Edot = _mm256_div_pd(n, den);
+	__m256d vdot = _mm256_div_pd(_mm256_mul_pd(Edot, sqrt1me2), den);
+	__m256d vdot2 = _mm256_mul_pd(V(2.0), vdot);
+	__m256d idotk = _mm256_fmadd_pd(vdot2,
+	    _mm256_fmsub_pd(Cis, cos2Phi, _mm256_mul_pd(Cic, sin2Phi)), idot);
+	__m256d udot = _mm256_fmadd_pd(vdot2,
+	    _mm256_fmsub_pd(Cus, cos2Phi, _mm256_mul_pd(Cuc, sin2Phi)), vdot);
+	__m256d rdot = _mm256_fmadd_pd(vdot2,
+	    _mm256_fmsub_pd(Crs, cos2Phi, _mm256_mul_pd(Crc, sin2Phi)),
+	    _mm256_mul_pd(_mm256_mul_pd(e, A), _mm256_mul_pd(Edot, sinE)));
+
+	__m256d xpdot = _mm256_fmsub_pd(rdot, cosu, _mm256_mul_pd(yp, udot));
+	__m256d ypdot = _mm256_fmadd_pd(rdot, sinu, _mm256_mul_pd(xp, udot));
+	__m256d ypidotk = _mm256_mul_pd(yp, idotk);
+
+	// vx = xpdot cosO - ypdot cosi sinO + yp idotk sini sinO - OMEGAdot y
+	__m256d vx = _mm256_mul_pd(xpdot, cosO);
+	vx = _mm256_fnmadd_pd(_mm256_mul_pd(ypdot, cosi), sinO, vx);
+	vx = _mm256_fmadd_pd(_mm256_mul_pd(ypidotk, sini), sinO, vx);
+	vx = _mm256_fnmadd_pd(OMEGAdot, y, vx);
+
+	// vy = xpdot sinO + ypdot cosi cosO - yp idotk sini cosO + OMEGAdot x
+	__m256d vy = _mm256_mul_pd(xpdot, sinO);
+	vy = _mm256_fmadd_pd(_mm256_mul_pd(ypdot, cosi), cosO, vy);
+	vy = _mm256_fnmadd_pd(_mm256_mul_pd(ypidotk, sini), cosO, vy);
+	vy = _mm256_fmadd_pd(OMEGAdot, x, vy);
+
+	__m256d vz = _mm256_fmadd_pd(ypdot, sini, _mm256_mul_pd(ypidotk, cosi));
+
+	// Clock
+	__m256d dt = v_wrap_week(_mm256_sub_pd(tt, v_load(&b->toc[i], eph_stride)));
+	__m256d af0 = v_load(&b->af0[i], eph_stride);
+	__m256d af1 = v_load(&b->af1[i], eph_stride);
+	__m256d af2 = v_load(&b->af2[i], eph_stride);
+	__m256d Fe = v_load(&b->Fe[i], eph_stride);
+
+	__m256d bias = _mm256_fmadd_pd(_mm256_fmadd_pd(af2, dt, af1), dt, af0);
+	bias = _mm256_fmadd_pd(Fe, sinE, bias);
+	bias = _mm256_sub_pd(bias, v_load(&b->tgd[i], eph_stride));
+
+	__m256d drift = _mm256_fmadd_pd(_mm256_mul_pd(V(2.0), af2), dt, af1);
+	drift = _mm256_fmadd_pd(_mm256_mul_pd(Fe, cosE), Edot, drift);
+
+	_mm256_storeu_pd(&s->x[k], x);
+	_mm256_storeu_pd(&s->y[k], y);
+	_mm256_storeu_pd(&s->z[k], z);
+	_mm256_storeu_pd(&s->vx[k], vx);
+	_mm256_storeu_pd(&s->vy[k], vy);
+	_mm256_storeu_pd(&s->vz[k], vz);
+	_mm256_storeu_pd(&s->clock_bias[k], bias);
+	_mm256_storeu_pd(&s->clock_drift[k], drift);
+}
+
+/**
+ * Solves Kepler's equation for four consecutive elements.
+ * sinE and cosE may be NULL.
+ */
+CGPS_TARGET_AVX2
+static void kepler_avx2(
+    const double *M,
+    const double *e,
+    double *E,
+    double *sinE,
+    double *cosE
+) {
+	__m256d vE, vsinE, vcosE;
+	v_kepler(_mm256_loadu_pd(M), _mm256_loadu_pd(e), &vE, &vsinE, &vcosE);
+
+	_mm256_storeu_pd(E, vE);
+	if (sinE != NULL) _mm256_storeu_pd(sinE, vsinE);
+	if (cosE != NULL) _mm256_storeu_pd(cosE, vcosE);
+}
+
+#undef V
+
+#endif // CGPS_HAVE_AVX2
+
+static int simd_supported(void) {
+#ifdef CGPS_HAVE_AVX2
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+	return 0;
+#endif
+}
+
+
+/**
+ * Allocates count arrays of capacity doubles from a single block.
+ * The first array is the block.
+ */
+static int alloc_arrays(double **arrays[], int count, size_t capacity) {
+	size_t n = (capacity > 0) ? capacity : 1;
+	double *block = malloc(count * n * sizeof(double));
+	if (block == NULL) {
+		return 0;
+	}
+	for (int j = 0; j < count; j++) {
+		*arrays[j] = &block[j * n];
+	}
+	return 1;
+}
+
+/**
+ * Copies the parameters of the navigation message into the element i
+ * of the batch, and computes the invariants of the ephemeris.
+ */
+static void store_navmsg(
+    cgps_orbit_batch *batch,
+    size_t i,
+    const cgps_navmsg *msg
+) {
+	const cgps_ephemeris *eph = &msg->eph;
+	const cgps_clock *clock = &msg->clock;
+
+	batch->sat_id[i] = msg->sat_id;
+	batch->IODE[i] = eph->IODE;
+	batch->IODC[i] = clock->IODC;
+
+	batch->toe[i] = eph->toe;
+	batch->sqrtA[i] = eph->sqrtA;
+	batch->e[i] = eph->e;
+	batch->M0[i] = eph->M0;
+	batch->OMEGA0[i] = eph->OMEGA0;
+	batch->i0[i] = eph->i0;
+	batch->w[i] = eph->w;
+	batch->delta_n[i] = eph->delta_n;
+	batch->OMEGADOT[i] = eph->OMEGADOT;
+	batch->idot[i] = eph->idot;
+	batch->Crc[i] = eph->Crc;
+	batch->Crs[i] = eph->Crs;
+	batch->Cuc[i] = eph->Cuc;
+	batch->Cus[i] = eph->Cus;
+	batch->Cic[i] = eph->Cic;
+	batch->Cis[i] = eph->Cis;
+
+	batch->toc[i] = clock->toc;
+	batch->af0[i] = clock->af0;
+	batch->af1[i] = clock->af1;
+	batch->af2[i] = clock->af2;
+	batch->tgd[i] = msg->tgd;
+
+	// Invariants
+	double A = eph->sqrtA * eph->sqrtA;
+	batch->A[i] = A;
+	batch->n[i] = sqrt(CGPS_GM / (A * A * A)) + eph->delta_n;
+	batch->sqrt1me2[i] = sqrt(1.0 - eph->e * eph->e);
+	batch->OMEGA_toe[i] = eph->OMEGA0 - CGPS_OMEGA_E * eph->toe;
+	batch->OMEGA_rate[i] = eph->OMEGADOT - CGPS_OMEGA_E;
+	batch->sinw[i] = sin(eph->w);
+	batch->cosw[i] = cos(eph->w);
+	batch->Fe[i] = CGPS_F * eph->e * eph->sqrtA;
+}
+
+//--- external methods -----------------------------------------------------//
+
+cgps_orbit_batch *cgps_orbit_batch_alloc(size_t capacity) {
+	cgps_orbit_batch *batch = NULL;
+
+	int complete = 0;
+	do {
+		batch = malloc(sizeof(cgps_orbit_batch));
+		if (batch == NULL) break;
+
+		batch->count = 0;
+		batch->capacity = capacity;
+		batch->sat_id = NULL;
+		batch->toe = NULL;
+
+		// sat_id, IODE and IODC share a block
+		size_t n = (capacity > 0) ? capacity : 1;
+		batch->sat_id = malloc(3 * n * sizeof(int));
+		if (batch->sat_id == NULL) break;
+		batch->IODE = &batch->sat_id[n];
+		batch->IODC = &batch->sat_id[2 * n];
+
+		double **arrays[BATCH_ARRAYS] = {
+			&batch->toe, &batch->sqrtA, &batch->e, &batch->M0,
+			&batch->OMEGA0, &batch->i0, &batch->w, &batch->delta_n,
+			&batch->OMEGADOT, &batch->idot, &batch->Crc, &batch->Crs,
+			&batch->Cuc, &batch->Cus, &batch->Cic, &batch->Cis,
+			&batch->toc, &batch->af0, &batch->af1, &batch->af2,
+			&batch->tgd, &batch->A, &batch->n, &batch->sqrt1me2,
+			&batch->OMEGA_toe, &batch->OMEGA_rate, &batch->sinw,
+			&batch->cosw, &batch->Fe
+		};
+		if (!alloc_arrays(arrays, BATCH_ARRAYS, capacity)) break;
+
+		complete = 1;
+	} while(0);
+
+	if (complete == 0) {
+		cgps_orbit_batch_free(batch);
+		batch = NULL;
+	}
+
+	return batch;
+}
+
+void cgps_orbit_batch_free(cgps_orbit_batch *batch) {
+	if (batch == NULL) {
+		// Already freed
+		return;
+	}
+	free(batch->sat_id);
+	// The arrays share the block of the first one.
+	free(batch->toe);
+	free(batch);
+}
+
+cgps_satstate *cgps_satstate_alloc(size_t capacity) {
+	cgps_satstate *state = malloc(sizeof(cgps_satstate));
+	if (state == NULL) {
+		return NULL;
+	}
+
+	state->capacity = capacity;
+	double **arrays[STATE_ARRAYS] = {
+		&state->x, &state->y, &state->z,
+		&state->vx, &state->vy, &state->vz,
+		&state->clock_bias, &state->clock_drift
+	};
+	if (!alloc_arrays(arrays, STATE_ARRAYS, capacity)) {
+		free(state);
+		return NULL;
+	}
+
+	return state;
+}
+
+void cgps_satstate_free(cgps_satstate *state) {
+	if (state == NULL) {
+		// Already freed
+		return;
+	}
+	// The arrays share the block of the first one.
+	free(state->x);
+	free(state);
+}
+
+long cgps_orbit_batch_add(cgps_orbit_batch *batch, const cgps_navmsg *msg) {
+	if (batch->count >= batch->capacity) {
+		// Full
+		return -1;
+	}
+
+	size_t i = batch->count++;
+	store_navmsg(batch, i, msg);
+
+	return (long) i;
+}
+
+int cgps_orbit_batch_set(
+    cgps_orbit_batch *batch,
+    size_t index,
+    const cgps_navmsg *msg
+) {
+	if ((batch->sat_id[index] == msg->sat_id)
+	    && (batch->IODE[index] == msg->eph.IODE)
+	    && (batch->toe[index] == msg->eph.toe)
+	    && (batch->IODC[index] == msg->clock.IODC)
+	    && (batch->toc[index] == msg->clock.toc))
+	{
+		// The invariants are still valid
+		return 0;
+	}
+
+	store_navmsg(batch, index, msg);
+
+	return 1;
+}
+
+void cgps_orbit_batch_clear(cgps_orbit_batch *batch) {
+	batch->count = 0;
+}
+
+void cgps_orbit_propagate(
+    const cgps_orbit_batch *batch,
+    double t,
+    cgps_satstate *state
+) {
+	size_t i = 0;
+
+#ifdef CGPS_HAVE_AVX2
+	if (cgps_simd_enabled()) {
+		for (; i + 4 <= batch->count; i += 4) {
+			propagate_avx2(batch, i, 1, &t, 0, state, i);
+		}
+	}
+#endif
+
+	// The rest one at a time
+	for (; i < batch->count; i++) {
+		propagate_scalar(batch, i, t, state, i);
+	}
+}
+
+void cgps_orbit_propagate_times(
+    const cgps_orbit_batch *batch,
+    size_t index,
+    const double *t,
+    size_t count,
+    cgps_satstate *state
+) {
+	size_t k = 0;
+
+#ifdef CGPS_HAVE_AVX2
+	if (cgps_simd_enabled()) {
+		for (; k + 4 <= count; k += 4) {
+			propagate_avx2(batch, index, 0, &t[k], 1, state, k);
+		}
+	}
+#endif
+
+	for (; k < count; k++) {
+		propagate_scalar(batch, index, t[k], state, k);
+	}
+}
+
+void cgps_kepler_solve(
+    const double *M,
+    const double *e,
+    double *E,
+    double *sinE,
+    double *cosE,
+    size_t count
+) {
+	size_t k = 0;
+
+#ifdef CGPS_HAVE_AVX2
+	if (cgps_simd_enabled()) {
+		for (; k + 4 <= count; k += 4) {
+			kepler_avx2(&M[k], &e[k], &E[k],
+			    (sinE != NULL) ? &sinE[k] : NULL,
+			    (cosE != NULL) ? &cosE[k] : NULL);
+		}
+	}
+#endif
+
+	for (; k < count; k++) {
+		double s, c;
+		kepler_scalar(M[k], e[k], &E[k], &s, &c);
+		if (sinE != NULL) sinE[k] = s;
+		if (cosE != NULL) cosE[k] = c;
+	}
+}
+
+#ifdef CGPS_HAVE_AVX2
+/**
+ * Enables the vectorized path when supported. Runs when the program
+ * is loaded, so that use_simd is not written by the threads.
+ */
+__attribute__((constructor))
+static void init_simd(void) {
+	use_simd = simd_supported();
+}
+#endif
+
+int cgps_simd_enabled(void) {
+	return use_simd;
+}
+
+int cgps_orbit_set_simd(int enabled) {
+	use_simd = enabled && simd_supported();
+	return use_simd;
+}
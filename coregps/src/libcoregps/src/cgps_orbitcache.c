@@ -0,0 +1,493 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#include "coregps/cgps_orbitcache.h"
+#include "cgps_simd.h"
+
+#include <stdlib.h> // malloc, free
+#include <math.h> // cos, floor, fabs, sqrt
+#include <float.h> // DBL_EPSILON
+
+//--- internal constants ---------------------------------------------------//
+
+/** Number of values per coefficient: the quantities and derivatives. */
+#define STRIDE (2 * CGPS_OC_QUANTITIES)
+
+/** Factor of the rounding errors of the evaluation in the estimate. */
+#define ROUNDING_MARGIN 4.0
+
+//--- internal helpers -----------------------------------------------------//
+
+/**
+ * Evaluates the values and the derivatives of all quantities at the
+ * normalized time u in [-1, 1] by Clenshaw's recurrence.
+ */
+static void clenshaw_scalar(
+    const double *c,
+    int n,
+    double u,
+    double out[STRIDE]
+) {
+	double b1[STRIDE] = { 0.0 };
+	double b2[STRIDE] = { 0.0 };
+	double u2 = 2.0 * u;
+
+	for (int k = n-1; k >= 1; k--) {
+		const double *ck = &c[k * STRIDE];
+		for (int q = 0; q < STRIDE; q++) {
+			// b2 is known a step earlier; keep it off the critical path.
+			double b0 = u2 * b1[q] + (ck[q] - b2[q]);
+			b2[q] = b1[q];
+			b1[q] = b0;
+		}
+	}
+
+	for (int q = 0; q < STRIDE; q++) {
+		out[q] = u * b1[q] + (c[q] - b2[q]);
+	}
+}
+
+#ifdef CGPS_HAVE_AVX2
+
+/**
+ * clenshaw_scalar() with the recurrences kept in two registers.
+ */
+CGPS_TARGET_AVX2
+static void clenshaw_avx2(
+    const double *c,
+    int n,
+    double u,
+    double out[STRIDE]
+) {
+	__m256d u2 = _mm256_set1_pd(2.0 * u);
+	__m256d b1a = _mm256_setzero_pd();
+	__m256d b1b = _mm256_setzero_pd();
+	__m256d b2a = _mm256_setzero_pd();
+	__m256d b2b = _mm256_setzero_pd();
+
+	for (int k = n-1; k >= 1; k--) {
+		const double *ck = &c[k * STRIDE];
+		__m256d b0a = _mm256_fmadd_pd(u2, b1a,
+		    _mm256_sub_pd(_mm256_loadu_pd(ck), b2a));
+		__m256d b0b = _mm256_fmadd_pd(u2, b1b,
+		    _mm256_sub_pd(_mm256_loadu_pd(ck + 4), b2b));
+		b2a = b1a;
+		b2b = b1b;
+		b1a = b0a;
+		b1b = b0b;
+	}
+
+	__m256d uu = _mm256_set1_pd(u);
+	_mm256_storeu_pd(out, _mm256_fmadd_pd(uu, b1a,
+	    _mm256_sub_pd(_mm256_loadu_pd(c), b2a)));
+	_mm256_storeu_pd(out + 4, _mm256_fmadd_pd(uu, b1b,
+	    _mm256_sub_pd(_mm256_loadu_pd(c + 4), b2b)));
+}
+
+#endif // CGPS_HAVE_AVX2
+
+static void clenshaw(const double *c, int n, double u, double out[STRIDE]) {
+#ifdef CGPS_HAVE_AVX2
+	if (cgps_simd_enabled()) {
+		clenshaw_avx2(c, n, u, out);
+		return;
+	}
+#endif
+	clenshaw_scalar(c, n, u, out);
+}
+
+/**
+ * Writes the state from the values evaluated by clenshaw().
+ */
+static void store_state(
+    const double v[STRIDE],
+    cgps_satstate *state,
+    size_t k
+) {
+	const double *d = &v[CGPS_OC_QUANTITIES];
+	state->x[k] = v[0];
+	state->y[k] = v[1];
+	state->z[k] = v[2];
+	state->clock_bias[k] = v[3];
+	state->vx[k] = d[0];
+	state->vy[k] = d[1];
+	state->vz[k] = d[2];
+	state->clock_drift[k] = d[3];
+}
+
+/**
+ * Copies the element j of the state src into the element k of dest.
+ */
+static void copy_state(
+    const cgps_satstate *src,
+    size_t j,
+    cgps_satstate *dest,
+    size_t k
+) {
+	dest->x[k] = src->x[j];
+	dest->y[k] = src->y[j];
+	dest->z[k] = src->z[j];
+	dest->vx[k] = src->vx[j];
+	dest->vy[k] = src->vy[j];
+	dest->vz[k] = src->vz[j];
+	dest->clock_bias[k] = src->clock_bias[j];
+	dest->clock_drift[k] = src->clock_drift[j];
+}
+
+/**
+ * Computes the coefficients of the values from the states at the
+ * Chebyshev nodes, and the coefficients of the derivatives from those.
+ * The derivatives are scaled from the normalized time to the time.
+ */
+static void compute_coeffs(
+    const cgps_satstate *s,
+    const double *cosines,
+    int n,
+    double scale,
+    double *c
+) {
+	const double *values[CGPS_OC_QUANTITIES] = {
+		s->x, s->y, s->z, s->clock_bias
+	};
+
+	for (int k = 0; k < n; k++) {
+		double *ck = &c[k * STRIDE];
+		const double *cosk = &cosines[k * n];
+		for (int q = 0; q < CGPS_OC_QUANTITIES; q++) {
+			double sum = 0.0;
+			for (int j = 0; j < n; j++) {
+				sum += values[q][j] * cosk[j];
+			}
+			ck[q] = ((k == 0) ? 1.0 : 2.0) * sum / n;
+		}
+	}
+
+	// Derivatives: d[k-1] = d[k+1] + 2k c[k], and d[0] halved.
+	for (int q = 0; q < CGPS_OC_QUANTITIES; q++) {
+		int dq = CGPS_OC_QUANTITIES + q;
+		double next = 0.0; // d[k+1]
+		double cur = 0.0; // d[k]
+		c[(n-1) * STRIDE + dq] = 0.0;
+		for (int k = n-1; k >= 1; k--) {
+			double prev = next + 2.0 * k * c[k * STRIDE + q];
+			c[(k-1) * STRIDE + dq] = prev;
+			next = cur;
+			cur = prev;
+		}
+		c[dq] *= 0.5;
+
+		for (int k = 0; k < n; k++) {
+			c[k * STRIDE + dq] *= scale;
+		}
+	}
+}
+
+/**
+ * Fills the table of cos(pi k (j + 1/2) / n) at [k*n + j].
+ */
+static void fill_cosines(double *cosines, int n) {
+	for (int k = 0; k < n; k++) {
+		for (int j = 0; j < n; j++) {
+			cosines[k * n + j] = cos(CGPS_PI * k * (j + 0.5) / n);
+		}
+	}
+}
+
+/**
+ * Fits n coefficients for the window [mid - 1/scale, mid + 1/scale]
+ * of the satellite i into c, with the cosine table of n.
+ * The states at the nodes are left in the scratch state.
+ */
+static void fit_window(
+    cgps_orbitcache *cache,
+    size_t i,
+    const double *cosines,
+    int n,
+    double mid,
+    double scale,
+    double *c
+) {
+	double half = 1.0 / scale;
+	const double *nodes = &cosines[n]; // the row k = 1
+	for (int j = 0; j < n; j++) {
+		cache->times[j] = mid + half * nodes[j];
+	}
+	cgps_orbit_propagate_times(cache->batch, i, cache->times, n,
+	    cache->scratch);
+	compute_coeffs(cache->scratch, cosines, n, scale, c);
+}
+
+/**
+ * Estimates the error of the fit c of n coefficients, see
+ * cgps_orbitcache.h. The reference fit r of 2n coefficients must have
+ * been the latest one, so that the scratch state holds the direct
+ * propagation at its nodes. Writes the estimates of the values and
+ * the derivatives into est.
+ */
+static void estimate_error(
+    const cgps_orbitcache *cache,
+    const double *c,
+    const double *r,
+    int n,
+    double est[STRIDE]
+) {
+	// Error measured at the nodes of the reference fit
+	double measured[STRIDE] = { 0.0 };
+	const cgps_satstate *s = cache->scratch;
+	const double *nodes = &cache->cos_ref[2*n]; // the row k = 1
+	for (int j = 0; j < 2*n; j++) {
+		double v[STRIDE];
+		clenshaw(c, n, nodes[j], v);
+		const double direct[STRIDE] = {
+			s->x[j], s->y[j], s->z[j], s->clock_bias[j],
+			s->vx[j], s->vy[j], s->vz[j], s->clock_drift[j]
+		};
+		for (int q = 0; q < STRIDE; q++) {
+			double e = fabs(v[q] - direct[q]);
+			if (e > measured[q]) measured[q] = e;
+		}
+	}
+
+	// Error estimated from the series
+	for (int q = 0; q < STRIDE; q++) {
+		double diff = 0.0;
+		double sum = 0.0;
+		for (int k = 0; k < 2*n; k++) {
+			double rk = r[k * STRIDE + q];
+			double ck = (k < n) ? c[k * STRIDE + q] : 0.0;
+			diff += fabs(ck - rk);
+			sum += fabs(rk);
+		}
+		double tail = fabs(r[(2*n-1) * STRIDE + q])
+		    + fabs(r[(2*n-2) * STRIDE + q]);
+		double series = diff + tail
+		    + ROUNDING_MARGIN * n * DBL_EPSILON * sum;
+		est[q] = CGPS_OC_SAFETY_FACTOR
+		    * ((series > measured[q]) ? series : measured[q]);
+	}
+}
+
+/**
+ * Fits the satellite i for a window containing the time t.
+ */
+static void refit(cgps_orbitcache *cache, size_t i, double t) {
+	const cgps_orbit_batch *b = cache->batch;
+	cgps_oc_fit *fit = &cache->fits[i];
+	int n = cache->coeffs;
+
+	double window = cache->window;
+	double est[STRIDE];
+	double err_pos, t0, mid, scale;
+	int direct = 0;
+
+	for (;;) {
+		// Windows are aligned, so that the satellites share them.
+		t0 = window * floor(t / window);
+		double half = 0.5 * window;
+		mid = t0 + half;
+		scale = 1.0 / half;
+
+		// The reference fit last, for the states at its nodes.
+		fit_window(cache, i, cache->cos_fit, n, mid, scale, fit->coeffs);
+		fit_window(cache, i, cache->cos_ref, 2*n, mid, scale,
+		    cache->ref_coeffs);
+		estimate_error(cache, fit->coeffs, cache->ref_coeffs, n, est);
+
+		err_pos = sqrt(est[0]*est[0] + est[1]*est[1] + est[2]*est[2]);
+		if (err_pos <= cache->tolerance) {
+			break;
+		}
+		if (0.5 * window < CGPS_OC_MIN_WINDOW) {
+			// The tolerance cannot be met; propagate directly.
+			direct = 1;
+			break;
+		}
+
+		// Too inaccurate; try again with a shorter window.
+		window *= 0.5;
+	}
+
+	fit->valid = 1;
+	fit->direct = direct;
+	fit->sat_id = b->sat_id[i];
+	fit->IODE = b->IODE[i];
+	fit->toe = b->toe[i];
+	fit->IODC = b->IODC[i];
+	fit->toc = b->toc[i];
+	fit->t0 = t0;
+	fit->t1 = t0 + window;
+	fit->mid = mid;
+	fit->scale = scale;
+
+	cache->refits++;
+	if (direct) {
+		cache->fallbacks++;
+		return;
+	}
+
+	const double *d = &est[CGPS_OC_QUANTITIES];
+	double err_vel = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+	if (err_pos > cache->max_est_pos) cache->max_est_pos = err_pos;
+	if (err_vel > cache->max_est_vel) cache->max_est_vel = err_vel;
+	if (est[3] > cache->max_est_clock) cache->max_est_clock = est[3];
+	if (d[3] > cache->max_est_drift) cache->max_est_drift = d[3];
+}
+
+/**
+ * Tells whether the fit of the satellite i is usable at the time t.
+ */
+static int fit_usable(const cgps_orbitcache *cache, size_t i, double t) {
+	const cgps_orbit_batch *b = cache->batch;
+	const cgps_oc_fit *fit = &cache->fits[i];
+
+	return fit->valid
+	    && (t >= fit->t0) && (t < fit->t1)
+	    && (fit->sat_id == b->sat_id[i])
+	    && (fit->IODE == b->IODE[i])
+	    && (fit->toe == b->toe[i])
+	    && (fit->IODC == b->IODC[i])
+	    && (fit->toc == b->toc[i]);
+}
+
+//--- external methods -----------------------------------------------------//
+
+cgps_orbitcache *cgps_oc_alloc(
+    const cgps_orbit_batch *batch,
+    double window,
+    int coeffs,
+    double tolerance
+) {
+	if ((coeffs < 2) || (coeffs > CGPS_OC_MAX_COEFFS)) {
+		return NULL;
+	}
+
+	cgps_orbitcache *cache = NULL;
+	size_t capacity = (batch->capacity > 0) ? batch->capacity : 1;
+
+	int complete = 0;
+	do {
+		cache = malloc(sizeof(cgps_orbitcache));
+		if (cache == NULL) break;
+
+		cache->batch = batch;
+		cache->window = window;
+		cache->coeffs = coeffs;
+		cache->tolerance = tolerance;
+		cache->fits = NULL;
+		cache->ref_coeffs = NULL;
+		cache->times = NULL;
+		cache->scratch = NULL;
+		cache->cos_fit = NULL;
+		cache->cos_ref = NULL;
+
+		cache->fits = malloc(capacity * sizeof(cgps_oc_fit));
+		if (cache->fits == NULL) break;
+		cache->fits[0].coeffs = NULL;
+
+		// The coefficients of all fits share a block
+		double *coeffs_block = malloc(
+		    capacity * coeffs * STRIDE * sizeof(double));
+		if (coeffs_block == NULL) break;
+
+		for (size_t i = 0; i < capacity; i++) {
+			cache->fits[i].coeffs = &coeffs_block[i * coeffs * STRIDE];
+		}
+
+		cache->ref_coeffs = malloc(2 * coeffs * STRIDE * sizeof(double));
+		if (cache->ref_coeffs == NULL) break;
+
+		cache->times = malloc(2 * coeffs * sizeof(double));
+		if (cache->times == NULL) break;
+
+		cache->scratch = cgps_satstate_alloc(2 * coeffs);
+		if (cache->scratch == NULL) break;
+
+		cache->cos_fit = malloc(coeffs * coeffs * sizeof(double));
+		if (cache->cos_fit == NULL) break;
+		fill_cosines(cache->cos_fit, coeffs);
+
+		cache->cos_ref = malloc(4 * coeffs * coeffs * sizeof(double));
+		if (cache->cos_ref == NULL) break;
+		fill_cosines(cache->cos_ref, 2 * coeffs);
+
+		cgps_oc_invalidate(cache);
+
+		complete = 1;
+	} while(0);
+
+	if (complete == 0) {
+		cgps_oc_free(cache);
+		cache = NULL;
+	}
+
+	return cache;
+}
+
+void cgps_oc_free(cgps_orbitcache *cache) {
+	if (cache == NULL) {
+		// Already freed
+		return;
+	}
+	if (cache->fits != NULL) {
+		// The coefficients of all fits share the block of the first one.
+		free(cache->fits[0].coeffs);
+		free(cache->fits);
+	}
+	free(cache->ref_coeffs);
+	free(cache->times);
+	cgps_satstate_free(cache->scratch);
+	free(cache->cos_fit);
+	free(cache->cos_ref);
+	free(cache);
+}
+
+void cgps_oc_eval(cgps_orbitcache *cache, double t, cgps_satstate *state) {
+	const cgps_orbit_batch *b = cache->batch;
+
+	for (size_t i = 0; i < b->count; i++) {
+		if (!fit_usable(cache, i, t)) {
+			refit(cache, i, t);
+		}
+
+		const cgps_oc_fit *fit = &cache->fits[i];
+		if (fit->direct) {
+			cgps_orbit_propagate_times(b, i, &t, 1, cache->scratch);
+			copy_state(cache->scratch, 0, state, i);
+			continue;
+		}
+
+		double u = (t - fit->mid) * fit->scale;
+
+		double v[STRIDE];
+		clenshaw(fit->coeffs, cache->coeffs, u, v);
+		store_state(v, state, i);
+	}
+}
+
+void cgps_oc_invalidate(cgps_orbitcache *cache) {
+	size_t capacity = cache->batch->capacity;
+	for (size_t i = 0; i < capacity; i++) {
+		cache->fits[i].valid = 0;
+	}
+	cache->refits = 0;
+	cache->fallbacks = 0;
+	cache->max_est_pos = 0.0;
+	cache->max_est_vel = 0.0;
+	cache->max_est_clock = 0.0;
+	cache->max_est_drift = 0.0;
+}
@@ -0,0 +1,46 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Internal: selection of the vectorized code paths.
+ */
+
+#ifndef CGPS_SIMD_H
+#define CGPS_SIMD_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CGPS_HAVE_AVX2
+#include <immintrin.h>
+#define CGPS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns 1 if the AVX2 paths are to be used, and 0 otherwise.
+ * See cgps_orbit_set_simd().
+ */
+int cgps_simd_enabled(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,189 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h> // clock
+
+#include "coregps/cgps_orbit.h"
+
+/**
+ * Deterministic pseudo-random numbers (xorshift64).
+ */
+static unsigned long long rand_state = 88172645463325252ULL;
+
+static double rand_uniform(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (double)(rand_state >> 11) / 9007199254740992.0;
+}
+
+/**
+ * The usual scalar solver: Newton's method from E = M until
+ * the step is below the tolerance.
+ */
+static double solve_newton(double M, double e) {
+	M -= 2.0 * CGPS_PI * floor((M + CGPS_PI) / (2.0 * CGPS_PI));
+	double E = M;
+	for (int i = 0; i < 30; i++) {
+		double dE = (E - e * sin(E) - M) / (1.0 - e * cos(E));
+		E -= dE;
+		if (fabs(dE) < 1e-15) {
+			break;
+		}
+	}
+	return E;
+}
+
+/**
+ * Reference solution in extended precision, iterated until
+ * the value no longer changes.
+ */
+static long double solve_reference(double M, double e, long double *Mr) {
+	long double m = M;
+	m -= 2.0L * CGPS_PI * floorl((m + CGPS_PI) / (2.0L * CGPS_PI));
+	long double E = m;
+	for (int i = 0; i < 60; i++) {
+		long double next = E - (E - e * sinl(E) - m) / (1.0L - e * cosl(E));
+		if (next == E) {
+			break;
+		}
+		E = next;
+	}
+	*Mr = m;
+	return E;
+}
+
+/**
+ * Returns the largest error of E, sinE and cosE against the reference.
+ */
+static double max_error(
+    const double *M,
+    const double *e,
+    const double *E,
+    const double *sinE,
+    const double *cosE,
+    int count
+) {
+	double worst = 0.0;
+	for (int k = 0; k < count; k++) {
+		long double m;
+		long double ref = solve_reference(M[k], e[k], &m);
+		double err[3] = {
+			fabsl(E[k] - ref),
+			fabsl(sinE[k] - sinl(ref)),
+			fabsl(cosE[k] - cosl(ref))
+		};
+		for (int j = 0; j < 3; j++) {
+			if (err[j] > worst) worst = err[j];
+		}
+	}
+	return worst;
+}
+
+int main(int argc, char *argv[]) {
+	int count = 1000000;
+	int rounds = 10;
+
+	if (argc > 1) {
+		count = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		rounds = atoi(argv[2]);
+	}
+	if ((count <= 0) || (rounds <= 0)) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    bench_kepler [<anomalies> [<rounds>]]\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	double *M = malloc(count * sizeof(double));
+	double *e = malloc(count * sizeof(double));
+	double *E = malloc(count * sizeof(double));
+	double *sinE = malloc(count * sizeof(double));
+	double *cosE = malloc(count * sizeof(double));
+	if ((M == NULL) || (e == NULL) || (E == NULL)
+	    || (sinE == NULL) || (cosE == NULL))
+	{
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// Mean anomalies over a few revolutions; every 8th eccentricity
+	// is the largest allowed.
+	for (int k = 0; k < count; k++) {
+		M[k] = (rand_uniform() - 0.5) * 8.0 * CGPS_PI;
+		e[k] = (k % 8) ? rand_uniform() * CGPS_KEPLER_MAX_E : CGPS_KEPLER_MAX_E;
+	}
+
+	clock_t start;
+	double total = (double) count * rounds;
+	double checksum = 0.0;
+
+	start = clock();
+	for (int round = 0; round < rounds; round++) {
+		for (int k = 0; k < count; k++) {
+			E[k] = solve_newton(M[k], e[k]);
+		}
+		checksum += E[count-1];
+	}
+	double secs_newton = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	printf("Anomalies:         %d x %d rounds\n", count, rounds);
+	printf("Newton to 1e-15:   %.1f ns/anomaly\n",
+	    1e9 * secs_newton / total);
+
+	int failures = 0;
+	for (int simd = 0; simd <= 1; simd++) {
+		if (cgps_orbit_set_simd(simd) != simd) {
+			printf("AVX2:              not supported\n");
+			continue;
+		}
+
+		start = clock();
+		for (int round = 0; round < rounds; round++) {
+			cgps_kepler_solve(M, e, E, sinE, cosE, count);
+			checksum += E[count-1];
+		}
+		double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		double err = max_error(M, e, E, sinE, cosE, count);
+		printf("%s %.1f ns/anomaly (%.2fx), max error %.2g rad\n",
+		    simd ? "Fixed, AVX2:      " : "Fixed, scalar:    ",
+		    1e9 * secs / total, secs_newton / secs, err);
+
+		if (err > 1e-15) {
+			failures++;
+		}
+	}
+
+	// Keeps the loops from being optimized away
+	printf("Checksum:          %g\n", checksum);
+
+	free(M);
+	free(e);
+	free(E);
+	free(sinE);
+	free(cosE);
+
+	return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
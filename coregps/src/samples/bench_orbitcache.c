@@ -0,0 +1,195 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h> // clock
+
+#include "coregps/cgps_orbit.h"
+#include "coregps/cgps_orbitcache.h"
+
+#define SATELLITES 32
+
+/**
+ * Broadcast ephemerides resembling those of the GPS constellation:
+ * six orbital planes, with the satellites spread within each plane.
+ */
+static void make_navmsg(cgps_navmsg *msg, int sat, double toe) {
+	memset(msg, 0, sizeof(cgps_navmsg));
+
+	msg->sat_id = sat + 1;
+	msg->eph.IODE = 1;
+	msg->eph.toe = toe;
+	msg->eph.sqrtA = 5153.6 + 0.05 * (sat % 7);
+	msg->eph.e = 0.002 + 0.0006 * sat;
+	msg->eph.M0 = 2.0 * CGPS_PI * (sat / 6) / 6.0 + 0.3 * (sat % 6) - CGPS_PI;
+	msg->eph.OMEGA0 = 2.0 * CGPS_PI * (sat % 6) / 6.0 - CGPS_PI;
+	msg->eph.i0 = 0.96 + 0.001 * (sat % 5);
+	msg->eph.w = -2.0 + 0.13 * sat;
+	msg->eph.delta_n = 4.5e-9;
+	msg->eph.OMEGADOT = -8.0e-9;
+	msg->eph.idot = 1.0e-10;
+	msg->eph.Crc = 250.0;
+	msg->eph.Crs = -40.0;
+	msg->eph.Cuc = -2.0e-6;
+	msg->eph.Cus = 8.0e-6;
+	msg->eph.Cic = 1.0e-7;
+	msg->eph.Cis = -5.0e-8;
+
+	msg->clock.toc = toe;
+	msg->clock.af0 = 1.0e-4 * ((sat % 3) - 1);
+	msg->clock.af1 = 1.0e-12;
+	msg->clock.af2 = 0.0;
+	msg->tgd = 5.0e-9;
+}
+
+int main(int argc, char *argv[]) {
+	double seconds = 600.0;
+	double rate = 1000.0;
+	double window = CGPS_OC_DEFAULT_WINDOW;
+	int coeffs = CGPS_OC_DEFAULT_COEFFS;
+
+	if (argc > 1) seconds = atof(argv[1]);
+	if (argc > 2) rate = atof(argv[2]);
+	if (argc > 3) window = atof(argv[3]);
+	if (argc > 4) coeffs = atoi(argv[4]);
+
+	if ((seconds <= 0.0) || (rate <= 0.0) || (window <= 0.0)) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    bench_orbitcache [<seconds> [<rate> [<window> [<coeffs>]]]]\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	cgps_orbit_batch *batch = cgps_orbit_batch_alloc(SATELLITES);
+	cgps_satstate *direct = cgps_satstate_alloc(SATELLITES);
+	cgps_satstate *cached = cgps_satstate_alloc(SATELLITES);
+	if ((batch == NULL) || (direct == NULL) || (cached == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	double t_begin = 345600.0;
+	for (int sat = 0; sat < SATELLITES; sat++) {
+		cgps_navmsg msg;
+		make_navmsg(&msg, sat, t_begin + 3600.0);
+		cgps_orbit_batch_add(batch, &msg);
+	}
+
+	cgps_orbitcache *cache = cgps_oc_alloc(
+	    batch, window, coeffs, CGPS_OC_DEFAULT_TOLERANCE);
+	if (cache == NULL) {
+		printf("Cannot allocate the cache\n");
+		return EXIT_FAILURE;
+	}
+
+	long epochs = (long) (seconds * rate);
+	double dt = 1.0 / rate;
+	double total = (double) epochs * batch->count;
+	double checksum = 0.0;
+	clock_t start;
+
+	printf("Satellites:        %d\n", (int) batch->count);
+	printf("Epochs:            %ld (%.0f s at %.0f Hz)\n",
+	    epochs, seconds, rate);
+	printf("Window:            %.0f s, %d coefficients\n", window, coeffs);
+
+	for (int simd = 0; simd <= 1; simd++) {
+		if (cgps_orbit_set_simd(simd) != simd) {
+			printf("AVX2:              not supported\n");
+			continue;
+		}
+
+		start = clock();
+		for (long k = 0; k < epochs; k++) {
+			cgps_orbit_propagate(batch, t_begin + k * dt, direct);
+			checksum += direct->x[0];
+		}
+		double secs_direct = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		cgps_oc_invalidate(cache);
+		start = clock();
+		for (long k = 0; k < epochs; k++) {
+			cgps_oc_eval(cache, t_begin + k * dt, cached);
+			checksum += cached->x[0];
+		}
+		double secs_cached = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		printf("%s direct %.1f ns, Chebyshev %.1f ns per satellite",
+		    simd ? "AVX2:  " : "Scalar:", 1e9 * secs_direct / total,
+		    1e9 * secs_cached / total);
+		if (secs_cached > 0.0) {
+			printf(" (%.2fx)", secs_direct / secs_cached);
+		}
+		printf("\n");
+	}
+	printf("Fits:              %lu (%lu direct)\n",
+	    (unsigned long) cache->refits, (unsigned long) cache->fallbacks);
+
+	// Errors against the direct propagation on every epoch
+	double err_pos = 0.0;
+	double err_vel = 0.0;
+	double err_clock = 0.0;
+	for (long k = 0; k < epochs; k++) {
+		double t = t_begin + k * dt;
+		cgps_orbit_propagate(batch, t, direct);
+		cgps_oc_eval(cache, t, cached);
+		for (size_t i = 0; i < batch->count; i++) {
+			double dx = cached->x[i] - direct->x[i];
+			double dy = cached->y[i] - direct->y[i];
+			double dz = cached->z[i] - direct->z[i];
+			double e = sqrt(dx*dx + dy*dy + dz*dz);
+			if (e > err_pos) err_pos = e;
+
+			dx = cached->vx[i] - direct->vx[i];
+			dy = cached->vy[i] - direct->vy[i];
+			dz = cached->vz[i] - direct->vz[i];
+			e = sqrt(dx*dx + dy*dy + dz*dz);
+			if (e > err_vel) err_vel = e;
+
+			e = fabs(cached->clock_bias[i] - direct->clock_bias[i]);
+			if (e > err_clock) err_clock = e;
+		}
+	}
+
+	printf("Error estimate:    %.2g m, %.2g m/s, %.2g s\n",
+	    cache->max_est_pos, cache->max_est_vel, cache->max_est_clock);
+	printf("Measured error:    %.2g m, %.2g m/s, %.2g s\n",
+	    err_pos, err_vel, err_clock);
+
+	// Keeps the loops from being optimized away
+	printf("Checksum:          %g\n", checksum);
+
+	int failed = (err_pos > cache->tolerance)
+	    || (err_pos > cache->max_est_pos)
+	    || (err_vel > cache->max_est_vel)
+	    || (err_clock > cache->max_est_clock);
+	if (failed) {
+		printf("The measured error exceeds the estimate\n");
+	}
+
+	cgps_oc_free(cache);
+	cgps_satstate_free(direct);
+	cgps_satstate_free(cached);
+	cgps_orbit_batch_free(batch);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Checks that cgps_orbit_batch_set() and the orbit cache drop their
+ * invariants and fits when the ephemeris or only the clock changes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "coregps/cgps_orbit.h"
+#include "coregps/cgps_orbitcache.h"
+
+static int failures = 0;
+
+static void check(int cond, const char *what) {
+	if (!cond) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static void make_navmsg(cgps_navmsg *msg) {
+	memset(msg, 0, sizeof(cgps_navmsg));
+
+	msg->sat_id = 7;
+	msg->eph.IODE = 40;
+	msg->eph.toe = 302400.0;
+	msg->eph.sqrtA = 5153.7;
+	msg->eph.e = 0.01;
+	msg->eph.M0 = 0.5;
+	msg->eph.OMEGA0 = -1.2;
+	msg->eph.i0 = 0.96;
+	msg->eph.w = 0.8;
+	msg->eph.delta_n = 4.5e-9;
+	msg->eph.OMEGADOT = -8.0e-9;
+	msg->eph.Crc = 250.0;
+	msg->eph.Crs = -40.0;
+
+	msg->clock.IODC = 40;
+	msg->clock.toc = 302400.0;
+	msg->clock.af0 = 1.0e-4;
+	msg->clock.af1 = 1.0e-12;
+	msg->tgd = 5.0e-9;
+}
+
+int main(void) {
+	cgps_orbit_batch *batch = cgps_orbit_batch_alloc(1);
+	cgps_satstate *state = cgps_satstate_alloc(1);
+	if ((batch == NULL) || (state == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	cgps_navmsg msg;
+	make_navmsg(&msg);
+	check(cgps_orbit_batch_add(batch, &msg) == 0, "the message is added");
+
+	cgps_orbitcache *cache = cgps_oc_alloc(batch, CGPS_OC_DEFAULT_WINDOW,
+	    CGPS_OC_DEFAULT_COEFFS, CGPS_OC_DEFAULT_TOLERANCE);
+	if (cache == NULL) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	double t = 303000.0;
+	cgps_oc_eval(cache, t, state);
+	double bias0 = state->clock_bias[0];
+	size_t refits = cache->refits;
+
+	// The same message keeps the invariants and the fit.
+	check(cgps_orbit_batch_set(batch, 0, &msg) == 0,
+	    "the same message is not stored again");
+	cgps_oc_eval(cache, t, state);
+	check(cache->refits == refits, "the same message keeps the fit");
+
+	// A new clock upload with the same IODE and toe.
+	msg.clock.IODC = 41;
+	msg.clock.toc = 309600.0;
+	msg.clock.af0 = 2.0e-4;
+	check(cgps_orbit_batch_set(batch, 0, &msg) == 1,
+	    "a new clock is stored");
+	check(batch->af0[0] == msg.clock.af0, "af0 is replaced");
+	check(batch->toc[0] == msg.clock.toc, "toc is replaced");
+
+	cgps_orbit_propagate(batch, t, state);
+	// The relativistic correction is below F e sqrt(A) = 2.3e-8 s.
+	double expected = 2.0e-4 + 1.0e-12 * (t - 309600.0) - 5.0e-9;
+	check(fabs(state->clock_bias[0] - expected) < 3e-8,
+	    "the propagation uses the new clock");
+
+	cgps_oc_eval(cache, t, state);
+	check(cache->refits == refits + 1, "a new clock makes a new fit");
+	check(fabs(state->clock_bias[0] - bias0) > 5e-5,
+	    "the cache uses the new clock");
+
+	// A new ephemeris with the same toe.
+	msg.eph.IODE = 41;
+	msg.eph.M0 = 0.6;
+	check(cgps_orbit_batch_set(batch, 0, &msg) == 1,
+	    "a new ephemeris is stored");
+	check(batch->M0[0] == msg.eph.M0, "M0 is replaced");
+
+	cgps_oc_free(cache);
+	cgps_satstate_free(state);
+	cgps_orbit_batch_free(batch);
+
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("All checks passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Compares the vectorized orbit propagation with the scalar one,
+ * for both cgps_orbit_propagate() and cgps_orbit_propagate_times().
+ *
+ * Tolerances: position 1e-6 m, velocity 1e-9 m/s, clock bias 1e-18 s,
+ * clock drift 1e-24 s/s. The paths differ only by the rounding of
+ * their sines and cosines, which are evaluated differently.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "coregps/cgps_orbit.h"
+
+#define SATELLITES 31
+#define EPOCHS 97
+
+#define TOL_POS 1e-6
+#define TOL_VEL 1e-9
+#define TOL_CLOCK 1e-18
+#define TOL_DRIFT 1e-24
+
+/**
+ * Ephemerides resembling those of the GPS constellation, with the
+ * eccentricities up to CGPS_KEPLER_MAX_E.
+ */
+static void make_navmsg(cgps_navmsg *msg, int sat, double toe) {
+	memset(msg, 0, sizeof(cgps_navmsg));
+
+	msg->sat_id = sat + 1;
+	msg->eph.IODE = 1;
+	msg->eph.toe = toe;
+	msg->eph.sqrtA = 5153.6 + 0.05 * (sat % 7);
+	msg->eph.e = CGPS_KEPLER_MAX_E * sat / (SATELLITES - 1);
+	msg->eph.M0 = 2.0 * CGPS_PI * (sat / 6) / 6.0 + 0.3 * (sat % 6) - CGPS_PI;
+	msg->eph.OMEGA0 = 2.0 * CGPS_PI * (sat % 6) / 6.0 - CGPS_PI;
+	msg->eph.i0 = 0.96 + 0.001 * (sat % 5);
+	msg->eph.w = -2.0 + 0.13 * sat;
+	msg->eph.delta_n = 4.5e-9;
+	msg->eph.OMEGADOT = -8.0e-9;
+	msg->eph.idot = 1.0e-10;
+	msg->eph.Crc = 250.0;
+	msg->eph.Crs = -40.0;
+	msg->eph.Cuc = -2.0e-6;
+	msg->eph.Cus = 8.0e-6;
+	msg->eph.Cic = 1.0e-7;
+	msg->eph.Cis = -5.0e-8;
+
+	msg->clock.toc = toe;
+	msg->clock.af0 = 1.0e-4 * ((sat % 3) - 1);
+	msg->clock.af1 = 1.0e-12;
+	msg->clock.af2 = 1.0e-19;
+	msg->tgd = 5.0e-9;
+}
+
+/** Largest differences over the elements 0 .. count-1. */
+struct diff {
+	double pos;
+	double vel;
+	double clock;
+	double drift;
+};
+
+static void compare(
+    const cgps_satstate *a,
+    const cgps_satstate *b,
+    size_t count,
+    struct diff *d
+) {
+	for (size_t k = 0; k < count; k++) {
+		double dx = a->x[k] - b->x[k];
+		double dy = a->y[k] - b->y[k];
+		double dz = a->z[k] - b->z[k];
+		double e = sqrt(dx*dx + dy*dy + dz*dz);
+		if (!(e <= d->pos)) d->pos = e;
+
+		dx = a->vx[k] - b->vx[k];
+		dy = a->vy[k] - b->vy[k];
+		dz = a->vz[k] - b->vz[k];
+		e = sqrt(dx*dx + dy*dy + dz*dz);
+		if (!(e <= d->vel)) d->vel = e;
+
+		e = fabs(a->clock_bias[k] - b->clock_bias[k]);
+		if (!(e <= d->clock)) d->clock = e;
+
+		e = fabs(a->clock_drift[k] - b->clock_drift[k]);
+		if (!(e <= d->drift)) d->drift = e;
+	}
+}
+
+static int report(const char *name, const struct diff *d) {
+	int ok = (d->pos <= TOL_POS) && (d->vel <= TOL_VEL)
+	    && (d->clock <= TOL_CLOCK) && (d->drift <= TOL_DRIFT);
+	printf("%s %.2g m, %.2g m/s, %.2g s, %.2g s/s  %s\n", name,
+	    d->pos, d->vel, d->clock, d->drift, ok ? "ok" : "FAIL");
+	return ok;
+}
+
+int main(void) {
+	if (!cgps_orbit_set_simd(1)) {
+		printf("AVX2 is not supported; nothing to compare\n");
+		return EXIT_SUCCESS;
+	}
+
+	cgps_orbit_batch *batch = cgps_orbit_batch_alloc(SATELLITES);
+	cgps_satstate *scalar = cgps_satstate_alloc(EPOCHS);
+	cgps_satstate *simd = cgps_satstate_alloc(EPOCHS);
+	if ((batch == NULL) || (scalar == NULL) || (simd == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// The toe is near the end of the week, so that the times
+	// cross over into the next week.
+	double toe = CGPS_SECONDS_IN_WEEK - 3600.0;
+	for (int sat = 0; sat < SATELLITES; sat++) {
+		cgps_navmsg msg;
+		make_navmsg(&msg, sat, toe);
+		cgps_orbit_batch_add(batch, &msg);
+	}
+
+	// Times from toe - 2 h to toe + 2 h, wrapped into the week
+	double times[EPOCHS];
+	for (int k = 0; k < EPOCHS; k++) {
+		double t = toe - 7200.0 + 150.0 * k + 0.37 * (k % 5);
+		times[k] = fmod(t, CGPS_SECONDS_IN_WEEK);
+	}
+
+	// All satellites at a time
+	struct diff batch_diff = { 0.0, 0.0, 0.0, 0.0 };
+	for (int k = 0; k < EPOCHS; k++) {
+		cgps_orbit_set_simd(0);
+		cgps_orbit_propagate(batch, times[k], scalar);
+		cgps_orbit_set_simd(1);
+		cgps_orbit_propagate(batch, times[k], simd);
+		compare(scalar, simd, batch->count, &batch_diff);
+	}
+
+	// A satellite at all times
+	struct diff times_diff = { 0.0, 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < batch->count; i++) {
+		cgps_orbit_set_simd(0);
+		cgps_orbit_propagate_times(batch, i, times, EPOCHS, scalar);
+		cgps_orbit_set_simd(1);
+		cgps_orbit_propagate_times(batch, i, times, EPOCHS, simd);
+		compare(scalar, simd, EPOCHS, &times_diff);
+	}
+
+	printf("Tolerance:          %.2g m, %.2g m/s, %.2g s, %.2g s/s\n",
+	    TOL_POS, TOL_VEL, TOL_CLOCK, TOL_DRIFT);
+	int ok = report("propagate:         ", &batch_diff);
+	ok = report("propagate_times:   ", &times_diff) && ok;
+
+	cgps_satstate_free(simd);
+	cgps_satstate_free(scalar);
+	cgps_orbit_batch_free(batch);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
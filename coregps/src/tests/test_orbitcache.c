@@ -0,0 +1,194 @@
+//******************************{begin:header}******************************//
+//         coregps - Fundamental GPS data structures and algorithms
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Checks that the errors of the orbit cache stay within the estimates
+ * it reports, and that a tolerance which cannot be met falls back
+ * to the direct propagation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "coregps/cgps_orbit.h"
+#include "coregps/cgps_orbitcache.h"
+
+#define SATELLITES 8
+
+static int failures = 0;
+
+static void check(int cond, const char *what) {
+	if (!cond) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static void make_navmsg(cgps_navmsg *msg, int sat, double toe) {
+	memset(msg, 0, sizeof(cgps_navmsg));
+
+	msg->sat_id = sat + 1;
+	msg->eph.IODE = 1;
+	msg->eph.toe = toe;
+	msg->eph.sqrtA = 5153.6 + 0.05 * sat;
+	msg->eph.e = 0.004 * sat;
+	msg->eph.M0 = 0.8 * sat - CGPS_PI;
+	msg->eph.OMEGA0 = 1.05 * sat - CGPS_PI;
+	msg->eph.i0 = 0.96;
+	msg->eph.w = -2.0 + 0.5 * sat;
+	msg->eph.delta_n = 4.5e-9;
+	msg->eph.OMEGADOT = -8.0e-9;
+	msg->eph.idot = 1.0e-10;
+	msg->eph.Crc = 250.0;
+	msg->eph.Crs = -40.0;
+	msg->eph.Cuc = -2.0e-6;
+	msg->eph.Cus = 8.0e-6;
+	msg->eph.Cic = 1.0e-7;
+	msg->eph.Cis = -5.0e-8;
+
+	msg->clock.toc = toe;
+	msg->clock.af0 = 1.0e-4;
+	msg->clock.af1 = 1.0e-12;
+	msg->tgd = 5.0e-9;
+}
+
+/**
+ * Evaluates the cache every step seconds over the span, and returns
+ * the largest position error [m] against the direct propagation.
+ * The largest velocity and clock bias errors go into err_vel and
+ * err_clock.
+ */
+static double max_error(
+    cgps_orbitcache *cache,
+    double t_begin,
+    double span,
+    double step,
+    double *err_vel,
+    double *err_clock
+) {
+	const cgps_orbit_batch *batch = cache->batch;
+	cgps_satstate *direct = cgps_satstate_alloc(batch->count);
+	cgps_satstate *cached = cgps_satstate_alloc(batch->count);
+	double err_pos = 0.0;
+	*err_vel = 0.0;
+	*err_clock = 0.0;
+
+	for (double t = t_begin; t < t_begin + span; t += step) {
+		cgps_orbit_propagate(batch, t, direct);
+		cgps_oc_eval(cache, t, cached);
+		for (size_t i = 0; i < batch->count; i++) {
+			double dx = cached->x[i] - direct->x[i];
+			double dy = cached->y[i] - direct->y[i];
+			double dz = cached->z[i] - direct->z[i];
+			double e = sqrt(dx*dx + dy*dy + dz*dz);
+			if (!(e <= err_pos)) err_pos = e;
+
+			dx = cached->vx[i] - direct->vx[i];
+			dy = cached->vy[i] - direct->vy[i];
+			dz = cached->vz[i] - direct->vz[i];
+			e = sqrt(dx*dx + dy*dy + dz*dz);
+			if (!(e <= *err_vel)) *err_vel = e;
+
+			e = fabs(cached->clock_bias[i] - direct->clock_bias[i]);
+			if (!(e <= *err_clock)) *err_clock = e;
+		}
+	}
+
+	cgps_satstate_free(direct);
+	cgps_satstate_free(cached);
+	return err_pos;
+}
+
+int main(void) {
+	cgps_orbit_batch *batch = cgps_orbit_batch_alloc(SATELLITES);
+	if (batch == NULL) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	double t_begin = 345600.0;
+	for (int sat = 0; sat < SATELLITES; sat++) {
+		cgps_navmsg msg;
+		make_navmsg(&msg, sat, t_begin + 3600.0);
+		cgps_orbit_batch_add(batch, &msg);
+	}
+
+	// Few coefficients over long windows, so that the windows are
+	// halved, and the errors stay well above the rounding.
+	const int coeffs[] = { 4, 6, 8 };
+	const double windows[] = { 300.0, 1800.0, 7200.0 };
+	for (int a = 0; a < 3; a++) {
+		for (int w = 0; w < 3; w++) {
+			cgps_orbitcache *cache = cgps_oc_alloc(
+			    batch, windows[w], coeffs[a], CGPS_OC_DEFAULT_TOLERANCE);
+			if (cache == NULL) {
+				printf("Out of memory\n");
+				return EXIT_FAILURE;
+			}
+
+			double err_vel, err_clock;
+			double err_pos = max_error(cache, t_begin, 7200.0, 0.7,
+			    &err_vel, &err_clock);
+			printf("%2d coefficients, %4.0f s: %.2g m (estimate %.2g m), "
+			    "%.2g m/s (estimate %.2g m/s)\n",
+			    coeffs[a], windows[w], err_pos, cache->max_est_pos,
+			    err_vel, cache->max_est_vel);
+
+			check(cache->fallbacks == 0, "the tolerance is met");
+			check(cache->max_est_pos <= cache->tolerance,
+			    "the position estimate is within the tolerance");
+			check(err_pos <= cache->max_est_pos,
+			    "the position error is within the estimate");
+			check(err_vel <= cache->max_est_vel,
+			    "the velocity error is within the estimate");
+			check(err_clock <= cache->max_est_clock,
+			    "the clock error is within the estimate");
+
+			cgps_oc_free(cache);
+		}
+	}
+
+	// A tolerance below the rounding cannot be met. The scalar path
+	// is used, so that the direct propagations are the same.
+	cgps_orbit_set_simd(0);
+	cgps_orbitcache *cache = cgps_oc_alloc(batch, 300.0, 8, 1e-12);
+	if (cache == NULL) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+	double err_vel, err_clock;
+	double err_pos = max_error(cache, t_begin, 30.0, 0.7,
+	    &err_vel, &err_clock);
+	check(cache->fallbacks == cache->refits,
+	    "every fit falls back to the direct propagation");
+	check((err_pos == 0.0) && (err_vel == 0.0) && (err_clock == 0.0),
+	    "the fallback equals the direct propagation");
+	cgps_oc_free(cache);
+
+	cgps_orbit_batch_free(batch);
+
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("All checks passed\n");
+	return EXIT_SUCCESS;
+}
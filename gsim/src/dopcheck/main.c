@@ -0,0 +1,331 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Checks gsim_dopmap against a per-point reference, and measures it.
+ *
+ * The reference takes the directions of the visible satellites from
+ * gsim_visibility, and inverts the 4x4 normal matrix by Gauss-Jordan
+ * elimination with partial pivoting. The DOP values must agree within
+ * a relative error of 1e-6 (the map stores floats), the visible counts
+ * exactly, and the maps computed with different numbers of threads
+ * bit for bit. The pool of a map is reused over several epochs.
+ */
+
+// For clock_gettime()
+#define _POSIX_C_SOURCE 200809L
+
+// EXIT_SUCCESS, EXIT_FAILURE
+#include <stdlib.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// liblatitude, lat_*
+#include "latitude/lat_ellipsoid.h"
+
+// libcoregps, cgps_*
+#include "coregps/cgps_orbit.h"
+
+// libgsim
+#include "gsim/gsim_dopmap.h"
+#include "gsim/gsim_visibility.h"
+
+#define WGS84_A 6378137.0
+#define WGS84_F (1.0 / 298.257223563)
+
+/** Radius of the GPS orbits [m]. */
+#define ORBIT_RADIUS 26560.0e3
+
+#define SATELLITES 12
+#define EPOCHS 5
+#define MASK 0.1
+
+/** Largest accepted relative error of the DOP values. */
+#define TOLERANCE 1.0e-6
+
+static double seconds_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/**
+ * Inverts the 4x4 matrix in the left half of a into the right half.
+ * Returns 0 if it is singular.
+ */
+static int invert(double a[4][8]) {
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			a[i][4+j] = (i == j) ? 1.0 : 0.0;
+		}
+	}
+
+	for (int c = 0; c < 4; c++) {
+		int p = c;
+		for (int r = c+1; r < 4; r++) {
+			if (fabs(a[r][c]) > fabs(a[p][c])) p = r;
+		}
+		if (fabs(a[p][c]) < 1.0e-14) {
+			return 0;
+		}
+		for (int k = 0; k < 8; k++) {
+			double tmp = a[c][k];
+			a[c][k] = a[p][k];
+			a[p][k] = tmp;
+		}
+		double d = a[c][c];
+		for (int k = 0; k < 8; k++) {
+			a[c][k] /= d;
+		}
+		for (int r = 0; r < 4; r++) {
+			if (r == c) continue;
+			double f = a[r][c];
+			for (int k = 0; k < 8; k++) {
+				a[r][k] -= f * a[c][k];
+			}
+		}
+	}
+
+	return 1;
+}
+
+static double rel_error(double ref, float value) {
+	return fabs(ref - value) / ref;
+}
+
+/**
+ * Compares the map with the reference. Returns the number of points
+ * which disagree, and updates the largest relative error.
+ */
+static size_t check_map(
+    const gsim_dopmap *map,
+    const lat_ellipsoid *ellipsoid,
+    gsim_visibility *vis,
+    const cgps_satstate *sats,
+    size_t count,
+    double *max_error
+) {
+	const gsim_dopmap_grid *g = &map->grid;
+	size_t bad = 0;
+
+	for (size_t i = 0; i < g->lat_count; i++) {
+		for (size_t j = 0; j < g->lon_count; j++) {
+			double geo[3];
+			double xyz[3];
+			double local[9];
+			geo[0] = g->lon0 + j * g->lon_step;
+			geo[1] = g->lat0 + i * g->lat_step;
+			geo[2] = g->height;
+			lat_ellipsoid_geo2xyz(ellipsoid, geo, xyz);
+			lat_ellipsoid_localframe_at(ellipsoid, geo, local);
+
+			size_t n = gsim_vis_compute(vis, xyz, local, sats, count);
+			size_t k = i * g->lon_count + j;
+			if (n != map->visible[k]) {
+				bad++;
+				continue;
+			}
+
+			double a[4][8];
+			memset(a, 0, sizeof(a));
+			for (size_t q = 0; q < n; q++) {
+				double el = vis->elevation[q];
+				double az = vis->azimuth[q];
+				double h[4];
+				h[0] = cos(el) * sin(az);
+				h[1] = cos(el) * cos(az);
+				h[2] = sin(el);
+				h[3] = 1.0;
+				for (int r = 0; r < 4; r++) {
+					for (int c = 0; c < 4; c++) {
+						a[r][c] += h[r] * h[c];
+					}
+				}
+			}
+
+			if ((n < 4) || !invert(a)) {
+				if (map->gdop[k] != GSIM_DOPMAP_NONE) bad++;
+				continue;
+			}
+
+			double h2 = a[0][4] + a[1][5];
+			double p2 = h2 + a[2][6];
+			double e = rel_error(sqrt(p2 + a[3][7]), map->gdop[k]);
+			e = fmax(e, rel_error(sqrt(p2), map->pdop[k]));
+			e = fmax(e, rel_error(sqrt(h2), map->hdop[k]));
+			e = fmax(e, rel_error(sqrt(a[2][6]), map->vdop[k]));
+			if (!(e <= TOLERANCE)) bad++;
+			if (e > *max_error) *max_error = e;
+		}
+	}
+
+	return bad;
+}
+
+/**
+ * Satellites at random directions on the orbit radius.
+ */
+static void random_sats(cgps_satstate *sats, size_t count) {
+	for (size_t s = 0; s < count; s++) {
+		double z = 2.0 * rand() / RAND_MAX - 1.0;
+		double phi = 2.0 * CGPS_PI * rand() / RAND_MAX;
+		double rxy = ORBIT_RADIUS * sqrt(1.0 - z*z);
+		sats->x[s] = rxy * cos(phi);
+		sats->y[s] = rxy * sin(phi);
+		sats->z[s] = ORBIT_RADIUS * z;
+	}
+}
+
+static int same_results(const gsim_dopmap *a, const gsim_dopmap *b) {
+	size_t n = a->points;
+	return (memcmp(a->gdop, b->gdop, 4 * n * sizeof(float)) == 0)
+	    && (memcmp(a->visible, b->visible, n) == 0);
+}
+
+/**
+ * Checks a grid with 1, 2 and 4 threads over EPOCHS epochs.
+ * Returns 1 if everything agrees.
+ */
+static int check_grid(
+    const char *name,
+    const lat_ellipsoid *ellipsoid,
+    const gsim_dopmap_grid *grid,
+    gsim_visibility *vis,
+    cgps_satstate *sats
+) {
+	const int threads[3] = { 1, 2, 4 };
+	gsim_dopmap *maps[3];
+	int ok = 1;
+
+	for (int t = 0; t < 3; t++) {
+		maps[t] = gsim_dopmap_alloc(ellipsoid, grid, threads[t]);
+		if (maps[t] == NULL) {
+			printf("Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+		gsim_dopmap_set_mask(maps[t], MASK);
+	}
+
+	size_t bad = 0;
+	double max_error = 0.0;
+	for (int epoch = 0; epoch < EPOCHS; epoch++) {
+		random_sats(sats, SATELLITES);
+		for (int t = 0; t < 3; t++) {
+			gsim_dopmap_compute(maps[t], sats, SATELLITES);
+		}
+
+		bad += check_map(maps[0], ellipsoid, vis, sats, SATELLITES,
+		    &max_error);
+		for (int t = 1; t < 3; t++) {
+			if (!same_results(maps[0], maps[t])) {
+				printf("%s: %d threads differ from 1 thread\n",
+				    name, maps[t]->num_threads);
+				ok = 0;
+			}
+		}
+	}
+
+	printf("%-16s %4zu x %-4zu points: %zu bad, max rel err %.2g\n",
+	    name, grid->lon_count, grid->lat_count, bad, max_error);
+
+	for (int t = 0; t < 3; t++) {
+		gsim_dopmap_free(maps[t]);
+	}
+
+	return ok && (bad == 0);
+}
+
+/**
+ * Time per epoch of a grid with the given number of threads.
+ */
+static double time_epoch(
+    const lat_ellipsoid *ellipsoid,
+    const gsim_dopmap_grid *grid,
+    int num_threads,
+    const cgps_satstate *sats,
+    int epochs
+) {
+	gsim_dopmap *map = gsim_dopmap_alloc(ellipsoid, grid, num_threads);
+	if (map == NULL) {
+		printf("Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+	gsim_dopmap_set_mask(map, MASK);
+
+	double start = seconds_now();
+	for (int i = 0; i < epochs; i++) {
+		gsim_dopmap_compute(map, sats, SATELLITES);
+	}
+	double secs = seconds_now() - start;
+
+	gsim_dopmap_free(map);
+	return secs / epochs;
+}
+
+int main(void) {
+	lat_ellipsoid ellipsoid;
+	lat_ellipsoid_set_af(&ellipsoid, WGS84_A, WGS84_F);
+
+	gsim_visibility *vis = gsim_vis_alloc(SATELLITES);
+	cgps_satstate *sats = cgps_satstate_alloc(SATELLITES);
+	if ((vis == NULL) || (sats == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+	gsim_vis_set_mask(vis, MASK);
+	srand(3);
+
+	// A global grid, a single row, and a grid smaller than a chunk
+	gsim_dopmap_grid global = {
+		-3.1, -1.55, 0.037, 0.031, 170, 101, 150.0
+	};
+	gsim_dopmap_grid row = {
+		-3.14, 0.7, 0.0175, 0.0, 360, 1, 0.0
+	};
+	gsim_dopmap_grid tiny = {
+		0.2, 0.4, 0.01, 0.01, 3, 2, 1000.0
+	};
+
+	int ok = check_grid("Global grid:", &ellipsoid, &global, vis, sats);
+	ok = check_grid("Single row:", &ellipsoid, &row, vis, sats) && ok;
+	ok = check_grid("Tiny grid:", &ellipsoid, &tiny, vis, sats) && ok;
+
+	// The cost of an epoch includes no thread setup, so that even
+	// the small grids are cheap.
+	printf("\n");
+	printf("Time per epoch   1 thread    2 threads   4 threads\n");
+	const gsim_dopmap_grid *grids[3] = { &global, &row, &tiny };
+	const char *names[3] = { "Global grid:", "Single row:", "Tiny grid:" };
+	for (int g = 0; g < 3; g++) {
+		printf("%-16s", names[g]);
+		for (int t = 1; t <= 4; t *= 2) {
+			double secs = time_epoch(&ellipsoid, grids[g], t, sats, 200);
+			printf(" %8.1f us", 1.0e6 * secs);
+		}
+		printf("\n");
+	}
+
+	gsim_vis_free(vis);
+	cgps_satstate_free(sats);
+
+	printf("\n%s\n", ok ? "All checks passed" : "Checks failed");
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
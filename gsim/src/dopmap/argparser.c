@@ -0,0 +1,218 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+// libgrease, gut_*
+#include "grease/gut_parse.h"
+#include "grease/gut_argparser.h"
+// GUT_E_USER
+#include "grease/gut_error.h"
+
+// The application-specific configuration
+#include "dopmap_config.h"
+
+// strcmp
+#include <string.h>
+
+// PARSER STATES
+//===============
+
+#define S_NOMINAL 0
+#define S_OUTFILE 1
+#define S_STEP 2
+#define S_HEIGHT 3
+#define S_MASK 4
+#define S_INTERVAL 5
+#define S_EPOCHS 6
+#define S_START 7
+#define S_THREADS 8
+#define S_ERROR -1
+
+
+// INTERNAL HELPERS
+//==================
+
+static void errorfmt(gut_argparser *parser, const char *fmt, ...) {
+	// Set error state
+	parser->state = S_ERROR;
+
+	// Format human-readable error message
+	va_list args;
+	va_start(args, fmt);
+	gut_argparser_verrorfmt(parser, fmt, args);
+	va_end(args);
+}
+
+static void parse_uint(
+    gut_argparser *parser,
+    const char *carg,
+    unsigned int *result
+) {
+	// Parse the string into int
+	if (gut_parse_uint(carg, result) != 0) {
+		// Error, conversion failed.
+		errorfmt(parser, "Cannot convert to unsigned int: %s", carg);
+	}
+}
+
+static void parse_double(
+    gut_argparser *parser,
+    const char *carg,
+    double *result
+) {
+	if (gut_parse_double(carg, result) != 0) {
+		// Conversion failed
+		errorfmt(parser, "Cannot convert to double: %s", carg);
+	}
+}
+
+/**
+ * Consumes a single input argument
+ */
+static void consume(gut_argparser *parser) {
+
+	// For convenience
+	const char *carg = parser->carg;
+	int state = parser->state;
+	dopmap_config *config = parser->itemptr;
+
+	// For automatic return to nominal after an excursion
+	int back_to_nominal = 0;
+	if (state != S_NOMINAL) {
+		back_to_nominal = 1;
+	}
+
+	switch(state) {
+	case S_NOMINAL:
+		if ((strcmp(carg, "-outfile") == 0)
+		    || (strcmp(carg, "-out") == 0)
+		    || (strcmp(carg, "-o") == 0))
+		{
+			state = S_OUTFILE;
+		}
+		else if (strcmp(carg, "-step") == 0) {
+			state = S_STEP;
+		}
+		else if ((strcmp(carg, "-height") == 0)
+		    || (strcmp(carg, "-h") == 0))
+		{
+			state = S_HEIGHT;
+		}
+		else if (strcmp(carg, "-mask") == 0) {
+			state = S_MASK;
+		}
+		else if (strcmp(carg, "-interval") == 0) {
+			state = S_INTERVAL;
+		}
+		else if (strcmp(carg, "-epochs") == 0) {
+			state = S_EPOCHS;
+		}
+		else if (strcmp(carg, "-start") == 0) {
+			state = S_START;
+		}
+		else if (strcmp(carg, "-threads") == 0) {
+			state = S_THREADS;
+		}
+		else if ((carg[0] != '-') && (config->navfile == NULL)) {
+			config->navfile = carg;
+		}
+		else {
+			// Error, unexpected argument
+			errorfmt(parser, "Unexpected argument: %s", carg);
+		}
+		break;
+
+	case S_OUTFILE:
+		config->outfile = carg;
+		break;
+
+	case S_STEP:
+		// Grid spacing [deg]
+		parse_double(parser, carg, &config->step);
+		break;
+
+	case S_HEIGHT:
+		// Receiver height [m]
+		parse_double(parser, carg, &config->height);
+		break;
+
+	case S_MASK:
+		// Elevation mask [deg]
+		parse_double(parser, carg, &config->mask);
+		break;
+
+	case S_INTERVAL:
+		// Time between epochs [s]
+		parse_uint(parser, carg, &config->interval);
+		break;
+
+	case S_EPOCHS:
+		parse_uint(parser, carg, &config->epochs);
+		break;
+
+	case S_START:
+		// GPS time of week [s]
+		parse_double(parser, carg, &config->start);
+		break;
+
+	case S_THREADS:
+		parse_uint(parser, carg, &config->threads);
+		break;
+
+	case S_ERROR:
+		// Finishing state; hold it.
+		break;
+
+	default:
+		// Error
+		break;
+	} // switch
+
+	if (back_to_nominal) {
+		state = S_NOMINAL;
+	}
+
+	// Store the updated state only if the parser
+	// has not been set to error state
+	if (parser->state != S_ERROR) {
+		parser->state = state;
+	}
+}
+
+int argparser_parse(
+    gut_argparser *parser,
+    int argc,
+    char *argv[],
+    dopmap_config *config
+) {
+
+	// Configure the application-depend aspects of the argparser.
+	parser->cycle = consume;
+	parser->itemptr = config;
+
+	// Parse command-line arguments to "config".
+	gut_argparser_parse(parser, argc, argv);
+
+	// Inspect the ending state
+	if ((parser->err == 0) && (parser->state != S_NOMINAL)) {
+		gut_argparser_errorfmt(parser,
+		    "Unexpected end of command-line");
+	}
+
+	// Returns the error code for the parser
+	return parser->err;
+}
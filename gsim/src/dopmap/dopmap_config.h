@@ -0,0 +1,83 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#ifndef DOPMAP_CONFIG_H
+#define DOPMAP_CONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Application specific configuration
+ */
+struct dopmap_config {
+	/**
+	 * The RINEX navigation file, or NULL if not given.
+	 */
+	const char *navfile;
+
+	/**
+	 * The output file name, or NULL if not given.
+	 */
+	const char *outfile;
+
+	/**
+	 * Grid spacing [deg].
+	 */
+	double step;
+
+	/**
+	 * Receiver height above the ellipsoid [m].
+	 */
+	double height;
+
+	/**
+	 * Elevation mask [deg].
+	 */
+	double mask;
+
+	/**
+	 * Time between the epochs [s].
+	 */
+	unsigned int interval;
+
+	/**
+	 * Number of epochs.
+	 */
+	unsigned int epochs;
+
+	/**
+	 * GPS time of week of the first epoch [s],
+	 * or negative for the toe of the first navigation message.
+	 */
+	double start;
+
+	/**
+	 * Number of threads, or 0 for the number of processors.
+	 */
+	unsigned int threads;
+};
+
+typedef struct dopmap_config dopmap_config;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,417 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+// For clock_gettime()
+#define _POSIX_C_SOURCE 200809L
+
+// EXIT_SUCCESS, EXIT_FAILURE
+#include <stdlib.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+// libgrease, gut_*
+#include "grease/gut_argparser.h"
+
+// liblatitude, lat_*
+#include "latitude/lat_ellipsoid.h"
+
+// libmaid, MAID_*
+#include "maid/maid_angleconv.h"
+
+// librrnx, rrnx_*
+#include "rrnx/rrnx.h"
+#include "rrnx/rrnx_ephtable.h"
+
+// libcoregps, cgps_*
+#include "coregps/cgps_orbit.h"
+
+// libgsim
+#include "gsim/gsim_navconv.h"
+#include "gsim/gsim_dopmap.h"
+
+// The application-specific configuration
+#include "dopmap_config.h"
+// The command-line parser
+#include "argparser.h"
+
+/**
+ * Semi-major axis [m]
+ * (WGS84, p 3-2, eq 3-1)
+ */
+#define WGS84_A 6378137.0
+
+/**
+ * Flattening [1]
+ * (WGS84, p 3-2, eq 3-2)
+ */
+#define WGS84_F (1.0 / 298.257223563)
+
+/**
+ * Navigation messages of the satellites, and the message of each
+ * satellite currently in the orbit batch.
+ */
+struct ephemerides {
+	/** Navigation messages, sorted by the satellite and the toe. */
+	rrnx_ephtable *table;
+	rrnx_et_cursor cursor;
+
+	/**
+	 * The messages of the table converted, in the same order.
+	 * Those failing the conversion have usable[j] = 0.
+	 */
+	cgps_navmsg *msgs;
+	char *usable;
+	size_t unusable;
+
+	/** Largest PRN number of the usable messages. */
+	int max_sat_id;
+
+	/** Index of the message of each element of the batch. */
+	long *index;
+
+	/** The indices found by update_batch(), before the update. */
+	long *found;
+
+	cgps_orbit_batch *batch;
+};
+
+static double seconds_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/**
+ * Build the table, and convert its messages.
+ * Returns error code of rrnx.
+ */
+static int init_ephemerides(struct ephemerides *eph, const rrnx_file_nav *nav) {
+	int err = rrnx_et_build(nav, &eph->table);
+	if (err != RRNX_E_OK) {
+		return err;
+	}
+	rrnx_et_cursor_init(&eph->cursor, eph->table);
+
+	size_t count = eph->table->count;
+	size_t n = (count > 0) ? count : 1;
+	eph->msgs = malloc(n * sizeof(cgps_navmsg));
+	eph->usable = malloc(n);
+	if ((eph->msgs == NULL) || (eph->usable == NULL)) {
+		return RRNX_E_NOMEM;
+	}
+
+	eph->unusable = 0;
+	eph->max_sat_id = 0;
+	for (size_t j = 0; j < count; j++) {
+		int rc = gsim_navconv_msg(&eph->table->navmsgs[j], &eph->msgs[j]);
+		eph->usable[j] = (rc == GSIM_NAVCONV_E_OK);
+		if (!eph->usable[j]) {
+			eph->unusable++;
+		} else if (eph->msgs[j].sat_id > eph->max_sat_id) {
+			eph->max_sat_id = eph->msgs[j].sat_id;
+		}
+	}
+
+	// The satellites are sized by the data, not by a fixed PRN range.
+	size_t sats = (eph->max_sat_id > 0) ? eph->max_sat_id : 1;
+	eph->index = malloc(sats * sizeof(long));
+	eph->found = malloc(sats * sizeof(long));
+	eph->batch = cgps_orbit_batch_alloc(sats);
+	if ((eph->index == NULL) || (eph->found == NULL) || (eph->batch == NULL)) {
+		return RRNX_E_NOMEM;
+	}
+
+	return RRNX_E_OK;
+}
+
+static void free_ephemerides(struct ephemerides *eph) {
+	cgps_orbit_batch_free(eph->batch);
+	free(eph->found);
+	free(eph->index);
+	free(eph->usable);
+	free(eph->msgs);
+	rrnx_et_free(eph->table);
+}
+
+/**
+ * Put every satellite with a healthy message valid at (week, tow)
+ * into the batch. The batch is rebuilt only when the set of the
+ * satellites changes; otherwise the messages are updated in place.
+ */
+static void update_batch(struct ephemerides *eph, int week, double tow) {
+	long *index = eph->found;
+	size_t sats = 0;
+
+	for (int sat_id = 1; sat_id <= eph->max_sat_id; sat_id++) {
+		long j = rrnx_et_cursor_find(&eph->cursor, sat_id, week, tow);
+		if ((j >= 0) && eph->usable[j]) {
+			index[sats++] = j;
+		}
+	}
+
+	int same = (sats == eph->batch->count);
+	for (size_t k = 0; same && (k < sats); k++) {
+		same = (eph->msgs[index[k]].sat_id == eph->batch->sat_id[k]);
+	}
+
+	if (!same) {
+		cgps_orbit_batch_clear(eph->batch);
+		for (size_t k = 0; k < sats; k++) {
+			cgps_orbit_batch_add(eph->batch, &eph->msgs[index[k]]);
+		}
+	} else {
+		for (size_t k = 0; k < sats; k++) {
+			if (index[k] != eph->index[k]) {
+				cgps_orbit_batch_set(eph->batch, k, &eph->msgs[index[k]]);
+			}
+		}
+	}
+
+	for (size_t k = 0; k < sats; k++) {
+		eph->index[k] = index[k];
+	}
+}
+
+/**
+ * Time of the earliest toe of the table.
+ */
+static void first_toe(const rrnx_ephtable *table, int *week, double *tow) {
+	double first = table->toe[0];
+	for (size_t j = 1; j < table->count; j++) {
+		if (table->toe[j] < first) {
+			first = table->toe[j];
+		}
+	}
+	*week = (int) floor(first / CGPS_SECONDS_IN_WEEK);
+	*tow = first - *week * CGPS_SECONDS_IN_WEEK;
+}
+
+static int generate_map(const dopmap_config *config) {
+	int rval = EXIT_FAILURE;
+
+	rrnx_file_nav *nav = NULL;
+	struct ephemerides eph;
+	cgps_satstate *state = NULL;
+	gsim_dopmap *map = NULL;
+	FILE *fp = NULL;
+
+	eph.table = NULL;
+	eph.msgs = NULL;
+	eph.usable = NULL;
+	eph.batch = NULL;
+	eph.index = NULL;
+	eph.found = NULL;
+
+	do {
+		int err = rrnx_read_navfile(config->navfile, &nav);
+		if (err != RRNX_E_OK) {
+			fprintf(stderr, "%s: cannot read the navigation file (error %d)\n",
+			    config->navfile, err);
+			break;
+		}
+
+		err = init_ephemerides(&eph, nav);
+		if (err != RRNX_E_OK) {
+			fprintf(stderr, "Out of memory\n");
+			break;
+		}
+		if (eph.table->count == eph.unusable) {
+			fprintf(stderr, "%s: no usable navigation messages\n",
+			    config->navfile);
+			break;
+		}
+		if (eph.unusable > 0) {
+			printf("Records left out: %zu\n", eph.unusable);
+		}
+
+		int week;
+		double tow;
+		first_toe(eph.table, &week, &tow);
+		if (config->start >= 0.0) {
+			tow = config->start;
+		}
+
+		state = cgps_satstate_alloc(eph.max_sat_id);
+		if (state == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			break;
+		}
+
+		// Global grid; longitudes wrap around, latitudes include the poles.
+		lat_ellipsoid ellipsoid;
+		lat_ellipsoid_set_af(&ellipsoid, WGS84_A, WGS84_F);
+
+		gsim_dopmap_grid grid;
+		grid.lon0 = MAID_DEG2RAD(-180.0);
+		grid.lat0 = MAID_DEG2RAD(-90.0);
+		grid.lon_step = MAID_DEG2RAD(config->step);
+		grid.lat_step = MAID_DEG2RAD(config->step);
+		grid.lon_count = (size_t) floor(360.0 / config->step + 0.5);
+		grid.lat_count = (size_t) floor(180.0 / config->step + 0.5) + 1;
+		grid.height = config->height;
+
+		map = gsim_dopmap_alloc(&ellipsoid, &grid, config->threads);
+		if (map == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			break;
+		}
+		gsim_dopmap_set_mask(map, MAID_DEG2RAD(config->mask));
+
+		fp = fopen(config->outfile, "wb");
+		if (fp == NULL) {
+			fprintf(stderr, "%s: %s\n", config->outfile, strerror(errno));
+			break;
+		}
+
+		printf("Grid:           %zu x %zu points\n",
+		    grid.lon_count, grid.lat_count);
+		printf("Epochs:         %u x %u s\n",
+		    config->epochs, config->interval);
+		printf("Threads:        %d\n", map->num_threads);
+		printf("Recording to file %s\n", config->outfile);
+
+		if (gsim_dopmap_write_header(map, fp, config->epochs) != 0) {
+			fprintf(stderr, "%s: write failed\n", config->outfile);
+			break;
+		}
+
+		double secs = 0.0;
+		size_t min_sats = eph.max_sat_id;
+		size_t max_sats = 0;
+		unsigned int i;
+		for (i = 0; i < config->epochs; i++) {
+			update_batch(&eph, week, tow);
+			cgps_orbit_propagate(eph.batch, tow, state);
+
+			size_t sats = eph.batch->count;
+			if (sats < min_sats) min_sats = sats;
+			if (sats > max_sats) max_sats = sats;
+
+			double start = seconds_now();
+			gsim_dopmap_compute(map, state, sats);
+			secs += seconds_now() - start;
+
+			if (gsim_dopmap_write_epoch(map, fp, week, tow) != 0) {
+				fprintf(stderr, "%s: write failed\n", config->outfile);
+				break;
+			}
+
+			tow += config->interval;
+			if (tow >= CGPS_SECONDS_IN_WEEK) {
+				tow -= CGPS_SECONDS_IN_WEEK;
+				week++;
+			}
+		}
+		if (i < config->epochs) break;
+
+		if (fclose(fp) != 0) {
+			fp = NULL;
+			fprintf(stderr, "%s: %s\n", config->outfile, strerror(errno));
+			break;
+		}
+		fp = NULL;
+
+		printf("Satellites:     %zu to %zu\n", min_sats, max_sats);
+
+		double points = (double) map->points * config->epochs;
+		printf("DOP time:       %.3f s (%.1f ns/point)\n",
+		    secs, (secs > 0.0) ? 1.0e9 * secs / points : 0.0);
+
+		rval = EXIT_SUCCESS;
+	} while(0);
+
+	if (fp != NULL) {
+		fclose(fp);
+	}
+	gsim_dopmap_free(map);
+	cgps_satstate_free(state);
+	free_ephemerides(&eph);
+	rrnx_free_navfile(nav);
+
+	return rval;
+}
+
+int main(int argc, char *argv[]) {
+
+	// Configuration object
+	dopmap_config config;
+
+	config.navfile = NULL;
+	config.outfile = NULL;
+	// Default grid: 1 degree at the ellipsoid surface
+	config.step = 1.0;
+	config.height = 0.0;
+	config.mask = 5.0;
+	// Default epochs: a day at 1 min
+	config.interval = 60;
+	config.epochs = 24*60;
+	config.start = -1.0;
+	config.threads = 0;
+
+	gut_argparser *parser = NULL;
+
+	// Instantiate a parser
+	parser = gut_argparser_create();
+	if (parser == NULL) {
+		printf("gut_argparser_create() failed: out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	argparser_parse(parser, argc, argv, &config);
+
+	int err = parser->err;
+	if (err) {
+		printf("%s\n", parser->errmsg);
+	}
+
+	// Deallocate the parser
+	gut_argparser_free(parser);
+
+	if (err) {
+		exit(EXIT_FAILURE);
+	}
+
+	// Validate input data
+	if ((config.navfile == NULL) || (config.outfile == NULL)) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    dopmap <navfile> -o <outfile> [-step <deg>] [-height <m>]\n");
+		printf("        [-mask <deg>] [-interval <s>] [-epochs <n>]\n");
+		printf("        [-start <tow>] [-threads <n>]\n");
+		printf("\n");
+		exit(EXIT_FAILURE);
+	}
+	if ((config.step <= 0.0) || (config.step > 90.0)) {
+		printf("Error: grid spacing must be within 0..90 degrees\n");
+		exit(EXIT_FAILURE);
+	}
+	if ((config.mask < -90.0) || (config.mask > 90.0)) {
+		printf("Error: elevation mask must be within -90..90 degrees\n");
+		exit(EXIT_FAILURE);
+	}
+	if (config.start >= CGPS_SECONDS_IN_WEEK) {
+		printf("Error: start time must be within the week\n");
+		exit(EXIT_FAILURE);
+	}
+
+	exit(generate_map(&config));
+}
@@ -0,0 +1,215 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Dilution of precision over a grid of receivers.
+ *
+ * The receivers are on a regular longitude-latitude grid at a constant
+ * height above the ellipsoid. For every epoch, the satellite states are
+ * computed once by the caller, and the DOP values of all points are
+ * computed from them. The grid is split into chunks of consecutive
+ * points of a row, which are handed out to a pool of threads. The pool
+ * lives from gsim_dopmap_alloc() to gsim_dopmap_free(), so that no
+ * threads are created per epoch. Within a chunk, the loops run over
+ * the points, so that each satellite is accumulated into the normal
+ * matrices of the chunk at once, without branches. The normal matrices are 4x4 (east, north,
+ * up, clock), and their inverses are obtained via Cholesky factors.
+ *
+ * Binary grid file (host byte order, no padding):
+ *
+ *     char[8]     "GSIMDOP1"
+ *     int32       lon_count, lat_count, epochs, reserved (0)
+ *     double      lon0, lat0, lon_step, lat_step [rad], height [m],
+ *                 elevation mask [rad]
+ *
+ * followed by the epochs:
+ *
+ *     int32       week, reserved (0)
+ *     double      time of week [s]
+ *     float[n]    GDOP, PDOP, HDOP, VDOP (n = lon_count * lat_count each)
+ *     uint8[n]    number of satellites above the mask
+ *
+ * The points are row by row: point (i, j) is at lat0 + i*lat_step,
+ * lon0 + j*lon_step, and its index is i*lon_count + j.
+ */
+
+#ifndef GSIM_DOPMAP_H
+#define GSIM_DOPMAP_H
+
+#include "coregps/cgps_orbit.h"
+#include "latitude/lat_ellipsoid.h"
+
+#include <stdio.h> // FILE
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/** Identifier at the beginning of the binary grid file. */
+#define GSIM_DOPMAP_MAGIC "GSIMDOP1"
+
+/**
+ * DOP value of a point which has less than four satellites above
+ * the mask, or whose geometry is singular.
+ */
+#define GSIM_DOPMAP_NONE -1.0f
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+/**
+ * Receiver grid. Angles in radians.
+ */
+struct gsim_dopmap_grid {
+	/** Longitude and latitude of the first point. */
+	double lon0;
+	double lat0;
+
+	/** Spacing of the columns and the rows. */
+	double lon_step;
+	double lat_step;
+
+	/** Number of columns and rows. */
+	size_t lon_count;
+	size_t lat_count;
+
+	/** Height above the ellipsoid [m]. */
+	double height;
+};
+
+typedef struct gsim_dopmap_grid gsim_dopmap_grid;
+
+/**
+ * DOP values of the grid at a single epoch.
+ */
+struct gsim_dopmap {
+	gsim_dopmap_grid grid;
+
+	/** Number of points, lon_count * lat_count. */
+	size_t points;
+
+	/** Elevation mask [rad], and its sine. */
+	double mask;
+	double sin_mask;
+
+	/** Number of threads computing, including the calling thread. */
+	int num_threads;
+
+	/** Worker threads. Internal. */
+	struct gsim_dopmap_pool *pool;
+
+	// RECEIVERS
+	//===========
+
+	/** ECEF positions of the points. */
+	double *x;
+	double *y;
+	double *z;
+
+	/** Sines and cosines of the longitudes (columns). */
+	double *sin_lon;
+	double *cos_lon;
+
+	/** Sines and cosines of the latitudes (rows). */
+	double *sin_lat;
+	double *cos_lat;
+
+	// RESULTS
+	//=========
+
+	/** DOP values of the points, or GSIM_DOPMAP_NONE. */
+	float *gdop;
+	float *pdop;
+	float *hdop;
+	float *vdop;
+
+	/** Number of satellites above the mask at the points. */
+	unsigned char *visible;
+};
+
+typedef struct gsim_dopmap gsim_dopmap;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+/**
+ * Allocate a map for the grid, and compute the ECEF positions of the
+ * points with lat_ellipsoid_geo2xyz(). If num_threads <= 0, the number
+ * of processors is used. The calling thread of gsim_dopmap_compute()
+ * is one of them; the others are started here, and they wait for the
+ * epochs until gsim_dopmap_free(). The elevation mask is initially zero.
+ * Returns NULL if out of memory, or if the grid is empty.
+ */
+gsim_dopmap *gsim_dopmap_alloc(
+    const lat_ellipsoid *ellipsoid,
+    const gsim_dopmap_grid *grid,
+    int num_threads
+);
+
+void gsim_dopmap_free(gsim_dopmap *map);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Set the elevation mask [rad].
+ */
+void gsim_dopmap_set_mask(gsim_dopmap *map, double mask);
+
+/**
+ * Compute the DOP values of every point from the positions of the
+ * satellites 0 .. count-1 of the state. At most 255 satellites are
+ * counted into the visible counts. A map is computed by one thread
+ * at a time.
+ */
+void gsim_dopmap_compute(
+    gsim_dopmap *map,
+    const cgps_satstate *sats,
+    size_t count
+);
+
+/**
+ * Write the header of the binary grid file.
+ * Returns 0 on success, or -1 if writing fails.
+ */
+int gsim_dopmap_write_header(const gsim_dopmap *map, FILE *fp, int epochs);
+
+/**
+ * Write the current DOP values as an epoch of the binary grid file.
+ * Returns 0 on success, or -1 if writing fails.
+ */
+int gsim_dopmap_write_epoch(
+    const gsim_dopmap *map,
+    FILE *fp,
+    int week,
+    double tow
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
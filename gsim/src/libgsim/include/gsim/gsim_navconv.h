@@ -0,0 +1,155 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Conversion of RINEX navigation messages (rrnx) into GPS navigation
+ * messages (coregps).
+ *
+ * rrnx_navmsg keeps every broadcast orbit field as a double, exactly as
+ * it appears in the file. cgps_navmsg has the integer fields of the
+ * subframes, and the time of clock as a GPS time of week. The fields
+ * are checked for integrality and range while they are converted;
+ * a record failing a check is left out of the result.
+ */
+
+#ifndef GSIM_NAVCONV_H
+#define GSIM_NAVCONV_H
+
+#include "coregps/cgps.h"
+#include "rrnx/rrnx_basetypes_nav.h"
+#include "rrnx/rrnx_file_nav.h"
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// ERROR CODES
+//============================================================================
+
+/** No error. */
+#define GSIM_NAVCONV_E_OK               0
+
+/** PRN number out of range. */
+#define GSIM_NAVCONV_E_SV_ID            1
+
+/** Time of clock is not a valid date and time. */
+#define GSIM_NAVCONV_E_TOC              2
+
+/** IODE is not an integer within 0-255. */
+#define GSIM_NAVCONV_E_IODE             3
+
+/** IODC is not an integer within 0-1023. */
+#define GSIM_NAVCONV_E_IODC             4
+
+/** Week of toe is not a non-negative integer. */
+#define GSIM_NAVCONV_E_TOE_WEEK         5
+
+/** toe is not within the week. */
+#define GSIM_NAVCONV_E_TOE              6
+
+/** Codes on L2 is not an integer within 0-3. */
+#define GSIM_NAVCONV_E_L2_CODES         7
+
+/** L2 P data flag is not 0 or 1. */
+#define GSIM_NAVCONV_E_L2P_DATAFLAG     8
+
+/** SV health is not an integer within 0-63. */
+#define GSIM_NAVCONV_E_HEALTH           9
+
+/** SV accuracy is negative or not a number. */
+#define GSIM_NAVCONV_E_ACCURACY         10
+
+/** Transmission time is not within a week from the toe week. */
+#define GSIM_NAVCONV_E_TOW              11
+
+/** Eccentricity or the semi-major axis out of range. */
+#define GSIM_NAVCONV_E_ORBIT            12
+
+/** Time of clock is more than half a week from the toe. */
+#define GSIM_NAVCONV_E_TOC_WEEK         13
+
+/** Number of the error codes. */
+#define GSIM_NAVCONV_E_COUNT            14
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+/**
+ * Results of gsim_navconv_file().
+ */
+struct gsim_navconv_stats {
+	/** Number of records in the file. */
+	size_t input;
+
+	/** Number of records converted. */
+	size_t converted;
+
+	/** Number of records left out, by the error code. */
+	size_t rejected[GSIM_NAVCONV_E_COUNT];
+
+	/**
+	 * Index (in the file) of the first record left out,
+	 * or -1 if none. Its error code is first_error.
+	 */
+	long first_index;
+	int first_error;
+};
+
+typedef struct gsim_navconv_stats gsim_navconv_stats;
+
+//============================================================================
+// METHODS
+//============================================================================
+
+/**
+ * Convert a single navigation message. The toc is taken to be in GPS
+ * time, as in RINEX; its week is not stored, since cgps_navmsg has
+ * room for the week of the toe only. The toc must be within half a
+ * week from the toe, which allows the two to fall on either side of
+ * a week boundary. The accuracy in meters is turned
+ * into the URA index. Returns GSIM_NAVCONV_E_OK on success, or the
+ * code of the first failed check, in which case dest is undefined.
+ */
+int gsim_navconv_msg(const rrnx_navmsg *src, cgps_navmsg *dest);
+
+/**
+ * Convert all navigation messages of the file, in the file order,
+ * into a single array allocated with malloc(). The number of messages
+ * in the array is stats->converted. The records failing a check are
+ * counted in stats, and left out. Returns NULL if out of memory,
+ * or if there are no messages to return.
+ */
+cgps_navmsg *gsim_navconv_file(
+    const rrnx_file_nav *nav,
+    gsim_navconv_stats *stats
+);
+
+/**
+ * Human-readable description of the error code.
+ */
+const char *gsim_navconv_strerror(int err);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
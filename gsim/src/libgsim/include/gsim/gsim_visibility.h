@@ -0,0 +1,135 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+/*
+ * Satellite visibility from a receiver.
+ *
+ * For a receiver position and its local frame, the satellites above the
+ * elevation mask are selected, and their azimuths, elevations, ranges
+ * and lines of sight are computed. The satellites are first culled by
+ * comparing the dot product of the line of sight and the up vector with
+ * the range in a loop over the whole constellation, which has neither
+ * branches nor trigonometry. The remaining work is done for the visible
+ * satellites only.
+ *
+ * gsim_dopmap does not use this: it loops over the points of the grid
+ * for each satellite, which is the loop that vectorizes there, and it
+ * needs no angles. The tool vischeck checks and measures this engine.
+ */
+
+#ifndef GSIM_VISIBILITY_H
+#define GSIM_VISIBILITY_H
+
+#include "coregps/cgps_orbit.h"
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+/**
+ * Visible satellites of an epoch.
+ */
+struct gsim_visibility {
+	/** Largest number of satellites per epoch. */
+	size_t capacity;
+
+	/** Elevation mask [rad], and its sine. */
+	double mask;
+	double sin_mask;
+
+	// VISIBLE SATELLITES
+	//====================
+
+	/** Number of visible satellites. */
+	size_t count;
+
+	/** Index of the satellite in the satellite state. */
+	size_t *index;
+
+	/** Azimuth [rad], clockwise from the north, within [0, 2 pi). */
+	double *azimuth;
+
+	/** Elevation [rad]. */
+	double *elevation;
+
+	/** Geometric range [m]. */
+	double *range;
+
+	/** Unit vector from the receiver to the satellite (ECEF). */
+	double *los_x;
+	double *los_y;
+	double *los_z;
+
+	// SCRATCH
+	//=========
+
+	/** Up component and the squared length of the receiver-satellite vector. */
+	double *up;
+	double *range2;
+};
+
+typedef struct gsim_visibility gsim_visibility;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+/**
+ * Allocate for at most capacity satellites per epoch.
+ * The elevation mask is initially zero. Returns NULL if out of memory.
+ */
+gsim_visibility *gsim_vis_alloc(size_t capacity);
+
+void gsim_vis_free(gsim_visibility *vis);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Set the elevation mask [rad].
+ */
+void gsim_vis_set_mask(gsim_visibility *vis, double mask);
+
+/**
+ * Select the satellites 0 .. count-1 of the state which are visible
+ * from the receiver at xyz (ECEF), and compute their directions.
+ * The local frame is that of lat_ellipsoid_localframe_at(): the
+ * columns of the row-major 3x3 matrix are the east, north and up unit
+ * vectors. At most vis->capacity satellites are considered.
+ * Returns the number of visible satellites, also in vis->count.
+ */
+size_t gsim_vis_compute(
+    gsim_visibility *vis,
+    const double *xyz,
+    const double *local,
+    const cgps_satstate *sats,
+    size_t count
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,568 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+// For sysconf()
+#define _POSIX_C_SOURCE 200809L
+
+#include "gsim/gsim_dopmap.h"
+
+#include <stdlib.h> // malloc, calloc, free
+#include <string.h> // memset
+#include <stdint.h> // int32_t
+#include <math.h> // sin, cos, sqrt
+#include <pthread.h>
+#include <unistd.h> // sysconf
+
+//--- internal constants ---------------------------------------------------//
+
+/** Number of distinct elements in the symmetric 4x4 normal matrix. */
+#define NORMAL_ELEMENTS 10
+
+/**
+ * Number of points whose normal matrices are accumulated together.
+ * The accumulators of a chunk stay in the L1 cache.
+ */
+#define CHUNK 64
+
+/**
+ * Relative size of the smallest accepted Cholesky pivot.
+ * Smaller pivots are taken as a singular geometry.
+ */
+#define MIN_PIVOT 1.0e-12
+
+//--- internal data types --------------------------------------------------//
+
+/**
+ * Worker threads, kept from gsim_dopmap_alloc() to gsim_dopmap_free().
+ * The thread calling gsim_dopmap_compute() works with them.
+ */
+struct gsim_dopmap_pool {
+	pthread_t *threads;
+	int num_started;
+
+	pthread_mutex_t lock;
+
+	/** Signaled when an epoch is started, or when quitting. */
+	pthread_cond_t start;
+
+	/** Signaled when the last worker has finished an epoch. */
+	pthread_cond_t done;
+
+	/** Incremented for every epoch; a worker waits for a new one. */
+	unsigned long generation;
+
+	/** Number of workers still on the current epoch. */
+	int active;
+
+	/** Set by gsim_dopmap_free(). */
+	int quit;
+
+	// THE CURRENT EPOCH
+	//===================
+
+	const cgps_satstate *sats;
+	size_t count;
+
+	/** Index of the next chunk to compute. */
+	size_t next;
+};
+
+//--- internal helpers -----------------------------------------------------//
+
+/**
+ * Accumulates a satellite at (sx, sy, sz) into the normal matrices
+ * H^T H of m <= CHUNK points. The rows of H are the unit vectors to the
+ * satellites in the local frame (east, north, up) and 1 for the clock.
+ * The unit vectors point to the satellites rather than from them; this
+ * changes the signs of the clock terms, but not the diagonal of the
+ * inverse. A satellite below the mask has weight 0, so that the loop
+ * has no branches, and it is vectorized over the points.
+ */
+static void accumulate_satellite(
+    size_t m,
+    double sx,
+    double sy,
+    double sz,
+    const double *restrict x,
+    const double *restrict y,
+    const double *restrict z,
+    const double *restrict sin_lon,
+    const double *restrict cos_lon,
+    double sin_lat,
+    double cos_lat,
+    double sin_mask,
+    double normal[NORMAL_ELEMENTS][CHUNK]
+) {
+	for (size_t j = 0; j < m; j++) {
+		double dx = sx - x[j];
+		double dy = sy - y[j];
+		double dz = sz - z[j];
+
+		// Rotate into the local frame of lat_ellipsoid_localframe_at()
+		double h = cos_lon[j]*dx + sin_lon[j]*dy;
+		double de = cos_lon[j]*dy - sin_lon[j]*dx;
+		double dn = cos_lat*dz - sin_lat*h;
+		double du = cos_lat*h + sin_lat*dz;
+
+		double r = sqrt(dx*dx + dy*dy + dz*dz);
+		double v = (du >= sin_mask*r) ? 1.0 : 0.0;
+		double w = v / r;
+
+		double ge = de*w;
+		double gn = dn*w;
+		double gu = du*w;
+
+		normal[0][j] += ge*ge;
+		normal[1][j] += ge*gn;
+		normal[2][j] += ge*gu;
+		normal[3][j] += ge;
+		normal[4][j] += gn*gn;
+		normal[5][j] += gn*gu;
+		normal[6][j] += gn;
+		normal[7][j] += gu*gu;
+		normal[8][j] += gu;
+		normal[9][j] += v;
+	}
+}
+
+/**
+ * Computes the diagonal of the inverse of the symmetric 4x4 matrix m
+ * via its Cholesky factor L: the inverse is L^-T L^-1, and its diagonal
+ * element i is the sum of the squares of the column i of L^-1.
+ * Returns 0 if m is not positive definite.
+ */
+static int inverse_diagonal(double m[4][4], double q[4]) {
+	double L[4][4] = {{0.0}};
+	double M[4][4] = {{0.0}};
+
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j <= i; j++) {
+			double sum = m[i][j];
+			for (int k = 0; k < j; k++) {
+				sum -= L[i][k] * L[j][k];
+			}
+			if (i == j) {
+				if (sum <= MIN_PIVOT * m[i][i]) {
+					// Singular
+					return 0;
+				}
+				L[i][i] = sqrt(sum);
+			} else {
+				L[i][j] = sum / L[j][j];
+			}
+		}
+	}
+
+	// M = L^-1, lower triangular
+	for (int i = 0; i < 4; i++) {
+		M[i][i] = 1.0 / L[i][i];
+		for (int j = 0; j < i; j++) {
+			double sum = 0.0;
+			for (int k = j; k < i; k++) {
+				sum += L[i][k] * M[k][j];
+			}
+			M[i][j] = -sum * M[i][i];
+		}
+	}
+
+	for (int i = 0; i < 4; i++) {
+		q[i] = 0.0;
+		for (int k = i; k < 4; k++) {
+			q[i] += M[k][i] * M[k][i];
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Computes the DOP values of the points first .. first+m-1 of a row.
+ */
+static void compute_chunk(
+    gsim_dopmap *map,
+    size_t row,
+    size_t first,
+    size_t m,
+    const cgps_satstate *sats,
+    size_t count
+) {
+	double normal[NORMAL_ELEMENTS][CHUNK];
+	size_t offset = row * map->grid.lon_count + first;
+
+	memset(normal, 0, sizeof(normal));
+
+	for (size_t s = 0; s < count; s++) {
+		accumulate_satellite(m, sats->x[s], sats->y[s], sats->z[s],
+		    &map->x[offset], &map->y[offset], &map->z[offset],
+		    &map->sin_lon[first], &map->cos_lon[first],
+		    map->sin_lat[row], map->cos_lat[row], map->sin_mask,
+		    normal);
+	}
+
+	for (size_t j = 0; j < m; j++) {
+		double a[4][4] = {
+			{ normal[0][j], normal[1][j], normal[2][j], normal[3][j] },
+			{ normal[1][j], normal[4][j], normal[5][j], normal[6][j] },
+			{ normal[2][j], normal[5][j], normal[7][j], normal[8][j] },
+			{ normal[3][j], normal[6][j], normal[8][j], normal[9][j] }
+		};
+		double visible = a[3][3];
+		double q[4];
+
+		size_t i = offset + j;
+		map->visible[i] = (visible < 255.0) ? (unsigned char) visible : 255;
+
+		if ((visible < 4.0) || !inverse_diagonal(a, q)) {
+			map->gdop[i] = GSIM_DOPMAP_NONE;
+			map->pdop[i] = GSIM_DOPMAP_NONE;
+			map->hdop[i] = GSIM_DOPMAP_NONE;
+			map->vdop[i] = GSIM_DOPMAP_NONE;
+			continue;
+		}
+
+		double h2 = q[0] + q[1];
+		double p2 = h2 + q[2];
+		map->gdop[i] = (float) sqrt(p2 + q[3]);
+		map->pdop[i] = (float) sqrt(p2);
+		map->hdop[i] = (float) sqrt(h2);
+		map->vdop[i] = (float) sqrt(q[2]);
+	}
+}
+
+/**
+ * Number of chunks in a row.
+ */
+static size_t row_chunks(const gsim_dopmap *map) {
+	return (map->grid.lon_count + CHUNK - 1) / CHUNK;
+}
+
+/**
+ * Takes and computes the chunks of the current epoch until none is
+ * left. The chunks are numbered row by row.
+ */
+static void compute_chunks(gsim_dopmap *map) {
+	struct gsim_dopmap_pool *pool = map->pool;
+	size_t n = map->grid.lon_count;
+	size_t per_row = row_chunks(map);
+	size_t chunks = per_row * map->grid.lat_count;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		size_t c = pool->next;
+		if (c < chunks) {
+			pool->next++;
+		}
+		pthread_mutex_unlock(&pool->lock);
+
+		if (c >= chunks) {
+			// No more chunks
+			break;
+		}
+
+		size_t row = c / per_row;
+		size_t first = (c % per_row) * CHUNK;
+		size_t m = (n - first < CHUNK) ? n - first : CHUNK;
+		compute_chunk(map, row, first, m, pool->sats, pool->count);
+	}
+}
+
+static void *dopmap_worker(void *arg) {
+	gsim_dopmap *map = arg;
+	struct gsim_dopmap_pool *pool = map->pool;
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->quit && (pool->generation == seen)) {
+			pthread_cond_wait(&pool->start, &pool->lock);
+		}
+		if (pool->quit) {
+			break;
+		}
+		seen = pool->generation;
+		pthread_mutex_unlock(&pool->lock);
+
+		compute_chunks(map);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->active--;
+		if (pool->active == 0) {
+			pthread_cond_signal(&pool->done);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/**
+ * Starts num_threads-1 workers; the calling thread is the last one.
+ * Returns 0 if out of memory. Fewer workers are kept, if some cannot
+ * be started.
+ */
+static int start_pool(gsim_dopmap *map) {
+	struct gsim_dopmap_pool *pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		return 0;
+	}
+
+	int workers = map->num_threads - 1;
+	if (workers > 0) {
+		pool->threads = calloc(workers, sizeof(pthread_t));
+		if (pool->threads == NULL) {
+			free(pool);
+			return 0;
+		}
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	map->pool = pool;
+
+	for (int t = 0; t < workers; t++) {
+		if (pthread_create(&pool->threads[t], NULL,
+		    dopmap_worker, map) != 0)
+		{
+			break;
+		}
+		pool->num_started++;
+	}
+	map->num_threads = pool->num_started + 1;
+
+	return 1;
+}
+
+static void stop_pool(gsim_dopmap *map) {
+	struct gsim_dopmap_pool *pool = map->pool;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (int t = 0; t < pool->num_started; t++) {
+		pthread_join(pool->threads[t], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->start);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool);
+	map->pool = NULL;
+}
+
+static int write_all(const void *ptr, size_t size, size_t count, FILE *fp) {
+	return (fwrite(ptr, size, count, fp) == count) ? 0 : -1;
+}
+
+//--- external methods -----------------------------------------------------//
+
+gsim_dopmap *gsim_dopmap_alloc(
+    const lat_ellipsoid *ellipsoid,
+    const gsim_dopmap_grid *grid,
+    int num_threads
+) {
+	if ((grid->lon_count == 0) || (grid->lat_count == 0)) {
+		// Empty grid
+		return NULL;
+	}
+
+	if (num_threads <= 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cpus > 0) ? (int) cpus : 1;
+	}
+	size_t chunks = grid->lat_count
+	    * ((grid->lon_count + CHUNK - 1) / CHUNK);
+	if ((size_t) num_threads > chunks) {
+		num_threads = (int) chunks;
+	}
+
+	gsim_dopmap *map = calloc(1, sizeof(gsim_dopmap));
+	if (map == NULL) {
+		return NULL;
+	}
+
+	map->grid = *grid;
+	map->points = grid->lon_count * grid->lat_count;
+	map->num_threads = num_threads;
+	gsim_dopmap_set_mask(map, 0.0);
+
+	size_t points = map->points;
+	size_t lon_count = grid->lon_count;
+	size_t lat_count = grid->lat_count;
+
+	int complete = 0;
+	do {
+		map->x = malloc(3 * points * sizeof(double));
+		map->sin_lon = malloc(2 * (lon_count+lat_count) * sizeof(double));
+		map->gdop = malloc(4 * points * sizeof(float));
+		map->visible = malloc(points);
+
+		if ((map->x == NULL) || (map->sin_lon == NULL)
+		    || (map->gdop == NULL) || (map->visible == NULL))
+		{
+			break;
+		}
+
+		map->y = &map->x[points];
+		map->z = &map->x[2 * points];
+		map->cos_lon = &map->sin_lon[lon_count];
+		map->sin_lat = &map->sin_lon[2 * lon_count];
+		map->cos_lat = &map->sin_lat[lat_count];
+		map->pdop = &map->gdop[points];
+		map->hdop = &map->gdop[2 * points];
+		map->vdop = &map->gdop[3 * points];
+
+		for (size_t j = 0; j < lon_count; j++) {
+			double lon = grid->lon0 + j * grid->lon_step;
+			map->sin_lon[j] = sin(lon);
+			map->cos_lon[j] = cos(lon);
+		}
+
+		for (size_t i = 0; i < lat_count; i++) {
+			double lat = grid->lat0 + i * grid->lat_step;
+			map->sin_lat[i] = sin(lat);
+			map->cos_lat[i] = cos(lat);
+
+			for (size_t j = 0; j < lon_count; j++) {
+				double geo[3];
+				double xyz[3];
+				geo[0] = grid->lon0 + j * grid->lon_step;
+				geo[1] = lat;
+				geo[2] = grid->height;
+				lat_ellipsoid_geo2xyz(ellipsoid, geo, xyz);
+
+				size_t k = i*lon_count + j;
+				map->x[k] = xyz[0];
+				map->y[k] = xyz[1];
+				map->z[k] = xyz[2];
+			}
+		}
+
+		if (!start_pool(map)) {
+			break;
+		}
+
+		complete = 1;
+	} while(0);
+
+	if (!complete) {
+		gsim_dopmap_free(map);
+		map = NULL;
+	}
+
+	return map;
+}
+
+void gsim_dopmap_free(gsim_dopmap *map) {
+	if (map == NULL) {
+		// Already freed
+		return;
+	}
+
+	if (map->pool != NULL) {
+		stop_pool(map);
+	}
+
+	// The arrays share the blocks of the first ones.
+	free(map->x);
+	free(map->sin_lon);
+	free(map->gdop);
+	free(map->visible);
+
+	free(map);
+}
+
+void gsim_dopmap_set_mask(gsim_dopmap *map, double mask) {
+	map->mask = mask;
+	map->sin_mask = sin(mask);
+}
+
+void gsim_dopmap_compute(
+    gsim_dopmap *map,
+    const cgps_satstate *sats,
+    size_t count
+) {
+	struct gsim_dopmap_pool *pool = map->pool;
+
+	// Start the epoch, and take part in it.
+	pthread_mutex_lock(&pool->lock);
+	pool->sats = sats;
+	pool->count = count;
+	pool->next = 0;
+	pool->active = pool->num_started;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+
+	compute_chunks(map);
+
+	// The workers may still be on their last chunks.
+	pthread_mutex_lock(&pool->lock);
+	while (pool->active > 0) {
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+int gsim_dopmap_write_header(const gsim_dopmap *map, FILE *fp, int epochs) {
+	const gsim_dopmap_grid *grid = &map->grid;
+	int32_t counts[4];
+	double params[6];
+
+	counts[0] = (int32_t) grid->lon_count;
+	counts[1] = (int32_t) grid->lat_count;
+	counts[2] = (int32_t) epochs;
+	counts[3] = 0;
+
+	params[0] = grid->lon0;
+	params[1] = grid->lat0;
+	params[2] = grid->lon_step;
+	params[3] = grid->lat_step;
+	params[4] = grid->height;
+	params[5] = map->mask;
+
+	if (write_all(GSIM_DOPMAP_MAGIC, 1, 8, fp) != 0) return -1;
+	if (write_all(counts, sizeof(int32_t), 4, fp) != 0) return -1;
+	if (write_all(params, sizeof(double), 6, fp) != 0) return -1;
+
+	return 0;
+}
+
+int gsim_dopmap_write_epoch(
+    const gsim_dopmap *map,
+    FILE *fp,
+    int week,
+    double tow
+) {
+	int32_t header[2];
+	header[0] = (int32_t) week;
+	header[1] = 0;
+
+	if (write_all(header, sizeof(int32_t), 2, fp) != 0) return -1;
+	if (write_all(&tow, sizeof(double), 1, fp) != 0) return -1;
+	// The four DOP arrays are consecutive.
+	if (write_all(map->gdop, sizeof(float), 4 * map->points, fp) != 0) {
+		return -1;
+	}
+	if (write_all(map->visible, 1, map->points, fp) != 0) return -1;
+
+	return 0;
+}
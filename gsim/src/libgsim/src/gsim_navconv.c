@@ -0,0 +1,271 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#include "gsim/gsim_navconv.h"
+#include "sundial/sundial.h"
+#include "rrnx/rrnx_list.h"
+
+#include <stdlib.h> // malloc
+#include <string.h> // memset
+#include <math.h> // floor, fabs
+
+//--- internal constants ---------------------------------------------------//
+
+#define SECONDS_IN_WEEK ((double) SUN_SECONDS_IN_WEEK)
+
+/** Largest accepted PRN number. */
+#define MAX_SV_ID 63
+
+/** Largest accepted GPS week number. */
+#define MAX_WEEK 0xffff
+
+/**
+ * Upper bounds [m] of the URA indices 0-14 (IS-GPS-200, 20.3.3.3.1.3).
+ * Accuracies above the last one map to the index 15.
+ */
+static const double URA_BOUNDS[15] = {
+	2.40, 3.40, 4.85, 6.85, 9.65, 13.65, 24.0, 48.0,
+	96.0, 192.0, 384.0, 768.0, 1536.0, 3072.0, 6144.0
+};
+
+static const char *ERROR_STRINGS[GSIM_NAVCONV_E_COUNT] = {
+	"No error",
+	"PRN number out of range",
+	"Invalid time of clock",
+	"IODE is not an integer within 0-255",
+	"IODC is not an integer within 0-1023",
+	"Week of toe is not a non-negative integer",
+	"toe is not within the week",
+	"Codes on L2 is not an integer within 0-3",
+	"L2 P data flag is not 0 or 1",
+	"SV health is not an integer within 0-63",
+	"Invalid SV accuracy",
+	"Transmission time is not within a week from the toe week",
+	"Eccentricity or semi-major axis out of range",
+	"Time of clock is more than half a week from the toe"
+};
+
+//--- internal helpers -----------------------------------------------------//
+
+/**
+ * Converts value into an integer, if it is one within [min, max].
+ * Returns 1 on success, and 0 otherwise (also for NaN).
+ */
+static int to_int(double value, int min, int max, int *result) {
+	if (!((value >= min) && (value <= max))) {
+		return 0;
+	}
+	int i = (int) value;
+	if ((double) i != value) {
+		return 0;
+	}
+	*result = i;
+	return 1;
+}
+
+static int ura_index(double accuracy) {
+	int n = 0;
+	while ((n < 15) && (accuracy > URA_BOUNDS[n])) {
+		n++;
+	}
+	return n;
+}
+
+/**
+ * Converts the RINEX epoch (GPS time) into the GPS time of week.
+ * Two-digit years are those of RINEX 2: 80-99 are 1980-1999,
+ * and 00-79 are 2000-2079. Returns 0 if the epoch is invalid.
+ */
+static int toc2gpstime(const rrnx_datetime *t, int *week, double *tow) {
+	if ((t->month < 1) || (t->month > 12)
+	    || (t->day < 1) || (t->day > 31)
+	    || (t->hour < 0) || (t->hour > 23)
+	    || (t->min < 0) || (t->min > 59)
+	    || !((t->sec >= 0.0) && (t->sec < 61.0)))
+	{
+		return 0;
+	}
+
+	sun_datetime dt;
+	dt.year = t->year;
+	if (dt.year < 80) {
+		dt.year += 2000;
+	} else if (dt.year < 100) {
+		dt.year += 1900;
+	}
+	dt.month = t->month;
+	dt.day = t->day;
+	dt.hour = t->hour;
+	dt.min = t->min;
+	dt.sec = (int) floor(t->sec);
+	dt.subsec = t->sec - dt.sec;
+
+	if (dt.year < 1980) {
+		// Before the GPS time epoch
+		return 0;
+	}
+
+	sun_datetime2gpstime(&dt, week, tow);
+
+	return 1;
+}
+
+//--- external methods -----------------------------------------------------//
+
+int gsim_navconv_msg(const rrnx_navmsg *src, cgps_navmsg *dest) {
+	cgps_ephemeris *eph = &dest->eph;
+	cgps_clock *clock = &dest->clock;
+
+	if ((src->sv_id < 1) || (src->sv_id > MAX_SV_ID)) {
+		return GSIM_NAVCONV_E_SV_ID;
+	}
+	dest->sat_id = src->sv_id;
+
+	int toc_week;
+	if (!toc2gpstime(&src->toc, &toc_week, &clock->toc)) {
+		return GSIM_NAVCONV_E_TOC;
+	}
+
+	if (!to_int(src->IODE, 0, 255, &eph->IODE)) {
+		return GSIM_NAVCONV_E_IODE;
+	}
+	if (!to_int(src->IODC, 0, 1023, &clock->IODC)) {
+		return GSIM_NAVCONV_E_IODC;
+	}
+	if (!to_int(src->toe_week, 0, MAX_WEEK, &dest->week)) {
+		return GSIM_NAVCONV_E_TOE_WEEK;
+	}
+	if (!((src->toe >= 0.0) && (src->toe < SECONDS_IN_WEEK))) {
+		return GSIM_NAVCONV_E_TOE;
+	}
+
+	// The toc and the toe may be in different weeks only when they
+	// are near the boundary, so compare them across the weeks.
+	double toc_from_toe = (toc_week - dest->week) * SECONDS_IN_WEEK
+	    + (clock->toc - src->toe);
+	if (!(fabs(toc_from_toe) <= 0.5 * SECONDS_IN_WEEK)) {
+		return GSIM_NAVCONV_E_TOC_WEEK;
+	}
+	if (!to_int(src->L2_codes, 0, 3, &dest->L2_codes)) {
+		return GSIM_NAVCONV_E_L2_CODES;
+	}
+	if (!to_int(src->L2P_dataflag, 0, 1, &dest->L2P_dataflag)) {
+		return GSIM_NAVCONV_E_L2P_DATAFLAG;
+	}
+	if (!to_int(src->health, 0, 63, &dest->health)) {
+		return GSIM_NAVCONV_E_HEALTH;
+	}
+	if (!(src->accuracy >= 0.0)) {
+		return GSIM_NAVCONV_E_ACCURACY;
+	}
+	dest->ura_index = ura_index(src->accuracy);
+
+	// RINEX allows the transmission time to be adjusted by -604800 s
+	// to refer to the week of toe.
+	if (!((src->tow >= -SECONDS_IN_WEEK) && (src->tow < SECONDS_IN_WEEK))) {
+		return GSIM_NAVCONV_E_TOW;
+	}
+	dest->tow = src->tow;
+
+	if (!((src->e >= 0.0) && (src->e < 1.0) && (src->sqrtA > 0.0))) {
+		return GSIM_NAVCONV_E_ORBIT;
+	}
+
+	dest->tgd = src->Tgd;
+
+	// The fit interval is in hours; zero or blank means four hours.
+	dest->fit_interval = 0;
+	if (src->valid_fit_interval && (src->fit_interval > 4.0)) {
+		dest->fit_interval = 1;
+	}
+
+	clock->af0 = src->af0;
+	clock->af1 = src->af1;
+	clock->af2 = src->valid_af2 ? src->af2 : 0.0;
+
+	eph->toe = src->toe;
+	eph->e = src->e;
+	eph->sqrtA = src->sqrtA;
+	eph->M0 = src->M0;
+	eph->OMEGA0 = src->OMEGA0;
+	eph->i0 = src->i0;
+	eph->w = src->w;
+	eph->delta_n = src->delta_n;
+	eph->OMEGADOT = src->OMEGADOT;
+	eph->idot = src->idot;
+	eph->Crc = src->Crc;
+	eph->Crs = src->Crs;
+	eph->Cuc = src->Cuc;
+	eph->Cus = src->Cus;
+	eph->Cic = src->Cic;
+	eph->Cis = src->Cis;
+
+	return GSIM_NAVCONV_E_OK;
+}
+
+cgps_navmsg *gsim_navconv_file(
+    const rrnx_file_nav *nav,
+    gsim_navconv_stats *stats
+) {
+	memset(stats, 0, sizeof(gsim_navconv_stats));
+	stats->first_index = -1;
+	stats->first_error = GSIM_NAVCONV_E_OK;
+
+	const rrnx_list_item *item;
+	for (item = nav->navmsg_list->first; item != NULL; item = item->next) {
+		stats->input++;
+	}
+	if (stats->input == 0) {
+		return NULL;
+	}
+
+	cgps_navmsg *navmsgs = malloc(stats->input * sizeof(cgps_navmsg));
+	if (navmsgs == NULL) {
+		return NULL;
+	}
+
+	size_t index = 0;
+	for (item = nav->navmsg_list->first; item != NULL; item = item->next) {
+		cgps_navmsg *dest = &navmsgs[stats->converted];
+		int err = gsim_navconv_msg(item->data, dest);
+		if (err == GSIM_NAVCONV_E_OK) {
+			stats->converted++;
+		} else {
+			stats->rejected[err]++;
+			if (stats->first_index < 0) {
+				stats->first_index = (long) index;
+				stats->first_error = err;
+			}
+		}
+		index++;
+	}
+
+	if (stats->converted == 0) {
+		free(navmsgs);
+		return NULL;
+	}
+
+	return navmsgs;
+}
+
+const char *gsim_navconv_strerror(int err) {
+	if ((err < 0) || (err >= GSIM_NAVCONV_E_COUNT)) {
+		return "Unknown error";
+	}
+	return ERROR_STRINGS[err];
+}
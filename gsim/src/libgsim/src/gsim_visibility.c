@@ -0,0 +1,184 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+
+#include "gsim/gsim_visibility.h"
+
+#include <stdlib.h> // malloc, free
+#include <math.h> // sin, sqrt, atan2
+
+//--- internal constants ---------------------------------------------------//
+
+/** Number of double arrays in gsim_visibility. */
+#define ARRAYS 8
+
+#define TWO_PI 6.283185307179586
+
+//--- internal helpers -----------------------------------------------------//
+
+/**
+ * Computes the up component and the squared length of the vector from
+ * the receiver (rx, up vector u) to each satellite. There are no
+ * branches, so that the loop is vectorized.
+ */
+static void project_up(
+    size_t count,
+    const double *restrict x,
+    const double *restrict y,
+    const double *restrict z,
+    const double rx[3],
+    const double u[3],
+    double *restrict up,
+    double *restrict range2
+) {
+	double rx0 = rx[0], rx1 = rx[1], rx2 = rx[2];
+	double u0 = u[0], u1 = u[1], u2 = u[2];
+
+	for (size_t i = 0; i < count; i++) {
+		double dx = x[i] - rx0;
+		double dy = y[i] - rx1;
+		double dz = z[i] - rx2;
+		up[i] = dx*u0 + dy*u1 + dz*u2;
+		range2[i] = dx*dx + dy*dy + dz*dz;
+	}
+}
+
+/**
+ * Tells whether the elevation is at or above the mask:
+ * up >= |d| sin(mask), tested without the square root.
+ */
+static int above_mask(double up, double range2, double sin_mask) {
+	double limit2 = range2 * sin_mask * sin_mask;
+	if (sin_mask >= 0.0) {
+		return (up >= 0.0) && (up*up >= limit2);
+	}
+	return (up >= 0.0) || (up*up <= limit2);
+}
+
+//--- external methods -----------------------------------------------------//
+
+gsim_visibility *gsim_vis_alloc(size_t capacity) {
+	gsim_visibility *vis = NULL;
+	size_t n = (capacity > 0) ? capacity : 1;
+
+	int complete = 0;
+	do {
+		vis = malloc(sizeof(gsim_visibility));
+		if (vis == NULL) break;
+
+		vis->capacity = capacity;
+		vis->count = 0;
+		vis->azimuth = NULL;
+		gsim_vis_set_mask(vis, 0.0);
+
+		vis->index = malloc(n * sizeof(size_t));
+		if (vis->index == NULL) break;
+
+		// The arrays share a block
+		double *block = malloc(ARRAYS * n * sizeof(double));
+		if (block == NULL) break;
+
+		double **arrays[ARRAYS] = {
+			&vis->azimuth, &vis->elevation, &vis->range,
+			&vis->los_x, &vis->los_y, &vis->los_z,
+			&vis->up, &vis->range2
+		};
+		for (int j = 0; j < ARRAYS; j++) {
+			*arrays[j] = &block[j * n];
+		}
+
+		complete = 1;
+	} while(0);
+
+	if ((complete == 0) && (vis != NULL)) {
+		free(vis->index);
+		free(vis);
+		vis = NULL;
+	}
+
+	return vis;
+}
+
+void gsim_vis_free(gsim_visibility *vis) {
+	if (vis == NULL) {
+		// Already freed
+		return;
+	}
+	free(vis->index);
+	// The arrays share the block of the first one.
+	free(vis->azimuth);
+	free(vis);
+}
+
+void gsim_vis_set_mask(gsim_visibility *vis, double mask) {
+	vis->mask = mask;
+	vis->sin_mask = sin(mask);
+}
+
+size_t gsim_vis_compute(
+    gsim_visibility *vis,
+    const double *xyz,
+    const double *local,
+    const cgps_satstate *sats,
+    size_t count
+) {
+	if (count > vis->capacity) {
+		count = vis->capacity;
+	}
+
+	// East, north and up are the columns of the local frame.
+	double e[3] = { local[0*3+0], local[1*3+0], local[2*3+0] };
+	double n[3] = { local[0*3+1], local[1*3+1], local[2*3+1] };
+	double u[3] = { local[0*3+2], local[1*3+2], local[2*3+2] };
+
+	project_up(count, sats->x, sats->y, sats->z, xyz, u,
+	    vis->up, vis->range2);
+
+	// Compact the visible ones
+	size_t visible = 0;
+	for (size_t i = 0; i < count; i++) {
+		vis->index[visible] = i;
+		visible += above_mask(vis->up[i], vis->range2[i], vis->sin_mask);
+	}
+
+	for (size_t k = 0; k < visible; k++) {
+		size_t i = vis->index[k];
+		double dx = sats->x[i] - xyz[0];
+		double dy = sats->y[i] - xyz[1];
+		double dz = sats->z[i] - xyz[2];
+
+		double range = sqrt(vis->range2[i]);
+		double east = dx*e[0] + dy*e[1] + dz*e[2];
+		double north = dx*n[0] + dy*n[1] + dz*n[2];
+		double up = vis->up[i];
+
+		double azimuth = atan2(east, north);
+		if (azimuth < 0.0) {
+			azimuth += TWO_PI;
+		}
+
+		vis->azimuth[k] = azimuth;
+		vis->elevation[k] = atan2(up, sqrt(east*east + north*north));
+		vis->range[k] = range;
+		vis->los_x[k] = dx / range;
+		vis->los_y[k] = dy / range;
+		vis->los_z[k] = dz / range;
+	}
+
+	vis->count = visible;
+	return visible;
+}
@@ -0,0 +1,414 @@
+//******************************{begin:header}******************************//
+//               gsim - GPS/INS measurement simulation system               //
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+/*
+ * Checks gsim_visibility against a direct azimuth and elevation
+ * computation, and measures it.
+ *
+ * The satellites are placed at known directions from receivers on the
+ * equator, at a middle latitude, and at both poles: at the zenith, on
+ * either side of the horizon and of the mask, and in between. The
+ * selection must follow the directions exactly, and the azimuths and
+ * the elevations must agree with the reference within 1e-9 rad.
+ * The benchmark compares the engine with computing the direction of
+ * every satellite before applying the mask.
+ */
+
+// For clock_gettime()
+#define _POSIX_C_SOURCE 200809L
+
+// EXIT_SUCCESS, EXIT_FAILURE
+#include <stdlib.h>
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+// liblatitude, lat_*
+#include "latitude/lat_ellipsoid.h"
+
+// libcoregps, cgps_*
+#include "coregps/cgps_orbit.h"
+
+// libgsim
+#include "gsim/gsim_visibility.h"
+
+#define WGS84_A 6378137.0
+#define WGS84_F (1.0 / 298.257223563)
+
+/** Distance of the satellites from the receiver [m]. */
+#define SAT_RANGE 20200.0e3
+
+/** Radius of the GPS orbits [m]. */
+#define ORBIT_RADIUS 26560.0e3
+
+/** Distance of the satellites from the horizon or the mask [rad]. */
+#define EDGE 1.0e-6
+
+/** Largest accepted error of the angles [rad]. */
+#define TOLERANCE 1.0e-9
+
+#define DEG (CGPS_PI / 180.0)
+
+#define MAX_CASES 16
+
+/**
+ * A receiver, with its position and local frame.
+ */
+struct receiver {
+	const char *name;
+	double xyz[3];
+	double local[9];
+};
+
+/**
+ * Direction of a satellite [rad], and whether it is visible.
+ */
+struct direction {
+	double azimuth;
+	double elevation;
+	int visible;
+};
+
+static double seconds_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void make_receiver(
+    struct receiver *rx,
+    const lat_ellipsoid *ellipsoid,
+    const char *name,
+    double lon,
+    double lat,
+    double height
+) {
+	double geo[3] = { lon, lat, height };
+	rx->name = name;
+	lat_ellipsoid_geo2xyz(ellipsoid, geo, rx->xyz);
+	lat_ellipsoid_localframe_at(ellipsoid, geo, rx->local);
+}
+
+/**
+ * Places the satellite s at the direction (azimuth, elevation)
+ * from the receiver.
+ */
+static void place_sat(
+    cgps_satstate *sats,
+    size_t s,
+    const struct receiver *rx,
+    double azimuth,
+    double elevation
+) {
+	// East, north and up in the local frame
+	double enu[3] = {
+		cos(elevation) * sin(azimuth),
+		cos(elevation) * cos(azimuth),
+		sin(elevation)
+	};
+	double d[3];
+	for (int r = 0; r < 3; r++) {
+		d[r] = 0.0;
+		for (int c = 0; c < 3; c++) {
+			d[r] += rx->local[r*3+c] * enu[c];
+		}
+	}
+	sats->x[s] = rx->xyz[0] + SAT_RANGE * d[0];
+	sats->y[s] = rx->xyz[1] + SAT_RANGE * d[1];
+	sats->z[s] = rx->xyz[2] + SAT_RANGE * d[2];
+}
+
+/**
+ * The reference: the direction of the satellite s from the receiver
+ * by rotating into the local frame, with asin() for the elevation.
+ */
+static void reference(
+    const cgps_satstate *sats,
+    size_t s,
+    const struct receiver *rx,
+    double *azimuth,
+    double *elevation
+) {
+	double d[3] = {
+		sats->x[s] - rx->xyz[0],
+		sats->y[s] - rx->xyz[1],
+		sats->z[s] - rx->xyz[2]
+	};
+	double enu[3] = { 0.0, 0.0, 0.0 };
+	for (int c = 0; c < 3; c++) {
+		for (int r = 0; r < 3; r++) {
+			enu[c] += rx->local[r*3+c] * d[r];
+		}
+	}
+	double range = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+	// Rounding may take the sine just over 1 at the zenith.
+	*elevation = asin(fmin(fmax(enu[2] / range, -1.0), 1.0));
+	*azimuth = atan2(enu[0], enu[1]);
+	if (*azimuth < 0.0) {
+		*azimuth += 2.0 * CGPS_PI;
+	}
+}
+
+static double angle_error(double a, double b) {
+	double e = fabs(a - b);
+	// The azimuth wraps around
+	return fmin(e, 2.0 * CGPS_PI - e);
+}
+
+/**
+ * Checks the cases with the mask from the receiver. Returns the number
+ * of failures, and updates the largest angle error.
+ */
+static int check_cases(
+    gsim_visibility *vis,
+    cgps_satstate *sats,
+    const struct receiver *rx,
+    double mask,
+    const struct direction *cases,
+    size_t count,
+    double *max_error
+) {
+	int failures = 0;
+
+	gsim_vis_set_mask(vis, mask);
+	for (size_t s = 0; s < count; s++) {
+		place_sat(sats, s, rx, cases[s].azimuth, cases[s].elevation);
+	}
+
+	size_t n = gsim_vis_compute(vis, rx->xyz, rx->local, sats, count);
+
+	size_t k = 0;
+	for (size_t s = 0; s < count; s++) {
+		int selected = (k < n) && (vis->index[k] == s);
+		if (selected != cases[s].visible) {
+			printf("%s, mask %.1f deg: satellite at %.6f deg is %s\n",
+			    rx->name, mask / DEG, cases[s].elevation / DEG,
+			    selected ? "selected" : "not selected");
+			failures++;
+		}
+		if (!selected) {
+			continue;
+		}
+
+		double az, el;
+		reference(sats, s, rx, &az, &el);
+		double e = angle_error(el, vis->elevation[k]);
+		// The azimuth of the zenith is undefined
+		if (cos(el) > 1.0e-6) {
+			e = fmax(e, angle_error(az, vis->azimuth[k]));
+		}
+		double e_range = fabs(vis->range[k] - SAT_RANGE) / SAT_RANGE;
+		if (!(e <= TOLERANCE) || !(e_range <= TOLERANCE)) {
+			printf("%s, mask %.1f deg: satellite at %.6f deg is off "
+			    "by %.2g rad\n", rx->name, mask / DEG,
+			    cases[s].elevation / DEG, e);
+			failures++;
+		}
+		if (e > *max_error) *max_error = e;
+		k++;
+	}
+
+	return failures;
+}
+
+/**
+ * Checks every receiver with a positive, a zero and a negative mask.
+ */
+static int check_receivers(
+    gsim_visibility *vis,
+    cgps_satstate *sats,
+    const struct receiver *receivers,
+    int count
+) {
+	const double masks[3] = { 10.0 * DEG, 0.0, -5.0 * DEG };
+	int failures = 0;
+
+	for (int r = 0; r < count; r++) {
+		double max_error = 0.0;
+		for (int m = 0; m < 3; m++) {
+			double mask = masks[m];
+			struct direction cases[MAX_CASES];
+			size_t n = 0;
+
+			// The zenith, and all around the horizon
+			cases[n++] = (struct direction) { 0.0, 90.0 * DEG, 1 };
+			for (int a = 0; a < 4; a++) {
+				double az = (a * 90.0 + 30.0) * DEG;
+				cases[n++] = (struct direction) {
+				    az, 45.0 * DEG, 1 };
+				cases[n++] = (struct direction) {
+				    az, EDGE, mask <= 0.0 };
+				cases[n++] = (struct direction) {
+				    az, -EDGE, mask < 0.0 };
+			}
+			// Just above and just under the mask
+			cases[n++] = (struct direction) {
+			    200.0 * DEG, mask + EDGE, 1 };
+			cases[n++] = (struct direction) {
+			    200.0 * DEG, mask - EDGE, 0 };
+			// Well under the horizon
+			cases[n++] = (struct direction) {
+			    300.0 * DEG, -60.0 * DEG, 0 };
+
+			failures += check_cases(vis, sats, &receivers[r], mask,
+			    cases, n, &max_error);
+		}
+		printf("%-18s max error %.2g rad\n", receivers[r].name, max_error);
+	}
+
+	return failures;
+}
+
+/**
+ * Satellites at random directions on the orbit radius.
+ */
+static void random_sats(cgps_satstate *sats, size_t count) {
+	for (size_t s = 0; s < count; s++) {
+		double z = 2.0 * rand() / RAND_MAX - 1.0;
+		double phi = 2.0 * CGPS_PI * rand() / RAND_MAX;
+		double rxy = ORBIT_RADIUS * sqrt(1.0 - z*z);
+		sats->x[s] = rxy * cos(phi);
+		sats->y[s] = rxy * sin(phi);
+		sats->z[s] = ORBIT_RADIUS * z;
+	}
+}
+
+/**
+ * The direct way: the direction of every satellite, then the mask.
+ * Returns the number of visible satellites.
+ */
+static size_t direct_compute(
+    const struct receiver *rx,
+    double mask,
+    const cgps_satstate *sats,
+    size_t count,
+    double *azimuth,
+    double *elevation
+) {
+	size_t visible = 0;
+	for (size_t s = 0; s < count; s++) {
+		double az, el;
+		reference(sats, s, rx, &az, &el);
+		if (el >= mask) {
+			azimuth[visible] = az;
+			elevation[visible] = el;
+			visible++;
+		}
+	}
+	return visible;
+}
+
+/**
+ * Time per satellite [s] of the engine and of the direct way, over
+ * the receivers.
+ */
+static void benchmark(
+    gsim_visibility *vis,
+    const cgps_satstate *sats,
+    size_t count,
+    const struct receiver *receivers,
+    int num_receivers,
+    int rounds
+) {
+	double *azimuth = malloc(count * sizeof(double));
+	double *elevation = malloc(count * sizeof(double));
+	if ((azimuth == NULL) || (elevation == NULL)) {
+		printf("Out of memory\n");
+		exit(EXIT_FAILURE);
+	}
+
+	size_t total_engine = 0;
+	size_t total_direct = 0;
+
+	double start = seconds_now();
+	for (int i = 0; i < rounds; i++) {
+		const struct receiver *rx = &receivers[i % num_receivers];
+		total_engine += gsim_vis_compute(vis, rx->xyz, rx->local,
+		    sats, count);
+	}
+	double secs_engine = seconds_now() - start;
+
+	start = seconds_now();
+	for (int i = 0; i < rounds; i++) {
+		const struct receiver *rx = &receivers[i % num_receivers];
+		total_direct += direct_compute(rx, vis->mask, sats, count,
+		    azimuth, elevation);
+	}
+	double secs_direct = seconds_now() - start;
+
+	double per = 1.0e9 / ((double) rounds * count);
+	printf("%5zu satellites:  engine %5.1f ns, direct %5.1f ns "
+	    "per satellite (%.2fx)%s\n", count,
+	    secs_engine * per, secs_direct * per, secs_direct / secs_engine,
+	    (total_engine == total_direct) ? "" : ", counts differ");
+
+	free(azimuth);
+	free(elevation);
+}
+
+int main(void) {
+	lat_ellipsoid ellipsoid;
+	lat_ellipsoid_set_af(&ellipsoid, WGS84_A, WGS84_F);
+
+	struct receiver receivers[4];
+	make_receiver(&receivers[0], &ellipsoid, "Equator", 0.0, 0.0, 0.0);
+	make_receiver(&receivers[1], &ellipsoid, "Middle latitude",
+	    25.0 * DEG, 60.0 * DEG, 150.0);
+	make_receiver(&receivers[2], &ellipsoid, "North pole",
+	    0.0, 90.0 * DEG, 0.0);
+	make_receiver(&receivers[3], &ellipsoid, "South pole",
+	    -120.0 * DEG, -90.0 * DEG, 2800.0);
+
+	const size_t sizes[2] = { 32, 1024 };
+	gsim_visibility *vis = gsim_vis_alloc(sizes[1]);
+	cgps_satstate *sats = cgps_satstate_alloc(sizes[1]);
+	if ((vis == NULL) || (sats == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	int failures = check_receivers(vis, sats, receivers, 4);
+
+	// Receivers all over the globe, and a 10 degree mask
+	struct receiver spread[64];
+	srand(5);
+	for (int r = 0; r < 64; r++) {
+		double lon = (2.0 * rand() / RAND_MAX - 1.0) * CGPS_PI;
+		double lat = asin(2.0 * rand() / RAND_MAX - 1.0);
+		make_receiver(&spread[r], &ellipsoid, "", lon, lat, 0.0);
+	}
+	gsim_vis_set_mask(vis, 10.0 * DEG);
+
+	printf("\n");
+	for (int i = 0; i < 2; i++) {
+		random_sats(sats, sizes[i]);
+		benchmark(vis, sats, sizes[i], spread, 64,
+		    (int) (4000000 / sizes[i]));
+	}
+
+	gsim_vis_free(vis);
+	cgps_satstate_free(sats);
+
+	if (failures > 0) {
+		printf("\n%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("\nAll checks passed\n");
+	return EXIT_SUCCESS;
+}
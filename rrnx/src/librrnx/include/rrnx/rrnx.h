@@ -41,6 +41,22 @@ extern "C" {
 #endif
 
 
+// DATA STRUCTURES
+//=================
+
+/**
+ * The result of reading a single file with rrnx_read_navfiles().
+ */
+struct rrnx_navfile_result {
+	/** Error code, or RRNX_E_OK. */
+	int err;
+
+	/** Error message with the line of the error, or empty. */
+	char errmsg[RRNX_DEFAULT_ERRMSG_SIZE];
+};
+
+typedef struct rrnx_navfile_result rrnx_navfile_result;
+
 // OTHER METHODS
 //===============
 
@@ -50,6 +66,36 @@ extern "C" {
  */
 int rrnx_read_navfile(const char *filename, rrnx_file_nav **nav);
 
+/**
+ * Read a NAV file like rrnx_read_navfile(). On failure, the error
+ * message of the reader is copied into errmsg, which has room for
+ * size chars (or is NULL). It is emptied on success.
+ * Returns error code.
+ */
+int rrnx_read_navfile_errmsg(
+    const char *filename,
+    rrnx_file_nav **nav,
+    char *errmsg,
+    size_t size
+);
+
+/**
+ * Read several NAV files using a pool of worker threads, and merge
+ * them into a single NAV file in the order of the filenames.
+ * When num_threads <= 0, one thread per processor is used.
+ *
+ * A file that fails is skipped, and its error code and message are
+ * written into results, which has room for count results (or is NULL).
+ * Returns error code of the merge.
+ */
+int rrnx_read_navfiles(
+    const char *const *filenames,
+    int count,
+    int num_threads,
+    rrnx_file_nav **nav,
+    rrnx_navfile_result *results
+);
+
 /**
  * Allocate and initialize a NAV file object.
  * Provided for convenience.
@@ -0,0 +1,90 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#ifndef RRNX_ARENA_H
+#define RRNX_ARENA_H
+
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/**
+ * Default size of a single arena block (bytes).
+ */
+#define RRNX_ARENA_BLOCK_SIZE 0x10000
+
+/**
+ * Alignment of the allocations (bytes).
+ */
+#define RRNX_ARENA_ALIGNMENT 16
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+struct rrnx_arena_block;
+
+/**
+ * Bump allocator. Allocations cannot be freed individually;
+ * all of them are released at once when the arena is freed.
+ */
+struct rrnx_arena {
+	/** Current block, where the allocations are made, or NULL. */
+	struct rrnx_arena_block *head;
+
+	/** Number of bytes allocated by the users. */
+	size_t used;
+
+	/** Number of bytes reserved from the heap. */
+	size_t reserved;
+};
+
+typedef struct rrnx_arena rrnx_arena;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+rrnx_arena *rrnx_arena_alloc(void);
+void rrnx_arena_free(rrnx_arena *arena);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Allocate memory from the arena. Returns NULL if out of memory.
+ */
+void *rrnx_arena_malloc(rrnx_arena *arena, size_t size);
+
+/**
+ * Move all blocks of the source arena into the destination arena.
+ * The source arena is left empty, but it still needs to be freed.
+ */
+void rrnx_arena_adopt(rrnx_arena *dest, rrnx_arena *src);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
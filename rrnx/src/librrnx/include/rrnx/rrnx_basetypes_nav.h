@@ -54,6 +54,12 @@ struct rrnx_navmsg {
 	 */
 	int valid_fit_interval;
 
+	/**
+	 * Indicates whether another record has the same key, but differs
+	 * in the other fields. Set by rrnx_fnav_dedup().
+	 */
+	int conflict;
+
 	// PAYLOAD DATA
 	//==============
 
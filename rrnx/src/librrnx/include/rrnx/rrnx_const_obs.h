@@ -52,7 +52,7 @@ extern "C" {
  *
  * GPS and Glonass: P code.
  */
-#define RRNX_OBS_PSEUDORANGE_P                  0x0001
+#define RRNX_OBS_PSEUDORANGE_P                  0x0010
 
 /**
  * Carrier phase in full cycles (observation code 'L').
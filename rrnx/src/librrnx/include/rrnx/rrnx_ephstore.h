@@ -0,0 +1,246 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+/*
+ * Binary ephemeris store.
+ *
+ * File layout (native byte order):
+ *
+ *     rrnx_es_header    header
+ *     rrnx_es_record    records[count]
+ *     rrnx_es_key       keys[count]
+ *
+ * The records are sorted by (PRN, toe week, toe), and keys[i] is the
+ * key of records[i]. Lookups binary search the compact key array and
+ * touch only the records they return, so the store can be queried
+ * straight from the mapping without deserializing it.
+ */
+
+#ifndef RRNX_EPHSTORE_H
+#define RRNX_EPHSTORE_H
+
+#include <stddef.h> // size_t
+#include <stdint.h> // uint32_t, uint64_t, int32_t
+
+// rrnx_navmsg
+#include "rrnx_basetypes_nav.h"
+// rrnx_file_nav
+#include "rrnx_file_nav.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/** File magic, including the terminating nul. */
+#define RRNX_ES_MAGIC "RRNXEPH"
+
+/** Current version of the file layout. */
+#define RRNX_ES_VERSION 1
+
+/** Byte order marker; reads differently on a foreign byte order. */
+#define RRNX_ES_BYTE_ORDER 0x01020304
+
+/** Bits of rrnx_es_record.flags; mirror the valid_* of rrnx_navmsg. */
+#define RRNX_ES_VALID_AF2           0x01
+#define RRNX_ES_VALID_SPARE1        0x02
+#define RRNX_ES_VALID_SPARE2        0x04
+#define RRNX_ES_VALID_FIT_INTERVAL  0x08
+
+//============================================================================
+// DATA STRUCTURES: FILE LAYOUT
+//============================================================================
+
+/**
+ * File header (64 bytes).
+ */
+struct rrnx_es_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t header_size;
+	uint32_t record_size;
+	uint32_t key_size;
+	uint32_t reserved;
+	uint64_t count;
+	uint64_t records_offset;
+	uint64_t keys_offset;
+	uint64_t file_size;
+};
+
+typedef struct rrnx_es_header rrnx_es_header;
+
+/**
+ * Fixed-size navigation message record (272 bytes).
+ * The fields are those of rrnx_navmsg, without padding.
+ */
+struct rrnx_es_record {
+	int32_t sv_id;
+	int32_t flags;
+	int32_t toc_year;
+	int32_t toc_month;
+	int32_t toc_day;
+	int32_t toc_hour;
+	int32_t toc_min;
+	int32_t reserved;
+	double toc_sec;
+
+	double af0;
+	double af1;
+	double af2;
+
+	double IODE;
+	double Crs;
+	double delta_n;
+	double M0;
+
+	double Cuc;
+	double e;
+	double Cus;
+	double sqrtA;
+
+	double toe;
+	double Cic;
+	double OMEGA0;
+	double Cis;
+
+	double i0;
+	double Crc;
+	double w;
+	double OMEGADOT;
+
+	double idot;
+	double L2_codes;
+	double toe_week;
+	double L2P_dataflag;
+
+	double accuracy;
+	double health;
+	double Tgd;
+	double IODC;
+
+	double tow;
+	double fit_interval;
+	double spare1;
+	double spare2;
+};
+
+typedef struct rrnx_es_record rrnx_es_record;
+
+/**
+ * Index key of a record (16 bytes).
+ */
+struct rrnx_es_key {
+	int32_t sv_id;
+	int32_t week;
+	double toe;
+};
+
+typedef struct rrnx_es_key rrnx_es_key;
+
+//============================================================================
+// DATA STRUCTURES: READER
+//============================================================================
+
+/**
+ * Memory-mapped ephemeris store.
+ */
+struct rrnx_ephstore {
+	/** The mapping and its size. */
+	void *map;
+	size_t map_size;
+
+	/** Views into the mapping. */
+	const rrnx_es_header *header;
+	const rrnx_es_record *records;
+	const rrnx_es_key *keys;
+
+	/** Number of records. */
+	size_t count;
+};
+
+typedef struct rrnx_ephstore rrnx_ephstore;
+
+//============================================================================
+// METHODS
+//============================================================================
+
+/**
+ * Write the navigation messages of a NAV file into a store.
+ * Returns error code; RRNX_E_SYSCALL leaves errno set.
+ */
+int rrnx_es_write(const char *filename, const rrnx_file_nav *nav);
+
+/**
+ * Map a store into memory, and validate its header.
+ * Returns error code; RRNX_E_FORMAT if the file is not a store
+ * of this version and byte order.
+ */
+int rrnx_es_open(const char *filename, rrnx_ephstore **store);
+
+/**
+ * Unmap and free a store.
+ */
+void rrnx_es_close(rrnx_ephstore *store);
+
+/**
+ * Index of the first record whose key is not less than
+ * (sv_id, week, toe), or store->count if there is none.
+ */
+size_t rrnx_es_lower_bound(
+    const rrnx_ephstore *store,
+    int sv_id,
+    int week,
+    double toe
+);
+
+/**
+ * Index of the record with exactly the key (sv_id, week, toe),
+ * or -1 if there is none.
+ */
+long rrnx_es_find(
+    const rrnx_ephstore *store,
+    int sv_id,
+    int week,
+    double toe
+);
+
+/**
+ * Index of the latest record of the satellite whose toe is
+ * not later than (week, tow), or -1 if there is none.
+ */
+long rrnx_es_find_latest(
+    const rrnx_ephstore *store,
+    int sv_id,
+    int week,
+    double tow
+);
+
+/**
+ * Convert between a record and a navigation message.
+ */
+void rrnx_es_to_navmsg(const rrnx_es_record *record, rrnx_navmsg *navmsg);
+void rrnx_es_from_navmsg(rrnx_es_record *record, const rrnx_navmsg *navmsg);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,216 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+/*
+ * Ephemeris table.
+ *
+ * The navigation messages of a NAV file copied into a single array,
+ * sorted by (PRN, toe week, toe). The messages of a satellite are
+ * consecutive, and their index range is looked up directly, so that
+ * the scans and the binary searches over the time of ephemeris touch
+ * only contiguous memory.
+ */
+
+#ifndef RRNX_EPHTABLE_H
+#define RRNX_EPHTABLE_H
+
+#include <stddef.h> // size_t
+
+// rrnx_navmsg
+#include "rrnx_basetypes_nav.h"
+// rrnx_file_nav
+#include "rrnx_file_nav.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/**
+ * The satellites 0 .. RRNX_ET_MAX_SV-1 have their index ranges
+ * in a table. The others are located by a binary search.
+ */
+#define RRNX_ET_MAX_SV 64
+
+/** Seconds in a GPS week. */
+#define RRNX_ET_SECONDS_IN_WEEK 604800.0
+
+/**
+ * Fit interval (hours) of a message which has none, or zero.
+ * Zero in the fit interval flag means four hours (IS-GPS-200).
+ */
+#define RRNX_ET_DEFAULT_FIT_INTERVAL 4.0
+
+//============================================================================
+// DATA STRUCTURES
+//============================================================================
+
+/**
+ * Navigation messages sorted by (sv_id, toe_week, toe). Messages with
+ * the same key retain the order of the NAV file.
+ */
+struct rrnx_ephtable {
+	/** Navigation messages. */
+	rrnx_navmsg *navmsgs;
+
+	/**
+	 * Time of ephemeris of each message, as seconds since the
+	 * beginning of the GPS time (toe_week * 604800 + toe).
+	 */
+	double *toe;
+
+	/** Satellite of each message. */
+	int *sv_id;
+
+	/** Number of messages. */
+	size_t count;
+
+	/**
+	 * Longest fit interval of the messages [s]. Bounds the search
+	 * for the messages whose fit interval covers a given time.
+	 */
+	double max_fit_interval;
+
+	/**
+	 * The messages of the satellite sv are
+	 * navmsgs[first[sv]] .. navmsgs[first[sv+1]-1].
+	 */
+	size_t first[RRNX_ET_MAX_SV+1];
+};
+
+typedef struct rrnx_ephtable rrnx_ephtable;
+
+/**
+ * Cursor for rrnx_et_cursor_find(). Remembers the position of each
+ * satellite, so that the queries at sequential times take constant
+ * time, instead of a binary search.
+ */
+struct rrnx_et_cursor {
+	/** The table searched. */
+	const rrnx_ephtable *table;
+
+	/**
+	 * For each satellite, the index of the first message later
+	 * than the time of the previous query.
+	 */
+	size_t next[RRNX_ET_MAX_SV];
+};
+
+typedef struct rrnx_et_cursor rrnx_et_cursor;
+
+//============================================================================
+// METHODS
+//============================================================================
+
+/**
+ * Build a table of the navigation messages of a NAV file.
+ * The messages are copied; the NAV file may be freed afterwards.
+ * Returns error code.
+ */
+int rrnx_et_build(const rrnx_file_nav *nav, rrnx_ephtable **table);
+
+/**
+ * Free a table.
+ */
+void rrnx_et_free(rrnx_ephtable *table);
+
+/**
+ * Index range [*begin, *end) of the messages of a satellite.
+ * The range is empty if there are none.
+ */
+void rrnx_et_range(
+    const rrnx_ephtable *table,
+    int sv_id,
+    size_t *begin,
+    size_t *end
+);
+
+/**
+ * Index of the first message of the satellite whose time of ephemeris
+ * is not earlier than (week, tow), or the end of its range.
+ */
+size_t rrnx_et_lower_bound(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+);
+
+/**
+ * Index of the latest message of the satellite whose time of ephemeris
+ * is not later than (week, tow), or -1 if there is none. Of the messages
+ * with the same time of ephemeris, the last one is chosen.
+ */
+long rrnx_et_find_latest(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+);
+
+/**
+ * Index of the message of the satellite whose time of ephemeris
+ * is nearest to (week, tow), or -1 if there is none. Ties go to
+ * the earlier message.
+ */
+long rrnx_et_find_nearest(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+);
+
+/**
+ * Index of the best message of the satellite for (week, tow), or -1
+ * if there is none. The best message is a healthy one whose fit interval
+ * covers the time, and whose time of ephemeris is nearest to it.
+ * Of the messages with the same time of ephemeris, the latest issue
+ * (the latest transmission time) is preferred.
+ */
+long rrnx_et_find_best(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+);
+
+/**
+ * Initialize a cursor for the table.
+ */
+void rrnx_et_cursor_init(rrnx_et_cursor *cursor, const rrnx_ephtable *table);
+
+/**
+ * Same as rrnx_et_find_best(), but the search continues from the
+ * previous query of the satellite. When the times of the queries
+ * advance steadily, each query takes amortized constant time.
+ * Queries back in time are allowed, but they take a binary search.
+ */
+long rrnx_et_cursor_find(
+    rrnx_et_cursor *cursor,
+    int sv_id,
+    int week,
+    double tow
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
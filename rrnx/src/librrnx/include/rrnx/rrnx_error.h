@@ -81,6 +81,9 @@ typedef int rrnx_errno;
 /** Parse error: syntax error. */
 #define RRNX_E_SYNTAX         -10
 
+/** Binary file has a wrong format, version or byte order. */
+#define RRNX_E_FORMAT         -11
+
 //============================================================================
 // METHODS
 //============================================================================
@@ -24,6 +24,11 @@
 // rrnx_list
 #include "rrnx_list.h"
 
+// rrnx_string
+#include "rrnx_string.h"
+
+#include <stddef.h> // size_t
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -118,12 +123,40 @@ struct rrnx_file_nav {
 
 	/**
 	 * Navigation message records.
+	 *
+	 * The records and the list items are allocated from the arena of
+	 * the list, and they are released with it; the list has no
+	 * destructor. Add records with rrnx_fnav_append(), which copies
+	 * them into the arena. A record allocated otherwise must not be
+	 * appended to the list directly: it would not be freed.
 	 */
 	rrnx_list *navmsg_list;
 };
 
 typedef struct rrnx_file_nav rrnx_file_nav;
 
+/**
+ * Results of rrnx_fnav_dedup().
+ */
+struct rrnx_fnav_dedup_stats {
+	/** Number of records before the de-duplication. */
+	size_t input;
+
+	/** Number of records kept. */
+	size_t unique;
+
+	/** Number of records removed as exact duplicates. */
+	size_t duplicates;
+
+	/**
+	 * Number of records which have the key of a former record,
+	 * but differ from it in the other fields. They are kept.
+	 */
+	size_t conflicts;
+};
+
+typedef struct rrnx_fnav_dedup_stats rrnx_fnav_dedup_stats;
+
 // CONSTRUCTION & DESTRUCTION
 //============================
 
@@ -133,8 +166,69 @@ void rrnx_fnav_free(rrnx_file_nav *nav);
 // OTHER METHODS
 //===============
 
+/**
+ * Append a copy of the navigation message to the navmsgs. The copy is
+ * allocated from the arena of the list, and the caller keeps the
+ * ownership of navmsg.
+ * Returns error code.
+ */
+int rrnx_fnav_append(rrnx_file_nav *nav, const rrnx_navmsg *navmsg);
+
 rrnx_file_nav *rrnx_fnav_deserialize(const rrnx_list *nodelist);
-//extern rrnx_list *rrnx_fnav_serialize(rrnx_file_nav *nav);
+
+/**
+ * Same as rrnx_fnav_deserialize(), but takes the ownership of the
+ * nodelist, and frees it. If the nodes were allocated from an arena,
+ * the arena is adopted and the records are not copied.
+ */
+rrnx_file_nav *rrnx_fnav_deserialize_owned(rrnx_list *nodelist);
+
+/**
+ * Append the navigation messages of src to dest. The header data is
+ * taken from src when dest has none, and the almanac parameters when
+ * src has them. The navmsgs are moved rather than copied when both
+ * were allocated by rrnx_fnav_alloc(). Either way, src still needs
+ * to be freed.
+ * Returns error code.
+ */
+int rrnx_fnav_merge(rrnx_file_nav *dest, rrnx_file_nav *src);
+
+/**
+ * Remove the duplicate navigation messages, such as the ones which
+ * result from merging the files of several stations. The records are
+ * keyed by (sv_id, toe_week, toe, IODE, IODC). A record is a duplicate
+ * when a former record has the same key and the same values in all
+ * fields except the transmission time, which differs between stations.
+ * The first occurrence is kept, and the order is preserved. Records
+ * which share a key but differ otherwise are kept, and each of them
+ * is flagged with the conflict field of the navmsg. The kept
+ * records are compacted into a new arena, so that the memory of the
+ * duplicates is released. The results are written into stats, if given.
+ * Returns error code. On failure, the navmsgs are left untouched.
+ */
+int rrnx_fnav_dedup(rrnx_file_nav *nav, rrnx_fnav_dedup_stats *stats);
+
+/**
+ * Format the navigation file as RINEX 2.11 text into dest. The string
+ * is enlarged when needed, so that a string reused between the calls
+ * settles to a size, after which no memory is allocated. The number
+ * of chars written, without the terminator, is returned in len,
+ * if given. The output is identical to that of a formatter which
+ * uses snprintf() with "%19.12E" and replaces the 'E' with 'D'.
+ * Returns error code. RRNX_E_OVERFLOW means that a value did not fit
+ * into its field; the string is then left empty.
+ */
+int rrnx_fnav_serialize(
+    const rrnx_file_nav *nav,
+    rrnx_string *dest,
+    size_t *len
+);
+
+/**
+ * Write the navigation file as RINEX 2.11 into a file.
+ * On failure, the file is removed. Returns error code.
+ */
+int rrnx_fnav_write(const rrnx_file_nav *nav, const char *filename);
 
 #ifdef __cplusplus
 } // extern "C"
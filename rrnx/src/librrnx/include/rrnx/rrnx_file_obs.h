@@ -29,6 +29,12 @@
 #ifndef RRNX_OBS_H
 #define RRNX_OBS_H
 
+// rrnx_datetime, rrnx_satellite_id, rrnx_file_format, rrnx_file_info
+#include "rrnx_basetypes_common.h"
+
+// rrnx_list
+#include "rrnx_list.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -87,7 +93,7 @@ typedef struct rrnx_meas_type rrnx_meas_type;
  *
  * GPS and Glonass: P code.
  */
-#define RRNX_OBS_PSEUDORANGE_P                  0x0001
+#define RRNX_OBS_PSEUDORANGE_P                  0x0010
 
 /**
  * Carrier phase in full cycles (observation code 'L').
@@ -301,7 +307,7 @@ struct rrnx_meas_layout {
 	rrnx_meas_type *item;
 };
 
-typedef struct rrnx_observables rrnx_observables;
+typedef struct rrnx_meas_layout rrnx_meas_layout;
 
 /**
  * Observation interval (INTERVAL).
@@ -316,16 +322,35 @@ struct rrnx_meas_interval {
 typedef struct rrnx_meas_interval rrnx_meas_interval;
 
 /**
- * Time of the last observation record (TIME OF FIRST OBS).
+ * Time of the first observation record (TIME OF FIRST OBS).
  */
 struct rrnx_first_meas {
-	// TODO
+	/**
+	 * Time of the first observation (5I6, F13.7).
+	 */
+	rrnx_datetime t;
+
+	/**
+	 * Time system (A3): "GPS", "GLO" or "GAL", or empty.
+	 */
+	char time_system[4];
 };
 
 typedef struct rrnx_first_meas rrnx_first_meas;
 
+/**
+ * Time of the last observation record (TIME OF LAST OBS).
+ */
 struct rrnx_last_meas {
-	// TODO
+	/**
+	 * Time of the last observation (5I6, F13.7).
+	 */
+	rrnx_datetime t;
+
+	/**
+	 * Time system (A3), or empty.
+	 */
+	char time_system[4];
 };
 
 typedef struct rrnx_last_meas rrnx_last_meas;
@@ -468,9 +493,76 @@ typedef struct rrnx_obs_epoch rrnx_obs_epoch;
 
 /* OBS file */
 
+/**
+ * Header of an observation file. The strings are stored trimmed,
+ * and the optional records have has_* indicators.
+ */
 struct rrnx_obs_header {
 
+	// ADMINISTRATIVE DATA
+	//=====================
+
+	int has_marker_xyz;
+	int has_antenna_delta;
+	int has_wavelength_fact;
+	int has_interval;
+	int has_first_meas;
+	int has_last_meas;
+	int has_clock_offset;
+	int has_leap_seconds;
+	int has_satellite_count;
+
+	// PAYLOAD DATA
+	//==============
+
+	rrnx_file_format format;
+
+	rrnx_file_info info;
+
+	/** Name of antenna marker (A60). */
+	char marker_name[61];
+
+	/** Number of antenna marker (A20). */
+	char marker_number[21];
+
+	/** Observer and agency (A20, A40). */
+	char observer[21];
+	char agency[41];
+
+	/** Receiver number, type and version (3A20). */
+	char receiver_number[21];
+	char receiver_type[21];
+	char receiver_version[21];
+
+	/** Antenna number and type (2A20). */
+	char antenna_number[21];
+	char antenna_type[21];
+
+	rrnx_marker_xyz marker_xyz;
+
+	rrnx_antenna_delta antenna_delta;
+
+	rrnx_wavelength_fact wavelength_fact;
+
+	/**
+	 * Observation types in the order of the data records.
+	 * The items are owned by the header.
+	 */
+	rrnx_meas_layout layout;
+
+	rrnx_meas_interval interval;
+
+	rrnx_first_meas first_meas;
+
+	rrnx_last_meas last_meas;
+
+	rrnx_recv_clock_offset clock_offset;
+
+	rrnx_leap_seconds2 leap_seconds;
+
+	rrnx_satellite_count satellite_count;
 };
+
 typedef struct rrnx_obs_header rrnx_obs_header;
 
 struct rrnx_obs {
@@ -480,6 +572,47 @@ struct rrnx_obs {
 
 typedef struct rrnx_obs rrnx_obs;
 
+// HEADER METHODS
+//================
+
+/**
+ * Initialize a header into empty values.
+ */
+void rrnx_fobs_init_header(rrnx_obs_header *header);
+
+/**
+ * Release the memory owned by the header. The header
+ * is left initialized, so that it can be reused.
+ */
+void rrnx_fobs_deinit_header(rrnx_obs_header *header);
+
+/**
+ * Resize the observation types of the header.
+ * Returns error code.
+ */
+int rrnx_fobs_resize_layout(rrnx_obs_header *header, unsigned int size);
+
+// OBSERVATION CODES
+//===================
+
+/**
+ * Convert an observation code, such as "C1" or "L2", into
+ * a measurement type of the given satellite system.
+ * Returns 1 on success, and 0 if the code is unknown.
+ */
+int rrnx_fobs_code2type(
+    rrnx_meas_type *type,
+    int system,
+    const char *code
+);
+
+/**
+ * Convert a measurement type into a two-letter observation code.
+ * The code buffer must have room for three chars. Unknown types
+ * are converted into "??".
+ */
+void rrnx_fobs_type2code(const rrnx_meas_type *type, char *code);
+
 
 #ifdef __cplusplus
 } // extern "C"
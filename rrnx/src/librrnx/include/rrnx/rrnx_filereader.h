@@ -19,6 +19,7 @@
 #define RRNX_FILEREADER_H
 
 #include <stdio.h> // FILE
+#include <stddef.h> // size_t
 #include "rrnx_error.h" // TODO: rrnx_errmsg, rrnx_errno?
 
 #ifdef __cplusplus
@@ -32,6 +33,12 @@ extern "C" {
 
 #define RRNX_FR_DEFAULT_BUFFER_SIZE 0x10000
 
+/**
+ * Default size for the line buffer used by rrnx_fr_readspan()
+ * when the file is read through a stream.
+ */
+#define RRNX_FR_DEFAULT_LINE_SIZE 0x200
+
 //============================================================================
 // DATA TYPES
 //============================================================================
@@ -70,6 +77,44 @@ struct rrnx_filereader {
 	 */
 	unsigned int buffer_size;
 
+	/**
+	 * Memory-mapped contents of the file, or NULL.
+	 * When the file is mapped, fp is NULL.
+	 */
+	const char *map;
+
+	/**
+	 * Size of the memory-mapped region.
+	 */
+	size_t map_size;
+
+	/**
+	 * Next read location within the memory-mapped region.
+	 */
+	size_t map_at;
+
+	/**
+	 * Indicates whether the file is memory-mapped.
+	 * Needed separately, since an empty file has no mapping.
+	 */
+	int mapped;
+
+	/**
+	 * Indicates whether the mapping is unmapped on close.
+	 * Memory given to rrnx_fr_openmem() is only borrowed.
+	 */
+	int map_owned;
+
+	/**
+	 * Line buffer for rrnx_fr_readspan() in stream mode.
+	 */
+	char *linebuf;
+
+	/**
+	 * Size of the line buffer.
+	 */
+	unsigned int linebuf_size;
+
 	/**
 	 * Current row.
 	 */
@@ -114,9 +159,50 @@ int rrnx_fr_fclose(rrnx_filereader *reader);
 int rrnx_fr_fopen(rrnx_filereader *reader, const char *filename);
 int rrnx_fr_buffer(rrnx_filereader *reader);
 
+/**
+ * Opens the file through a read-only memory mapping.
+ * Files which cannot be mapped (pipes, devices) are opened
+ * as a stream instead. The file is closed with rrnx_fr_fclose().
+ */
+int rrnx_fr_mmap(rrnx_filereader *reader, const char *filename);
+
+/**
+ * Reads lines from memory owned by the caller, as if it was a
+ * memory-mapped file. The filename is used in the error messages,
+ * and the row counting continues from the given row.
+ * The memory must remain valid until rrnx_fr_fclose().
+ */
+int rrnx_fr_openmem(
+    rrnx_filereader *reader,
+    const char *filename,
+    const char *buf,
+    size_t size,
+    unsigned int row
+);
+
 int rrnx_fr_readchar(rrnx_filereader *reader, char *dest);
 int rrnx_fr_readline(rrnx_filereader *reader, char *dest, size_t maxlen);
 
+/**
+ * Reads the next line as a span (pointer and length).
+ * The span is not terminated, and it remains valid until
+ * the next read or close. For a memory-mapped file the span
+ * points directly into the mapping, unless it has carriage
+ * returns in the middle. Otherwise the line is read into an
+ * internal line buffer with rrnx_fr_readline().
+ *
+ * Both modes drop every carriage return, and both fail with
+ * RRNX_E_OVERFLOW when the line is longer than the internal
+ * line buffer allows; the span is then truncated to it.
+ *
+ * Possible errors are the same as for rrnx_fr_readline().
+ */
+int rrnx_fr_readspan(
+    rrnx_filereader *reader,
+    const char **line,
+    unsigned int *len
+);
+
 
 
 #ifdef __cplusplus
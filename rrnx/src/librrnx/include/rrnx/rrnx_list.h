@@ -18,6 +18,8 @@
 #ifndef RRNX_LIST_H
 #define RRNX_LIST_H
 
+#include "rrnx_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -47,8 +49,14 @@ struct rrnx_list {
         rrnx_list_item *first;
         /** Pointer to the last (tail) item, or NULL. */
         rrnx_list_item *last;
-	/** Pointer to the destructor function */
+	/** Pointer to the destructor function, or NULL */
 	void (*destructor)(void*);
+	/**
+	 * Arena for the list items, or NULL. Owned by the list.
+	 * The payloads may be allocated from the arena too;
+	 * then the destructor should be NULL.
+	 */
+	rrnx_arena *arena;
 };
 
 typedef struct rrnx_list rrnx_list;
@@ -61,6 +69,12 @@ typedef struct rrnx_list rrnx_list;
 rrnx_list *rrnx_list_alloc(void);
 void rrnx_list_free(rrnx_list *list);
 
+/**
+ * Allocate a list whose items are allocated from an arena.
+ * The destructor is initially NULL.
+ */
+rrnx_list *rrnx_list_alloc_arena(void);
+
 //============================================================================
 // METHODS: MANIPULATION
 //============================================================================
@@ -68,6 +82,14 @@ void rrnx_list_free(rrnx_list *list);
 rrnx_list_item *rrnx_list_append(rrnx_list *list, void* data);
 void rrnx_list_remove(rrnx_list *list, rrnx_list_item *item);
 
+/**
+ * Move all items of the source list to the end of the destination list.
+ * The lists must be of the same kind: either both have an arena, or
+ * neither has. The source list is left empty, but it needs to be freed.
+ * Returns 1 on success, and 0 if the lists are incompatible.
+ */
+int rrnx_list_splice(rrnx_list *dest, rrnx_list *src);
+
 
 // Iteration and accessing are not neccessary....
 
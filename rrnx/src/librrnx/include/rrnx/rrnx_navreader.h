@@ -23,6 +23,7 @@
 #include "rrnx_error.h"
 #include "rrnx_basetypes_nav.h" // rrnx_navmsg
 #include "rrnx_filereader.h"
+#include "rrnx_node.h" // rrnx_node
 
 #ifdef __cplusplus
 extern "C" {
@@ -54,6 +55,7 @@ struct rrnx_navreader {
 
         /**
          * Parsed nodes as a linked-list.
+         * The nodes are allocated from the arena of the list.
          */
         rrnx_list *nodelist;
 
@@ -62,6 +64,28 @@ struct rrnx_navreader {
 	 */
 	rrnx_navmsg *cur_navmsg;
 
+	/**
+	 * Index of the next record field to parse.
+	 */
+	int cur_field;
+
+	/**
+	 * Current node that is being built or NULL.
+	 */
+	rrnx_node *cur_node;
+
+	/**
+	 * The most recently completed node, until it is picked up
+	 * by rrnx_navr_next(), or NULL.
+	 */
+	rrnx_node *ready_node;
+
+	/**
+	 * When streaming, every node is built into this buffer,
+	 * instead of the nodelist.
+	 */
+	rrnx_node *scratch_node;
+
 	/**
 	 * Human-readable error message.
 	 */
@@ -93,6 +117,56 @@ struct rrnx_navreader {
 	 */
 	unsigned int workbuf_size;
 
+	/**
+	 * When set, files are read through a memory mapping,
+	 * and the lines are parsed directly from the mapping.
+	 */
+	int use_mmap;
+
+	/**
+	 * Bytes which are not parsed yet: a partial line at the end
+	 * of the followed file or of the previous block, and any lines
+	 * left over when the callback stopped the parsing.
+	 */
+	char *pending;
+
+	/**
+	 * Number of pending bytes.
+	 */
+	size_t pending_len;
+
+	/**
+	 * Size of the pending buffer.
+	 */
+	size_t pending_size;
+
+	/**
+	 * Descriptor of the followed file, or -1.
+	 */
+	int follow_fd;
+
+	/**
+	 * Name of the followed file, or NULL.
+	 */
+	char *follow_name;
+
+	/**
+	 * Number of bytes read from the followed file.
+	 */
+	long long follow_offset;
+
+	/**
+	 * Number of lines parsed so far by rrnx_navr_follow_poll()
+	 * or rrnx_navr_consume_block().
+	 */
+	unsigned int row;
+
+	/**
+	 * Descriptor for the change notifications of the followed
+	 * file, or -1 when they are not available.
+	 */
+	int notify_fd;
+
 };
 
 typedef struct rrnx_navreader rrnx_navreader;
@@ -113,16 +187,135 @@ void rrnx_navr_readfile(
     const char *filename
 );
 
+/**
+ * Same as rrnx_navr_readfile(), but after the header, the data section
+ * is split at record boundaries into chunks, which are parsed
+ * concurrently by up to num_threads threads (one per processor,
+ * if num_threads <= 0). The nodes are joined in the file order, and
+ * the error messages have the exact line numbers, as usual.
+ * Files which cannot be memory-mapped are read sequentially.
+ */
+void rrnx_navr_readfile_parallel(
+    rrnx_navreader *navreader,
+    const char *filename,
+    int num_threads
+);
+
+/**
+ * Enables or disables memory-mapped reading in rrnx_navr_readfile().
+ * Disabled by default.
+ */
+void rrnx_navr_set_mmap(rrnx_navreader *navreader, int enabled);
+
 int rrnx_navr_consume(
     rrnx_navreader *navreader,
     const char *line
 );
 
+/**
+ * Parse RINEX from memory, such as a decompressed buffer. The data may
+ * be split into blocks arbitrarily; a partial line at the end of a block
+ * is kept until the next call. The lines are parsed directly from buf,
+ * and the nodes are collected into the nodelist like rrnx_navr_readfile()
+ * does. The end of input is signalled with a NULL buf, after which the
+ * nodelist can be released. After the end of input or an error, the
+ * next call begins a new file.
+ * Returns error code.
+ */
+int rrnx_navr_consume_block(
+    rrnx_navreader *navreader,
+    const char *buf,
+    size_t len
+);
+
 /**
  * Transfer the ownership of the built navdata to the caller.
  */
 rrnx_list *rrnx_navr_release_nodelist(rrnx_navreader *navreader);
 
+//============================================================================
+// METHODS: STREAMING
+//============================================================================
+
+/**
+ * Open a file for streaming. The nodes are not collected into
+ * a nodelist, but they are delivered one at a time by rrnx_navr_next().
+ * Returns error code.
+ */
+int rrnx_navr_open(rrnx_navreader *navreader, const char *filename);
+
+/**
+ * Read until the next node is complete. Header lines are delivered
+ * as soon as they are parsed, and navigation messages (datarecords)
+ * when their last broadcast orbit line has been parsed.
+ *
+ * The node is valid until the next call. Returns 1 when a node
+ * was read, and 0 at the end of file or on error.
+ */
+int rrnx_navr_next(rrnx_navreader *navreader, const rrnx_node **node);
+
+/**
+ * Close the file opened by rrnx_navr_open().
+ */
+void rrnx_navr_close(rrnx_navreader *navreader);
+
+/**
+ * Callback for rrnx_navr_readfile_cb(). Returning non-zero stops
+ * the reading.
+ */
+typedef int (*rrnx_navr_callback)(void *userdata, const rrnx_node *node);
+
+/**
+ * Stream the file through the callback.
+ * Returns error code.
+ */
+int rrnx_navr_readfile_cb(
+    rrnx_navreader *navreader,
+    const char *filename,
+    rrnx_navr_callback callback,
+    void *userdata
+);
+
+//============================================================================
+// METHODS: FOLLOWING A GROWING FILE
+//============================================================================
+
+/**
+ * Open a file, which is still being written, for following.
+ * The parser state and the file offset are kept between the calls
+ * to rrnx_navr_follow_poll(), so that only the appended data is parsed.
+ * Returns error code.
+ */
+int rrnx_navr_follow_open(rrnx_navreader *navreader, const char *filename);
+
+/**
+ * Parse the complete lines appended to the followed file since the
+ * previous call, and deliver the completed nodes to the callback,
+ * like rrnx_navr_readfile_cb() does. A partial line at the end of the
+ * file is kept until it is completed. When the callback stops the
+ * parsing, the remaining lines are parsed by the next call.
+ * A file which is truncated or replaced is not detected.
+ * Returns error code.
+ */
+int rrnx_navr_follow_poll(
+    rrnx_navreader *navreader,
+    rrnx_navr_callback callback,
+    void *userdata
+);
+
+/**
+ * Wait until the followed file has grown, or the timeout (ms) expires.
+ * On Linux, the file is watched with inotify; elsewhere, and when the
+ * watch cannot be set up, the size of the file is polled periodically.
+ * Returns 1 when there may be new data, and 0 on timeout.
+ */
+int rrnx_navr_follow_wait(rrnx_navreader *navreader, int timeout_ms);
+
+/**
+ * Stop following the file. Any partial record is discarded.
+ */
+void rrnx_navr_follow_close(rrnx_navreader *navreader);
+
 //============================================================================
 // METHODS: ERROR MANAGEMENT
 //============================================================================
@@ -18,6 +18,8 @@
 #ifndef RRNX_NODE_H
 #define RRNX_NODE_H
 
+#include "rrnx_arena.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -77,12 +79,23 @@ typedef struct rrnx_node rrnx_node;
 rrnx_node *rrnx_node_alloc(int type);
 void rrnx_node_free(rrnx_node *node);
 
+/**
+ * Allocate a node from an arena.
+ * The node must not be freed with rrnx_node_free().
+ */
+rrnx_node *rrnx_node_alloc_arena(rrnx_arena *arena, int type);
+
 //============================================================================
 // METHODS: CONSTRUCTION & DESTRUCTION
 //============================================================================
 
 int rrnx_node_is_type_valid(int type);
 
+/**
+ * Payload size of the node type, or -1 if the type is unknown.
+ */
+int rrnx_node_data_size(int type);
+
 
 #ifdef __cplusplus
 } // extern "C"
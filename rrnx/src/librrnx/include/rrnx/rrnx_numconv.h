@@ -0,0 +1,110 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+/**
+ * Number conversions specialized for the fixed-width fields
+ * of RINEX files.
+ */
+
+#ifndef RRNX_NUMCONV_H
+#define RRNX_NUMCONV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/**
+ * Longest output of rrnx_num_format_shortest().
+ */
+#define RRNX_NUM_SHORTEST_MAX 24
+
+//============================================================================
+// METHODS: PARSING
+//============================================================================
+
+/**
+ * Converts a Fortran floating-point number (Fw.d, Ew.d or Dw.d)
+ * into a double without copying it.
+ *
+ * The number is given as a span of len chars without surrounding
+ * blanks. Both 'D' and 'E' exponent markers are understood.
+ *
+ * Returns 1 when the number was converted; the result is then
+ * bit-for-bit identical to the result of strtod(). Returns 0 when
+ * the text is malformed, or when it cannot be converted without
+ * rounding twice. In that case the result is left untouched, and
+ * the caller should fall back to strtod().
+ */
+int rrnx_num_parse_fortran(const char *s, int len, double *result);
+
+//============================================================================
+// METHODS: FORMATTING
+//============================================================================
+
+/**
+ * Formats a fixed-point number (Fw.d) right-justified into exactly
+ * width chars. Nothing is terminated.
+ *
+ * The output is identical to that of snprintf() with "%w.df".
+ * Returns 1 on success. Returns 0, and writes nothing, when the number
+ * does not fit into the width, when it is not finite or its magnitude
+ * is 2^52 or more, or when there are more than three decimals.
+ */
+int rrnx_num_format_fixed(char *dest, int width, int decimals, double value);
+
+/**
+ * Formats a Fortran double (Dw.d) right-justified into exactly
+ * width chars. Nothing is terminated.
+ *
+ * The output is identical to that of snprintf() with "%w.dE",
+ * except that the exponent marker is 'D'. Returns 1 on success.
+ * Returns 0, and writes nothing, when the number does not fit into
+ * the width, when it is not finite, or when it cannot be converted
+ * exactly with 128-bit integers (magnitudes below about 1e-41 or
+ * above about 1e49 for D19.12). In that case the caller should
+ * fall back to snprintf().
+ */
+int rrnx_num_format_fortran(char *dest, int width, int decimals, double value);
+
+/**
+ * Formats a double with the fewest significant digits which convert
+ * back to the same double with strtod(). When several numbers are
+ * equally short, the one closest to the double is taken. Nothing
+ * is terminated; at most RRNX_NUM_SHORTEST_MAX chars are written.
+ *
+ * The layout is that of snprintf() with "%.17g": the exponential
+ * form is used when the exponent is below -4, or 17 or more, and
+ * there are no trailing zeros. For example, 0.1 becomes "0.1",
+ * 345600.0 becomes "345600", and 2^-40 becomes "9.094947017729282e-13".
+ *
+ * The digits are found as in Ryu, with exact 128-bit arithmetic.
+ * Magnitudes below about 1e-38 or above about 1e47, or compilers
+ * without 128-bit integers, take a slower path through snprintf().
+ * Returns the number of chars written.
+ */
+int rrnx_num_format_shortest(char *dest, double value);
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
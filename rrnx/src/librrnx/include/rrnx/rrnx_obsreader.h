@@ -0,0 +1,230 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#ifndef RRNX_OBSREADER_H
+#define RRNX_OBSREADER_H
+
+#include "rrnx_string.h" // rrnx_string
+#include "rrnx_error.h"
+#include "rrnx_filereader.h"
+#include "rrnx_file_obs.h" // rrnx_obs_header, rrnx_meas_epoch
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/**
+ * Initial satellite capacity of the observation block.
+ * The block grows when an epoch has more satellites.
+ */
+#define RRNX_OBSR_DEFAULT_CAPACITY 32
+
+/**
+ * Value of a blank LLI or signal strength indicator.
+ */
+#define RRNX_OBSR_FLAG_BLANK -1
+
+//============================================================================
+// DATA TYPES
+//============================================================================
+
+/**
+ * Observations of a single epoch as a structure of arrays.
+ *
+ * Each observation type of the header has a column of "capacity"
+ * entries, and the observation of the i'th satellite of type t is
+ * at index (t * capacity + i) of the arrays. The columns of one type
+ * are therefore contiguous over the satellites.
+ *
+ * The block is reused between the epochs.
+ */
+struct rrnx_obs_block {
+	/**
+	 * Epoch time, flag, satellites and receiver clock offset.
+	 * For the event flags 2-5, epoch.size is the number of special
+	 * records, which have been applied to the header, and the
+	 * block has no satellites.
+	 */
+	rrnx_meas_epoch epoch;
+
+	/**
+	 * Number of satellites in the block.
+	 */
+	unsigned int num_sats;
+
+	/**
+	 * Number of observation types (columns).
+	 */
+	unsigned int num_types;
+
+	/**
+	 * Allocated satellites per column.
+	 */
+	unsigned int capacity;
+
+	/**
+	 * Observed values; 0.0 when blank.
+	 */
+	double *value;
+
+	/**
+	 * Nonzero when the value was present.
+	 */
+	unsigned char *valid;
+
+	/**
+	 * For the event flags 2-5, the special records as they were
+	 * read, each terminated by a newline. NULL for other epochs.
+	 */
+	const char *records;
+
+	/**
+	 * Loss of lock indicators (0-7), or RRNX_OBSR_FLAG_BLANK.
+	 */
+	signed char *lli;
+
+	/**
+	 * Signal strength indicators (1-9), or RRNX_OBSR_FLAG_BLANK.
+	 */
+	signed char *ssi;
+};
+
+typedef struct rrnx_obs_block rrnx_obs_block;
+
+/**
+ * This data type should be opaque.
+ */
+struct rrnx_obsreader {
+	/**
+	 * For reading lines from the underlying file.
+	 */
+	rrnx_filereader *fr;
+
+	/**
+	 * Header of the current file. Event records of
+	 * the data section are applied to it too.
+	 */
+	rrnx_obs_header header;
+
+	/**
+	 * The observations of the most recent epoch.
+	 */
+	rrnx_obs_block block;
+
+	/**
+	 * Human-readable error message.
+	 */
+	rrnx_string *errmsg;
+
+	/**
+	 * Error code
+	 */
+	int err;
+
+	/**
+	 * Set at the end of file.
+	 */
+	int finished;
+
+	/**
+	 * Number of observation types parsed so far
+	 * from the "# / TYPES OF OBSERV" records.
+	 */
+	unsigned int types_parsed;
+
+	/**
+	 * The special records of the most recent event.
+	 */
+	char *records;
+
+	/**
+	 * Size of the special records buffer.
+	 */
+	size_t records_size;
+
+	/**
+	 * An internal buffer for miscellaneous purposes.
+	 */
+	char *workbuf;
+
+	/**
+	 * Size of the internal buffer.
+	 */
+	unsigned int workbuf_size;
+
+	/**
+	 * When set, files are read through a memory mapping.
+	 */
+	int use_mmap;
+};
+
+typedef struct rrnx_obsreader rrnx_obsreader;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+rrnx_obsreader *rrnx_obsr_alloc(void);
+void rrnx_obsr_free(rrnx_obsreader *obsreader);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Enables or disables memory-mapped reading. Disabled by default.
+ */
+void rrnx_obsr_set_mmap(rrnx_obsreader *obsreader, int enabled);
+
+/**
+ * Open an observation file, and read its header.
+ * Returns error code.
+ */
+int rrnx_obsr_open(rrnx_obsreader *obsreader, const char *filename);
+
+/**
+ * Read the next epoch into the observation block. Nothing is
+ * allocated, unless the epoch has more satellites than the block
+ * has had room for so far, or an event record changes the
+ * observation types.
+ *
+ * The block is valid until the next call. Returns 1 when an epoch
+ * was read, and 0 at the end of file or on error.
+ */
+int rrnx_obsr_next(rrnx_obsreader *obsreader, const rrnx_obs_block **block);
+
+/**
+ * Close the file opened by rrnx_obsr_open().
+ */
+void rrnx_obsr_close(rrnx_obsreader *obsreader);
+
+//============================================================================
+// METHODS: ERROR MANAGEMENT
+//============================================================================
+
+int rrnx_obsr_errno(const rrnx_obsreader *obsreader);
+const char *rrnx_obsr_strerror(const rrnx_obsreader *obsreader);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
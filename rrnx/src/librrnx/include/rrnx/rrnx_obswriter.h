@@ -0,0 +1,138 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#ifndef RRNX_OBSWRITER_H
+#define RRNX_OBSWRITER_H
+
+#include "rrnx_string.h" // rrnx_string
+#include "rrnx_error.h"
+#include "rrnx_file_obs.h" // rrnx_obs_header
+#include "rrnx_obsreader.h" // rrnx_obs_block
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//============================================================================
+// CONSTANTS
+//============================================================================
+
+/**
+ * Default size of the output buffer.
+ */
+#define RRNX_OBSW_DEFAULT_BUFFER_SIZE 0x100000
+
+//============================================================================
+// DATA TYPES
+//============================================================================
+
+struct rrnx_outbuf;
+
+/**
+ * This data type should be opaque.
+ */
+struct rrnx_obswriter {
+	/**
+	 * Output buffer, and the file.
+	 */
+	struct rrnx_outbuf *ob;
+
+	/**
+	 * The file name that is being written.
+	 */
+	char *filename;
+
+	/**
+	 * Number of observation types of the header written,
+	 * or of the latest event which changed them.
+	 */
+	unsigned int num_types;
+
+	/**
+	 * Number of lines written.
+	 */
+	unsigned long lines;
+
+	/**
+	 * Human-readable error message.
+	 */
+	rrnx_string *errmsg;
+
+	/**
+	 * Error code
+	 */
+	int err;
+};
+
+typedef struct rrnx_obswriter rrnx_obswriter;
+
+//============================================================================
+// METHODS: CONSTRUCTION & DESTRUCTION
+//============================================================================
+
+rrnx_obswriter *rrnx_obsw_alloc(void);
+void rrnx_obsw_free(rrnx_obswriter *obswriter);
+
+//============================================================================
+// METHODS: OTHER METHODS
+//============================================================================
+
+/**
+ * Create a file for writing. Returns error code.
+ */
+int rrnx_obsw_open(rrnx_obswriter *obswriter, const char *filename);
+
+/**
+ * Write the header. The mandatory records are always written,
+ * and the optional ones when the header has them.
+ * Returns error code.
+ */
+int rrnx_obsw_write_header(
+    rrnx_obswriter *obswriter,
+    const rrnx_obs_header *header
+);
+
+/**
+ * Write an epoch and its observations. The block must have as many
+ * observation types as the header. For the event flags 2-5, the
+ * epoch.size special records of block->records are written instead,
+ * and a "# / TYPES OF OBSERV" record among them sets the number of
+ * observation types of the following epochs. An event without a time
+ * (month zero) gets blank time fields. Returns error code.
+ */
+int rrnx_obsw_write_epoch(
+    rrnx_obswriter *obswriter,
+    const rrnx_obs_block *block
+);
+
+/**
+ * Flush the buffer, and close the file. Returns error code.
+ */
+int rrnx_obsw_close(rrnx_obswriter *obswriter);
+
+//============================================================================
+// METHODS: ERROR MANAGEMENT
+//============================================================================
+
+int rrnx_obsw_errno(const rrnx_obswriter *obswriter);
+const char *rrnx_obsw_strerror(const rrnx_obswriter *obswriter);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -15,7 +15,14 @@
 //
 //********************************{end:header}******************************//
 
+// For sysconf()
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
+#include <stdlib.h> // malloc, free
+#include <string.h> // strncpy
+#include <pthread.h>
+#include <unistd.h> // sysconf
 
 #include "rrnx/rrnx.h"
 #include "rrnx/rrnx_navreader.h"
@@ -29,13 +36,25 @@ void rrnx_free_navfile(rrnx_file_nav *nav) {
 }
 
 int rrnx_read_navfile(const char *filename, rrnx_file_nav **nav) {
+	return rrnx_read_navfile_errmsg(filename, nav, NULL, 0);
+}
+
+int rrnx_read_navfile_errmsg(
+    const char *filename,
+    rrnx_file_nav **nav,
+    char *errmsg,
+    size_t size
+) {
 	int err = RRNX_E_OK;
 
 	rrnx_navreader *navreader = NULL;
 	rrnx_list *nodelist = NULL;
 
-	// Reset return variable
+	// Reset return variables
 	*nav = NULL;
+	if ((errmsg != NULL) && (size > 0)) {
+		errmsg[0] = '\0';
+	}
 
 	do {
 		// Attempt to allocate a navreader
@@ -46,13 +65,20 @@ int rrnx_read_navfile(const char *filename, rrnx_file_nav **nav) {
 			break;
 		}
 
+		// Parse directly from a memory mapping of the file.
+		rrnx_navr_set_mmap(navreader, 1);
+
 		// Attempt to parse the file into a nodelist.
         	rrnx_navr_readfile(navreader, filename);
 
 		// Inspect the result of the operation.
 		err = rrnx_navr_errno(navreader);
 		if (err) {
-			// Operation failed. Abort immediately.
+			// Operation failed. Keep the message, and abort.
+			if ((errmsg != NULL) && (size > 0)) {
+				strncpy(errmsg, rrnx_navr_strerror(navreader), size);
+				errmsg[size-1] = '\0';
+			}
 			break;
 		}
 
@@ -60,7 +86,9 @@ int rrnx_read_navfile(const char *filename, rrnx_file_nav **nav) {
 		nodelist = rrnx_navr_release_nodelist(navreader);
 
 		// Attempt to deserialize the list into a navfile object.
-		*nav = rrnx_fnav_deserialize(nodelist);
+		// The nodelist is consumed, and its arena is adopted.
+		*nav = rrnx_fnav_deserialize_owned(nodelist);
+		nodelist = NULL;
 
 		if (*nav == NULL) {
 			// Insufficient memory. Abort immediately.
@@ -81,5 +109,164 @@ int rrnx_read_navfile(const char *filename, rrnx_file_nav **nav) {
 	return err;
 }
 
+//--- multi-file reading ---------------------------------------------------//
+
+/**
+ * State shared by the worker threads of rrnx_read_navfiles().
+ */
+struct navfiles_job {
+	const char *const *filenames;
+	int count;
+
+	/** Results, one per file. */
+	rrnx_file_nav **navs;
+	rrnx_navfile_result *results;
+
+	/** Index of the next file to read. */
+	int next;
+	pthread_mutex_t lock;
+};
+
+static void *navfiles_worker(void *arg) {
+	struct navfiles_job *job = arg;
+
+	for (;;) {
+		// Take the next file
+		pthread_mutex_lock(&job->lock);
+		int i = job->next;
+		if (i < job->count) {
+			job->next++;
+		}
+		pthread_mutex_unlock(&job->lock);
+
+		if (i >= job->count) {
+			// No more files
+			break;
+		}
+
+		// Each call uses a navreader of its own.
+		rrnx_navfile_result *result = &job->results[i];
+		result->err = rrnx_read_navfile_errmsg(job->filenames[i],
+		    &job->navs[i], result->errmsg, sizeof(result->errmsg));
+	}
+
+	return NULL;
+}
+
+int rrnx_read_navfiles(
+    const char *const *filenames,
+    int count,
+    int num_threads,
+    rrnx_file_nav **nav,
+    rrnx_navfile_result *results
+) {
+	int err = RRNX_E_OK;
+
+	struct navfiles_job job;
+	job.filenames = filenames;
+	job.count = count;
+	job.navs = NULL;
+	job.results = NULL;
+	job.next = 0;
+
+	pthread_t *threads = NULL;
+	int num_started = 0;
+
+	// Reset return variable
+	*nav = NULL;
+
+	if (num_threads <= 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cpus > 0) ? (int) cpus : 1;
+	}
+	if (num_threads > count) {
+		num_threads = count;
+	}
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+
+	do {
+		*nav = rrnx_fnav_alloc();
+		if (*nav == NULL) {
+			err = RRNX_E_NOMEM;
+			break;
+		}
+
+		if (count <= 0) {
+			// Nothing to read
+			break;
+		}
+
+		job.navs = calloc(count, sizeof(rrnx_file_nav *));
+		job.results = calloc(count, sizeof(rrnx_navfile_result));
+		threads = calloc(num_threads, sizeof(pthread_t));
+
+		if ((job.navs == NULL) || (job.results == NULL)
+		    || (threads == NULL))
+		{
+			err = RRNX_E_NOMEM;
+			break;
+		}
+
+		pthread_mutex_init(&job.lock, NULL);
+
+		// The files are handed out to the threads one at a time,
+		// which balances the load when the file sizes differ.
+		for (int t = 0; t < num_threads; t++) {
+			if (pthread_create(&threads[t], NULL,
+			    navfiles_worker, &job) != 0)
+			{
+				break;
+			}
+			num_started++;
+		}
+
+		if (num_started == 0) {
+			// Read in this thread instead
+			navfiles_worker(&job);
+		}
+
+		for (int t = 0; t < num_started; t++) {
+			pthread_join(threads[t], NULL);
+		}
+
+		pthread_mutex_destroy(&job.lock);
+
+		// Merge in the order of the filenames.
+		for (int i = 0; i < count; i++) {
+			if (job.navs[i] == NULL) {
+				// Failed; skip.
+				continue;
+			}
+			err = rrnx_fnav_merge(*nav, job.navs[i]);
+			if (err) {
+				break;
+			}
+		}
+	} while(0);
+
+	// Report the per-file results
+	if ((results != NULL) && (job.results != NULL)) {
+		for (int i = 0; i < count; i++) {
+			results[i] = job.results[i];
+		}
+	}
 
+	// Free the per-file results, if any.
+	if (job.navs != NULL) {
+		for (int i = 0; i < count; i++) {
+			rrnx_fnav_free(job.navs[i]);
+		}
+	}
+	free(job.navs);
+	free(job.results);
+	free(threads);
 
+	if (err) {
+		rrnx_fnav_free(*nav);
+		*nav = NULL;
+	}
+
+	return err;
+}
@@ -0,0 +1,151 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include "rrnx/rrnx_arena.h"
+
+#include <stdlib.h> // malloc, free
+
+//--- internal data types --------------------------------------------------//
+
+/**
+ * A block of memory. The payload follows the header.
+ */
+struct rrnx_arena_block {
+	/** Next (older) block, or NULL. */
+	struct rrnx_arena_block *next;
+
+	/** Payload capacity (bytes). */
+	size_t size;
+
+	/** Payload bytes in use. */
+	size_t used;
+};
+
+typedef struct rrnx_arena_block rrnx_arena_block;
+
+//--- internal helpers -----------------------------------------------------//
+
+static size_t align_up(size_t size) {
+	return (size + (RRNX_ARENA_ALIGNMENT-1))
+	    & ~((size_t) (RRNX_ARENA_ALIGNMENT-1));
+}
+
+/** Header size rounded up, so that the payload is aligned. */
+static size_t header_size(void) {
+	return align_up(sizeof(rrnx_arena_block));
+}
+
+static char *block_payload(rrnx_arena_block *block) {
+	return ((char *) block) + header_size();
+}
+
+static rrnx_arena_block *block_alloc(size_t size) {
+	rrnx_arena_block *block = malloc(header_size() + size);
+	if (block != NULL) {
+		block->next = NULL;
+		block->size = size;
+		block->used = 0;
+	}
+	return block;
+}
+
+//--- external methods -----------------------------------------------------//
+
+rrnx_arena *rrnx_arena_alloc(void) {
+	rrnx_arena *arena = malloc(sizeof(rrnx_arena));
+	if (arena != NULL) {
+		arena->head = NULL;
+		arena->used = 0;
+		arena->reserved = 0;
+	}
+	return arena;
+}
+
+void rrnx_arena_free(rrnx_arena *arena) {
+	if (arena == NULL) {
+		// Already freed
+		return;
+	}
+
+	rrnx_arena_block *block = arena->head;
+	while (block != NULL) {
+		rrnx_arena_block *next = block->next;
+		free(block);
+		block = next;
+	}
+	arena->head = NULL;
+
+	free(arena);
+}
+
+void *rrnx_arena_malloc(rrnx_arena *arena, size_t size) {
+	size = align_up(size);
+
+	rrnx_arena_block *block = arena->head;
+	if ((block == NULL) || (block->size - block->used < size)) {
+		// Doesn't fit; start a new block.
+		// Oversized requests get a block of their own.
+		size_t block_size = RRNX_ARENA_BLOCK_SIZE;
+		if (size > block_size) {
+			block_size = size;
+		}
+
+		block = block_alloc(block_size);
+		if (block == NULL) {
+			// Out of memory
+			return NULL;
+		}
+
+		block->next = arena->head;
+		arena->head = block;
+		arena->reserved += block_size;
+	}
+
+	void *ptr = block_payload(block) + block->used;
+	block->used += size;
+	arena->used += size;
+
+	return ptr;
+}
+
+void rrnx_arena_adopt(rrnx_arena *dest, rrnx_arena *src) {
+	if ((src == NULL) || (src->head == NULL)) {
+		// Nothing to adopt
+		return;
+	}
+
+	// Link the source blocks behind the current head of dest,
+	// so that the allocations continue from the current block.
+	rrnx_arena_block *tail = src->head;
+	while (tail->next != NULL) {
+		tail = tail->next;
+	}
+
+	if (dest->head != NULL) {
+		tail->next = dest->head->next;
+		dest->head->next = src->head;
+	} else {
+		dest->head = src->head;
+	}
+
+	dest->used += src->used;
+	dest->reserved += src->reserved;
+
+	src->head = NULL;
+	src->used = 0;
+	src->reserved = 0;
+}
@@ -0,0 +1,481 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+// open, fstat, mmap are POSIX
+#define _POSIX_C_SOURCE 200809L
+
+#include "rrnx/rrnx_ephstore.h"
+#include "rrnx/rrnx_error.h"
+
+#include <stdlib.h> // malloc, free, qsort
+#include <stdio.h> // fopen, fwrite, remove
+#include <string.h> // memcpy, memcmp, memset
+#include <errno.h>
+
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <sys/stat.h> // fstat
+#include <sys/mman.h> // mmap, munmap
+
+//--- internal data types --------------------------------------------------//
+
+/**
+ * Sort entry of the writer. The sequence number keeps the sort
+ * stable, so that duplicate keys retain the order of the input.
+ */
+struct sort_entry {
+	rrnx_es_key key;
+	size_t seq;
+	const rrnx_navmsg *navmsg;
+};
+
+typedef struct sort_entry sort_entry;
+
+//--- internal helpers -----------------------------------------------------//
+
+static int compare_key(const rrnx_es_key *a, const rrnx_es_key *b) {
+	if (a->sv_id != b->sv_id) {
+		return (a->sv_id < b->sv_id) ? -1 : 1;
+	}
+	if (a->week != b->week) {
+		return (a->week < b->week) ? -1 : 1;
+	}
+	if (a->toe != b->toe) {
+		return (a->toe < b->toe) ? -1 : 1;
+	}
+	return 0;
+}
+
+static int compare_entry(const void *pa, const void *pb) {
+	const sort_entry *a = pa;
+	const sort_entry *b = pb;
+	int cmp = compare_key(&a->key, &b->key);
+	if (cmp == 0) {
+		cmp = (a->seq < b->seq) ? -1 : (a->seq > b->seq);
+	}
+	return cmp;
+}
+
+static void init_header(rrnx_es_header *header, size_t count) {
+	memset(header, 0, sizeof(rrnx_es_header));
+	memcpy(header->magic, RRNX_ES_MAGIC, sizeof(RRNX_ES_MAGIC));
+	header->version = RRNX_ES_VERSION;
+	header->byte_order = RRNX_ES_BYTE_ORDER;
+	header->header_size = sizeof(rrnx_es_header);
+	header->record_size = sizeof(rrnx_es_record);
+	header->key_size = sizeof(rrnx_es_key);
+	header->count = count;
+	header->records_offset = sizeof(rrnx_es_header);
+	header->keys_offset = header->records_offset
+	    + count * sizeof(rrnx_es_record);
+	header->file_size = header->keys_offset
+	    + count * sizeof(rrnx_es_key);
+}
+
+/**
+ * Returns 1 if the header describes a valid store
+ * of the given size, 0 otherwise.
+ */
+static int validate_header(const rrnx_es_header *header, size_t size) {
+	if (memcmp(header->magic, RRNX_ES_MAGIC, sizeof(RRNX_ES_MAGIC)) != 0) {
+		return 0;
+	}
+	if ((header->version != RRNX_ES_VERSION)
+	    || (header->byte_order != RRNX_ES_BYTE_ORDER)
+	    || (header->header_size != sizeof(rrnx_es_header))
+	    || (header->record_size != sizeof(rrnx_es_record))
+	    || (header->key_size != sizeof(rrnx_es_key)))
+	{
+		return 0;
+	}
+	if (header->file_size != size) {
+		// Truncated, or garbage at the end.
+		return 0;
+	}
+
+	// The sections must be within the file, and aligned
+	// for the doubles, which the mapping itself is.
+	uint64_t count = header->count;
+	uint64_t records = header->records_offset;
+	uint64_t keys = header->keys_offset;
+	if (((records % sizeof(double)) != 0)
+	    || ((keys % sizeof(double)) != 0))
+	{
+		return 0;
+	}
+	if ((records < sizeof(rrnx_es_header)) || (records > size)
+	    || (count > (size - records) / sizeof(rrnx_es_record)))
+	{
+		return 0;
+	}
+	if ((keys < sizeof(rrnx_es_header)) || (keys > size)
+	    || (count > (size - keys) / sizeof(rrnx_es_key)))
+	{
+		return 0;
+	}
+
+	// The sections must not overlap each other.
+	// The ends cannot overflow, since they are within the file.
+	uint64_t records_end = records + count * sizeof(rrnx_es_record);
+	uint64_t keys_end = keys + count * sizeof(rrnx_es_key);
+	if ((keys < records_end) && (records < keys_end)) {
+		return 0;
+	}
+
+	return 1;
+}
+
+//--- external methods -----------------------------------------------------//
+
+void rrnx_es_from_navmsg(rrnx_es_record *record, const rrnx_navmsg *navmsg) {
+	memset(record, 0, sizeof(rrnx_es_record));
+
+	record->sv_id = navmsg->sv_id;
+	record->flags
+	    = (navmsg->valid_af2 ? RRNX_ES_VALID_AF2 : 0)
+	    | (navmsg->valid_spare1 ? RRNX_ES_VALID_SPARE1 : 0)
+	    | (navmsg->valid_spare2 ? RRNX_ES_VALID_SPARE2 : 0)
+	    | (navmsg->valid_fit_interval ? RRNX_ES_VALID_FIT_INTERVAL : 0);
+
+	record->toc_year = navmsg->toc.year;
+	record->toc_month = navmsg->toc.month;
+	record->toc_day = navmsg->toc.day;
+	record->toc_hour = navmsg->toc.hour;
+	record->toc_min = navmsg->toc.min;
+	record->toc_sec = navmsg->toc.sec;
+
+	record->af0 = navmsg->af0;
+	record->af1 = navmsg->af1;
+	record->af2 = navmsg->af2;
+
+	record->IODE = navmsg->IODE;
+	record->Crs = navmsg->Crs;
+	record->delta_n = navmsg->delta_n;
+	record->M0 = navmsg->M0;
+
+	record->Cuc = navmsg->Cuc;
+	record->e = navmsg->e;
+	record->Cus = navmsg->Cus;
+	record->sqrtA = navmsg->sqrtA;
+
+	record->toe = navmsg->toe;
+	record->Cic = navmsg->Cic;
+	record->OMEGA0 = navmsg->OMEGA0;
+	record->Cis = navmsg->Cis;
+
+	record->i0 = navmsg->i0;
+	record->Crc = navmsg->Crc;
+	record->w = navmsg->w;
+	record->OMEGADOT = navmsg->OMEGADOT;
+
+	record->idot = navmsg->idot;
+	record->L2_codes = navmsg->L2_codes;
+	record->toe_week = navmsg->toe_week;
+	record->L2P_dataflag = navmsg->L2P_dataflag;
+
+	record->accuracy = navmsg->accuracy;
+	record->health = navmsg->health;
+	record->Tgd = navmsg->Tgd;
+	record->IODC = navmsg->IODC;
+
+	record->tow = navmsg->tow;
+	record->fit_interval = navmsg->fit_interval;
+	record->spare1 = navmsg->spare1;
+	record->spare2 = navmsg->spare2;
+}
+
+void rrnx_es_to_navmsg(const rrnx_es_record *record, rrnx_navmsg *navmsg) {
+	navmsg->valid_af2 = (record->flags & RRNX_ES_VALID_AF2) != 0;
+	navmsg->valid_spare1 = (record->flags & RRNX_ES_VALID_SPARE1) != 0;
+	navmsg->valid_spare2 = (record->flags & RRNX_ES_VALID_SPARE2) != 0;
+	navmsg->valid_fit_interval
+	    = (record->flags & RRNX_ES_VALID_FIT_INTERVAL) != 0;
+
+	navmsg->sv_id = record->sv_id;
+
+	navmsg->toc.year = record->toc_year;
+	navmsg->toc.month = record->toc_month;
+	navmsg->toc.day = record->toc_day;
+	navmsg->toc.hour = record->toc_hour;
+	navmsg->toc.min = record->toc_min;
+	navmsg->toc.sec = record->toc_sec;
+
+	navmsg->af0 = record->af0;
+	navmsg->af1 = record->af1;
+	navmsg->af2 = record->af2;
+
+	navmsg->IODE = record->IODE;
+	navmsg->Crs = record->Crs;
+	navmsg->delta_n = record->delta_n;
+	navmsg->M0 = record->M0;
+
+	navmsg->Cuc = record->Cuc;
+	navmsg->e = record->e;
+	navmsg->Cus = record->Cus;
+	navmsg->sqrtA = record->sqrtA;
+
+	navmsg->toe = record->toe;
+	navmsg->Cic = record->Cic;
+	navmsg->OMEGA0 = record->OMEGA0;
+	navmsg->Cis = record->Cis;
+
+	navmsg->i0 = record->i0;
+	navmsg->Crc = record->Crc;
+	navmsg->w = record->w;
+	navmsg->OMEGADOT = record->OMEGADOT;
+
+	navmsg->idot = record->idot;
+	navmsg->L2_codes = record->L2_codes;
+	navmsg->toe_week = record->toe_week;
+	navmsg->L2P_dataflag = record->L2P_dataflag;
+
+	navmsg->accuracy = record->accuracy;
+	navmsg->health = record->health;
+	navmsg->Tgd = record->Tgd;
+	navmsg->IODC = record->IODC;
+
+	navmsg->tow = record->tow;
+	navmsg->fit_interval = record->fit_interval;
+	navmsg->spare1 = record->spare1;
+	navmsg->spare2 = record->spare2;
+}
+
+int rrnx_es_write(const char *filename, const rrnx_file_nav *nav) {
+	int err = RRNX_E_OK;
+	sort_entry *entries = NULL;
+	FILE *fp = NULL;
+
+	do {
+		// Collect and sort the navmsgs by key
+		size_t count = 0;
+		const rrnx_list_item *item = nav->navmsg_list->first;
+		for (; item != NULL; item = item->next) {
+			count++;
+		}
+
+		entries = malloc((count > 0 ? count : 1) * sizeof(sort_entry));
+		if (entries == NULL) {
+			err = RRNX_E_NOMEM;
+			break;
+		}
+
+		size_t i = 0;
+		item = nav->navmsg_list->first;
+		for (; item != NULL; item = item->next, i++) {
+			const rrnx_navmsg *navmsg = item->data;
+			entries[i].key.sv_id = navmsg->sv_id;
+			entries[i].key.week = (int32_t) navmsg->toe_week;
+			entries[i].key.toe = navmsg->toe;
+			entries[i].seq = i;
+			entries[i].navmsg = navmsg;
+		}
+
+		qsort(entries, count, sizeof(sort_entry), compare_entry);
+
+		fp = fopen(filename, "wb");
+		if (fp == NULL) {
+			err = RRNX_E_SYSCALL;
+			break;
+		}
+
+		rrnx_es_header header;
+		init_header(&header, count);
+		fwrite(&header, sizeof(header), 1, fp);
+
+		for (i = 0; i < count; i++) {
+			rrnx_es_record record;
+			rrnx_es_from_navmsg(&record, entries[i].navmsg);
+			fwrite(&record, sizeof(record), 1, fp);
+		}
+
+		for (i = 0; i < count; i++) {
+			fwrite(&entries[i].key, sizeof(rrnx_es_key), 1, fp);
+		}
+
+		// The write errors are sticky; check them once.
+		int failed = ferror(fp);
+		if (fclose(fp) != 0) {
+			failed = 1;
+		}
+		fp = NULL;
+
+		if (failed) {
+			err = RRNX_E_SYSCALL;
+			// Don't leave a truncated store behind.
+			int saved_errno = errno;
+			remove(filename);
+			errno = saved_errno;
+			break;
+		}
+	} while(0);
+
+	if (fp != NULL) {
+		fclose(fp);
+	}
+	free(entries);
+
+	return err;
+}
+
+int rrnx_es_open(const char *filename, rrnx_ephstore **store) {
+	int err = RRNX_E_OK;
+	rrnx_ephstore *es = NULL;
+	int fd = -1;
+
+	do {
+		es = malloc(sizeof(rrnx_ephstore));
+		if (es == NULL) {
+			err = RRNX_E_NOMEM;
+			break;
+		}
+		es->map = NULL;
+		es->map_size = 0;
+
+		fd = open(filename, O_RDONLY);
+		if (fd == -1) {
+			err = RRNX_E_SYSCALL;
+			break;
+		}
+
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			err = RRNX_E_SYSCALL;
+			break;
+		}
+
+		if ((size_t) st.st_size < sizeof(rrnx_es_header)) {
+			err = RRNX_E_FORMAT;
+			break;
+		}
+
+		void *map = mmap(NULL, st.st_size,
+		    PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map == MAP_FAILED) {
+			err = RRNX_E_SYSCALL;
+			break;
+		}
+		es->map = map;
+		es->map_size = st.st_size;
+
+		const rrnx_es_header *header = map;
+		if (!validate_header(header, es->map_size)) {
+			err = RRNX_E_FORMAT;
+			break;
+		}
+
+		const char *base = map;
+		es->header = header;
+		es->records = (const rrnx_es_record *)
+		    (base + header->records_offset);
+		es->keys = (const rrnx_es_key *)
+		    (base + header->keys_offset);
+		es->count = header->count;
+	} while(0);
+
+	if (fd != -1) {
+		// The mapping stays valid after the close.
+		int saved_errno = errno;
+		close(fd);
+		errno = saved_errno;
+	}
+
+	if (err != RRNX_E_OK) {
+		rrnx_es_close(es);
+		es = NULL;
+	}
+
+	*store = es;
+	return err;
+}
+
+void rrnx_es_close(rrnx_ephstore *store) {
+	if (store == NULL) {
+		// Already closed
+		return;
+	}
+	if (store->map != NULL) {
+		munmap(store->map, store->map_size);
+		store->map = NULL;
+	}
+	free(store);
+}
+
+size_t rrnx_es_lower_bound(
+    const rrnx_ephstore *store,
+    int sv_id,
+    int week,
+    double toe
+) {
+	rrnx_es_key key;
+	key.sv_id = sv_id;
+	key.week = week;
+	key.toe = toe;
+
+	size_t lo = 0;
+	size_t hi = store->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (compare_key(&store->keys[mid], &key) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+long rrnx_es_find(
+    const rrnx_ephstore *store,
+    int sv_id,
+    int week,
+    double toe
+) {
+	size_t i = rrnx_es_lower_bound(store, sv_id, week, toe);
+	if (i < store->count) {
+		const rrnx_es_key *key = &store->keys[i];
+		if ((key->sv_id == sv_id) && (key->week == week)
+		    && (key->toe == toe))
+		{
+			return (long) i;
+		}
+	}
+	return -1;
+}
+
+long rrnx_es_find_latest(
+    const rrnx_ephstore *store,
+    int sv_id,
+    int week,
+    double tow
+) {
+	// First record later than (week, tow); the one before it is
+	// the latest not later, if it belongs to the same satellite.
+	size_t i = rrnx_es_lower_bound(store, sv_id, week, tow);
+	while ((i < store->count)
+	    && (store->keys[i].sv_id == sv_id)
+	    && (store->keys[i].week == week)
+	    && (store->keys[i].toe == tow))
+	{
+		i++;
+	}
+
+	if ((i > 0) && (store->keys[i-1].sv_id == sv_id)) {
+		return (long) (i-1);
+	}
+	return -1;
+}
@@ -0,0 +1,400 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include "rrnx/rrnx_ephtable.h"
+#include "rrnx/rrnx_error.h"
+
+#include <stdlib.h> // malloc, free, qsort
+#include <string.h> // memcpy
+
+//--- internal data types --------------------------------------------------//
+
+/**
+ * Sort entry. The sequence number keeps the sort stable,
+ * so that duplicate keys retain the order of the input.
+ */
+struct sort_entry {
+	int sv_id;
+	double toe;
+	size_t seq;
+	const rrnx_navmsg *navmsg;
+};
+
+typedef struct sort_entry sort_entry;
+
+//--- internal helpers -----------------------------------------------------//
+
+static int compare_entry(const void *pa, const void *pb) {
+	const sort_entry *a = pa;
+	const sort_entry *b = pb;
+	if (a->sv_id != b->sv_id) {
+		return (a->sv_id < b->sv_id) ? -1 : 1;
+	}
+	if (a->toe != b->toe) {
+		return (a->toe < b->toe) ? -1 : 1;
+	}
+	return (a->seq < b->seq) ? -1 : (a->seq > b->seq);
+}
+
+static double gps_seconds(double week, double tow) {
+	return (week * RRNX_ET_SECONDS_IN_WEEK) + tow;
+}
+
+/**
+ * Fit interval of a message [s].
+ */
+static double fit_interval(const rrnx_navmsg *navmsg) {
+	double hours = RRNX_ET_DEFAULT_FIT_INTERVAL;
+	if (navmsg->valid_fit_interval && (navmsg->fit_interval > 0.0)) {
+		hours = navmsg->fit_interval;
+	}
+	return hours * 3600.0;
+}
+
+/**
+ * First index of the satellite, found by binary search.
+ */
+static size_t search_sv(const rrnx_ephtable *table, int sv_id) {
+	size_t lo = 0;
+	size_t hi = table->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (table->sv_id[mid] < sv_id) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * First index within [lo, hi) whose time is not earlier (strict == 0)
+ * or later (strict == 1) than t, or hi.
+ */
+static size_t search_time(
+    const double *toe,
+    size_t lo,
+    size_t hi,
+    double t,
+    int strict
+) {
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if ((toe[mid] < t) || (strict && (toe[mid] == t))) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+//--- external methods -----------------------------------------------------//
+
+int rrnx_et_build(const rrnx_file_nav *nav, rrnx_ephtable **table) {
+	int err = RRNX_E_OK;
+	rrnx_ephtable *et = NULL;
+	sort_entry *entries = NULL;
+
+	do {
+		et = malloc(sizeof(rrnx_ephtable));
+		if (et == NULL) {
+			err = RRNX_E_NOMEM;
+			break;
+		}
+		et->navmsgs = NULL;
+		et->toe = NULL;
+		et->sv_id = NULL;
+		et->count = 0;
+		et->max_fit_interval = 0.0;
+
+		size_t count = 0;
+		const rrnx_list_item *item = nav->navmsg_list->first;
+		for (; item != NULL; item = item->next) {
+			count++;
+		}
+
+		// Room for at least one, so that NULL means out of memory.
+		size_t n = (count > 0) ? count : 1;
+		entries = malloc(n * sizeof(sort_entry));
+		et->navmsgs = malloc(n * sizeof(rrnx_navmsg));
+		et->toe = malloc(n * sizeof(double));
+		et->sv_id = malloc(n * sizeof(int));
+		if ((entries == NULL) || (et->navmsgs == NULL)
+		    || (et->toe == NULL) || (et->sv_id == NULL))
+		{
+			err = RRNX_E_NOMEM;
+			break;
+		}
+
+		size_t i = 0;
+		item = nav->navmsg_list->first;
+		for (; item != NULL; item = item->next, i++) {
+			const rrnx_navmsg *navmsg = item->data;
+			entries[i].sv_id = navmsg->sv_id;
+			entries[i].toe = gps_seconds(navmsg->toe_week, navmsg->toe);
+			entries[i].seq = i;
+			entries[i].navmsg = navmsg;
+		}
+
+		qsort(entries, count, sizeof(sort_entry), compare_entry);
+
+		for (i = 0; i < count; i++) {
+			memcpy(&et->navmsgs[i], entries[i].navmsg,
+			    sizeof(rrnx_navmsg));
+			et->toe[i] = entries[i].toe;
+			et->sv_id[i] = entries[i].sv_id;
+
+			double fit = fit_interval(&et->navmsgs[i]);
+			if (fit > et->max_fit_interval) {
+				et->max_fit_interval = fit;
+			}
+		}
+		et->count = count;
+
+		// The satellites are in order, so a single pass
+		// finds the beginnings of their ranges.
+		i = 0;
+		for (int sv = 0; sv <= RRNX_ET_MAX_SV; sv++) {
+			while ((i < count) && (et->sv_id[i] < sv)) {
+				i++;
+			}
+			et->first[sv] = i;
+		}
+	} while(0);
+
+	free(entries);
+
+	if (err != RRNX_E_OK) {
+		rrnx_et_free(et);
+		et = NULL;
+	}
+
+	*table = et;
+	return err;
+}
+
+void rrnx_et_free(rrnx_ephtable *table) {
+	if (table == NULL) {
+		// Already freed
+		return;
+	}
+	free(table->navmsgs);
+	free(table->toe);
+	free(table->sv_id);
+	free(table);
+}
+
+void rrnx_et_range(
+    const rrnx_ephtable *table,
+    int sv_id,
+    size_t *begin,
+    size_t *end
+) {
+	if ((sv_id >= 0) && (sv_id < RRNX_ET_MAX_SV)) {
+		*begin = table->first[sv_id];
+		*end = table->first[sv_id+1];
+	} else {
+		*begin = search_sv(table, sv_id);
+		*end = search_sv(table, sv_id+1);
+	}
+}
+
+size_t rrnx_et_lower_bound(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+) {
+	size_t begin, end;
+	rrnx_et_range(table, sv_id, &begin, &end);
+	return search_time(table->toe, begin, end, gps_seconds(week, tow), 0);
+}
+
+long rrnx_et_find_latest(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+) {
+	size_t begin, end;
+	rrnx_et_range(table, sv_id, &begin, &end);
+
+	// First message later than the time; the one before it
+	// is the latest not later, if it is within the range.
+	size_t i = search_time(table->toe, begin, end,
+	    gps_seconds(week, tow), 1);
+
+	return (i > begin) ? (long) (i-1) : -1;
+}
+
+long rrnx_et_find_nearest(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+) {
+	size_t begin, end;
+	rrnx_et_range(table, sv_id, &begin, &end);
+	if (begin == end) {
+		return -1;
+	}
+
+	double t = gps_seconds(week, tow);
+	size_t i = search_time(table->toe, begin, end, t, 0);
+
+	// The nearest is either the first not earlier,
+	// or the last earlier.
+	if (i == end) {
+		return (long) (i-1);
+	}
+	if ((i > begin) && (t - table->toe[i-1] <= table->toe[i] - t)) {
+		return (long) (i-1);
+	}
+	return (long) i;
+}
+
+/**
+ * Picks the best message around the position next, which is the first
+ * message later than t within the range [begin, end).
+ */
+static long find_best_around(
+    const rrnx_ephtable *table,
+    size_t begin,
+    size_t end,
+    size_t next,
+    double t
+) {
+	// Only the messages within the longest half fit interval
+	// can cover the time.
+	double reach = table->max_fit_interval / 2.0;
+
+	size_t lo = next;
+	while ((lo > begin) && (t - table->toe[lo-1] <= reach)) {
+		lo--;
+	}
+	size_t hi = next;
+	while ((hi < end) && (table->toe[hi] - t <= reach)) {
+		hi++;
+	}
+
+	long best = -1;
+	double best_dt = 0.0;
+
+	for (size_t i = lo; i < hi; i++) {
+		const rrnx_navmsg *navmsg = &table->navmsgs[i];
+		double dt = table->toe[i] - t;
+		if (dt < 0.0) {
+			dt = -dt;
+		}
+
+		if ((navmsg->health != 0.0) || (dt > fit_interval(navmsg) / 2.0)) {
+			// Unhealthy, or not valid at the time
+			continue;
+		}
+
+		if (best >= 0) {
+			// The messages are in the order of the time of
+			// ephemeris, so an equally near one is later,
+			// and loses; unless it has the same time.
+			if (dt > best_dt) {
+				continue;
+			}
+			if ((dt == best_dt) && (table->toe[i] != table->toe[best])) {
+				continue;
+			}
+			if ((table->toe[i] == table->toe[best])
+			    && (navmsg->tow < table->navmsgs[best].tow))
+			{
+				// An earlier issue of the same ephemeris
+				continue;
+			}
+		}
+
+		best = (long) i;
+		best_dt = dt;
+	}
+
+	return best;
+}
+
+long rrnx_et_find_best(
+    const rrnx_ephtable *table,
+    int sv_id,
+    int week,
+    double tow
+) {
+	size_t begin, end;
+	rrnx_et_range(table, sv_id, &begin, &end);
+
+	double t = gps_seconds(week, tow);
+	size_t next = search_time(table->toe, begin, end, t, 1);
+
+	return find_best_around(table, begin, end, next, t);
+}
+
+/**
+ * Largest number of steps the cursor is advanced one message
+ * at a time, before resorting to a binary search.
+ */
+#define CURSOR_MAX_STEPS 8
+
+void rrnx_et_cursor_init(rrnx_et_cursor *cursor, const rrnx_ephtable *table) {
+	cursor->table = table;
+	for (int sv = 0; sv < RRNX_ET_MAX_SV; sv++) {
+		cursor->next[sv] = table->first[sv];
+	}
+}
+
+long rrnx_et_cursor_find(
+    rrnx_et_cursor *cursor,
+    int sv_id,
+    int week,
+    double tow
+) {
+	const rrnx_ephtable *table = cursor->table;
+
+	if ((sv_id < 0) || (sv_id >= RRNX_ET_MAX_SV)) {
+		// No cursor for the satellite
+		return rrnx_et_find_best(table, sv_id, week, tow);
+	}
+
+	size_t begin = table->first[sv_id];
+	size_t end = table->first[sv_id+1];
+	double t = gps_seconds(week, tow);
+
+	size_t next = cursor->next[sv_id];
+	int steps = 0;
+	while ((next < end) && (table->toe[next] <= t)
+	    && (steps < CURSOR_MAX_STEPS))
+	{
+		next++;
+		steps++;
+	}
+
+	if (((next < end) && (table->toe[next] <= t))
+	    || ((next > begin) && (table->toe[next-1] > t)))
+	{
+		// Jumped forward, or back in time
+		next = search_time(table->toe, begin, end, t, 1);
+	}
+
+	cursor->next[sv_id] = next;
+
+	return find_best_around(table, begin, end, next, t);
+}
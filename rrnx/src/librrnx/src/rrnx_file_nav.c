@@ -23,9 +23,20 @@
 #include "rrnx/rrnx_nodes_nav.h"
 // Errors
 #include "rrnx/rrnx_error.h"
+// Serialization
+#include "rrnx/rrnx_numconv.h"
+#include "rrnx/rrnx_string.h"
+
+// These are internal
+#include "rrnx_schema.h"
+#include "rrnx_outbuf.h"
 
 #include <stdlib.h> // malloc, free, NULL
 #include <string.h> // strcpy, memcpy
+#include <stdint.h> // uint64_t
+#include <stddef.h> // offsetof
+#include <stdio.h> // fopen, fclose, remove, snprintf
+#include <errno.h>
 #include <assert.h> // assert() TODO get rid of this.
 
 // CONSTRUCTION & DESTRUCTION
@@ -62,7 +73,9 @@ rrnx_file_nav *rrnx_fnav_alloc(void) {
 		// Initialization finished.
 		// Allocate sub-objects.
 
-		nav->navmsg_list = rrnx_list_alloc();
+		// The navmsgs and the list items are allocated
+		// from the arena of the list.
+		nav->navmsg_list = rrnx_list_alloc_arena();
 		if (nav->navmsg_list == NULL) break;
 
 		// Instantiation complete.
@@ -90,6 +103,23 @@ void rrnx_fnav_free(rrnx_file_nav *nav) {
 // OTHER METHODS
 //===============
 
+int rrnx_fnav_append(rrnx_file_nav *nav, const rrnx_navmsg *navmsg) {
+	rrnx_navmsg *copy = rrnx_arena_malloc(
+	    nav->navmsg_list->arena, sizeof(rrnx_navmsg));
+	if (copy == NULL) {
+		return RRNX_E_NOMEM;
+	}
+	memcpy(copy, navmsg, sizeof(rrnx_navmsg));
+
+	// Attempt appending to the list.
+	// On failure, the copy is released along with the arena.
+	if (rrnx_list_append(nav->navmsg_list, copy) == NULL) {
+		return RRNX_E_NOMEM;
+	}
+
+	return RRNX_E_OK;
+}
+
 static void parse_format_decl(
     rrnx_file_nav *nav,
     const rrnx_format_decl *data
@@ -150,54 +180,24 @@ static void parse_leap_seconds(
 
 static int parse_datarecord_nav(
     rrnx_file_nav *nav,
-    const rrnx_datarecord_nav *data
+    rrnx_datarecord_nav *data,
+    int adopt
 ) {
-	const rrnx_navmsg *source_navmsg = &data->navmsg;
-	rrnx_navmsg *navmsg = NULL;
-	rrnx_list_item *list_item = NULL;
-	int err = RRNX_E_OK;
-
-	// Create a copy
-	int complete = 0;
-	do {
-		// Attempt allocation
-		navmsg = malloc(sizeof(rrnx_navmsg));
-		if (navmsg == NULL) {
-			err = RRNX_E_NOMEM;
-			break;
-		}
-		// Clone the navmsg
-		memcpy(navmsg, source_navmsg, sizeof(rrnx_navmsg));
-
-		// Attempt appending to the list
-		list_item = rrnx_list_append(nav->navmsg_list, navmsg);
-		if (list_item == NULL) {
-			err = RRNX_E_NOMEM;
-			break;
-		}
-
-		complete = 1;
-	} while(0);
-
-	if (complete == 0) {
-		// Destroy
-		if (list_item != NULL) {
-			// Remove list item
-			rrnx_list_remove(nav->navmsg_list, list_item);
-			list_item = NULL;
-		}
+	if (!adopt) {
+		// Create a copy
+		return rrnx_fnav_append(nav, &data->navmsg);
+	}
 
-		if (navmsg != NULL) {
-			free(navmsg);
-			navmsg = NULL;
-		}
-	} // if: incomplete
+	// The node is kept alive by the adopted arena.
+	if (rrnx_list_append(nav->navmsg_list, &data->navmsg) == NULL) {
+		return RRNX_E_NOMEM;
+	}
 
-	return err;
+	return RRNX_E_OK;
 }
 
-static int parse_node(rrnx_file_nav *nav, const rrnx_node *node) {
-	const void *payload = node->data;
+static int parse_node(rrnx_file_nav *nav, rrnx_node *node, int adopt) {
+	void *payload = node->data;
 
 	int err = RRNX_E_OK;
 
@@ -229,7 +229,7 @@ static int parse_node(rrnx_file_nav *nav, const rrnx_node *node) {
 		break;
 	case RRNX_ID_DATARECORD_NAV:
 		// May run out of memory here.
-		err = parse_datarecord_nav(nav, payload);
+		err = parse_datarecord_nav(nav, payload, adopt);
 		break;
 
 	default:
@@ -240,7 +240,7 @@ static int parse_node(rrnx_file_nav *nav, const rrnx_node *node) {
 	return err;
 }
 
-rrnx_file_nav *rrnx_fnav_deserialize(const rrnx_list *nodelist) {
+static rrnx_file_nav *deserialize(const rrnx_list *nodelist, int adopt) {
 	rrnx_file_nav *nav = NULL;
 
 	nav = rrnx_fnav_alloc();
@@ -254,7 +254,7 @@ rrnx_file_nav *rrnx_fnav_deserialize(const rrnx_list *nodelist) {
 	while (iter != NULL) {
 
 		// Parse the node into file
-		err = parse_node(nav, iter->data);
+		err = parse_node(nav, iter->data, adopt);
 
 		if (err != RRNX_E_OK) {
 			// Abort parsing immediately
@@ -275,6 +275,609 @@ rrnx_file_nav *rrnx_fnav_deserialize(const rrnx_list *nodelist) {
 	return nav;
 }
 
-//rrnx_list *rrnx_fnav_serialize(rrnx_file_nav *nav);
+rrnx_file_nav *rrnx_fnav_deserialize(const rrnx_list *nodelist) {
+	return deserialize(nodelist, 0);
+}
+
+rrnx_file_nav *rrnx_fnav_deserialize_owned(rrnx_list *nodelist) {
+	// The nodes can be referred to only if they live in an arena.
+	int adopt = (nodelist != NULL) && (nodelist->arena != NULL);
+
+	rrnx_file_nav *nav = deserialize(nodelist, adopt);
+
+	if ((nav != NULL) && adopt) {
+		// Take the nodes. The list items of the nodelist
+		// come along, but they are just unused memory.
+		rrnx_arena_adopt(nav->navmsg_list->arena, nodelist->arena);
+	}
+
+	rrnx_list_free(nodelist);
+
+	return nav;
+}
+
+int rrnx_fnav_merge(rrnx_file_nav *dest, rrnx_file_nav *src) {
+	// Header data from the first file which has it.
+	if (dest->format.version[0] == '\0') {
+		dest->format = src->format;
+		dest->info = src->info;
+	}
 
+	// Almanac parameters from the latest file which has them.
+	if (src->has_iono_alpha) {
+		dest->has_iono_alpha = 1;
+		memcpy(dest->iono.alpha, src->iono.alpha, sizeof(dest->iono.alpha));
+	}
+	if (src->has_iono_beta) {
+		dest->has_iono_beta = 1;
+		memcpy(dest->iono.beta, src->iono.beta, sizeof(dest->iono.beta));
+	}
+	if (src->has_delta_utc) {
+		dest->has_delta_utc = 1;
+		dest->utc.a0 = src->utc.a0;
+		dest->utc.a1 = src->utc.a1;
+		dest->utc.tot = src->utc.tot;
+		dest->utc.tot_week = src->utc.tot_week;
+	}
+	if (src->has_leap_seconds) {
+		dest->has_leap_seconds = 1;
+		dest->utc.delta_ls = src->utc.delta_ls;
+	}
+
+	if (rrnx_list_splice(dest->navmsg_list, src->navmsg_list)) {
+		// Moved
+		return RRNX_E_OK;
+	}
+
+	// The lists are of different kind; copy the navmsgs instead.
+	int err = RRNX_E_OK;
+	rrnx_list_item *iter = src->navmsg_list->first;
+	while ((iter != NULL) && (err == RRNX_E_OK)) {
+		rrnx_navmsg *navmsg = NULL;
+		if (dest->navmsg_list->arena != NULL) {
+			navmsg = rrnx_arena_malloc(
+			    dest->navmsg_list->arena, sizeof(rrnx_navmsg));
+		} else {
+			navmsg = malloc(sizeof(rrnx_navmsg));
+		}
+		if (navmsg == NULL) {
+			err = RRNX_E_NOMEM;
+			break;
+		}
+		memcpy(navmsg, iter->data, sizeof(rrnx_navmsg));
+
+		if (rrnx_list_append(dest->navmsg_list, navmsg) == NULL) {
+			if (dest->navmsg_list->arena == NULL) {
+				free(navmsg);
+			}
+			err = RRNX_E_NOMEM;
+		}
+
+		iter = iter->next;
+	}
+
+	return err;
+}
+
+// DE-DUPLICATION
+//================
+
+/**
+ * Bits of a double for hashing. The zeros are equal as keys,
+ * so that their hashes must be equal too.
+ */
+static uint64_t double_bits(double x) {
+	uint64_t bits = 0;
+	if (x != 0.0) {
+		memcpy(&bits, &x, sizeof(bits));
+	}
+	return bits;
+}
+
+/** Finalizer of SplitMix64; spreads the bits of the key. */
+static uint64_t mix(uint64_t h) {
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return h;
+}
+
+static uint64_t key_hash(const rrnx_navmsg *navmsg) {
+	uint64_t h = (uint64_t) (unsigned int) navmsg->sv_id;
+	h = mix(h ^ double_bits(navmsg->toe_week));
+	h = mix(h ^ double_bits(navmsg->toe));
+	h = mix(h ^ double_bits(navmsg->IODE));
+	h = mix(h ^ double_bits(navmsg->IODC));
+	return h;
+}
+
+static int key_equals(const rrnx_navmsg *a, const rrnx_navmsg *b) {
+	return (a->sv_id == b->sv_id)
+	    && (a->toe_week == b->toe_week)
+	    && (a->toe == b->toe)
+	    && (a->IODE == b->IODE)
+	    && (a->IODC == b->IODC);
+}
+
+/**
+ * Compares the fields of the schema, except the transmission time.
+ * Blank fields are equal regardless of their values.
+ */
+static int payload_equals(const rrnx_navmsg *a, const rrnx_navmsg *b) {
+	const rrnx_schema *schema = &rrnx_schema_gps_nav;
+	const char *ra = (const char *) a;
+	const char *rb = (const char *) b;
+
+	for (int i = 0; i < schema->num_fields; i++) {
+		const rrnx_schema_field *field = &schema->fields[i];
+		if (field->offset == (int) offsetof(rrnx_navmsg, tow)) {
+			continue;
+		}
+
+		if (field->valid_offset >= 0) {
+			const int *valid_a = (const void *) (ra + field->valid_offset);
+			const int *valid_b = (const void *) (rb + field->valid_offset);
+			if ((*valid_a != 0) != (*valid_b != 0)) {
+				return 0;
+			}
+			if (!*valid_a) {
+				continue;
+			}
+		}
+
+		if (field->type == RRNX_FIELD_INT) {
+			const int *value_a = (const void *) (ra + field->offset);
+			const int *value_b = (const void *) (rb + field->offset);
+			if (*value_a != *value_b) {
+				return 0;
+			}
+		} else {
+			const double *value_a = (const void *) (ra + field->offset);
+			const double *value_b = (const void *) (rb + field->offset);
+			if (*value_a != *value_b) {
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+int rrnx_fnav_dedup(rrnx_file_nav *nav, rrnx_fnav_dedup_stats *stats) {
+	rrnx_fnav_dedup_stats result = {0, 0, 0, 0};
+
+	const rrnx_list_item *iter;
+	for (iter = nav->navmsg_list->first; iter != NULL; iter = iter->next) {
+		result.input++;
+	}
+
+	// Open addressing with linear probing. The table is kept
+	// at most half full, so that the probe sequences stay short.
+	size_t capacity = 16;
+	while (capacity < 2 * result.input) {
+		capacity *= 2;
+	}
+	size_t mask = capacity - 1;
+
+	rrnx_navmsg **table = calloc(capacity, sizeof(rrnx_navmsg *));
+	rrnx_list *list = rrnx_list_alloc_arena();
+
+	int err = RRNX_E_OK;
+
+	do {
+		if ((table == NULL) || (list == NULL)) {
+			err = RRNX_E_NOMEM;
+			break;
+		}
+
+		iter = nav->navmsg_list->first;
+		for (; iter != NULL; iter = iter->next) {
+			const rrnx_navmsg *navmsg = iter->data;
+
+			// A conflict does not end the probing, since a later
+			// record of the same key may still be identical.
+			size_t slot = (size_t) key_hash(navmsg) & mask;
+			int same_key = 0;
+			int duplicate = 0;
+			while (table[slot] != NULL) {
+				if (key_equals(table[slot], navmsg)) {
+					same_key = 1;
+					if (payload_equals(table[slot], navmsg)) {
+						duplicate = 1;
+						break;
+					}
+				}
+				slot = (slot + 1) & mask;
+			}
+
+			if (duplicate) {
+				result.duplicates++;
+				continue;
+			}
+
+			// Keep; copy into the new arena.
+			rrnx_navmsg *copy = rrnx_arena_malloc(
+			    list->arena, sizeof(rrnx_navmsg));
+			if (copy == NULL) {
+				err = RRNX_E_NOMEM;
+				break;
+			}
+			memcpy(copy, navmsg, sizeof(rrnx_navmsg));
+			copy->conflict = 0;
+
+			if (same_key) {
+				// Flag the record, and the former ones of the key.
+				result.conflicts++;
+				copy->conflict = 1;
+				size_t probe = (size_t) key_hash(navmsg) & mask;
+				for (; probe != slot; probe = (probe + 1) & mask) {
+					if (key_equals(table[probe], navmsg)) {
+						table[probe]->conflict = 1;
+					}
+				}
+			}
+			if (rrnx_list_append(list, copy) == NULL) {
+				err = RRNX_E_NOMEM;
+				break;
+			}
+
+			table[slot] = copy;
+			result.unique++;
+		}
+	} while(0);
+
+	free(table);
+
+	if (err != RRNX_E_OK) {
+		rrnx_list_free(list);
+		return err;
+	}
 
+	// Replace the records
+	rrnx_list_free(nav->navmsg_list);
+	nav->navmsg_list = list;
+
+	if (stats != NULL) {
+		*stats = result;
+	}
+
+	return RRNX_E_OK;
+}
+
+// SERIALIZATION
+//===============
+
+/** Longest line, including the newline. */
+#define MAX_LINE_SIZE 82
+
+/** Column of the header labels. */
+#define LABEL_OFFSET 60
+
+/** Width of the PRN and the epoch, which precede the SV clock. */
+#define EPOCH_WIDTH 22
+
+/** Size of the file buffer used by rrnx_fnav_write(). */
+#define WRITE_BUFFER_SIZE 0x10000
+
+/**
+ * Returns room for a blank line, or NULL on error.
+ */
+static char *begin_line(rrnx_outbuf *ob) {
+	char *line = rrnx_outbuf_reserve(ob, MAX_LINE_SIZE);
+	if (line != NULL) {
+		memset(line, ' ', MAX_LINE_SIZE-1);
+	}
+	return line;
+}
+
+/**
+ * Trims the trailing blanks of the line of len chars,
+ * and adds it to the buffer with a newline.
+ */
+static void end_line(rrnx_outbuf *ob, char *line, int len) {
+	while ((len > 0) && (line[len-1] == ' ')) {
+		len--;
+	}
+	line[len++] = '\n';
+	rrnx_outbuf_commit(ob, len);
+}
+
+static void end_header_line(rrnx_outbuf *ob, char *line, const char *label) {
+	int len = strlen(label);
+	memcpy(line + LABEL_OFFSET, label, len);
+	end_line(ob, line, LABEL_OFFSET + len);
+}
+
+/**
+ * Copies a string into a field of the line, left-justified.
+ * The string is cropped to the width of the field.
+ */
+static void put_string(char *line, int offset, int width, const char *s) {
+	int len = strlen(s);
+	if (len > width) {
+		len = width;
+	}
+	memcpy(line + offset, s, len);
+}
+
+/**
+ * Formats an integer right-justified (Iw).
+ * Returns 0 if it does not fit.
+ */
+static int put_int(char *line, int offset, int width, int value) {
+	unsigned int u = (value < 0) ? -(unsigned int) value : value;
+	char *p = line + offset + width;
+	do {
+		if (p == line + offset) {
+			return 0;
+		}
+		*--p = (char) ('0' + (u % 10));
+		u /= 10;
+	} while (u > 0);
+
+	if (value < 0) {
+		if (p == line + offset) {
+			return 0;
+		}
+		*--p = '-';
+	}
+	return 1;
+}
+
+/**
+ * Formats a double (Dw.d). The numbers which rrnx_numconv cannot
+ * format exactly are given to snprintf(). Returns 0 if it does not fit.
+ */
+static int put_double(
+    char *line,
+    int offset,
+    int width,
+    int decimals,
+    double value
+) {
+	if (rrnx_num_format_fortran(line + offset, width, decimals, value)) {
+		return 1;
+	}
+
+	char buf[MAX_LINE_SIZE];
+	int len = snprintf(buf, sizeof(buf), "%*.*E", width, decimals, value);
+	if ((len != width) || (strchr(buf, 'E') == NULL)) {
+		// Too wide, or not finite
+		return 0;
+	}
+	*strchr(buf, 'E') = 'D';
+	memcpy(line + offset, buf, width);
+	return 1;
+}
+
+static int put_doubles(
+    char *line,
+    int offset,
+    int width,
+    int decimals,
+    const double *values,
+    int count
+) {
+	for (int i = 0; i < count; i++) {
+		if (!put_double(
+		    line, offset + (i * width), width, decimals, values[i]))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Returns the error code of the buffer.
+ */
+static int outbuf_error(const rrnx_outbuf *ob) {
+	return (ob->errnum == ENOMEM) ? RRNX_E_NOMEM : RRNX_E_SYSCALL;
+}
+
+static int write_header(rrnx_outbuf *ob, const rrnx_file_nav *nav) {
+	char *line;
+	int fits = 1;
+
+	// RINEX VERSION / TYPE: F9.2, 11X, A1, 19X
+	if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+	const char *version = nav->format.version;
+	if (version[0] == '\0') {
+		version = "2.11";
+	}
+	int version_len = strlen(version);
+	if (version_len > 9) {
+		version_len = 9;
+	}
+	memcpy(line + 9 - version_len, version, version_len);
+	put_string(line, 20, 20, "N: GPS NAV DATA");
+	end_header_line(ob, line, "RINEX VERSION / TYPE");
+
+	// PGM / RUN BY / DATE: 3A20
+	if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+	put_string(line, 0, 20, nav->info.program);
+	put_string(line, 20, 20, nav->info.agency);
+	put_string(line, 40, 20, nav->info.date);
+	end_header_line(ob, line, "PGM / RUN BY / DATE");
+
+	if (nav->has_iono_alpha) {
+		// ION ALPHA: 2X, 4D12.4
+		if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+		fits &= put_doubles(line, 2, 12, 4, nav->iono.alpha, 4);
+		end_header_line(ob, line, "ION ALPHA");
+	}
+
+	if (nav->has_iono_beta) {
+		// ION BETA: 2X, 4D12.4
+		if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+		fits &= put_doubles(line, 2, 12, 4, nav->iono.beta, 4);
+		end_header_line(ob, line, "ION BETA");
+	}
+
+	if (nav->has_delta_utc) {
+		// DELTA-UTC: A0,A1,T,W: 3X, 2D19.12, 2I9
+		if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+		fits &= put_double(line, 3, 19, 12, nav->utc.a0);
+		fits &= put_double(line, 22, 19, 12, nav->utc.a1);
+		fits &= put_int(line, 41, 9, nav->utc.tot);
+		fits &= put_int(line, 50, 9, nav->utc.tot_week);
+		end_header_line(ob, line, "DELTA-UTC: A0,A1,T,W");
+	}
+
+	if (nav->has_leap_seconds) {
+		// LEAP SECONDS: I6
+		if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+		fits &= put_int(line, 0, 6, nav->utc.delta_ls);
+		end_header_line(ob, line, "LEAP SECONDS");
+	}
+
+	if ((line = begin_line(ob)) == NULL) return outbuf_error(ob);
+	end_header_line(ob, line, "END OF HEADER");
+
+	return fits ? RRNX_E_OK : RRNX_E_OVERFLOW;
+}
+
+/**
+ * Writes a navigation message. The epoch is written here, and the
+ * rest of the fields as laid out by the schema that the navreader
+ * uses. Fields without validity flag are blank.
+ */
+static int write_navmsg(rrnx_outbuf *ob, const rrnx_navmsg *navmsg) {
+	const rrnx_schema *schema = &rrnx_schema_gps_nav;
+	const rrnx_schema_field *field = schema->fields;
+	const rrnx_schema_field *end = &schema->fields[schema->num_fields];
+
+	int fits = 1;
+
+	for (int lineno = 0; lineno < schema->num_lines; lineno++) {
+		char *line = begin_line(ob);
+		if (line == NULL) {
+			return outbuf_error(ob);
+		}
+
+		int len = 0;
+		if (lineno == 0) {
+			// PRN / EPOCH: I2, 1X, I2.2, 4(1X, I2), F5.1
+			const rrnx_datetime *t = &navmsg->toc;
+			fits &= put_int(line, 0, 2, navmsg->sv_id);
+			int yy = t->year % 100;
+			line[3] = (char) ('0' + (yy / 10));
+			line[4] = (char) ('0' + (yy % 10));
+			fits &= put_int(line, 6, 2, t->month);
+			fits &= put_int(line, 9, 2, t->day);
+			fits &= put_int(line, 12, 2, t->hour);
+			fits &= put_int(line, 15, 2, t->min);
+			fits &= rrnx_num_format_fixed(line + 17, 5, 1, t->sec);
+			len = EPOCH_WIDTH;
+
+			while ((field < end) && (field->column < EPOCH_WIDTH)) {
+				field++;
+			}
+		}
+
+		for (; (field < end) && (field->line == lineno); field++) {
+			const char *record = (const char *) navmsg;
+			if (field->valid_offset >= 0) {
+				const int *valid = (const void *)
+				    (record + field->valid_offset);
+				if (!*valid) {
+					// Leave blank
+					continue;
+				}
+			}
+
+			const double *value = (const void *) (record + field->offset);
+			fits &= put_double(
+			    line, field->column, field->width, 12, *value);
+			len = field->column + field->width;
+		}
+
+		end_line(ob, line, len);
+	}
+
+	return fits ? RRNX_E_OK : RRNX_E_OVERFLOW;
+}
+
+static int serialize(rrnx_outbuf *ob, const rrnx_file_nav *nav) {
+	int err = write_header(ob, nav);
+
+	const rrnx_list_item *iter = nav->navmsg_list->first;
+	while ((iter != NULL) && (err == RRNX_E_OK)) {
+		err = write_navmsg(ob, iter->data);
+		iter = iter->next;
+	}
+
+	return err;
+}
+
+int rrnx_fnav_serialize(
+    const rrnx_file_nav *nav,
+    rrnx_string *dest,
+    size_t *len
+) {
+	// The buffer of the string is borrowed,
+	// and given back when finished.
+	rrnx_outbuf ob;
+	ob.fp = NULL;
+	ob.data = dest->text;
+	ob.size = dest->size;
+	ob.len = 0;
+	ob.errnum = 0;
+
+	int err = serialize(&ob, nav);
+
+	if (err == RRNX_E_OK) {
+		// Room for the terminator
+		if (rrnx_outbuf_reserve(&ob, 1) == NULL) {
+			err = RRNX_E_NOMEM;
+		}
+	}
+
+	dest->text = ob.data;
+	dest->size = ob.size;
+
+	if (err != RRNX_E_OK) {
+		ob.len = 0;
+	}
+	if (dest->size > 0) {
+		dest->text[ob.len] = '\0';
+	}
+	if (len != NULL) {
+		*len = ob.len;
+	}
+
+	return err;
+}
+
+int rrnx_fnav_write(const rrnx_file_nav *nav, const char *filename) {
+	rrnx_outbuf ob;
+	if (rrnx_outbuf_init(&ob, WRITE_BUFFER_SIZE) != RRNX_E_OK) {
+		return RRNX_E_NOMEM;
+	}
+
+	int err = RRNX_E_OK;
+	ob.fp = fopen(filename, "wb");
+	if (ob.fp == NULL) {
+		err = RRNX_E_SYSCALL;
+	}
+
+	if (err == RRNX_E_OK) {
+		err = serialize(&ob, nav);
+		if ((rrnx_outbuf_flush(&ob) != 0) && (err == RRNX_E_OK)) {
+			err = RRNX_E_SYSCALL;
+		}
+		if ((fclose(ob.fp) != 0) && (err == RRNX_E_OK)) {
+			err = RRNX_E_SYSCALL;
+		}
+		if (err != RRNX_E_OK) {
+			// Do not leave a partial file behind.
+			remove(filename);
+		}
+	}
+
+	rrnx_outbuf_deinit(&ob);
+
+	return err;
+}
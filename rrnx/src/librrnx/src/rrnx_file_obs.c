@@ -0,0 +1,114 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include "rrnx/rrnx_file_obs.h"
+#include "rrnx/rrnx_error.h"
+
+#include <stdlib.h> // malloc, free
+#include <string.h> // memset
+
+//--- internal data types --------------------------------------------------//
+
+/**
+ * Observation code letters and the corresponding observables.
+ */
+struct observable_code {
+	char letter;
+	unsigned int observable;
+};
+
+typedef struct observable_code observable_code;
+
+static const observable_code OBSERVABLE_CODE[] = {
+	{'C', RRNX_OBS_PSEUDORANGE},
+	{'P', RRNX_OBS_PSEUDORANGE_P},
+	{'L', RRNX_OBS_PHASE},
+	{'D', RRNX_OBS_DOPPLER},
+	{'S', RRNX_OBS_RAW}
+};
+
+#define NUM_OBSERVABLE_CODES \
+    (sizeof(OBSERVABLE_CODE) / sizeof(OBSERVABLE_CODE[0]))
+
+//--- external methods -----------------------------------------------------//
+
+void rrnx_fobs_init_header(rrnx_obs_header *header) {
+	memset(header, 0, sizeof(rrnx_obs_header));
+	header->layout.size = 0;
+	header->layout.item = NULL;
+}
+
+void rrnx_fobs_deinit_header(rrnx_obs_header *header) {
+	free(header->layout.item);
+	rrnx_fobs_init_header(header);
+}
+
+int rrnx_fobs_resize_layout(rrnx_obs_header *header, unsigned int size) {
+	rrnx_meas_type *item = NULL;
+	if (size > 0) {
+		item = malloc(size * sizeof(rrnx_meas_type));
+		if (item == NULL) {
+			return RRNX_E_NOMEM;
+		}
+		memset(item, 0, size * sizeof(rrnx_meas_type));
+	}
+
+	free(header->layout.item);
+	header->layout.item = item;
+	header->layout.size = size;
+
+	return RRNX_E_OK;
+}
+
+int rrnx_fobs_code2type(
+    rrnx_meas_type *type,
+    int system,
+    const char *code
+) {
+	for (unsigned int i = 0; i < NUM_OBSERVABLE_CODES; i++) {
+		if (OBSERVABLE_CODE[i].letter != code[0]) {
+			continue;
+		}
+		// The band is the frequency number
+		if ((code[1] < '1') || (code[1] > '9')) {
+			return 0;
+		}
+		type->system = system;
+		type->band = code[1] - '0';
+		type->observable = OBSERVABLE_CODE[i].observable;
+		return 1;
+	}
+	return 0;
+}
+
+void rrnx_fobs_type2code(const rrnx_meas_type *type, char *code) {
+	code[0] = '?';
+	code[1] = '?';
+	code[2] = '\0';
+
+	if ((type->band < 1) || (type->band > 9)) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < NUM_OBSERVABLE_CODES; i++) {
+		if (OBSERVABLE_CODE[i].observable == type->observable) {
+			code[0] = OBSERVABLE_CODE[i].letter;
+			code[1] = (char) ('0' + type->band);
+			return;
+		}
+	}
+}
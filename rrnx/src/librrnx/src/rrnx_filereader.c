@@ -15,14 +15,22 @@
 //
 //********************************{end:header}******************************//
 
+// open, fstat, mmap, fdopen are POSIX
+#define _POSIX_C_SOURCE 200809L
+
 #include "rrnx/rrnx_filereader.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
-#include <string.h> // strerror, strncpy
+#include <string.h> // strerror, strncpy, memchr
 #include <stdarg.h>
 
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <sys/stat.h> // fstat
+#include <sys/mman.h> // mmap, munmap, posix_madvise
+
 
 //--- internal methods -----------------------------------------------------//
 
@@ -83,6 +91,18 @@ static int errmsg_none(rrnx_filereader *reader, int err) {
 	return reader->err;
 }
 
+static int has_file(const rrnx_filereader *reader) {
+	return (reader->fp != NULL) || (reader->mapped);
+}
+
+static void reset_location(rrnx_filereader *reader) {
+	reader->row = 0;
+	reader->col = 0;
+	reader->len = 0;
+	reader->at = 0;
+	reader->map_at = 0;
+}
+
 //--- external methods: basic primitives -----------------------------------//
 
 rrnx_filereader *rrnx_fr_alloc(void) {
@@ -105,6 +125,15 @@ rrnx_filereader *rrnx_fr_alloc(void) {
 		reader->errmsg_size = 0;
 		reader->errmsg = NULL;
 
+		reader->map = NULL;
+		reader->map_size = 0;
+		reader->map_at = 0;
+		reader->mapped = 0;
+		reader->map_owned = 0;
+
+		reader->linebuf_size = 0;
+		reader->linebuf = NULL;
+
 		reader->at = 0;
 		reader->len = 0;
 		reader->row = 0;
@@ -128,6 +157,13 @@ rrnx_filereader *rrnx_fr_alloc(void) {
 		}
 		reader->errmsg_size = size;
 
+		size = RRNX_FR_DEFAULT_LINE_SIZE;
+		reader->linebuf = malloc(size);
+		if (reader->linebuf == NULL) {
+			break; // malloc failed, abort
+		}
+		reader->linebuf_size = size;
+
 		// Success.
 		failure = 0;
 
@@ -161,6 +197,11 @@ void rrnx_fr_free(rrnx_filereader *reader) {
 	reader->errmsg = NULL;
 	reader->errmsg_size = 0;
 
+	// Free line buffer, and remove dangling ptr
+	free(reader->linebuf);
+	reader->linebuf = NULL;
+	reader->linebuf_size = 0;
+
 	// Finally, free the filereader itself
 	free(reader);
 }
@@ -202,10 +243,10 @@ int rrnx_fr_set_filename(
 	if (filename != NULL) {
 		// Attempt allocation
 		int len = strlen(filename);
-		reader->filename = malloc(len);
+		reader->filename = malloc(len+1);
 		if (reader->filename != NULL) {
-			// Memory allocation succeeded. Copy
-			strncpy(reader->filename, filename, len);
+			// Memory allocation succeeded. Copy with terminator
+			memcpy(reader->filename, filename, len+1);
 		} else {
 			// Memory allocation failed.
 			errmsg_none(reader, RRNX_E_NOMEM);
@@ -220,6 +261,26 @@ static int fclose_silently(rrnx_filereader *reader) {
 	// any system call or library function.
 	int errnum = 0;
 
+	if (reader->mapped) {
+		// Attempt munmap; an empty file has no mapping,
+		// and borrowed memory is not unmapped.
+		if ((reader->map != NULL) && (reader->map_owned)
+		    && (munmap((void *) reader->map, reader->map_size) != 0))
+		{
+			// Record errno
+			errnum = errno;
+		}
+
+		// Remove mapping
+		reader->map = NULL;
+		reader->map_size = 0;
+		reader->mapped = 0;
+		reader->map_owned = 0;
+
+		// Reset location
+		reset_location(reader);
+	} // if
+
 	if (reader->fp != NULL) {
 		// Attempt fclose
 		if (fclose(reader->fp) != 0) {
@@ -243,7 +304,7 @@ static int fclose_silently(rrnx_filereader *reader) {
 int rrnx_fr_fclose(rrnx_filereader *reader) {
 	noerr(reader);
 
-	if (reader->fp != NULL) {
+	if (has_file(reader)) {
 		int errnum = fclose_silently(reader);
 
 		if (errnum != 0) {
@@ -262,7 +323,7 @@ int rrnx_fr_fopen(rrnx_filereader *reader, const char *filename) {
 	// Reset error
 	noerr(reader);
 
-	if (reader->fp != NULL) {
+	if (has_file(reader)) {
 		// Already file open
 		return errmsg(reader, RRNX_E_HASFILE,
 		    "%s: cannot open, because previous file (%s) is still open",
@@ -300,8 +361,124 @@ int rrnx_fr_fopen(rrnx_filereader *reader, const char *filename) {
 	return reader->err;
 }
 
+int rrnx_fr_mmap(rrnx_filereader *reader, const char *filename) {
+	// Reset error
+	noerr(reader);
+
+	if (has_file(reader)) {
+		// Already file open
+		return errmsg(reader, RRNX_E_HASFILE,
+		    "%s: cannot open, because previous file (%s) is still open",
+		    filename, reader->filename);
+	} // if: file already open
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		// open failed
+		return errmsg_syscall(reader, errno,
+		    "%s: open() failed: ", filename);
+	} // if: open failed
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		int errnum = errno;
+		close(fd);
+		return errmsg_syscall(reader, errnum,
+		    "%s: fstat() failed: ", filename);
+	} // if: fstat failed
+
+	if (!S_ISREG(st.st_mode)) {
+		// Pipes and devices cannot be mapped.
+		// Fall back to reading through a stream.
+		reader->fp = fdopen(fd, "r");
+		if (reader->fp == NULL) {
+			int errnum = errno;
+			close(fd);
+			return errmsg_syscall(reader, errnum,
+			    "%s: fdopen() failed: ", filename);
+		}
+	} else if (st.st_size > 0) {
+		void *map = mmap(NULL, st.st_size,
+		    PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping stays valid after the descriptor is closed.
+		int errnum = errno;
+		close(fd);
+
+		if (map == MAP_FAILED) {
+			return errmsg_syscall(reader, errnum,
+			    "%s: mmap() failed: ", filename);
+		}
+
+		// The file is read once from the beginning to the end.
+		// This is only a hint; errors are ignored.
+		posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+
+		reader->map = map;
+		reader->map_size = st.st_size;
+		reader->mapped = 1;
+		reader->map_owned = 1;
+	} else {
+		// An empty file cannot be mapped, and needs no mapping.
+		close(fd);
+		reader->map = NULL;
+		reader->map_size = 0;
+		reader->mapped = 1;
+		reader->map_owned = 0;
+	} // if-else
+
+	// File opened succesfully.
+	reset_location(reader);
+
+	// Remember the file name
+	rrnx_fr_set_filename(reader, filename);
+	if (reader->err) {
+		// Memory allocation failed. Abort.
+		// Silently close the file
+		fclose_silently(reader);
+		// Error is propagated upwards.
+	}
+
+	return reader->err;
+}
+
+int rrnx_fr_openmem(
+    rrnx_filereader *reader,
+    const char *filename,
+    const char *buf,
+    size_t size,
+    unsigned int row
+) {
+	// Reset error
+	noerr(reader);
+
+	if (has_file(reader)) {
+		// Already file open
+		return errmsg(reader, RRNX_E_HASFILE,
+		    "%s: cannot open, because previous file (%s) is still open",
+		    filename, reader->filename);
+	} // if: file already open
+
+	// The memory is read exactly like a memory-mapped file.
+	reader->map = buf;
+	reader->map_size = size;
+	reader->mapped = 1;
+	reader->map_owned = 0;
+
+	reset_location(reader);
+	reader->row = row;
+
+	// Remember the file name
+	rrnx_fr_set_filename(reader, filename);
+	if (reader->err) {
+		// Memory allocation failed. Abort.
+		fclose_silently(reader);
+	}
+
+	return reader->err;
+}
+
 int rrnx_fr_bind(rrnx_filereader *reader, FILE *fp) {
-	if (reader->fp != NULL) {
+	if (has_file(reader)) {
 		// Already file open
 		return errmsg(reader, RRNX_E_HASFILE,
 		    "bind error: previous file (%s) is still open",
@@ -387,6 +564,16 @@ int rrnx_fr_buffer(rrnx_filereader *reader) {
  * reader->err
  */
 int rrnx_fr_readchar(rrnx_filereader *reader, char *dest) {
+	if (reader->mapped) {
+		// Consume a char directly from the mapping.
+		if (reader->map_at == reader->map_size) {
+			return errmsg_none(reader, RRNX_E_EOF);
+		}
+		*dest = reader->map[reader->map_at];
+		reader->map_at++;
+		return noerr(reader);
+	}
+
 	// Buffer consumed?
 	if (reader->at == reader->len) {
 		// Fill buffer with new data. This updated reader->len.
@@ -423,7 +610,7 @@ int rrnx_fr_readline(
     char *dest,
     size_t maxlen
 ) {
-	char c; // current char
+	char c = 0; // current char
 	unsigned int i; // writing position
 	unsigned int overflow = 0;
 
@@ -493,3 +680,85 @@ int rrnx_fr_readline(
 	return reader->err;
 } // rrnx_fr_readline()
 
+int rrnx_fr_readspan(
+    rrnx_filereader *reader,
+    const char **line,
+    unsigned int *len
+) {
+	if (!reader->mapped) {
+		// Read through the stream into the line buffer.
+		rrnx_fr_readline(reader,
+		    reader->linebuf, reader->linebuf_size);
+		*line = reader->linebuf;
+		// On overflow col counts the whole line,
+		// but only maxlen-1 chars were stored.
+		*len = reader->col;
+		if (*len >= reader->linebuf_size) {
+			*len = reader->linebuf_size-1;
+		}
+		return reader->err;
+	}
+
+	if (reader->map_at == reader->map_size) {
+		// Everything has been consumed.
+		*line = NULL;
+		*len = 0;
+		return errmsg_none(reader, RRNX_E_EOF);
+	}
+
+	// For convenience
+	const char *begin = &reader->map[reader->map_at];
+	size_t left = reader->map_size - reader->map_at;
+	size_t maxlen = reader->linebuf_size-1;
+
+	const char *end = memchr(begin, '\n', left);
+	if (end != NULL) {
+		// Consume the line and its newline.
+		reader->map_at += (end - begin) + 1;
+	} else {
+		// Last line without a newline.
+		end = begin + left;
+		reader->map_at = reader->map_size;
+	}
+
+	// Strip a trailing carriage return, if any.
+	if ((end > begin) && (end[-1] == '\r')) {
+		end--;
+	}
+
+	// Advance textual location
+	reader->row++;
+
+	if (memchr(begin, '\r', end - begin) == NULL) {
+		// The usual case: the line is used in place.
+		reader->col = end - begin;
+		*line = begin;
+		*len = (reader->col > maxlen) ? maxlen : reader->col;
+	} else {
+		// Stray carriage returns are dropped, as in
+		// rrnx_fr_readline(), which needs a copy.
+		const char *p;
+		unsigned int n = 0;
+		reader->col = 0;
+		for (p = begin; p < end; p++) {
+			if (*p == '\r') {
+				continue;
+			}
+			if (n < maxlen) {
+				reader->linebuf[n++] = *p;
+			}
+			reader->col++;
+		}
+		*line = reader->linebuf;
+		*len = n;
+	}
+
+	if (reader->col > maxlen) {
+		// Same limit as in rrnx_fr_readline().
+		return errmsg(reader, RRNX_E_OVERFLOW,
+		    "Line too long (%d chars, while %d expected at most)",
+		    (int) reader->col, (int) maxlen);
+	}
+
+	return noerr(reader);
+} // rrnx_fr_readspan()
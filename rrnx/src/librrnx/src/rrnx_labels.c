@@ -39,11 +39,35 @@ static const enumerated_label NAV_LABEL[] = {
 	{RRNX_LBL_END_OF_HEADER, "END OF HEADER"}
 };
 
-// TODO: enum_navr_label?
-int rrnx_enumerate_label(const char *label) {
-	int labels = sizeof(NAV_LABEL) / sizeof(NAV_LABEL[0]);
+static const enumerated_label OBS_LABEL[] = {
+	{RRNX_LBL_RINEX_DECL, "RINEX VERSION / TYPE"},
+	{RRNX_LBL_CREATION_INFO, "PGM / RUN BY / DATE"},
+	{RRNX_LBL_COMMENT, "COMMENT"},
+	{RRNX_LBL_MARKER_NAME, "MARKER NAME"},
+	{RRNX_LBL_MARKER_NUMBER, "MARKER NUMBER"},
+	{RRNX_LBL_OBSERVER_AGENCY, "OBSERVER / AGENCY"},
+	{RRNX_LBL_RECEIVER_INFO, "REC # / TYPE / VERS"},
+	{RRNX_LBL_ANTENNA_INFO, "ANT # / TYPE"},
+	{RRNX_LBL_MARKER_XYZ, "APPROX POSITION XYZ"},
+	{RRNX_LBL_ANTENNA_DELTA, "ANTENNA: DELTA H/E/N"},
+	{RRNX_LBL_WAVELENGTH_FACT, "WAVELENGTH FACT L1/2"},
+	{RRNX_LBL_MEAS_LAYOUT, "# / TYPES OF OBSERV"},
+	{RRNX_LBL_INTERVAL, "INTERVAL"},
+	{RRNX_LBL_FIRST_MEAS, "TIME OF FIRST OBS"},
+	{RRNX_LBL_LAST_MEAS, "TIME OF LAST OBS"},
+	{RRNX_LBL_CLOCK_OFFSET, "RCV CLOCK OFFS APPL"},
+	{RRNX_LBL_LEAP_SECONDS, "LEAP SECONDS"},
+	{RRNX_LBL_SATELLITE_COUNT, "# OF SATELLITES"},
+	{RRNX_LBL_MEAS_SUMMARY, "PRN / # OF OBS"},
+	{RRNX_LBL_END_OF_HEADER, "END OF HEADER"}
+};
 
-	const enumerated_label *cur = NAV_LABEL;
+static int enumerate_label(
+    const enumerated_label *table,
+    int labels,
+    const char *label
+) {
+	const enumerated_label *cur = table;
 	for (int i = 0; i < labels; i++, cur++) {
 		if (strcmp(cur->text, label) == 0) {
 			return cur->id;
@@ -52,7 +76,21 @@ int rrnx_enumerate_label(const char *label) {
 	return RRNX_LBL_UNKNOWN;
 }
 
+// TODO: enum_navr_label?
+int rrnx_enumerate_label(const char *label) {
+	int labels = sizeof(NAV_LABEL) / sizeof(NAV_LABEL[0]);
+	return enumerate_label(NAV_LABEL, labels, label);
+}
+
 int rrnx_enumerate_linetype(const char *line) {
+	if (line == NULL) {
+		return RRNX_LBL_UNKNOWN;
+	}
+
+	return rrnx_enumerate_linetype_n(line, strlen(line));
+}
+
+int rrnx_enumerate_linetype_n(const char *line, int linelen) {
 	// Identified line type
 	int id = RRNX_LBL_UNKNOWN;
 
@@ -61,8 +99,19 @@ int rrnx_enumerate_linetype(const char *line) {
 	}
 
 	char label[32];
-	rrnx_substr_trimmed(label, line, 60, 20);
+	rrnx_substr_trimmed_n(label, line, linelen, 60, 20);
 	id = rrnx_enumerate_label(label);
 	return id;
 }
 
+int rrnx_enumerate_obs_linetype_n(const char *line, int linelen) {
+	if (line == NULL) {
+		return RRNX_LBL_UNKNOWN;
+	}
+
+	char label[32];
+	rrnx_substr_trimmed_n(label, line, linelen, 60, 20);
+
+	int labels = sizeof(OBS_LABEL) / sizeof(OBS_LABEL[0]);
+	return enumerate_label(OBS_LABEL, labels, label);
+}
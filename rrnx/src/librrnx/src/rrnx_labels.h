@@ -38,9 +38,31 @@ extern "C" {
 #define RRNX_LBL_LEAP_SECONDS    8
 
 // OBS specific
+#define RRNX_LBL_MARKER_NAME     9
+#define RRNX_LBL_MARKER_NUMBER   10
+#define RRNX_LBL_OBSERVER_AGENCY 11
+#define RRNX_LBL_RECEIVER_INFO   12
+#define RRNX_LBL_ANTENNA_INFO    13
+#define RRNX_LBL_MARKER_XYZ      14
+#define RRNX_LBL_ANTENNA_DELTA   15
+#define RRNX_LBL_WAVELENGTH_FACT 16
+#define RRNX_LBL_MEAS_LAYOUT     17
+#define RRNX_LBL_INTERVAL        18
+#define RRNX_LBL_FIRST_MEAS      19
+#define RRNX_LBL_LAST_MEAS       20
+#define RRNX_LBL_CLOCK_OFFSET    21
+#define RRNX_LBL_SATELLITE_COUNT 22
+#define RRNX_LBL_MEAS_SUMMARY    23
 
 
 int rrnx_enumerate_linetype(const char *line);
+int rrnx_enumerate_linetype_n(const char *line, int linelen);
+
+/**
+ * Same as rrnx_enumerate_linetype_n(), but for the header labels
+ * of an observation file.
+ */
+int rrnx_enumerate_obs_linetype_n(const char *line, int linelen);
 
 #ifdef __cplusplus
 } // extern "C"
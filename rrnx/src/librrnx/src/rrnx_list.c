@@ -16,15 +16,17 @@
 //********************************{end:header}******************************//
 
 #include "rrnx/rrnx_list.h"
-#include <stdlib.h> // free
+#include <stdlib.h> // malloc, free
 
 static void free_payload(rrnx_list *list, rrnx_list_item *item) {
 	if (item == NULL) {
 		// Already destroyed
 		return;
 	}
-	// Otherwise free the payload
-	list->destructor(item->data);
+	// Otherwise free the payload, unless it is owned elsewhere
+	if (list->destructor != NULL) {
+		list->destructor(item->data);
+	}
 	item->data = NULL;
 }
 
@@ -34,6 +36,20 @@ rrnx_list *rrnx_list_alloc(void) {
 		list->first = NULL;
 		list->last = NULL;
 		list->destructor = free;
+		list->arena = NULL;
+	}
+	return list;
+}
+
+rrnx_list *rrnx_list_alloc_arena(void) {
+	rrnx_list *list = rrnx_list_alloc();
+	if (list != NULL) {
+		list->destructor = NULL;
+		list->arena = rrnx_arena_alloc();
+		if (list->arena == NULL) {
+			free(list);
+			list = NULL;
+		}
 	}
 	return list;
 }
@@ -48,15 +64,21 @@ void rrnx_list_free(rrnx_list *list) {
 		rrnx_list_item *next = item->next;
 		// Free user-defined payload
 		free_payload(list, item);
-		// Free the list item itself.
+		// Free the list item itself, unless it is in the arena.
 		// Don't bother to maintain links.
-		free(item);
+		if (list->arena == NULL) {
+			free(item);
+		}
 		// Advance
 		item = next;
 	}
 	list->first = NULL;
 	list->last = NULL;
 
+	// Release the arena, if any, with everything in it.
+	rrnx_arena_free(list->arena);
+	list->arena = NULL;
+
 	// Remove the list itself
 	free(list);
 }
@@ -64,7 +86,12 @@ void rrnx_list_free(rrnx_list *list) {
 // Manipulation
 
 rrnx_list_item *rrnx_list_append(rrnx_list *list, void* data) {
-	rrnx_list_item *item = malloc(sizeof(rrnx_list_item));
+	rrnx_list_item *item = NULL;
+	if (list->arena != NULL) {
+		item = rrnx_arena_malloc(list->arena, sizeof(rrnx_list_item));
+	} else {
+		item = malloc(sizeof(rrnx_list_item));
+	}
 	if (item == NULL) {
 		// Allocation failed
 		return item;
@@ -114,8 +141,41 @@ void rrnx_list_remove(rrnx_list *list, rrnx_list_item *item) {
 
 	// Free user data
 	free_payload(list, item);
-	// free the node itself
-	free(item);
+	// free the node itself; arena items are released with the arena.
+	if (list->arena == NULL) {
+		free(item);
+	}
+}
+
+int rrnx_list_splice(rrnx_list *dest, rrnx_list *src) {
+	if ((dest->arena == NULL) != (src->arena == NULL)) {
+		// The items would be released differently
+		return 0;
+	}
+
+	if (src->arena != NULL) {
+		// Take the items, and whatever else is in the arena.
+		rrnx_arena_adopt(dest->arena, src->arena);
+	}
+
+	if (src->first == NULL) {
+		// Nothing to move
+		return 1;
+	}
+
+	// Maintain the links
+	src->first->prev = dest->last;
+	if (dest->last != NULL) {
+		dest->last->next = src->first;
+	} else {
+		dest->first = src->first;
+	}
+	dest->last = src->last;
+
+	src->first = NULL;
+	src->last = NULL;
+
+	return 1;
 }
 
 /*
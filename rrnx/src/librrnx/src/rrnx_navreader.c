@@ -15,21 +15,36 @@
 //
 //********************************{end:header}******************************//
 
+// For sysconf()
+#define _POSIX_C_SOURCE 200809L
+
 #include "rrnx/rrnx_navreader.h"
 
 #include "rrnx/rrnx_node.h"
 #include "rrnx/rrnx_nodes_common.h"
 #include "rrnx/rrnx_nodes_nav.h"
+#include "rrnx/rrnx_numconv.h"
 
 // internal
 #include "rrnx_labels.h"
 #include "rrnx_strutil.h"
+#include "rrnx_schema.h"
 
 
 #include <stdlib.h> // malloc, free, NULL, FILE
 #include <string.h>
 #include <errno.h> // errno
 #include <stdarg.h> // va_list, va_start, va_end
+#include <pthread.h>
+#include <unistd.h> // sysconf, read, close
+#include <fcntl.h> // open
+#include <time.h> // nanosleep
+#include <sys/stat.h> // fstat
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
 
 /*
 static int noerr(rrnx_navreader *navreader) {
@@ -117,7 +132,11 @@ static rrnx_node *nodelist_alloc_node(rrnx_list *nodelist, int nodetype) {
 	int complete = 0;
 	do {
 		// Allocate a node with sizeof(nodetype)
-		node = rrnx_node_alloc(nodetype);
+		if (nodelist->arena != NULL) {
+			node = rrnx_node_alloc_arena(nodelist->arena, nodetype);
+		} else {
+			node = rrnx_node_alloc(nodetype);
+		}
 		if (node == NULL) break;
 
 		listitem = rrnx_list_append(nodelist, node);
@@ -131,15 +150,50 @@ static rrnx_node *nodelist_alloc_node(rrnx_list *nodelist, int nodetype) {
 			rrnx_list_remove(nodelist, listitem);
 			listitem = NULL;
 		}
-		if (node != NULL) {
+		if ((node != NULL) && (nodelist->arena == NULL)) {
 			rrnx_node_free(node);
-			node = NULL;
 		}
+		node = NULL;
 	}
 
 	return node;
 }
 
+/**
+ * Union of all node payloads. Determines the size of the scratch node.
+ */
+union node_payload {
+	rrnx_format_decl format_decl;
+	rrnx_creation_info creation_info;
+	rrnx_comment comment;
+	rrnx_ion_alpha ion_alpha;
+	rrnx_ion_beta ion_beta;
+	rrnx_delta_utc delta_utc;
+	rrnx_leap_seconds leap_seconds;
+	rrnx_datarecord_nav datarecord_nav;
+};
+
+static rrnx_node *scratch_alloc_node(
+    rrnx_navreader *navreader,
+    int nodetype
+) {
+	rrnx_node *node = navreader->scratch_node;
+	if (node != NULL) {
+		node->type = nodetype;
+		node->size = rrnx_node_data_size(nodetype);
+		memset(node->data, 0, node->size);
+	}
+	return node;
+}
+
+/**
+ * Marks the current node complete, if there is one.
+ */
+static void complete_node(rrnx_navreader *navreader) {
+	navreader->ready_node = navreader->cur_node;
+	navreader->cur_node = NULL;
+}
+
 static rrnx_node *alloc_node(rrnx_navreader *navreader, int type) {
 	// Validate the node type prior to allocation attempt.
 	if (rrnx_node_is_type_valid(type) == 0) {
@@ -152,9 +206,16 @@ static rrnx_node *alloc_node(rrnx_navreader *navreader, int type) {
 		return NULL;
 	}
 
-	// Attempt allocation
+	// Attempt allocation. Without a nodelist, the reader is
+	// streaming, and the node is built into the scratch buffer.
 	//rrnx_node *node = rrnx_nav_alloc_node(navreader->navdata, type);
-	rrnx_node *node = nodelist_alloc_node(navreader->nodelist, type);
+	rrnx_node *node = NULL;
+	if (navreader->nodelist != NULL) {
+		node = nodelist_alloc_node(navreader->nodelist, type);
+	} else {
+		node = scratch_alloc_node(navreader, type);
+	}
+	navreader->cur_node = node;
 
 	if (node == NULL) {
 		// Either a) malloc failed; or b) invalid node type.
@@ -302,31 +363,87 @@ static void parse_int(
 	}
 }
 
+/**
+ * Parses a trimmed Fortran double field directly from the line.
+ * When the fast conversion is not possible, the field is copied,
+ * and parsed with parse_fortran_double(), which also produces
+ * the diagnostics.
+ */
+static void parse_fortran_double_span(
+    rrnx_navreader *navreader,
+    double *result,
+    const char *s,
+    int len
+) {
+	if (navreader->err) {
+		return;
+	}
+
+	if (rrnx_num_parse_fortran(s, len, result)) {
+		// Converted without copies.
+		return;
+	}
+
+	// Copy to the workbuf, leaving space for the terminator.
+	if (len >= navreader->workbuf_size) {
+		len = navreader->workbuf_size-1;
+	}
+	memcpy(navreader->workbuf, s, len);
+	navreader->workbuf[len] = '\0';
+
+	parse_fortran_double(navreader, result, navreader->workbuf);
+}
+
 static void parse_fortran_double_substr(
     rrnx_navreader *navreader,
     double *result,
     const char *line,
+    int linelen,
     int offset,
     int len
 ) {
-	rrnx_substr_trimmed(navreader->workbuf, line, offset, len);
-	parse_fortran_double(navreader, result, navreader->workbuf);
+	const char *field;
+	len = rrnx_field_span(&field, line, linelen, offset, len);
+	parse_fortran_double_span(navreader, result, field, len);
+}
+
+/**
+ * Parses a trimmed integer field. The field is copied,
+ * since strtol() requires a terminated string.
+ */
+static void parse_int_span(
+    rrnx_navreader *navreader,
+    int *result,
+    const char *s,
+    int len
+) {
+	// Copy to the workbuf, leaving space for the terminator.
+	if (len >= navreader->workbuf_size) {
+		len = navreader->workbuf_size-1;
+	}
+	memcpy(navreader->workbuf, s, len);
+	navreader->workbuf[len] = '\0';
+
+	parse_int(navreader, result, navreader->workbuf);
 }
 
 static void parse_int_substr(
     rrnx_navreader *navreader,
     int *result,
     const char *line,
+    int linelen,
     int offset,
     int len
 ) {
-	rrnx_substr_trimmed(navreader->workbuf, line, offset, len);
-	parse_int(navreader, result, navreader->workbuf);
+	const char *field;
+	len = rrnx_field_span(&field, line, linelen, offset, len);
+	parse_int_span(navreader, result, field, len);
 }
 
 static void parse_rinex_decl(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_FORMAT_DECL);
@@ -338,10 +455,10 @@ static void parse_rinex_decl(
 	rrnx_format_decl *data = (void *) node->data;
 
 	// Format version (F9.2)
-	rrnx_substr_trimmed(data->version, line, 0, 9);
+	rrnx_substr_trimmed_n(data->version, line, linelen, 0, 9);
 
 	// File type (A1)
-	data->type = line[20];
+	data->type = (linelen > 20) ? line[20] : ' ';
 
 	// TODO:
 	// Satellite system
@@ -349,7 +466,8 @@ static void parse_rinex_decl(
 
 static void parse_creation_info(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_CREATION_INFO);
@@ -361,19 +479,20 @@ static void parse_creation_info(
 	rrnx_creation_info *data = (void *) node->data;
 
 	// Program name (A20)
-	rrnx_substr_trimmed2(data->program, line, 0, 20);
+	rrnx_substr_trimmed2_n(data->program, line, linelen, 0, 20);
 
 	// Agency name (A20)
-	rrnx_substr_trimmed2(data->agency, line, 20, 20);
+	rrnx_substr_trimmed2_n(data->agency, line, linelen, 20, 20);
 
 	// Creation date (A20)
-	rrnx_substr_trimmed2(data->date, line, 40, 20);
+	rrnx_substr_trimmed2_n(data->date, line, linelen, 40, 20);
 
 }
 
 static void parse_comment(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_COMMENT);
@@ -385,13 +504,14 @@ static void parse_comment(
 	rrnx_comment *data = (void *) node->data;
 
 	// Comment (A60)
-	rrnx_substr_trimmed2(data->text, line, 0, 60);
+	rrnx_substr_trimmed2_n(data->text, line, linelen, 0, 60);
 
 }
 
 static void parse_end_of_header(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_END_OF_HEADER);
@@ -400,7 +520,8 @@ static void parse_end_of_header(
 
 static void parse_ion_alpha(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_ION_ALPHA);
@@ -410,24 +531,25 @@ static void parse_ion_alpha(
 
 	// A0 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->alpha[0], line, 2, 12);
+	    navreader, &data->alpha[0], line, linelen, 2, 12);
 
 	// A1 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->alpha[1], line, 14, 12);
+	    navreader, &data->alpha[1], line, linelen, 14, 12);
 
 	// A2 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->alpha[2], line, 26, 12);
+	    navreader, &data->alpha[2], line, linelen, 26, 12);
 
 	// A3 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->alpha[3], line, 38, 12);
+	    navreader, &data->alpha[3], line, linelen, 38, 12);
 }
 
 static void parse_ion_beta(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_ION_BETA);
@@ -437,25 +559,26 @@ static void parse_ion_beta(
 
 	// B0 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->beta[0], line, 2, 12);
+	    navreader, &data->beta[0], line, linelen, 2, 12);
 
 	// B1 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->beta[1], line, 14, 12);
+	    navreader, &data->beta[1], line, linelen, 14, 12);
 
 	// B2 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->beta[2], line, 26, 12);
+	    navreader, &data->beta[2], line, linelen, 26, 12);
 
 	// B3 (D12.4)
 	parse_fortran_double_substr(
-	    navreader, &data->beta[3], line, 38, 12);
+	    navreader, &data->beta[3], line, linelen, 38, 12);
 
 }
 
 static void parse_delta_utc(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_DELTA_UTC);
@@ -465,25 +588,26 @@ static void parse_delta_utc(
 
 	// A0 (D19.12)
 	parse_fortran_double_substr(
-	    navreader, &data->a0, line, 3, 19);
+	    navreader, &data->a0, line, linelen, 3, 19);
 
 	// A1 (D19.12)
 	parse_fortran_double_substr(
-	    navreader, &data->a1, line, 22, 19);
+	    navreader, &data->a1, line, linelen, 22, 19);
 
 	// T (I9)
 	// TODO: This is optional!
 	parse_int_substr(
-	    navreader, &data->T, line, 41, 9);
+	    navreader, &data->T, line, linelen, 41, 9);
 
 	// W (I9)
 	parse_int_substr(
-	    navreader, &data->T_week, line, 50, 9);
+	    navreader, &data->T_week, line, linelen, 50, 9);
 }
 
 static void parse_leap_seconds(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	rrnx_node *node = alloc_node(
 	    navreader, RRNX_ID_LEAP_SECONDS);
@@ -493,291 +617,151 @@ static void parse_leap_seconds(
 
 	// Leap seconds (I6)
 	parse_int_substr(
-	    navreader, &data->leap_seconds, line, 0, 6);
+	    navreader, &data->leap_seconds, line, linelen, 0, 6);
 }
 
 
 /**
- * Parses a fortran double field (Fx.y) in a BROADCAST ORBIT line.
- *
- * The BC orbit field is specified by "fieldnum".
- * Its value must be within 0-3.
- *
- * The result is stored into the variable pointed by "result".
- *
- * If unempty_flag is not NULL, then the variable is set to either 0 or 1
- * depending on whether the field is empty (0) or unempty (1).
- * If unempty_flag is NULL, then empty field results in an error.
- *
+ * Parses the fields of a single record line as laid out by the schema.
+ * The fields are consumed in one pass, starting from cur_field.
  */
-static void parse_bco_value(
+static void parse_schema_line(
     rrnx_navreader *navreader,
+    const rrnx_schema *schema,
+    int lineno,
     const char *line,
-    int fieldnum,
-    double *result,
-    int *unempty_flag
+    int linelen,
+    void *record
 ) {
-	// Length of a field
-	int len = 19;
-	// Compute the starting offset for the requested field.
-	int offset = 3 + (fieldnum * len);
+	const rrnx_schema_field *field = &schema->fields[navreader->cur_field];
+	const rrnx_schema_field *end = &schema->fields[schema->num_fields];
+
+	for (; (field < end) && (field->line == lineno); field++) {
+		// Locate the field within the line; no copies.
+		const char *s;
+		int len = rrnx_field_span(
+		    &s, line, linelen, field->column, field->width);
+
+		if (field->valid_offset >= 0) {
+			// Record field blank status
+			int *valid = (void *) ((char *) record + field->valid_offset);
+			*valid = (len > 0);
+			if (len == 0) {
+				// Blanks are allowed.
+				continue;
+			}
+		} else if ((len == 0)
+		    && (field->valid_offset == RRNX_BLANK_ERROR))
+		{
+			// Error. Blanks are not allowed.
+			errmsg_format(
+			    navreader, RRNX_E_BLANK,
+			    "Cannot convert %s line\'s field #%d to a number: the field is blank",
+			    schema->linename, field->fieldnum
+			); // ermsg_format()
+			break;
+		}
+
+		void *dest = (char *) record + field->offset;
 
-	int workbuf_len = rrnx_substr_trimmed(
-	    navreader->workbuf, line, offset, len);
+		switch(field->type) {
+		case RRNX_FIELD_DOUBLE:
+			parse_fortran_double_span(navreader, dest, s, len);
+			break;
+		case RRNX_FIELD_INT:
+			parse_int_span(navreader, dest, s, len);
+			break;
+		default:
+			break;
+		}
 
-	// Record field blank status
-	if (unempty_flag != NULL) {
-		*unempty_flag = (workbuf_len > 0);
+		if (navreader->err) {
+			break;
+		}
 	}
 
-	if (workbuf_len > 0) {
-		// Attempt parsing
-		parse_fortran_double(
-		    navreader, result, navreader->workbuf);
-	} else if (unempty_flag != NULL) {
-		// Blanks are allowed.
-	} else {
-		// Error. Blanks are not allowed.
-		errmsg_format(
-		    navreader, RRNX_E_BLANK,
-		    "Cannot convert broadcast orbit line\'s field #%d to a number: the field is blank",
-	    	    fieldnum+1
-		); // ermsg_format()
-	} // if-else
+	navreader->cur_field = field - schema->fields;
 }
 
-static void parse_broadcast_orbit0(
+/**
+ * Parses a line of a navigation message: the PRN / EPOCH / SV CLK
+ * line (lineno 0) or one of the BROADCAST ORBIT lines.
+ */
+static void parse_datarecord_line(
     rrnx_navreader *navreader,
-    const char *line
+    int lineno,
+    const char *line,
+    int linelen
 ) {
-	// Allocate a new data record node,
-	// and store a pointer to the navmsg
-	// that is currently being built.
-	navreader->cur_navmsg = alloc_datarecord_node(navreader);
+	const rrnx_schema *schema = &rrnx_schema_gps_nav;
+
+	if (lineno == 0) {
+		// Allocate a new data record node,
+		// and store a pointer to the navmsg
+		// that is currently being built.
+		navreader->cur_navmsg = alloc_datarecord_node(navreader);
+		navreader->cur_field = 0;
+	}
 
 	rrnx_navmsg *data = navreader->cur_navmsg;
 	if (data == NULL) return; // Alloc failed, abort.
 
+	parse_schema_line(navreader, schema, lineno, line, linelen, data);
 
-	// Satellite PRN number (I2)
-	parse_int_substr(
-	    navreader, &data->sv_id, line, 0, 2);
-
-	// For convenience
-	rrnx_datetime *Toc = &data->toc;
-	// Epoch: year (I2.2)
-	parse_int_substr(
-	    navreader, &Toc->year, line, 3, 2);
-	// Epoch: month (I2)
-	parse_int_substr(
-	    navreader, &Toc->month, line, 6, 2);
-	// Epoch: day (I2)
-	parse_int_substr(
-	    navreader, &Toc->day, line, 9, 2);
-	// Epoch: hour (I2)
-	parse_int_substr(
-	    navreader, &Toc->hour, line, 12, 2);
-	// Epoch: minute (I2)
-	parse_int_substr(
-	    navreader, &Toc->min, line, 15, 2);
-	// Epoch: second (F5.1)
-	parse_fortran_double_substr(
-	    navreader, &Toc->sec, line, 17, 5);
-
-	// Ordinary broadcast orbit line items.
-
-	parse_bco_value(navreader, line, 1, &data->af0, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->af1, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3,
-	    &data->af2, &data->valid_af2);
-	if (navreader->err) return;
-
-}
-
-static void parse_broadcast_orbit1(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->IODE, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1, &data->Crs, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->delta_n, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3, &data->M0, NULL);
-	if (navreader->err) return;
-
-}
-
-static void parse_broadcast_orbit2(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->Cuc, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1, &data->e, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->Cus, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3, &data->sqrtA, NULL);
-	if (navreader->err) return;
-}
-
-static void parse_broadcast_orbit3(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->toe, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1, &data->Cic, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->OMEGA0, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3, &data->Cis, NULL);
-	if (navreader->err) return;
-}
-
-static void parse_broadcast_orbit4(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->i0, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1, &data->Crc, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->w, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3, &data->OMEGADOT, NULL);
-	if (navreader->err) return;
-
-}
-
-static void parse_broadcast_orbit5(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->idot, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1, &data->L2_codes, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->toe_week, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3, &data->L2P_dataflag, NULL);
-	if (navreader->err) return;
-}
-
-static void parse_broadcast_orbit6(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->accuracy, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1, &data->health, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2, &data->Tgd, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3, &data->IODC, NULL);
-	if (navreader->err) return;
-}
-
-static void parse_broadcast_orbit7(
-    rrnx_navreader *navreader,
-    const char *line
-) {
-	rrnx_navmsg *data = navreader->cur_navmsg;
-
-	parse_bco_value(navreader, line, 0, &data->tow, NULL);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 1,
-	    &data->fit_interval, &data->valid_fit_interval);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 2,
-	    &data->spare1, &data->valid_spare1);
-	if (navreader->err) return;
-
-	parse_bco_value(navreader, line, 3,
-	    &data->spare2, &data->valid_spare2);
-	if (navreader->err) return;
-
-	// The navigation message is now complete.
-	// Consequently, unset the current navmsg
-	navreader->cur_navmsg = NULL;
+	if ((navreader->err == RRNX_E_OK)
+	    && (lineno == schema->num_lines-1))
+	{
+		// The navigation message is now complete.
+		// Consequently, unset the current navmsg
+		navreader->cur_navmsg = NULL;
+	}
 }
 
 static void parse_unknown(
     rrnx_navreader *navreader,
-    const char *line
+    const char *line,
+    int linelen
 ) {
 	// Dummy. TODO: Remove this function??
 }
 
-static int parse_line(rrnx_navreader *navreader, const char *line) {
-	int label_id = rrnx_enumerate_linetype(line);
-
-	switch(label_id) {
+/**
+ * Parses a header line, which has been classified already.
+ */
+static int parse_line(
+    rrnx_navreader *navreader,
+    const char *line,
+    int linelen,
+    int linetype
+) {
+	switch(linetype) {
 	case RRNX_LBL_RINEX_DECL:
-		parse_rinex_decl(navreader, line);
+		parse_rinex_decl(navreader, line, linelen);
 		break;
 	case RRNX_LBL_CREATION_INFO:
-		parse_creation_info(navreader, line);
+		parse_creation_info(navreader, line, linelen);
 		break;
 	case RRNX_LBL_COMMENT:
-		parse_comment(navreader, line);
+		parse_comment(navreader, line, linelen);
 		break;
 	case RRNX_LBL_END_OF_HEADER:
-		parse_end_of_header(navreader, line);
+		parse_end_of_header(navreader, line, linelen);
 		break;
 	case RRNX_LBL_ION_ALPHA:
-		parse_ion_alpha(navreader, line);
+		parse_ion_alpha(navreader, line, linelen);
 		break;
 	case RRNX_LBL_ION_BETA:
-		parse_ion_beta(navreader, line);
+		parse_ion_beta(navreader, line, linelen);
 		break;
 	case RRNX_LBL_DELTA_UTC:
-		parse_delta_utc(navreader, line);
+		parse_delta_utc(navreader, line, linelen);
 		break;
 	case RRNX_LBL_LEAP_SECONDS:
-		parse_leap_seconds(navreader, line);
+		parse_leap_seconds(navreader, line, linelen);
 		break;
 
 	case RRNX_LBL_UNKNOWN:
-		parse_unknown(navreader, line);
+		parse_unknown(navreader, line, linelen);
 		break;
 
 	default:
@@ -807,6 +791,7 @@ static int parse_line(rrnx_navreader *navreader, const char *line) {
 static int cycle_data(
     rrnx_navreader *navreader,
     const char *line,
+    int linelen,
     int linetype
 ) {
 	// For every state, always.
@@ -815,9 +800,11 @@ static int cycle_data(
 	// Rename into S_EXPECT_HEADER
 	case S_HEADER:
 		if (linetype != RRNX_LBL_UNKNOWN) {
-			parse_line(navreader, line);
+			parse_line(navreader, line, linelen, linetype);
 			if (navreader->err) {
 				navreader->state = S_ERROR;
+			} else {
+				complete_node(navreader);
 			}
 		}
 		if (linetype == RRNX_LBL_END_OF_HEADER) {
@@ -848,74 +835,23 @@ static int cycle_data(
 		break;
 
 	case S_BROADCAST_ORBIT0:
-		parse_broadcast_orbit0(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT1;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT1:
-		parse_broadcast_orbit1(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT2;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT2:
-		parse_broadcast_orbit2(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT3;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT3:
-		parse_broadcast_orbit3(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT4;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT4:
-		parse_broadcast_orbit4(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT5;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT5:
-		parse_broadcast_orbit5(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT6;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT6:
-		parse_broadcast_orbit6(navreader, line);
-		if (!navreader->err) {
-			navreader->state = S_BROADCAST_ORBIT7;
-		} else {
-			navreader->state = S_ERROR;
-		}
-		break;
-
 	case S_BROADCAST_ORBIT7:
-		parse_broadcast_orbit7(navreader, line);
-		if (!navreader->err) {
+		// The states are consecutive
+		parse_datarecord_line(navreader,
+		    navreader->state - S_BROADCAST_ORBIT0, line, linelen);
+		if (navreader->err) {
+			navreader->state = S_ERROR;
+		} else if (navreader->state == S_BROADCAST_ORBIT7) {
+			complete_node(navreader);
 			navreader->state = S_EXPECT_ORBIT_OR_EOF;
 		} else {
-			navreader->state = S_ERROR;
+			navreader->state++;
 		}
 		break;
 
@@ -979,10 +915,23 @@ rrnx_navreader *rrnx_navr_alloc(void) {
 		//navreader->navdata = NULL;
 		navreader->nodelist = NULL;
 		navreader->cur_navmsg = NULL;
+		navreader->cur_field = 0;
+		navreader->cur_node = NULL;
+		navreader->ready_node = NULL;
+		navreader->scratch_node = NULL;
 		navreader->errmsg = NULL;
 		navreader->err = RRNX_E_OK;
 		navreader->workbuf = NULL;
 		navreader->workbuf_size = 0;
+		navreader->use_mmap = 0;
+		navreader->pending = NULL;
+		navreader->pending_len = 0;
+		navreader->pending_size = 0;
+		navreader->follow_fd = -1;
+		navreader->follow_name = NULL;
+		navreader->follow_offset = 0;
+		navreader->row = 0;
+		navreader->notify_fd = -1;
 
 		// These are not neccessary initializations
 		navreader->state = 0;
@@ -1045,6 +994,15 @@ void rrnx_navr_free(rrnx_navreader *navreader) {
 	navreader->workbuf = NULL;
 	navreader->workbuf_size = 0;
 
+	free(navreader->scratch_node);
+	navreader->scratch_node = NULL;
+
+	// Stop following, if following
+	rrnx_navr_follow_close(navreader);
+	free(navreader->pending);
+	navreader->pending = NULL;
+	navreader->pending_size = 0;
+
 	// Deallocate self
 	free(navreader);
 }
@@ -1076,11 +1034,22 @@ void rrnx_navr_bind(
 }
 
 
-int rrnx_navr_consume(rrnx_navreader *navreader, const char *line) {
-
-	// Determine the tag code on the line, if any
-	int linetype = rrnx_enumerate_linetype(line);
-	//enumerate_label(line);
+/**
+ * Feeds a single line, given as a span, to the parser.
+ * The line need not to be terminated.
+ * NULL line signals the end-of-file.
+ */
+static int consume_span(
+    rrnx_navreader *navreader,
+    const char *line,
+    int linelen
+) {
+	// Determine the tag code on the line, if any. Only the header
+	// lines have labels, so the data lines are not classified.
+	int linetype = RRNX_LBL_UNKNOWN;
+	if (navreader->state == S_HEADER) {
+		linetype = rrnx_enumerate_linetype_n(line, linelen);
+	}
 
 	do {
 		// Reset null-transition flag
@@ -1088,7 +1057,7 @@ int rrnx_navr_consume(rrnx_navreader *navreader, const char *line) {
 
 		// Perform one cycle per loop
 		if (line != NULL) {
-			cycle_data(navreader, line, linetype);
+			cycle_data(navreader, line, linelen, linetype);
 		} else {
 			cycle_eof(navreader);
 		} // if-else
@@ -1098,62 +1067,519 @@ int rrnx_navr_consume(rrnx_navreader *navreader, const char *line) {
 	return navreader->err;
 }
 
-void rrnx_navr_readfile(
-    rrnx_navreader *navreader,
-    const char *filename
-) {
+int rrnx_navr_consume(rrnx_navreader *navreader, const char *line) {
+	int linelen = (line != NULL) ? strlen(line) : 0;
+	return consume_span(navreader, line, linelen);
+}
+
+void rrnx_navr_set_mmap(rrnx_navreader *navreader, int enabled) {
+	navreader->use_mmap = enabled;
+}
+
+/**
+ * Opens the file, and resets the parser.
+ */
+static int open_file(rrnx_navreader *navreader, const char *filename) {
 	// For convenience
 	rrnx_filereader *fr = navreader->fr;
 
+	// Clear any previous error
+	errmsg_none(navreader, RRNX_E_OK);
+
 	// Open file
-	rrnx_fr_fopen(fr, filename);
+	if (navreader->use_mmap) {
+		rrnx_fr_mmap(fr, filename);
+	} else {
+		rrnx_fr_fopen(fr, filename);
+	}
 	if (fr->err) {
 		// fopen() failed; propagate error
-		errmsg_fr(navreader);
-		return;
+		return errmsg_fr(navreader);
 	}
 
-	char line[0x200];
-
 	// Reset parser state
 	navreader->state = S_HEADER;
+	navreader->cur_navmsg = NULL;
+	navreader->cur_node = NULL;
+	navreader->ready_node = NULL;
+
+	return navreader->err;
+}
 
+/**
+ * Replaces the nodelist with a new one.
+ */
+static int reset_nodelist(rrnx_navreader *navreader) {
 	// If there's a previous nodelist, free it first.
 	rrnx_list_free(navreader->nodelist);
 	navreader->nodelist = NULL;
 
-	// Allocate a new nodelist
-	navreader->nodelist = rrnx_list_alloc();
+	// Allocate a new nodelist. The nodes and the list items
+	// are allocated from the arena of the list, and they are
+	// released all at once when the list is freed.
+	navreader->nodelist = rrnx_list_alloc_arena();
 	if (navreader->nodelist == NULL) {
 		// Mem alloc failed, abort.
-		errmsg_none(navreader, RRNX_E_NOMEM);
+		return errmsg_none(navreader, RRNX_E_NOMEM);
 	}
-	// Configure a custom destructor for the nodelist.
-	navreader->nodelist->destructor = (void *) rrnx_node_free;
 
-	while ((navreader->state != S_ERROR)
-	    && (navreader->state != S_FINISHED))
-	{
-		// Read a line
-		rrnx_fr_readline(fr, line, sizeof(line));
+	return navreader->err;
+}
 
-		if (fr->err == RRNX_E_EOF) {
-			// Eof reached.
-			// Signal the eof to the parser
-			// using a special value.
-			rrnx_navr_consume(navreader, NULL);
-			break;
-		}
-		else if (fr->err) {
-			// Non-eof error. Propagate upwards
-			errmsg_fr(navreader);
-			break;
-		}
+void rrnx_navr_readfile(
+    rrnx_navreader *navreader,
+    const char *filename
+) {
+	if (open_file(navreader, filename)) {
+		return;
+	}
+
+	if (reset_nodelist(navreader)) {
+		rrnx_fr_fclose(navreader->fr);
+		return;
+	}
+
+	// The nodes are collected into the nodelist while reading.
+	const rrnx_node *node;
+	while (rrnx_navr_next(navreader, &node)) {
+		// Nothing to do
+	}
+
+	// Close the file.
+	// If this causes an error, it hides any parsing errors.. TODO
+	rrnx_navr_close(navreader);
+}
+
+//--- consuming memory blocks ---------------------------------------------//
+
+/**
+ * Makes room for at least extra bytes after the pending bytes.
+ */
+static int reserve_pending(rrnx_navreader *navreader, size_t extra) {
+	if (navreader->pending_size - navreader->pending_len >= extra) {
+		return RRNX_E_OK;
+	}
+
+	size_t size = navreader->pending_len + extra;
+	char *pending = realloc(navreader->pending, size);
+	if (pending == NULL) {
+		return errmsg_none(navreader, RRNX_E_NOMEM);
+	}
+	navreader->pending = pending;
+	navreader->pending_size = size;
+
+	return RRNX_E_OK;
+}
+
+static int append_pending(
+    rrnx_navreader *navreader,
+    const char *buf,
+    size_t len
+) {
+	if (reserve_pending(navreader, len) == RRNX_E_OK) {
+		memcpy(navreader->pending + navreader->pending_len, buf, len);
+		navreader->pending_len += len;
+	}
+	return navreader->err;
+}
+
+/**
+ * Feeds a line without the newline to the parser.
+ * A trailing carriage return is stripped, as when reading a file.
+ */
+static int consume_block_line(
+    rrnx_navreader *navreader,
+    const char *line,
+    size_t linelen
+) {
+	if ((linelen > 0) && (line[linelen-1] == '\r')) {
+		linelen--;
+	}
+	navreader->row++;
+	return consume_span(navreader, line, (int) linelen);
+}
+
+/**
+ * Tells whether a file is being parsed by rrnx_navr_consume_block().
+ */
+static int block_in_progress(const rrnx_navreader *navreader) {
+	return (navreader->nodelist != NULL)
+	    && (navreader->state >= S_HEADER)
+	    && (navreader->state != S_ERROR)
+	    && (navreader->state != S_EOF)
+	    && (navreader->state != S_FINISHED);
+}
+
+int rrnx_navr_consume_block(
+    rrnx_navreader *navreader,
+    const char *buf,
+    size_t len
+) {
+	if (!block_in_progress(navreader)) {
+		// Begin a new file
+		errmsg_none(navreader, RRNX_E_OK);
+		if (reset_nodelist(navreader)) {
+			return navreader->err;
+		}
+		navreader->state = S_HEADER;
+		navreader->cur_navmsg = NULL;
+		navreader->cur_node = NULL;
+		navreader->ready_node = NULL;
+		navreader->pending_len = 0;
+		navreader->row = 0;
+	}
+
+	if (buf == NULL) {
+		// End of input. A partial line is the last line.
+		if (navreader->pending_len > 0) {
+			consume_block_line(navreader,
+			    navreader->pending, navreader->pending_len);
+			navreader->pending_len = 0;
+		}
+		if (navreader->err == RRNX_E_OK) {
+			consume_span(navreader, NULL, 0);
+		}
+	} else {
+		const char *end = buf + len;
+
+		if (navreader->pending_len > 0) {
+			// Complete the partial line of the previous block.
+			const char *nl = memchr(buf, '\n', len);
+			size_t n = (nl != NULL) ? (size_t) (nl - buf) : len;
+			if (append_pending(navreader, buf, n)) {
+				return navreader->err;
+			}
+			if (nl == NULL) {
+				// Still incomplete
+				return navreader->err;
+			}
+			consume_block_line(navreader,
+			    navreader->pending, navreader->pending_len);
+			navreader->pending_len = 0;
+			buf = nl + 1;
+		}
+
+		while ((buf < end) && (navreader->err == RRNX_E_OK)) {
+			const char *nl = memchr(buf, '\n', end - buf);
+			if (nl == NULL) {
+				// Keep the partial line until the next block.
+				append_pending(navreader, buf, end - buf);
+				break;
+			}
+			consume_block_line(navreader, buf, nl - buf);
+			buf = nl + 1;
+		}
+	}
+
+	if (navreader->err) {
+		errmsg_prepend(navreader, "line %u: ", navreader->row);
+	}
+
+	return navreader->err;
+}
+
+//--- parallel reading -----------------------------------------------------//
+
+/**
+ * Number of lines in a data record: PRN/EPOCH/SV CLK line,
+ * and seven BROADCAST ORBIT lines.
+ */
+#define RECORD_LINES 8
+
+/**
+ * Smallest data section chunk (bytes) worth a thread of its own.
+ */
+#define MIN_CHUNK_SIZE 0x40000
+
+/**
+ * A part of the data section, which begins at a record boundary.
+ */
+struct chunk {
+	/** Parser for the chunk. */
+	rrnx_navreader *navreader;
+	/** For error messages. */
+	const char *filename;
+	/** Chunk contents. */
+	const char *begin;
+	size_t size;
+	/** Number of lines before the chunk. */
+	unsigned int row;
+};
+
+static void *parse_chunk(void *arg) {
+	struct chunk *chunk = arg;
+	rrnx_navreader *navreader = chunk->navreader;
+	rrnx_filereader *fr = navreader->fr;
+
+	errmsg_none(navreader, RRNX_E_OK);
+
+	rrnx_fr_openmem(fr, chunk->filename,
+	    chunk->begin, chunk->size, chunk->row);
+	if (fr->err) {
+		errmsg_fr(navreader);
+		return NULL;
+	}
+
+	if (reset_nodelist(navreader) == RRNX_E_OK) {
+		// The chunk begins at a record boundary.
+		navreader->state = S_EXPECT_ORBIT_OR_EOF;
+
+		const rrnx_node *node;
+		while (rrnx_navr_next(navreader, &node)) {
+			// Nothing to do
+		}
+	}
+
+	rrnx_navr_close(navreader);
+
+	return NULL;
+}
+
+/**
+ * Splits the remaining data section of a memory-mapped file into
+ * chunks, parses them concurrently, and joins the results in order.
+ * Leaves the file untouched if it is too small to be split.
+ */
+static void parse_data_parallel(
+    rrnx_navreader *navreader,
+    int num_threads
+) {
+	// For convenience
+	rrnx_filereader *fr = navreader->fr;
+
+	const char *data = fr->map + fr->map_at;
+	size_t size = fr->map_size - fr->map_at;
+
+	size_t num_chunks = size / MIN_CHUNK_SIZE;
+	if (num_chunks > (size_t) num_threads) {
+		num_chunks = num_threads;
+	}
+	if (num_chunks < 2) {
+		// Not worth it
+		return;
+	}
+
+	struct chunk *chunks = calloc(num_chunks, sizeof(struct chunk));
+	pthread_t *threads = calloc(num_chunks, sizeof(pthread_t));
+	int *started = calloc(num_chunks, sizeof(int));
+
+	if ((chunks == NULL) || (threads == NULL) || (started == NULL)) {
+		errmsg_none(navreader, RRNX_E_NOMEM);
+		num_chunks = 0;
+	}
+
+	// Find the chunk boundaries by counting lines. Since every record
+	// has the same number of lines, the boundaries are exact, and so
+	// are the line numbers within the chunks.
+	size_t n = 0;
+	if (num_chunks > 0) {
+		chunks[0].begin = data;
+		chunks[0].row = fr->row;
+		n = 1;
+	}
+
+	size_t pos = 0;
+	unsigned int lines = 0;
+	while ((n < num_chunks) && (pos < size)) {
+		if (((lines % RECORD_LINES) == 0)
+		    && (pos >= (size / num_chunks) * n))
+		{
+			chunks[n].begin = data + pos;
+			chunks[n].row = fr->row + lines;
+			n++;
+			continue;
+		}
+
+		const char *nl = memchr(data + pos, '\n', size - pos);
+		pos = (nl != NULL) ? (size_t)(nl - data) + 1 : size;
+		lines++;
+	}
+	num_chunks = n;
+
+	for (size_t i = 0; i < num_chunks; i++) {
+		const char *end = (i+1 < num_chunks)
+		    ? chunks[i+1].begin : data + size;
+		chunks[i].size = end - chunks[i].begin;
+		chunks[i].filename = fr->filename;
+		chunks[i].navreader = rrnx_navr_alloc();
+		if (chunks[i].navreader == NULL) {
+			errmsg_none(navreader, RRNX_E_NOMEM);
+		}
+	}
+
+	if (navreader->err == RRNX_E_OK) {
+		// The first chunk is parsed by this thread.
+		for (size_t i = 1; i < num_chunks; i++) {
+			started[i] = (pthread_create(&threads[i], NULL,
+			    parse_chunk, &chunks[i]) == 0);
+		}
+
+		for (size_t i = 0; i < num_chunks; i++) {
+			if (i == 0) {
+				parse_chunk(&chunks[i]);
+			} else if (started[i]) {
+				pthread_join(threads[i], NULL);
+			} else {
+				// Couldn't start a thread; parse here instead.
+				parse_chunk(&chunks[i]);
+			}
+		}
+
+		// Join the results in the file order, up to the first
+		// error, like a sequential parser would have stopped there.
+		navreader->state = S_FINISHED;
+		for (size_t i = 0; i < num_chunks; i++) {
+			rrnx_navreader *worker = chunks[i].navreader;
+
+			if (worker->nodelist != NULL) {
+				rrnx_list_splice(
+				    navreader->nodelist, worker->nodelist);
+			}
+
+			if (worker->err) {
+				// The message includes the location already.
+				navreader->err = worker->err;
+				rrnx_str_strcpy(navreader->errmsg,
+				    worker->errmsg->text);
+				navreader->state = S_ERROR;
+				break;
+			}
+		}
+	} else {
+		navreader->state = S_ERROR;
+	}
+
+	for (size_t i = 0; i < num_chunks; i++) {
+		rrnx_navr_free(chunks[i].navreader);
+	}
+	free(chunks);
+	free(threads);
+	free(started);
+}
+
+void rrnx_navr_readfile_parallel(
+    rrnx_navreader *navreader,
+    const char *filename,
+    int num_threads
+) {
+	// For convenience
+	rrnx_filereader *fr = navreader->fr;
+
+	// The chunks are parsed directly from the memory mapping.
+	int use_mmap = navreader->use_mmap;
+	navreader->use_mmap = 1;
+	open_file(navreader, filename);
+	navreader->use_mmap = use_mmap;
+
+	if (navreader->err) {
+		return;
+	}
+
+	if (reset_nodelist(navreader)) {
+		rrnx_fr_fclose(fr);
+		return;
+	}
+
+	if (num_threads <= 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cpus > 0) ? (int) cpus : 1;
+	}
+
+	// Parse the header sequentially.
+	const rrnx_node *node;
+	while ((navreader->state == S_HEADER)
+	    && rrnx_navr_next(navreader, &node))
+	{
+		// Nothing to do
+	}
+
+	if ((navreader->state == S_EXPECT_ORBIT_OR_EOF)
+	    && (fr->mapped) && (num_threads > 1))
+	{
+		parse_data_parallel(navreader, num_threads);
+	}
+
+	// Anything left is parsed sequentially.
+	while (rrnx_navr_next(navreader, &node)) {
+		// Nothing to do
+	}
+
+	rrnx_navr_close(navreader);
+}
+
+/**
+ * Prepares for streaming: the nodes are not collected,
+ * but built into the scratch node.
+ */
+static int open_scratch(rrnx_navreader *navreader) {
+	rrnx_list_free(navreader->nodelist);
+	navreader->nodelist = NULL;
+
+	if (navreader->scratch_node == NULL) {
+		navreader->scratch_node = malloc(
+		    sizeof(rrnx_node) + sizeof(union node_payload));
+		if (navreader->scratch_node == NULL) {
+			return errmsg_none(navreader, RRNX_E_NOMEM);
+		}
+	}
+
+	return RRNX_E_OK;
+}
+
+int rrnx_navr_open(rrnx_navreader *navreader, const char *filename) {
+	if (open_scratch(navreader)) {
+		return navreader->err;
+	}
+
+	return open_file(navreader, filename);
+}
+
+int rrnx_navr_next(rrnx_navreader *navreader, const rrnx_node **node) {
+	// For convenience
+	rrnx_filereader *fr = navreader->fr;
+
+	// Current line
+	const char *line;
+	unsigned int linelen;
+
+	*node = NULL;
+
+	if (navreader->err) {
+		// Already failed, and reported.
+		return 0;
+	}
+
+	while ((navreader->state != S_ERROR)
+	    && (navreader->state != S_FINISHED))
+	{
+		// Read a line. When the file is memory-mapped,
+		// the line points directly into the mapping.
+		rrnx_fr_readspan(fr, &line, &linelen);
+
+		if (fr->err == RRNX_E_EOF) {
+			// Eof reached.
+			// Signal the eof to the parser
+			// using a special value.
+			consume_span(navreader, NULL, 0);
+			break;
+		}
+		else if (fr->err) {
+			// Non-eof error. Propagate upwards
+			errmsg_fr(navreader);
+			break;
+		}
 		else {
 			// Succesfully read a line.
-			rrnx_navr_consume(navreader, line);
+			consume_span(navreader, line, linelen);
 		} // if-else
 
+		if (navreader->ready_node != NULL) {
+			// A node was completed; deliver it.
+			*node = navreader->ready_node;
+			navreader->ready_node = NULL;
+			return 1;
+		}
+
 	} // while
 
 	// If the loop halted with an error code
@@ -1161,9 +1587,38 @@ void rrnx_navr_readfile(
 		errmsg_prepend_location(navreader);
 	}
 
-	// Close the file.
-	// If this causes an error, it hides any parsing errors.. TODO
-	rrnx_fr_fclose(fr);
+	return 0;
+}
+
+void rrnx_navr_close(rrnx_navreader *navreader) {
+	rrnx_fr_fclose(navreader->fr);
+
+	navreader->cur_navmsg = NULL;
+	navreader->cur_node = NULL;
+	navreader->ready_node = NULL;
+}
+
+int rrnx_navr_readfile_cb(
+    rrnx_navreader *navreader,
+    const char *filename,
+    rrnx_navr_callback callback,
+    void *userdata
+) {
+	if (rrnx_navr_open(navreader, filename)) {
+		return navreader->err;
+	}
+
+	const rrnx_node *node;
+	while (rrnx_navr_next(navreader, &node)) {
+		if (callback(userdata, node)) {
+			// Stopped by the caller
+			break;
+		}
+	}
+
+	rrnx_navr_close(navreader);
+
+	return navreader->err;
 }
 
 rrnx_list *rrnx_navr_release_nodelist(rrnx_navreader *navreader) {
@@ -1172,3 +1627,269 @@ rrnx_list *rrnx_navr_release_nodelist(rrnx_navreader *navreader) {
 	return nodelist;
 }
 
+
+//--- following a growing file ---------------------------------------------//
+
+/**
+ * Number of bytes read from the followed file at a time.
+ */
+#define FOLLOW_READ_SIZE 0x10000
+
+/**
+ * Interval (ms) of checking the file size, when there are no
+ * change notifications.
+ */
+#define FOLLOW_POLL_INTERVAL 100
+
+int rrnx_navr_follow_open(rrnx_navreader *navreader, const char *filename) {
+	rrnx_navr_follow_close(navreader);
+
+	// The nodes are delivered one at a time, as when streaming.
+	if (open_scratch(navreader)) {
+		return navreader->err;
+	}
+
+	errmsg_none(navreader, RRNX_E_OK);
+
+	navreader->follow_name = strdup(filename);
+	if (navreader->follow_name == NULL) {
+		return errmsg_none(navreader, RRNX_E_NOMEM);
+	}
+
+	navreader->follow_fd = open(filename, O_RDONLY);
+	if (navreader->follow_fd < 0) {
+		errmsg_format(navreader, RRNX_E_SYSCALL,
+		    "%s: open() failed: %s", filename, strerror(errno));
+		rrnx_navr_follow_close(navreader);
+		return navreader->err;
+	}
+
+#ifdef __linux__
+	// Without a watch, rrnx_navr_follow_wait() falls back to polling.
+	navreader->notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if ((navreader->notify_fd >= 0)
+	    && (inotify_add_watch(navreader->notify_fd, filename,
+	    IN_MODIFY | IN_CLOSE_WRITE) < 0))
+	{
+		close(navreader->notify_fd);
+		navreader->notify_fd = -1;
+	}
+#endif
+
+	// Reset parser state
+	navreader->state = S_HEADER;
+	navreader->cur_navmsg = NULL;
+	navreader->cur_node = NULL;
+	navreader->ready_node = NULL;
+
+	navreader->pending_len = 0;
+	navreader->follow_offset = 0;
+	navreader->row = 0;
+
+	return navreader->err;
+}
+
+/**
+ * Parses the complete lines of the pending buffer, and removes them.
+ * Returns 1 if the callback stopped the parsing, and 0 otherwise.
+ */
+static int parse_pending(
+    rrnx_navreader *navreader,
+    rrnx_navr_callback callback,
+    void *userdata
+) {
+	// For convenience
+	rrnx_filereader *fr = navreader->fr;
+
+	// Find the end of the last complete line
+	size_t size = navreader->pending_len;
+	while ((size > 0) && (navreader->pending[size-1] != '\n')) {
+		size--;
+	}
+	if (size == 0) {
+		// No complete lines
+		return 0;
+	}
+
+	rrnx_fr_openmem(fr, navreader->follow_name,
+	    navreader->pending, size, navreader->row);
+	if (fr->err) {
+		errmsg_fr(navreader);
+		return 0;
+	}
+
+	int stopped = 0;
+	while (!stopped && (navreader->state != S_ERROR)) {
+		const char *line;
+		unsigned int linelen;
+		rrnx_fr_readspan(fr, &line, &linelen);
+		if (fr->err == RRNX_E_EOF) {
+			// No more complete lines. Unlike at the end of
+			// a file, the parser is not told; more may follow.
+			break;
+		} else if (fr->err) {
+			errmsg_fr(navreader);
+			break;
+		}
+
+		consume_span(navreader, line, linelen);
+
+		if (navreader->ready_node != NULL) {
+			const rrnx_node *node = navreader->ready_node;
+			navreader->ready_node = NULL;
+			stopped = callback(userdata, node);
+		}
+	}
+
+	if (navreader->err) {
+		errmsg_prepend_location(navreader);
+	}
+
+	// Drop the parsed lines
+	size_t consumed = fr->map_at;
+	navreader->row = fr->row;
+	rrnx_fr_fclose(fr);
+
+	memmove(navreader->pending, navreader->pending + consumed,
+	    navreader->pending_len - consumed);
+	navreader->pending_len -= consumed;
+
+	return stopped;
+}
+
+int rrnx_navr_follow_poll(
+    rrnx_navreader *navreader,
+    rrnx_navr_callback callback,
+    void *userdata
+) {
+	if (navreader->err) {
+		// Already failed, and reported.
+		return navreader->err;
+	}
+
+	if (navreader->follow_fd < 0) {
+		return errmsg_format(navreader, RRNX_E_NOFILE,
+		    "No file is being followed");
+	}
+
+	for (;;) {
+		// Lines left over from the previous call come first.
+		if (parse_pending(navreader, callback, userdata)) {
+			// Stopped by the caller
+			break;
+		}
+		if (navreader->err) {
+			break;
+		}
+
+		// Make room for the next read
+		if (reserve_pending(navreader, FOLLOW_READ_SIZE)) {
+			break;
+		}
+
+		ssize_t n = read(navreader->follow_fd,
+		    navreader->pending + navreader->pending_len,
+		    navreader->pending_size - navreader->pending_len);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			errmsg_format(navreader, RRNX_E_SYSCALL,
+			    "%s: read() failed: %s",
+			    navreader->follow_name, strerror(errno));
+			break;
+		}
+		if (n == 0) {
+			// Nothing more appended, for now.
+			break;
+		}
+
+		navreader->pending_len += n;
+		navreader->follow_offset += n;
+	}
+
+	return navreader->err;
+}
+
+/**
+ * Tells whether the followed file has data which has not been read.
+ */
+static int has_unread_data(const rrnx_navreader *navreader) {
+	struct stat st;
+	if (fstat(navreader->follow_fd, &st) != 0) {
+		// Let rrnx_navr_follow_poll() find out the error.
+		return 1;
+	}
+	return (long long) st.st_size > navreader->follow_offset;
+}
+
+int rrnx_navr_follow_wait(rrnx_navreader *navreader, int timeout_ms) {
+	if (navreader->follow_fd < 0) {
+		return 0;
+	}
+
+	if (has_unread_data(navreader)) {
+		return 1;
+	}
+
+#ifdef __linux__
+	if (navreader->notify_fd >= 0) {
+		struct pollfd pfd;
+		pfd.fd = navreader->notify_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, timeout_ms) <= 0) {
+			// Timeout, or interrupted
+			return 0;
+		}
+
+		// Drain the events; only their arrival matters.
+		char events[4096];
+		while (read(navreader->notify_fd, events, sizeof(events)) > 0) {
+			// Nothing to do
+		}
+
+		return 1;
+	}
+#endif
+
+	int waited = 0;
+	while (waited < timeout_ms) {
+		int ms = timeout_ms - waited;
+		if (ms > FOLLOW_POLL_INTERVAL) {
+			ms = FOLLOW_POLL_INTERVAL;
+		}
+
+		struct timespec ts;
+		ts.tv_sec = 0;
+		ts.tv_nsec = ms * 1000000L;
+		nanosleep(&ts, NULL);
+		waited += ms;
+
+		if (has_unread_data(navreader)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void rrnx_navr_follow_close(rrnx_navreader *navreader) {
+	if (navreader->notify_fd >= 0) {
+		close(navreader->notify_fd);
+		navreader->notify_fd = -1;
+	}
+
+	if (navreader->follow_fd >= 0) {
+		close(navreader->follow_fd);
+		navreader->follow_fd = -1;
+	}
+
+	free(navreader->follow_name);
+	navreader->follow_name = NULL;
+
+	navreader->pending_len = 0;
+	navreader->cur_navmsg = NULL;
+	navreader->cur_node = NULL;
+	navreader->ready_node = NULL;
+}
@@ -58,6 +58,10 @@ int rrnx_node_is_type_valid(int type) {
 	return get_data_size(type) >= 0;
 }
 
+int rrnx_node_data_size(int type) {
+	return (int) get_data_size(type);
+}
+
 rrnx_node *rrnx_node_alloc(int type) {
 	// Determine payload size.
 	// Returns -1 if type is unknown.
@@ -95,6 +99,24 @@ rrnx_node *rrnx_node_alloc(int type) {
 	return node;
 }
 
+rrnx_node *rrnx_node_alloc_arena(rrnx_arena *arena, int type) {
+	// See rrnx_node_alloc() regarding the NULL return value.
+	ssize_t data_size = get_data_size(type);
+	if (data_size < 0) {
+		return NULL;
+	}
+
+	size_t total_size = sizeof(rrnx_node) + (size_t)(data_size);
+
+	rrnx_node *node = rrnx_arena_malloc(arena, total_size);
+	if (node != NULL) {
+		node->type = type;
+		node->size = data_size;
+	}
+
+	return node;
+}
+
 void rrnx_node_free(rrnx_node *node) {
 	if (node == NULL) {
 		// Already freed
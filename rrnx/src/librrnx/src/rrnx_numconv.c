@@ -0,0 +1,904 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+/*
+ * Reference:
+ *
+ * Clinger WD.
+ * How to Read Floating Point Numbers Accurately.
+ * ACM SIGPLAN Notices 25(6), 1990.
+ *
+ */
+
+#include "rrnx/rrnx_numconv.h"
+
+#include <stdint.h> // uint64_t
+#include <float.h> // FLT_EVAL_METHOD
+#include <string.h> // memcpy, memset
+#include <stdio.h> // snprintf
+#include <stdlib.h> // strtod
+
+//--- internal constants ---------------------------------------------------//
+
+/**
+ * Powers of ten that are exactly representable as doubles.
+ */
+static const double EXACT_POW10[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/** Largest exponent in EXACT_POW10. */
+#define MAX_EXACT_POW10 22
+
+/** Largest integer below which all integers are exact doubles. */
+#define MAX_EXACT_MANTISSA (((uint64_t) 1) << 53)
+
+/** Decimal digits that always fit into uint64_t. */
+#define MAX_MANTISSA_DIGITS 19
+
+/**
+ * Powers of ten for rrnx_num_format_fixed(). The 53-bit mantissa
+ * multiplied by any of these fits into uint64_t.
+ */
+static const uint64_t FIXED_POW10[] = {1, 10, 100, 1000};
+
+/** Largest number of decimals in rrnx_num_format_fixed(). */
+#define MAX_FIXED_DECIMALS 3
+
+/**
+ * Powers of ten that fit into uint64_t.
+ */
+static const uint64_t POW10_64[] = {
+	1ULL,
+	10ULL,
+	100ULL,
+	1000ULL,
+	10000ULL,
+	100000ULL,
+	1000000ULL,
+	10000000ULL,
+	100000000ULL,
+	1000000000ULL,
+	10000000000ULL,
+	100000000000ULL,
+	1000000000000ULL,
+	10000000000000ULL,
+	100000000000000ULL,
+	1000000000000000ULL,
+	10000000000000000ULL,
+	100000000000000000ULL,
+	1000000000000000000ULL,
+	10000000000000000000ULL
+};
+
+/**
+ * Largest number of decimals in rrnx_num_format_fortran().
+ * The digits, one more than decimals, must fit into uint64_t.
+ */
+#define MAX_FORTRAN_DECIMALS 17
+
+/** Bits in the mantissa of a double, including the hidden bit. */
+#define MANTISSA_BITS 53
+
+#ifdef __SIZEOF_INT128__
+#define HAVE_UINT128
+typedef unsigned __int128 uint128_t;
+
+/**
+ * Powers of five that fit into uint64_t.
+ */
+static const uint64_t POW5_64[] = {
+	1ULL,
+	5ULL,
+	25ULL,
+	125ULL,
+	625ULL,
+	3125ULL,
+	15625ULL,
+	78125ULL,
+	390625ULL,
+	1953125ULL,
+	9765625ULL,
+	48828125ULL,
+	244140625ULL,
+	1220703125ULL,
+	6103515625ULL,
+	30517578125ULL,
+	152587890625ULL,
+	762939453125ULL,
+	3814697265625ULL,
+	19073486328125ULL,
+	95367431640625ULL,
+	476837158203125ULL,
+	2384185791015625ULL,
+	11920928955078125ULL,
+	59604644775390625ULL,
+	298023223876953125ULL,
+	1490116119384765625ULL,
+	7450580596923828125ULL
+};
+
+/** Largest exponent in POW5_64. */
+#define MAX_POW5_64 27
+
+/** Largest power of five that pow5() computes into 128 bits. */
+#define MAX_POW5 (2 * MAX_POW5_64)
+#endif
+
+// Remainder classes of divide_pow10()
+#define REM_ZERO                 0
+#define REM_BELOW_HALF           1
+#define REM_HALF                 2
+#define REM_ABOVE_HALF           3
+
+//--- internal helpers -----------------------------------------------------//
+
+/**
+ * Decomposes a finite double: value = (-1)^negative * mantissa * 2^exp2.
+ * Returns 0 for infinities and NaNs.
+ */
+static int decompose(
+    double value,
+    int *negative,
+    uint64_t *mantissa,
+    int *exp2
+) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	int biased = (int) ((bits >> 52) & 0x7ff);
+	if (biased == 0x7ff) {
+		return 0;
+	}
+
+	*negative = (int) (bits >> 63);
+	*mantissa = bits & ((((uint64_t) 1) << 52) - 1);
+
+	if (biased == 0) {
+		*exp2 = -1074; // Subnormal
+	} else {
+		*mantissa |= ((uint64_t) 1) << 52;
+		*exp2 = biased - 1075;
+	}
+
+	return 1;
+}
+
+#ifdef HAVE_UINT128
+/**
+ * Returns 5^n for n <= MAX_POW5.
+ */
+static uint128_t pow5(int n) {
+	if (n <= MAX_POW5_64) {
+		return POW5_64[n];
+	}
+	return (uint128_t) POW5_64[MAX_POW5_64] * POW5_64[n - MAX_POW5_64];
+}
+
+/**
+ * Upper bound for the number of bits in 5^n.
+ * The factor 2378/1024 is slightly above log2(5).
+ */
+static int pow5_bits(int n) {
+	return ((n * 2378) >> 10) + 1;
+}
+
+/**
+ * Returns the 64 bits starting from the given bit of a 192-bit number.
+ */
+static uint64_t word_at(const uint64_t *w, int bit) {
+	int i = bit / 64;
+	int offset = bit % 64;
+	uint64_t word = (i < 3) ? (w[i] >> offset) : 0;
+	if ((offset > 0) && (i+1 < 3)) {
+		word |= w[i+1] << (64 - offset);
+	}
+	return word;
+}
+
+/**
+ * Computes x * 5^n / 2^s exactly for 0 < s < 192, where the product
+ * has up to 192 bits. The quotient is truncated, and the remainder
+ * is classified like in divide_pow10(). Returns -1 if the numbers
+ * might not fit.
+ */
+static int divide_pow2_wide(
+    uint64_t x,
+    int x_bits,
+    int n,
+    int s,
+    uint128_t *quotient
+) {
+	int num_bits = x_bits + pow5_bits(n);
+	if ((n > MAX_POW5) || (num_bits > 191) || (s >= 192)
+	    || (num_bits - s > 128))
+	{
+		return -1;
+	}
+
+	// The product as 64-bit words, least significant first
+	uint128_t y = pow5(n);
+	uint128_t lo = (uint128_t) x * (uint64_t) y;
+	uint128_t hi = (uint128_t) x * (uint64_t) (y >> 64);
+	uint128_t mid = (lo >> 64) + (uint64_t) hi;
+	uint64_t w[3];
+	w[0] = (uint64_t) lo;
+	w[1] = (uint64_t) mid;
+	w[2] = (uint64_t) (hi >> 64) + (uint64_t) (mid >> 64);
+
+	*quotient = word_at(w, s) | ((uint128_t) word_at(w, s + 64) << 64);
+
+	// The half is the highest bit of the remainder.
+	int half_bit = s - 1;
+	int half = (int) ((w[half_bit / 64] >> (half_bit % 64)) & 1);
+	uint64_t below = w[half_bit / 64]
+	    & ((((uint64_t) 1) << (half_bit % 64)) - 1);
+	for (int i = 0; i < half_bit / 64; i++) {
+		below |= w[i];
+	}
+
+	if (half) {
+		return (below != 0) ? REM_ABOVE_HALF : REM_HALF;
+	}
+	return (below != 0) ? REM_BELOW_HALF : REM_ZERO;
+}
+
+/**
+ * Computes x * 2^exp2 / 10^exp10 exactly, when x has at most x_bits
+ * bits. The quotient is truncated, and the remainder is classified
+ * against the half of the divisor (REM_xxx). Returns -1 if the
+ * intermediate values might not fit into 128 bits.
+ */
+static int divide_pow10(
+    uint64_t x,
+    int x_bits,
+    int exp2,
+    int exp10,
+    uint128_t *quotient
+) {
+	// 10^exp10 = 5^exp10 * 2^exp10
+	int shift = exp2 - exp10;
+	int pow5_exp = (exp10 < 0) ? -exp10 : exp10;
+	if (pow5_exp > MAX_POW5) {
+		return -1;
+	}
+
+	if ((exp10 <= 0) && (shift < 0)) {
+		// Small numbers: the divisor is a power of two,
+		// but the numerator may need more than 128 bits.
+		return divide_pow2_wide(x, x_bits, pow5_exp, -shift, quotient);
+	}
+
+	int num_bits = x_bits;
+	int den_bits = 1;
+	if (exp10 < 0) {
+		num_bits += pow5_bits(pow5_exp);
+	} else {
+		den_bits = pow5_bits(pow5_exp);
+	}
+	if (shift > 0) {
+		num_bits += shift;
+	} else {
+		den_bits -= shift;
+	}
+
+	// The doubled remainder must fit too.
+	if ((num_bits > 127) || (den_bits > 126)) {
+		return -1;
+	}
+
+	uint128_t num = x;
+	if (exp10 < 0) {
+		num *= pow5(pow5_exp);
+	}
+	if (shift > 0) {
+		num <<= shift;
+	}
+
+	if (exp10 <= 0) {
+		// An integer
+		*quotient = num;
+		return REM_ZERO;
+	}
+
+	// General division
+	uint128_t den = pow5(pow5_exp);
+	if (shift < 0) {
+		den <<= -shift;
+	}
+	*quotient = num / den;
+	uint128_t rem2 = (num - (*quotient * den)) << 1;
+
+	if (rem2 == 0) {
+		return REM_ZERO;
+	}
+	if (rem2 < den) {
+		return REM_BELOW_HALF;
+	}
+	return (rem2 == den) ? REM_HALF : REM_ABOVE_HALF;
+}
+
+/**
+ * Finds the shortest decimal digits which are within the rounding
+ * interval of the double, that is, which convert back to it.
+ * Among those, the closest to the double is taken. The value is
+ * digits * 10^exp10. This is the algorithm of Ryu, but the scaling
+ * is computed exactly with 128-bit integers instead of tables.
+ * Returns 0 if the numbers might not fit.
+ */
+static int shortest_digits(
+    uint64_t mantissa,
+    int exp2,
+    uint64_t *digits,
+    int *exp10
+) {
+	// The interval halfway to the neighbours is [mm, mp] * 2^e2.
+	// The lower neighbour is closer when the mantissa is a power
+	// of two, except for the smallest exponent.
+	int e2 = exp2 - 2;
+	uint64_t mv = mantissa << 2;
+	int mm_shift = (mantissa != (((uint64_t) 1) << (MANTISSA_BITS-1)))
+	    || (exp2 <= -1074);
+	uint64_t mp = mv + 2;
+	uint64_t mm = mv - 1 - mm_shift;
+
+	// Round-to-even picks the double itself for the halfway points
+	// when its mantissa is even.
+	int accept_bounds = (mantissa & 1) == 0;
+
+	// Decimal exponent for the scaling, as chosen by Ryu.
+	// The scaled interval is at least one unit wide.
+	int e10;
+	if (e2 >= 0) {
+		e10 = ((e2 * 78913) >> 18) - (e2 > 3);
+	} else {
+		int q = ((-e2 * 732923) >> 20) - (-e2 > 1);
+		e10 = q + e2;
+	}
+
+	uint128_t vr128;
+	uint128_t vp128;
+	uint128_t vm128;
+	int rem_r = divide_pow10(mv, MANTISSA_BITS+3, e2, e10, &vr128);
+	int rem_p = divide_pow10(mp, MANTISSA_BITS+3, e2, e10, &vp128);
+	int rem_m = divide_pow10(mm, MANTISSA_BITS+3, e2, e10, &vm128);
+	if ((rem_r < 0) || (rem_p < 0) || (rem_m < 0)
+	    || ((vp128 >> 64) != 0))
+	{
+		return 0;
+	}
+
+	uint64_t vr = (uint64_t) vr128;
+	uint64_t vp = (uint64_t) vp128;
+	uint64_t vm = (uint64_t) vm128;
+
+	int vr_trailing_zeros = (rem_r == REM_ZERO);
+	int vm_trailing_zeros = accept_bounds && (rem_m == REM_ZERO);
+	if ((!accept_bounds) && (rem_p == REM_ZERO)) {
+		// The upper bound is excluded.
+		vp--;
+	}
+
+	// Remove digits while the interval still has a number.
+	int removed = 0;
+	int last_removed = 0;
+	while ((vp / 10) > (vm / 10)) {
+		vm_trailing_zeros &= ((vm % 10) == 0);
+		vr_trailing_zeros &= (last_removed == 0);
+		last_removed = (int) (vr % 10);
+		vr /= 10;
+		vp /= 10;
+		vm /= 10;
+		removed++;
+	}
+	if (vm_trailing_zeros) {
+		// The lower bound itself is a candidate.
+		while ((vm % 10) == 0) {
+			vr_trailing_zeros &= (last_removed == 0);
+			last_removed = (int) (vr % 10);
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+	}
+	if (vr_trailing_zeros && (last_removed == 5) && ((vr % 2) == 0)) {
+		// Exactly halfway; round to even.
+		last_removed = 4;
+	}
+
+	*digits = vr + ((((vr == vm) && (!accept_bounds || !vm_trailing_zeros)))
+	    || (last_removed >= 5));
+	*exp10 = e10 + removed;
+
+	return 1;
+}
+#endif
+
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define HAVE_EIGHT_DIGITS
+#endif
+
+#ifdef HAVE_EIGHT_DIGITS
+/**
+ * Converts eight digits at once, if they all are digits.
+ * The chars are processed as a little-endian 64-bit word.
+ */
+static int parse_eight_digits(const char *s, uint64_t *value) {
+	uint64_t v;
+	memcpy(&v, s, sizeof(v));
+
+	// Every byte must be within 0x30-0x39.
+	if ((((v & 0xF0F0F0F0F0F0F0F0ULL)
+	    | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+	    != 0x3333333333333333ULL))
+	{
+		return 0;
+	}
+
+	// Combine the digits pairwise: 1-digit, 2-digit, 4-digit values.
+	v -= 0x3030303030303030ULL;
+	v = (v * 10) + (v >> 8);
+	v = (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL)
+	    + (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL))
+	    >> 32;
+
+	*value = (uint32_t) v;
+	return 1;
+}
+#endif
+
+/**
+ * Accumulates a run of digits into the mantissa.
+ * Returns the number of digits consumed.
+ */
+static int parse_digits(const char **ps, const char *end, uint64_t *mantissa) {
+	const char *s = *ps;
+	uint64_t m = *mantissa;
+
+#ifdef HAVE_EIGHT_DIGITS
+	uint64_t chunk;
+	while ((end - s >= 8) && (parse_eight_digits(s, &chunk))) {
+		m = (m * 100000000) + chunk;
+		s += 8;
+	}
+#endif
+
+	while ((s < end) && (*s >= '0') && (*s <= '9')) {
+		m = (m * 10) + (*s - '0');
+		s++;
+	}
+
+	int count = s - *ps;
+	*ps = s;
+	*mantissa = m;
+	return count;
+}
+
+/**
+ * Finds the shortest digits with snprintf() and strtod(), by trying
+ * the precisions in turn. Trailing zeros are removed.
+ */
+static void shortest_digits_slow(
+    double value,
+    uint64_t *digits,
+    int *exp10
+) {
+	char buf[40];
+	for (int precision = 1; precision <= 17; precision++) {
+		snprintf(buf, sizeof(buf), "%.*e", precision-1, value);
+		if ((strtod(buf, NULL) == value) || (precision == 17)) {
+			break;
+		}
+	}
+
+	// The form is [-]d.ddde[+-]xx
+	uint64_t d = 0;
+	int count = 0;
+	const char *s = buf;
+	if (*s == '-') {
+		s++;
+	}
+	for (; *s != 'e'; s++) {
+		if (*s != '.') {
+			d = (d * 10) + (*s - '0');
+			count++;
+		}
+	}
+	int e = atoi(s + 1) - (count - 1);
+
+	while ((d != 0) && ((d % 10) == 0)) {
+		d /= 10;
+		e++;
+	}
+
+	*digits = d;
+	*exp10 = e;
+}
+
+//--- external methods -----------------------------------------------------//
+
+int rrnx_num_parse_fortran(const char *s, int len, double *result) {
+#if !defined(FLT_EVAL_METHOD) || (FLT_EVAL_METHOD != 0)
+	// Excess precision would round twice; let strtod() do it.
+	return 0;
+#endif
+	const char *end = s + len;
+
+	// Sign, if any
+	int negative = 0;
+	if ((s < end) && ((*s == '+') || (*s == '-'))) {
+		negative = (*s == '-');
+		s++;
+	}
+
+	// Digits as an integer, and the decimal exponent
+	uint64_t mantissa = 0;
+	int exp10 = 0;
+
+	// Integer part
+	int digits = parse_digits(&s, end, &mantissa);
+
+	// Fractional part, if any
+	if ((s < end) && (*s == '.')) {
+		s++;
+		int fraction_digits = parse_digits(&s, end, &mantissa);
+		exp10 -= fraction_digits;
+		digits += fraction_digits;
+	}
+
+	if (digits == 0) {
+		return 0; // Not a number
+	}
+
+	if (digits > MAX_MANTISSA_DIGITS) {
+		// The mantissa may have overflown.
+		// Leading zeros are counted too; they are rare.
+		return 0;
+	}
+
+	// Exponent, if any. Fortran uses 'D' for doubles.
+	if ((s < end) && ((*s == 'D') || (*s == 'd')
+	    || (*s == 'E') || (*s == 'e')))
+	{
+		s++;
+
+		int exp_negative = 0;
+		if ((s < end) && ((*s == '+') || (*s == '-'))) {
+			exp_negative = (*s == '-');
+			s++;
+		}
+
+		int value = 0;
+		int exp_digits = 0;
+		while ((s < end) && (*s >= '0') && (*s <= '9')) {
+			// Saturate; large exponents are rejected below.
+			if (value < 10000) {
+				value = (value * 10) + (*s - '0');
+			}
+			exp_digits++;
+			s++;
+		}
+
+		if (exp_digits == 0) {
+			return 0; // Exponent marker without digits
+		}
+
+		exp10 += exp_negative ? -value : value;
+	}
+
+	if (s != end) {
+		return 0; // Trailing garbage
+	}
+
+	// Both the mantissa and the power of ten must be exact doubles.
+	// Then the single division or multiplication is correctly
+	// rounded, and so the result is the same as strtod() gives.
+	double value = 0.0;
+
+	if (mantissa != 0) {
+		if (mantissa > MAX_EXACT_MANTISSA) {
+			return 0;
+		}
+		if ((exp10 < -MAX_EXACT_POW10) || (exp10 > MAX_EXACT_POW10)) {
+			return 0;
+		}
+
+		value = (double) mantissa;
+		if (exp10 < 0) {
+			value /= EXACT_POW10[-exp10];
+		} else {
+			value *= EXACT_POW10[exp10];
+		}
+	}
+
+	*result = negative ? -value : value;
+
+	return 1;
+}
+
+int rrnx_num_format_fixed(char *dest, int width, int decimals, double value) {
+	if ((decimals < 0) || (decimals > MAX_FIXED_DECIMALS)) {
+		return 0;
+	}
+
+	int negative;
+	uint64_t mantissa;
+	int exp2;
+	if (!decompose(value, &negative, &mantissa, &exp2)) {
+		return 0; // Infinity or NaN
+	}
+
+	// The scaled value, mantissa * 10^decimals * 2^exp2, is rounded
+	// to an integer exactly, with ties to even, like printf() does.
+	uint64_t scaled = 0;
+	if (mantissa != 0) {
+		if (exp2 >= 0) {
+			return 0; // 2^52 or more
+		}
+
+		uint64_t n = mantissa * FIXED_POW10[decimals];
+		int shift = -exp2;
+		if (shift < 64) {
+			scaled = n >> shift;
+			uint64_t rem = n & ((((uint64_t) 1) << shift) - 1);
+			uint64_t half = ((uint64_t) 1) << (shift-1);
+			if ((rem > half) || ((rem == half) && (scaled & 1))) {
+				scaled++;
+			}
+		} else {
+			// n < 2^63, which is at most half; rounds to zero.
+		}
+	}
+
+	// Digits from the right
+	char buf[32];
+	int at = sizeof(buf);
+	for (int i = 0; i < decimals; i++) {
+		buf[--at] = (char) ('0' + (scaled % 10));
+		scaled /= 10;
+	}
+	if (decimals > 0) {
+		buf[--at] = '.';
+	}
+	do {
+		buf[--at] = (char) ('0' + (scaled % 10));
+		scaled /= 10;
+	} while (scaled > 0);
+
+	// Negative zero has the sign too, like in printf().
+	if (negative) {
+		buf[--at] = '-';
+	}
+
+	int len = sizeof(buf) - at;
+	if (len > width) {
+		return 0;
+	}
+
+	memset(dest, ' ', width - len);
+	memcpy(dest + (width - len), &buf[at], len);
+
+	return 1;
+}
+
+int rrnx_num_format_fortran(char *dest, int width, int decimals, double value) {
+#ifndef HAVE_UINT128
+	// The exact arithmetic needs 128-bit integers; use snprintf().
+	return 0;
+#else
+	if ((decimals < 0) || (decimals > MAX_FORTRAN_DECIMALS)) {
+		return 0;
+	}
+
+	int negative;
+	uint64_t mantissa;
+	int exp2;
+	if (!decompose(value, &negative, &mantissa, &exp2)) {
+		return 0; // Infinity or NaN
+	}
+
+	// The value is scaled into decimals+1 digits, that is,
+	// value / 10^(exp10-decimals), and rounded exactly with ties
+	// to even, like printf() does.
+	uint64_t digits = 0;
+	int exp10 = 0;
+	if (mantissa != 0) {
+		const uint64_t lower = POW10_64[decimals];
+		const uint64_t upper = POW10_64[decimals+1];
+
+		// Position of the most significant bit
+		int top = exp2 + (MANTISSA_BITS-1);
+		if (mantissa < (((uint64_t) 1) << (MANTISSA_BITS-1))) {
+			// Subnormal
+			for (uint64_t m = mantissa; m < (((uint64_t) 1) << 52); m <<= 1) {
+				top--;
+			}
+		}
+
+		// Estimate of the decimal exponent, floor(top * log10(2)).
+		// It may be off by one, which is corrected below.
+		if (top >= 0) {
+			exp10 = (top * 1233) / 4096;
+		} else {
+			exp10 = -((-top * 1233 + 4095) / 4096);
+		}
+
+		int attempts = 0;
+		for (;;) {
+			if (++attempts > 3) {
+				return 0; // Not expected
+			}
+
+			uint128_t quotient;
+			int rem = divide_pow10(mantissa, MANTISSA_BITS,
+			    exp2, exp10 - decimals, &quotient);
+			if (rem < 0) {
+				return 0;
+			}
+			int roundup = (rem == REM_ABOVE_HALF)
+			    || ((rem == REM_HALF) && (quotient & 1));
+
+			if (quotient >= upper) {
+				exp10++;
+			} else if (quotient < lower) {
+				exp10--;
+			} else {
+				digits = (uint64_t) quotient + roundup;
+				if (digits == upper) {
+					// Rounded up to the next power of ten
+					digits = lower;
+					exp10++;
+				}
+				break;
+			}
+		}
+	}
+
+	// Chars from the right
+	char buf[48];
+	int at = sizeof(buf);
+
+	// Exponent, at least two digits
+	unsigned int e = (exp10 < 0) ? -exp10 : exp10;
+	int exp_digits = 0;
+	do {
+		buf[--at] = (char) ('0' + (e % 10));
+		e /= 10;
+		exp_digits++;
+	} while ((e > 0) || (exp_digits < 2));
+	buf[--at] = (exp10 < 0) ? '-' : '+';
+	buf[--at] = 'D';
+
+	// Mantissa
+	for (int i = 0; i < decimals; i++) {
+		buf[--at] = (char) ('0' + (digits % 10));
+		digits /= 10;
+	}
+	if (decimals > 0) {
+		buf[--at] = '.';
+	}
+	buf[--at] = (char) ('0' + digits);
+
+	// Negative zero has the sign too, like in printf().
+	if (negative) {
+		buf[--at] = '-';
+	}
+
+	int len = sizeof(buf) - at;
+	if (len > width) {
+		return 0;
+	}
+
+	memset(dest, ' ', width - len);
+	memcpy(dest + (width - len), &buf[at], len);
+
+	return 1;
+#endif
+}
+
+int rrnx_num_format_shortest(char *dest, double value) {
+	int negative;
+	uint64_t mantissa;
+	int exp2;
+	if (!decompose(value, &negative, &mantissa, &exp2)) {
+		// Infinity or NaN, like printf() has them.
+		const char *s = (value != value) ? "nan" : "inf";
+		int len = 0;
+		if ((value < 0.0) && (value == value)) {
+			dest[len++] = '-';
+		}
+		memcpy(dest + len, s, 3);
+		return len + 3;
+	}
+
+	uint64_t digits = 0;
+	int exp10 = 0;
+	if (mantissa != 0) {
+		int done = 0;
+#ifdef HAVE_UINT128
+		done = shortest_digits(mantissa, exp2, &digits, &exp10);
+#endif
+		if (!done) {
+			shortest_digits_slow(negative ? -value : value,
+			    &digits, &exp10);
+		}
+	}
+
+	// Digits from the right
+	char buf[24];
+	int count = 0;
+	do {
+		buf[sizeof(buf) - (++count)] = (char) ('0' + (digits % 10));
+		digits /= 10;
+	} while (digits > 0);
+	const char *d = &buf[sizeof(buf) - count];
+
+	// Exponent of the first digit
+	int x = exp10 + count - 1;
+
+	int len = 0;
+	if (negative) {
+		dest[len++] = '-';
+	}
+
+	if ((x < -4) || (x >= 17)) {
+		// d.ddde+xx
+		dest[len++] = d[0];
+		if (count > 1) {
+			dest[len++] = '.';
+			memcpy(dest + len, d + 1, count - 1);
+			len += count - 1;
+		}
+		dest[len++] = 'e';
+		dest[len++] = (x < 0) ? '-' : '+';
+		int e = (x < 0) ? -x : x;
+		if (e >= 100) {
+			dest[len++] = (char) ('0' + (e / 100));
+		}
+		dest[len++] = (char) ('0' + ((e / 10) % 10));
+		dest[len++] = (char) ('0' + (e % 10));
+	} else if (x < 0) {
+		// 0.000ddd
+		dest[len++] = '0';
+		dest[len++] = '.';
+		for (int i = -1; i > x; i--) {
+			dest[len++] = '0';
+		}
+		memcpy(dest + len, d, count);
+		len += count;
+	} else if (x >= count - 1) {
+		// ddd000
+		memcpy(dest + len, d, count);
+		len += count;
+		for (int i = count - 1; i < x; i++) {
+			dest[len++] = '0';
+		}
+	} else {
+		// dd.ddd
+		memcpy(dest + len, d, x + 1);
+		len += x + 1;
+		dest[len++] = '.';
+		memcpy(dest + len, d + x + 1, count - (x + 1));
+		len += count - (x + 1);
+	}
+
+	return len;
+}
@@ -0,0 +1,1025 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include "rrnx/rrnx_obsreader.h"
+#include "rrnx/rrnx_numconv.h"
+
+// Internal headers
+#include "rrnx_labels.h"
+#include "rrnx_strutil.h"
+
+#include <stdlib.h> // malloc, free, strtod
+#include <string.h>
+#include <errno.h> // errno
+#include <stdarg.h> // va_list, va_start, va_end
+#include <math.h> // NAN
+
+/**
+ * Observations per line in the data records (5(F14.3, I1, I1)).
+ */
+#define OBS_PER_LINE 5
+
+/**
+ * Width of an observation, including the flags.
+ */
+#define OBS_WIDTH 16
+
+/**
+ * Satellites per line in the epoch records (12(A1, I2)).
+ */
+#define SATS_PER_LINE 12
+
+/**
+ * Observation types per line in the header (9(4X, A2)).
+ */
+#define TYPES_PER_LINE 9
+
+//--- error messages -------------------------------------------------------//
+
+static int errmsg_fr(rrnx_obsreader *obsreader) {
+	// For convenience
+	rrnx_filereader *fr = obsreader->fr;
+
+	// Copy error code and message
+	obsreader->err = fr->err;
+	rrnx_str_strcpy(obsreader->errmsg, fr->errmsg);
+
+	return obsreader->err;
+}
+
+static int errmsg_none(rrnx_obsreader *obsreader, int err) {
+	obsreader->err = err;
+	rrnx_str_reset(obsreader->errmsg);
+	return obsreader->err;
+}
+
+static int errmsg_format(
+    rrnx_obsreader *obsreader,
+    int err,
+    const char *fmt, ...
+) {
+	obsreader->err = err;
+
+	va_list args;
+	va_start(args, fmt);
+	rrnx_str_vformat(obsreader->errmsg, fmt, args);
+	va_end(args);
+
+	return obsreader->err;
+}
+
+static int errmsg_prepend_location(rrnx_obsreader *obsreader) {
+	// For convenience
+	rrnx_filereader *fr = obsreader->fr;
+
+	rrnx_string *org = rrnx_str_clone(obsreader->errmsg);
+	if (org != NULL) {
+		rrnx_str_format(obsreader->errmsg,
+		    "%s:%d: ", fr->filename, fr->row);
+		rrnx_str_concat(obsreader->errmsg, org);
+	} else {
+		// Allocation failed.
+		// Leave the message untouched,
+		// and ignore the error.
+	}
+	rrnx_str_free(org);
+
+	return obsreader->err;
+}
+
+//--- field parsing --------------------------------------------------------//
+
+/**
+ * Parses a fixed-width floating-point field.
+ * Returns 1 if the field had a value, and 0 if it was blank
+ * (or an error occurred), in which case the result is zero.
+ */
+static int parse_double(
+    rrnx_obsreader *obsreader,
+    double *result,
+    const char *line,
+    int linelen,
+    int offset,
+    int len
+) {
+	*result = 0.0;
+
+	const char *field;
+	len = rrnx_field_span(&field, line, linelen, offset, len);
+	if ((len == 0) || (obsreader->err)) {
+		return 0;
+	}
+
+	if (rrnx_num_parse_fortran(field, len, result)) {
+		// Converted without copies.
+		return 1;
+	}
+
+	// Copy to the workbuf, leaving space for the terminator.
+	char *workbuf = obsreader->workbuf;
+	if (len >= obsreader->workbuf_size) {
+		len = obsreader->workbuf_size-1;
+	}
+	memcpy(workbuf, field, len);
+	workbuf[len] = '\0';
+
+	rrnx_replace_fortran_exponent(workbuf);
+
+	errno = 0;
+	char *endptr;
+	*result = strtod(workbuf, &endptr);
+	int errnum = errno; // Record errno immediately
+
+	if (*endptr != '\0') {
+		// String not fully converted; error.
+		errmsg_format(
+		    obsreader, RRNX_E_CONV,
+		    "Cannot convert \"%s\" to a double (Unexpected char \'%c\')",
+		    workbuf, *endptr
+		);
+	}
+	else if (errnum != 0) {
+		errmsg_format(
+		    obsreader, RRNX_E_CONV,
+		    "Cannot convert \"%s\" to a double (%s)",
+		    workbuf, strerror(errnum)
+		);
+	}
+
+	return obsreader->err == RRNX_E_OK;
+}
+
+/**
+ * Parses a fixed-width integer field.
+ * Returns 1 if the field had a value, and 0 if it was blank
+ * (or an error occurred), in which case the result is zero.
+ */
+static int parse_int(
+    rrnx_obsreader *obsreader,
+    int *result,
+    const char *line,
+    int linelen,
+    int offset,
+    int len
+) {
+	*result = 0;
+
+	const char *field;
+	len = rrnx_field_span(&field, line, linelen, offset, len);
+	if ((len == 0) || (obsreader->err)) {
+		return 0;
+	}
+
+	// The fields are at most a few digits wide,
+	// so that they cannot overflow.
+	int i = 0;
+	int negative = 0;
+	if ((field[0] == '-') || (field[0] == '+')) {
+		negative = (field[0] == '-');
+		i++;
+	}
+
+	int value = 0;
+	for (; i < len; i++) {
+		char c = field[i];
+		if ((c < '0') || (c > '9') || (len > 9)) {
+			errmsg_format(
+			    obsreader, RRNX_E_CONV,
+			    "Cannot convert \"%.*s\" to an integer (Unexpected char \'%c\')",
+			    len, field, c
+			);
+			return 0;
+		}
+		value = (value * 10) + (c - '0');
+	}
+
+	*result = negative ? -value : value;
+	return 1;
+}
+
+/**
+ * Parses a single-digit flag (LLI or signal strength).
+ */
+static int parse_flag(
+    rrnx_obsreader *obsreader,
+    const char *line,
+    int linelen,
+    int offset
+) {
+	if ((offset >= linelen) || (line[offset] == ' ')) {
+		return RRNX_OBSR_FLAG_BLANK;
+	}
+
+	char c = line[offset];
+	if ((c < '0') || (c > '9')) {
+		errmsg_format(
+		    obsreader, RRNX_E_CONV,
+		    "Cannot convert \'%c\' to a flag", c
+		);
+		return RRNX_OBSR_FLAG_BLANK;
+	}
+	return c - '0';
+}
+
+static void parse_string(
+    char *dest,
+    const char *line,
+    int linelen,
+    int offset,
+    int len
+) {
+	rrnx_substr_trimmed2_n(dest, line, linelen, offset, len);
+}
+
+static void parse_datetime(
+    rrnx_obsreader *obsreader,
+    rrnx_datetime *t,
+    const char *line,
+    int linelen
+) {
+	// Time of first/last obs: 5I6, F13.7
+	parse_int(obsreader, &t->year, line, linelen, 0, 6);
+	parse_int(obsreader, &t->month, line, linelen, 6, 6);
+	parse_int(obsreader, &t->day, line, linelen, 12, 6);
+	parse_int(obsreader, &t->hour, line, linelen, 18, 6);
+	parse_int(obsreader, &t->min, line, linelen, 24, 6);
+	parse_double(obsreader, &t->sec, line, linelen, 30, 13);
+}
+
+//--- observation block ----------------------------------------------------//
+
+static void free_block(rrnx_obs_block *block) {
+	// The arrays share a single allocation.
+	free(block->value);
+	memset(block, 0, sizeof(rrnx_obs_block));
+}
+
+/**
+ * Makes room for the given number of satellites and types.
+ * The contents are not preserved.
+ */
+static int reserve_block(
+    rrnx_obsreader *obsreader,
+    unsigned int num_types,
+    unsigned int num_sats
+) {
+	rrnx_obs_block *block = &obsreader->block;
+
+	if ((block->value != NULL)
+	    && (num_types == block->num_types)
+	    && (num_sats <= block->capacity))
+	{
+		// Fits already
+		return obsreader->err;
+	}
+
+	unsigned int capacity = block->capacity;
+	if (capacity < RRNX_OBSR_DEFAULT_CAPACITY) {
+		capacity = RRNX_OBSR_DEFAULT_CAPACITY;
+	}
+	while (capacity < num_sats) {
+		capacity *= 2;
+	}
+
+	// The doubles go first for the alignment.
+	size_t slots = (size_t) num_types * capacity;
+	size_t size = (slots * sizeof(double))
+	    + (capacity * sizeof(rrnx_satellite_id))
+	    + (slots * 3);
+
+	char *mem = malloc(size);
+	if (mem == NULL) {
+		return errmsg_none(obsreader, RRNX_E_NOMEM);
+	}
+
+	// The epoch of an event record is kept, when the
+	// observation types change.
+	rrnx_meas_epoch epoch = block->epoch;
+	free_block(block);
+	block->epoch = epoch;
+
+	block->value = (double *) mem;
+	mem += slots * sizeof(double);
+	block->epoch.sat = (rrnx_satellite_id *) mem;
+	mem += capacity * sizeof(rrnx_satellite_id);
+	block->valid = (unsigned char *) mem;
+	mem += slots;
+	block->lli = (signed char *) mem;
+	mem += slots;
+	block->ssi = (signed char *) mem;
+
+	block->num_types = num_types;
+	block->capacity = capacity;
+
+	return obsreader->err;
+}
+
+//--- header ---------------------------------------------------------------//
+
+static void parse_rinex_decl(
+    rrnx_obsreader *obsreader,
+    const char *line,
+    int linelen
+) {
+	rrnx_file_format *format = &obsreader->header.format;
+
+	// Format version (F9.2)
+	rrnx_substr_trimmed_n(format->version, line, linelen, 0, 9);
+
+	// File type (A1)
+	format->type = (linelen > 20) ? line[20] : ' ';
+
+	// Satellite system (A1); blank means GPS.
+	format->system = (linelen > 40) ? line[40] : ' ';
+	if (format->system == ' ') {
+		format->system = RRNX_SYSTEM_GPS;
+	}
+
+	if (format->type != 'O') {
+		errmsg_format(obsreader, RRNX_E_SYNTAX,
+		    "Not an observation file (file type \'%c\')",
+		    format->type);
+	}
+}
+
+static void parse_meas_layout(
+    rrnx_obsreader *obsreader,
+    const char *line,
+    int linelen
+) {
+	rrnx_obs_header *header = &obsreader->header;
+
+	// Number of types (I6), blank on the continuation lines.
+	int size;
+	if (parse_int(obsreader, &size, line, linelen, 0, 6)) {
+		if (size < 0) {
+			errmsg_format(obsreader, RRNX_E_SYNTAX,
+			    "Invalid number of observation types: %d", size);
+			return;
+		}
+		int err = rrnx_fobs_resize_layout(header, size);
+		if (err) {
+			errmsg_none(obsreader, err);
+			return;
+		}
+		obsreader->types_parsed = 0;
+	}
+
+	// Types (9(4X, A2))
+	for (int i = 0; i < TYPES_PER_LINE; i++) {
+		if (obsreader->types_parsed >= header->layout.size) {
+			break;
+		}
+
+		char code[3];
+		rrnx_substr_trimmed_n(code, line, linelen, 10 + (6*i), 2);
+
+		rrnx_meas_type *type
+		    = &header->layout.item[obsreader->types_parsed];
+		if ((strlen(code) != 2)
+		    || (!rrnx_fobs_code2type(type, header->format.system, code)))
+		{
+			errmsg_format(obsreader, RRNX_E_SYNTAX,
+			    "Unknown observation type \"%s\"", code);
+			return;
+		}
+
+		obsreader->types_parsed++;
+	}
+}
+
+static void parse_header_line(
+    rrnx_obsreader *obsreader,
+    const char *line,
+    int linelen,
+    int linetype
+) {
+	// For convenience
+	rrnx_obs_header *header = &obsreader->header;
+
+	switch(linetype) {
+	case RRNX_LBL_RINEX_DECL:
+		parse_rinex_decl(obsreader, line, linelen);
+		break;
+
+	case RRNX_LBL_CREATION_INFO:
+		// Program, agency and date (3A20)
+		parse_string(header->info.program, line, linelen, 0, 20);
+		parse_string(header->info.agency, line, linelen, 20, 20);
+		parse_string(header->info.date, line, linelen, 40, 20);
+		break;
+
+	case RRNX_LBL_MARKER_NAME:
+		// Marker name (A60)
+		parse_string(header->marker_name, line, linelen, 0, 60);
+		break;
+
+	case RRNX_LBL_MARKER_NUMBER:
+		// Marker number (A20)
+		parse_string(header->marker_number, line, linelen, 0, 20);
+		break;
+
+	case RRNX_LBL_OBSERVER_AGENCY:
+		// Observer, agency (A20, A40)
+		parse_string(header->observer, line, linelen, 0, 20);
+		parse_string(header->agency, line, linelen, 20, 40);
+		break;
+
+	case RRNX_LBL_RECEIVER_INFO:
+		// Receiver number, type and version (3A20)
+		parse_string(header->receiver_number, line, linelen, 0, 20);
+		parse_string(header->receiver_type, line, linelen, 20, 20);
+		parse_string(header->receiver_version, line, linelen, 40, 20);
+		break;
+
+	case RRNX_LBL_ANTENNA_INFO:
+		// Antenna number and type (2A20)
+		parse_string(header->antenna_number, line, linelen, 0, 20);
+		parse_string(header->antenna_type, line, linelen, 20, 20);
+		break;
+
+	case RRNX_LBL_MARKER_XYZ:
+		// Approximate position (3F14.4)
+		parse_double(obsreader, &header->marker_xyz.x,
+		    line, linelen, 0, 14);
+		parse_double(obsreader, &header->marker_xyz.y,
+		    line, linelen, 14, 14);
+		parse_double(obsreader, &header->marker_xyz.z,
+		    line, linelen, 28, 14);
+		header->has_marker_xyz = 1;
+		break;
+
+	case RRNX_LBL_ANTENNA_DELTA:
+		// Antenna height, east and north (3F14.4)
+		parse_double(obsreader, &header->antenna_delta.height,
+		    line, linelen, 0, 14);
+		parse_double(obsreader, &header->antenna_delta.east,
+		    line, linelen, 14, 14);
+		parse_double(obsreader, &header->antenna_delta.north,
+		    line, linelen, 28, 14);
+		header->has_antenna_delta = 1;
+		break;
+
+	case RRNX_LBL_WAVELENGTH_FACT: {
+		// Wavelength factors and the number of satellites (3I6).
+		// The list of satellites is ignored.
+		int value;
+		parse_int(obsreader, &value, line, linelen, 0, 6);
+		header->wavelength_fact.L1_wavelen = value;
+		parse_int(obsreader, &value, line, linelen, 6, 6);
+		header->wavelength_fact.L2_wavelen = value;
+		parse_int(obsreader, &value, line, linelen, 12, 6);
+		header->wavelength_fact.size = value;
+		header->has_wavelength_fact = 1;
+		break;
+	}
+
+	case RRNX_LBL_MEAS_LAYOUT:
+		parse_meas_layout(obsreader, line, linelen);
+		break;
+
+	case RRNX_LBL_INTERVAL:
+		// Interval (F10.3)
+		parse_double(obsreader, &header->interval.interval,
+		    line, linelen, 0, 10);
+		header->has_interval = 1;
+		break;
+
+	case RRNX_LBL_FIRST_MEAS:
+		// Time (5I6, F13.7), 5X, time system (A3)
+		parse_datetime(obsreader, &header->first_meas.t, line, linelen);
+		parse_string(header->first_meas.time_system,
+		    line, linelen, 48, 3);
+		header->has_first_meas = 1;
+		break;
+
+	case RRNX_LBL_LAST_MEAS:
+		// Time (5I6, F13.7), 5X, time system (A3)
+		parse_datetime(obsreader, &header->last_meas.t, line, linelen);
+		parse_string(header->last_meas.time_system,
+		    line, linelen, 48, 3);
+		header->has_last_meas = 1;
+		break;
+
+	case RRNX_LBL_CLOCK_OFFSET: {
+		// Clock offset applied (I6)
+		int value;
+		parse_int(obsreader, &value, line, linelen, 0, 6);
+		header->clock_offset.is_applied = value;
+		header->has_clock_offset = 1;
+		break;
+	}
+
+	case RRNX_LBL_LEAP_SECONDS:
+		// Leap seconds (I6)
+		parse_int(obsreader, &header->leap_seconds.leap_seconds,
+		    line, linelen, 0, 6);
+		header->has_leap_seconds = 1;
+		break;
+
+	case RRNX_LBL_SATELLITE_COUNT:
+		// Number of satellites (I6)
+		parse_int(obsreader, &header->satellite_count.sat_count,
+		    line, linelen, 0, 6);
+		header->has_satellite_count = 1;
+		break;
+
+	default:
+		// Comments, PRN / # OF OBS, and unknown records
+		// are ignored.
+		break;
+	} // switch
+}
+
+/**
+ * Verifies that the observation types were complete,
+ * and sizes the block according to them.
+ */
+static int finish_header(rrnx_obsreader *obsreader) {
+	// For convenience
+	rrnx_obs_header *header = &obsreader->header;
+
+	if (obsreader->types_parsed != header->layout.size) {
+		return errmsg_format(obsreader, RRNX_E_SYNTAX,
+		    "Expected %u observation types, but found only %u",
+		    header->layout.size, obsreader->types_parsed);
+	}
+
+	return reserve_block(obsreader,
+	    header->layout.size, obsreader->block.capacity);
+}
+
+static int read_header(rrnx_obsreader *obsreader) {
+	// For convenience
+	rrnx_filereader *fr = obsreader->fr;
+
+	const char *line;
+	unsigned int linelen;
+
+	for (int first = 1; ; first = 0) {
+		rrnx_fr_readspan(fr, &line, &linelen);
+
+		if (fr->err == RRNX_E_EOF) {
+			return errmsg_format(obsreader, RRNX_E_SYNTAX,
+			    "Unexpected end of file within the header");
+		}
+		else if (fr->err) {
+			return errmsg_fr(obsreader);
+		}
+
+		int linetype = rrnx_enumerate_obs_linetype_n(line, linelen);
+
+		if (first && (linetype != RRNX_LBL_RINEX_DECL)) {
+			return errmsg_format(obsreader, RRNX_E_SYNTAX,
+			    "Expected RINEX VERSION / TYPE");
+		}
+
+		if (linetype == RRNX_LBL_END_OF_HEADER) {
+			break;
+		}
+
+		parse_header_line(obsreader, line, linelen, linetype);
+		if (obsreader->err) {
+			return obsreader->err;
+		}
+	}
+
+	return finish_header(obsreader);
+}
+
+//--- data records ---------------------------------------------------------//
+
+/**
+ * Reads a line which must exist.
+ */
+static int read_record_line(
+    rrnx_obsreader *obsreader,
+    const char **line,
+    unsigned int *linelen
+) {
+	// For convenience
+	rrnx_filereader *fr = obsreader->fr;
+
+	rrnx_fr_readspan(fr, line, linelen);
+
+	if (fr->err == RRNX_E_EOF) {
+		return errmsg_format(obsreader, RRNX_E_SYNTAX,
+		    "Unexpected end of file within an epoch");
+	}
+	else if (fr->err) {
+		return errmsg_fr(obsreader);
+	}
+
+	return obsreader->err;
+}
+
+/**
+ * Appends a special record and a newline to the records buffer.
+ * The buffer is kept terminated.
+ */
+static int append_record(
+    rrnx_obsreader *obsreader,
+    size_t *used,
+    const char *line,
+    unsigned int linelen
+) {
+	size_t needed = *used + linelen + 2;
+	if (needed > obsreader->records_size) {
+		size_t size = (obsreader->records_size > 0)
+		    ? obsreader->records_size : 256;
+		while (size < needed) {
+			size *= 2;
+		}
+		char *records = realloc(obsreader->records, size);
+		if (records == NULL) {
+			return errmsg_none(obsreader, RRNX_E_NOMEM);
+		}
+		obsreader->records = records;
+		obsreader->records_size = size;
+	}
+
+	memcpy(obsreader->records + *used, line, linelen);
+	*used += linelen;
+	obsreader->records[(*used)++] = '\n';
+	obsreader->records[*used] = '\0';
+
+	return obsreader->err;
+}
+
+/**
+ * Reads the special records following an event flag 2-5.
+ * They are header records, which are applied to the header.
+ * The records are also kept as they were, for the block.
+ */
+static int read_event_records(rrnx_obsreader *obsreader, int count) {
+	// For convenience
+	rrnx_obs_header *header = &obsreader->header;
+
+	const char *line;
+	unsigned int linelen;
+	size_t used = 0;
+
+	unsigned int num_types = header->layout.size;
+
+	for (int i = 0; i < count; i++) {
+		if (read_record_line(obsreader, &line, &linelen)) {
+			return obsreader->err;
+		}
+
+		if (append_record(obsreader, &used, line, linelen)) {
+			return obsreader->err;
+		}
+
+		int linetype = rrnx_enumerate_obs_linetype_n(line, linelen);
+		parse_header_line(obsreader, line, linelen, linetype);
+		if (obsreader->err) {
+			return obsreader->err;
+		}
+	}
+
+	if ((header->layout.size != num_types)
+	    || (obsreader->types_parsed != num_types))
+	{
+		// The observation types changed.
+		finish_header(obsreader);
+	}
+
+	// Set after finish_header(), which may reset the block.
+	obsreader->block.records = (used > 0) ? obsreader->records : "";
+
+	return obsreader->err;
+}
+
+/**
+ * Reads the satellites of the epoch. The first line
+ * has been parsed already.
+ */
+static int read_satellites(
+    rrnx_obsreader *obsreader,
+    const char *line,
+    unsigned int linelen,
+    int num_sats
+) {
+	// For convenience
+	rrnx_obs_block *block = &obsreader->block;
+	int default_system = obsreader->header.format.system;
+	if (default_system == 'M') {
+		default_system = RRNX_SYSTEM_GPS;
+	}
+
+	for (int i = 0; i < num_sats; i++) {
+		int col = i % SATS_PER_LINE;
+		if ((i > 0) && (col == 0)) {
+			// Continuation line, unless the previous one failed
+			if ((obsreader->err)
+			    || (read_record_line(obsreader, &line, &linelen)))
+			{
+				return obsreader->err;
+			}
+		}
+
+		// Satellite (A1, I2)
+		int offset = 32 + (3*col);
+		int system = (offset < linelen) ? line[offset] : ' ';
+		if (system == ' ') {
+			system = default_system;
+		}
+
+		rrnx_satellite_id *sat = &block->epoch.sat[i];
+		sat->system = system;
+		parse_int(obsreader, &sat->id, line, linelen, offset+1, 2);
+	}
+
+	return obsreader->err;
+}
+
+/**
+ * Reads the observation records of the satellites into the block.
+ */
+static int read_observations(rrnx_obsreader *obsreader, int num_sats) {
+	// For convenience
+	rrnx_obs_block *block = &obsreader->block;
+	unsigned int num_types = block->num_types;
+	unsigned int capacity = block->capacity;
+
+	const char *line;
+	unsigned int linelen;
+
+	for (int i = 0; i < num_sats; i++) {
+		for (unsigned int t = 0; t < num_types; t++) {
+			int col = t % OBS_PER_LINE;
+			if (col == 0) {
+				// Stop at the line which failed, if any
+				if ((obsreader->err)
+				    || (read_record_line(obsreader, &line, &linelen)))
+				{
+					return obsreader->err;
+				}
+			}
+
+			// Observation (F14.3, I1, I1)
+			int offset = OBS_WIDTH * col;
+			size_t slot = ((size_t) t * capacity) + i;
+
+			block->valid[slot] = parse_double(obsreader,
+			    &block->value[slot], line, linelen, offset, 14);
+			block->lli[slot] = parse_flag(obsreader,
+			    line, linelen, offset+14);
+			block->ssi[slot] = parse_flag(obsreader,
+			    line, linelen, offset+15);
+		}
+	}
+
+	return obsreader->err;
+}
+
+/**
+ * Parses an epoch record, and everything that belongs to it.
+ */
+static int read_epoch(
+    rrnx_obsreader *obsreader,
+    const char *line,
+    unsigned int linelen
+) {
+	// For convenience
+	rrnx_obs_block *block = &obsreader->block;
+	rrnx_meas_epoch *epoch = &block->epoch;
+
+	// Epoch time (1X, I2.2, 4(1X, I2), F11.7).
+	// May be blank for the event flags 2-4.
+	rrnx_datetime *t = &epoch->t;
+	parse_int(obsreader, &t->year, line, linelen, 1, 2);
+	parse_int(obsreader, &t->month, line, linelen, 4, 2);
+	parse_int(obsreader, &t->day, line, linelen, 7, 2);
+	parse_int(obsreader, &t->hour, line, linelen, 10, 2);
+	parse_int(obsreader, &t->min, line, linelen, 13, 2);
+	parse_double(obsreader, &t->sec, line, linelen, 15, 11);
+
+	// Epoch flag (2X, I1), and the number of satellites
+	// or special records (I3)
+	int flag;
+	int count;
+	parse_int(obsreader, &flag, line, linelen, 28, 1);
+	parse_int(obsreader, &count, line, linelen, 29, 3);
+
+	// Receiver clock offset (F12.9), optional
+	if (!parse_double(obsreader, &epoch->clock_offset,
+	    line, linelen, 68, 12))
+	{
+		epoch->clock_offset = NAN;
+	}
+
+	if (obsreader->err) {
+		return obsreader->err;
+	}
+
+	if ((flag < 0) || (flag > 6) || (count < 0)) {
+		return errmsg_format(obsreader, RRNX_E_SYNTAX,
+		    "Invalid epoch flag %d or count %d", flag, count);
+	}
+
+	epoch->event = flag;
+	epoch->size = count;
+	block->records = NULL;
+
+	if ((flag >= 2) && (flag <= 5)) {
+		// Special records follow
+		block->num_sats = 0;
+		return read_event_records(obsreader, count);
+	}
+
+	// Observations (flags 0 and 1), or cycle slips (flag 6) follow.
+	if (reserve_block(obsreader, block->num_types, count)) {
+		return obsreader->err;
+	}
+	block->num_sats = count;
+
+	if (read_satellites(obsreader, line, linelen, count)) {
+		return obsreader->err;
+	}
+
+	return read_observations(obsreader, count);
+}
+
+//--- external methods -----------------------------------------------------//
+
+rrnx_obsreader *rrnx_obsr_alloc(void) {
+	int incomplete = 1;
+
+	// Allocate new object
+	rrnx_obsreader *obsreader
+	    = malloc(sizeof(rrnx_obsreader));
+
+	if (obsreader != NULL) do {
+		// Initialize members
+		obsreader->fr = NULL;
+		rrnx_fobs_init_header(&obsreader->header);
+		memset(&obsreader->block, 0, sizeof(rrnx_obs_block));
+		obsreader->errmsg = NULL;
+		obsreader->err = RRNX_E_OK;
+		obsreader->finished = 0;
+		obsreader->types_parsed = 0;
+		obsreader->records = NULL;
+		obsreader->records_size = 0;
+		obsreader->workbuf = NULL;
+		obsreader->workbuf_size = 0;
+		obsreader->use_mmap = 0;
+
+		// Attempt further allocations
+		obsreader->fr = rrnx_fr_alloc();
+		if (obsreader->fr == NULL) {
+			// Abort
+			break;
+		}
+
+		obsreader->errmsg = rrnx_str_alloc();
+		if (obsreader->errmsg == NULL) {
+			// Abort
+			break;
+		}
+
+		int size = RRNX_DEFAULT_ERRMSG_SIZE;
+		obsreader->workbuf = malloc(size);
+		if (obsreader->workbuf == NULL) {
+			// Abort
+			break;
+		}
+		obsreader->workbuf_size = size;
+
+		// Success
+		incomplete = 0;
+	} while (0);
+
+	if (incomplete) {
+		rrnx_obsr_free(obsreader);
+		obsreader = NULL;
+	}
+
+	return obsreader;
+}
+
+void rrnx_obsr_free(rrnx_obsreader *obsreader) {
+	if (obsreader == NULL) {
+		// Already freed
+		return;
+	}
+
+	// Deallocate filereader, if any
+	rrnx_fr_free(obsreader->fr);
+	obsreader->fr = NULL;
+
+	rrnx_fobs_deinit_header(&obsreader->header);
+	free_block(&obsreader->block);
+
+	// Deallocate errmsg, if any
+	rrnx_str_free(obsreader->errmsg);
+	obsreader->errmsg = NULL;
+
+	free(obsreader->records);
+	obsreader->records = NULL;
+	obsreader->records_size = 0;
+
+	free(obsreader->workbuf);
+	obsreader->workbuf = NULL;
+	obsreader->workbuf_size = 0;
+
+	// Deallocate self
+	free(obsreader);
+}
+
+int rrnx_obsr_errno(const rrnx_obsreader *obsreader) {
+	return obsreader->err;
+}
+
+const char *rrnx_obsr_strerror(const rrnx_obsreader *obsreader) {
+	return obsreader->errmsg->text;
+}
+
+void rrnx_obsr_set_mmap(rrnx_obsreader *obsreader, int enabled) {
+	obsreader->use_mmap = enabled;
+}
+
+int rrnx_obsr_open(rrnx_obsreader *obsreader, const char *filename) {
+	// For convenience
+	rrnx_filereader *fr = obsreader->fr;
+
+	// Clear any previous error and header
+	errmsg_none(obsreader, RRNX_E_OK);
+	rrnx_fobs_deinit_header(&obsreader->header);
+	obsreader->types_parsed = 0;
+	obsreader->finished = 0;
+	obsreader->block.num_sats = 0;
+
+	// Open file
+	if (obsreader->use_mmap) {
+		rrnx_fr_mmap(fr, filename);
+	} else {
+		rrnx_fr_fopen(fr, filename);
+	}
+	if (fr->err) {
+		// Open failed; propagate error
+		return errmsg_fr(obsreader);
+	}
+
+	if (read_header(obsreader)) {
+		errmsg_prepend_location(obsreader);
+		rrnx_fr_fclose(fr);
+	}
+
+	return obsreader->err;
+}
+
+int rrnx_obsr_next(rrnx_obsreader *obsreader, const rrnx_obs_block **block) {
+	// For convenience
+	rrnx_filereader *fr = obsreader->fr;
+
+	*block = NULL;
+
+	if ((obsreader->err) || (obsreader->finished)) {
+		// Already failed and reported, or at the end
+		return 0;
+	}
+
+	const char *line;
+	unsigned int linelen;
+
+	do {
+		rrnx_fr_readspan(fr, &line, &linelen);
+		if (fr->err == RRNX_E_EOF) {
+			obsreader->finished = 1;
+			return 0;
+		}
+		else if (fr->err) {
+			errmsg_fr(obsreader);
+			return 0;
+		}
+		// Skip blank lines
+	} while (linelen == 0);
+
+	if (read_epoch(obsreader, line, linelen)) {
+		errmsg_prepend_location(obsreader);
+		return 0;
+	}
+
+	*block = &obsreader->block;
+	return 1;
+}
+
+void rrnx_obsr_close(rrnx_obsreader *obsreader) {
+	rrnx_fr_fclose(obsreader->fr);
+	obsreader->finished = 1;
+}
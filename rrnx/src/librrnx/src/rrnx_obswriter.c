@@ -0,0 +1,724 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include "rrnx/rrnx_obswriter.h"
+#include "rrnx/rrnx_numconv.h"
+
+// Internal headers
+#include "rrnx_outbuf.h"
+
+#include <stdlib.h> // malloc, free
+#include <stdio.h> // fopen, fclose, snprintf
+#include <string.h>
+#include <errno.h> // errno
+#include <stdarg.h> // va_list, va_start, va_end
+#include <math.h> // isnan
+
+/**
+ * Room for the longest line, including the newline.
+ */
+#define MAX_LINE_SIZE 128
+
+/**
+ * Width of a header line without the label.
+ */
+#define LABEL_OFFSET 60
+
+/**
+ * Observations per line in the data records (5(F14.3, I1, I1)).
+ */
+#define OBS_PER_LINE 5
+
+/**
+ * Width of an observation, including the flags.
+ */
+#define OBS_WIDTH 16
+
+/**
+ * Satellites per line in the epoch records (12(A1, I2)).
+ */
+#define SATS_PER_LINE 12
+
+/**
+ * Observation types per line in the header (9(4X, A2)).
+ */
+#define TYPES_PER_LINE 9
+
+/**
+ * Width of a header record.
+ */
+#define RECORD_WIDTH 80
+
+//--- error messages -------------------------------------------------------//
+
+static int errmsg_format(
+    rrnx_obswriter *obswriter,
+    int err,
+    const char *fmt, ...
+) {
+	obswriter->err = err;
+
+	va_list args;
+	va_start(args, fmt);
+	rrnx_str_vformat(obswriter->errmsg, fmt, args);
+	va_end(args);
+
+	return obswriter->err;
+}
+
+static int errmsg_syscall(
+    rrnx_obswriter *obswriter,
+    const char *syscall,
+    int errnum
+) {
+	return errmsg_format(obswriter, RRNX_E_SYSCALL,
+	    "%s: %s() failed: %s",
+	    obswriter->filename, syscall, strerror(errnum));
+}
+
+//--- line output ----------------------------------------------------------//
+
+/**
+ * Returns room for a line, or NULL on error.
+ */
+static char *begin_line(rrnx_obswriter *obswriter) {
+	if (obswriter->err) {
+		return NULL;
+	}
+
+	char *line = rrnx_outbuf_reserve(obswriter->ob, MAX_LINE_SIZE);
+	if (line == NULL) {
+		errmsg_syscall(obswriter, "fwrite", obswriter->ob->errnum);
+	}
+	return line;
+}
+
+/**
+ * Trims the trailing blanks of the line of len chars,
+ * and adds it to the buffer with a newline.
+ */
+static void end_line(rrnx_obswriter *obswriter, char *line, int len) {
+	while ((len > 0) && (line[len-1] == ' ')) {
+		len--;
+	}
+	line[len++] = '\n';
+	rrnx_outbuf_commit(obswriter->ob, len);
+	obswriter->lines++;
+}
+
+/**
+ * Copies a string into a field of the line, left-justified.
+ * The string is cropped to the width of the field.
+ */
+static void put_string(char *line, int offset, int width, const char *s) {
+	int len = strlen(s);
+	if (len > width) {
+		len = width;
+	}
+	memcpy(line + offset, s, len);
+}
+
+/**
+ * Formats a field with snprintf() into the line.
+ * The terminator is not left into the line.
+ */
+static void put_format(
+    char *line,
+    int offset,
+    int width,
+    const char *fmt, ...
+) {
+	char buf[MAX_LINE_SIZE];
+
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	put_string(line, offset, width, buf);
+}
+
+/**
+ * Formats a non-negative integer right-justified (Iw).
+ * Values which do not fit are cropped from the left.
+ */
+static void put_uint(char *line, int offset, int width, unsigned int value) {
+	char *p = line + offset + width;
+	do {
+		*--p = (char) ('0' + (value % 10));
+		value /= 10;
+	} while ((value > 0) && (p > line + offset));
+}
+
+static void write_header_line(
+    rrnx_obswriter *obswriter,
+    char *line,
+    const char *label
+) {
+	put_string(line, LABEL_OFFSET, 20, label);
+	end_line(obswriter, line, LABEL_OFFSET + 20);
+}
+
+static char *begin_header_line(rrnx_obswriter *obswriter) {
+	char *line = begin_line(obswriter);
+	if (line != NULL) {
+		memset(line, ' ', LABEL_OFFSET + 20);
+	}
+	return line;
+}
+
+static void write_meas_time(
+    rrnx_obswriter *obswriter,
+    const rrnx_datetime *t,
+    const char *time_system,
+    const char *label
+) {
+	char *line = begin_header_line(obswriter);
+	if (line == NULL) return;
+
+	// 5I6, F13.7, 5X, A3
+	put_format(line, 0, 43, "%6d%6d%6d%6d%6d%13.7f",
+	    t->year, t->month, t->day, t->hour, t->min, t->sec);
+	put_string(line, 48, 3, time_system);
+	write_header_line(obswriter, line, label);
+}
+
+//--- external methods -----------------------------------------------------//
+
+rrnx_obswriter *rrnx_obsw_alloc(void) {
+	int incomplete = 1;
+
+	// Allocate new object
+	rrnx_obswriter *obswriter
+	    = malloc(sizeof(rrnx_obswriter));
+
+	if (obswriter != NULL) do {
+		// Initialize members
+		obswriter->ob = NULL;
+		obswriter->filename = NULL;
+		obswriter->num_types = 0;
+		obswriter->lines = 0;
+		obswriter->errmsg = NULL;
+		obswriter->err = RRNX_E_OK;
+
+		// Attempt further allocations
+		obswriter->ob = malloc(sizeof(rrnx_outbuf));
+		if (obswriter->ob == NULL) {
+			// Abort
+			break;
+		}
+		if (rrnx_outbuf_init(obswriter->ob,
+		    RRNX_OBSW_DEFAULT_BUFFER_SIZE) != RRNX_E_OK)
+		{
+			// Abort
+			break;
+		}
+
+		obswriter->errmsg = rrnx_str_alloc();
+		if (obswriter->errmsg == NULL) {
+			// Abort
+			break;
+		}
+
+		// Success
+		incomplete = 0;
+	} while (0);
+
+	if (incomplete) {
+		rrnx_obsw_free(obswriter);
+		obswriter = NULL;
+	}
+
+	return obswriter;
+}
+
+void rrnx_obsw_free(rrnx_obswriter *obswriter) {
+	if (obswriter == NULL) {
+		// Already freed
+		return;
+	}
+
+	// Close the file, if still open.
+	if ((obswriter->ob != NULL) && (obswriter->ob->fp != NULL)) {
+		rrnx_obsw_close(obswriter);
+	}
+
+	if (obswriter->ob != NULL) {
+		rrnx_outbuf_deinit(obswriter->ob);
+		free(obswriter->ob);
+		obswriter->ob = NULL;
+	}
+
+	free(obswriter->filename);
+	obswriter->filename = NULL;
+
+	// Deallocate errmsg, if any
+	rrnx_str_free(obswriter->errmsg);
+	obswriter->errmsg = NULL;
+
+	// Deallocate self
+	free(obswriter);
+}
+
+int rrnx_obsw_errno(const rrnx_obswriter *obswriter) {
+	return obswriter->err;
+}
+
+const char *rrnx_obsw_strerror(const rrnx_obswriter *obswriter) {
+	return obswriter->errmsg->text;
+}
+
+int rrnx_obsw_open(rrnx_obswriter *obswriter, const char *filename) {
+	// For convenience
+	rrnx_outbuf *ob = obswriter->ob;
+
+	// Clear any previous error
+	obswriter->err = RRNX_E_OK;
+	rrnx_str_reset(obswriter->errmsg);
+
+	if (ob->fp != NULL) {
+		return errmsg_format(obswriter, RRNX_E_HASFILE,
+		    "%s: cannot open, because previous file (%s) is still open",
+		    filename, obswriter->filename);
+	}
+
+	free(obswriter->filename);
+	obswriter->filename = malloc(strlen(filename)+1);
+	if (obswriter->filename == NULL) {
+		return errmsg_format(obswriter, RRNX_E_NOMEM,
+		    "Out of memory");
+	}
+	strcpy(obswriter->filename, filename);
+
+	ob->fp = fopen(filename, "wb");
+	if (ob->fp == NULL) {
+		return errmsg_syscall(obswriter, "fopen", errno);
+	}
+
+	ob->len = 0;
+	ob->errnum = 0;
+	obswriter->num_types = 0;
+	obswriter->lines = 0;
+
+	return obswriter->err;
+}
+
+int rrnx_obsw_write_header(
+    rrnx_obswriter *obswriter,
+    const rrnx_obs_header *header
+) {
+	char *line;
+
+	// RINEX VERSION / TYPE: F9.2, 11X, A1, 19X, A1, 19X
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	const char *version = header->format.version;
+	put_format(line, 0, 9, "%9s", (version[0] != '\0') ? version : "2.11");
+	put_string(line, 20, 20, "OBSERVATION DATA");
+	line[40] = (header->format.system != 0)
+	    ? (char) header->format.system : RRNX_SYSTEM_GPS;
+	write_header_line(obswriter, line, "RINEX VERSION / TYPE");
+
+	// PGM / RUN BY / DATE: 3A20
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_string(line, 0, 20, header->info.program);
+	put_string(line, 20, 20, header->info.agency);
+	put_string(line, 40, 20, header->info.date);
+	write_header_line(obswriter, line, "PGM / RUN BY / DATE");
+
+	// MARKER NAME: A60
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_string(line, 0, 60, header->marker_name);
+	write_header_line(obswriter, line, "MARKER NAME");
+
+	// MARKER NUMBER: A20, optional
+	if (header->marker_number[0] != '\0') {
+		line = begin_header_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		put_string(line, 0, 20, header->marker_number);
+		write_header_line(obswriter, line, "MARKER NUMBER");
+	}
+
+	// OBSERVER / AGENCY: A20, A40
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_string(line, 0, 20, header->observer);
+	put_string(line, 20, 40, header->agency);
+	write_header_line(obswriter, line, "OBSERVER / AGENCY");
+
+	// REC # / TYPE / VERS: 3A20
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_string(line, 0, 20, header->receiver_number);
+	put_string(line, 20, 20, header->receiver_type);
+	put_string(line, 40, 20, header->receiver_version);
+	write_header_line(obswriter, line, "REC # / TYPE / VERS");
+
+	// ANT # / TYPE: 2A20
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_string(line, 0, 20, header->antenna_number);
+	put_string(line, 20, 20, header->antenna_type);
+	write_header_line(obswriter, line, "ANT # / TYPE");
+
+	// APPROX POSITION XYZ: 3F14.4
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_format(line, 0, 42, "%14.4f%14.4f%14.4f",
+	    header->marker_xyz.x, header->marker_xyz.y,
+	    header->marker_xyz.z);
+	write_header_line(obswriter, line, "APPROX POSITION XYZ");
+
+	// ANTENNA: DELTA H/E/N: 3F14.4
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	put_format(line, 0, 42, "%14.4f%14.4f%14.4f",
+	    header->antenna_delta.height, header->antenna_delta.east,
+	    header->antenna_delta.north);
+	write_header_line(obswriter, line, "ANTENNA: DELTA H/E/N");
+
+	// WAVELENGTH FACT L1/2: 2I6. The satellite list is not
+	// kept by the header, so only the default factors are written.
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	if (header->has_wavelength_fact) {
+		put_format(line, 0, 12, "%6u%6u",
+		    header->wavelength_fact.L1_wavelen,
+		    header->wavelength_fact.L2_wavelen);
+	} else {
+		put_format(line, 0, 12, "%6d%6d", 1, 1);
+	}
+	write_header_line(obswriter, line, "WAVELENGTH FACT L1/2");
+
+	// # / TYPES OF OBSERV: I6, 9(4X, A2), continued with 6X, 9(4X, A2)
+	unsigned int size = header->layout.size;
+	unsigned int i = 0;
+	do {
+		line = begin_header_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		if (i == 0) {
+			put_uint(line, 0, 6, size);
+		}
+		for (int col = 0; (col < TYPES_PER_LINE) && (i < size); col++, i++) {
+			char code[3];
+			rrnx_fobs_type2code(&header->layout.item[i], code);
+			put_string(line, 10 + (6*col), 2, code);
+		}
+		write_header_line(obswriter, line, "# / TYPES OF OBSERV");
+	} while (i < size);
+
+	// INTERVAL: F10.3, optional
+	if (header->has_interval) {
+		line = begin_header_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		put_format(line, 0, 10, "%10.3f", header->interval.interval);
+		write_header_line(obswriter, line, "INTERVAL");
+	}
+
+	if (header->has_first_meas) {
+		write_meas_time(obswriter, &header->first_meas.t,
+		    header->first_meas.time_system, "TIME OF FIRST OBS");
+	}
+
+	if (header->has_last_meas) {
+		write_meas_time(obswriter, &header->last_meas.t,
+		    header->last_meas.time_system, "TIME OF LAST OBS");
+	}
+
+	// RCV CLOCK OFFS APPL: I6, optional
+	if (header->has_clock_offset) {
+		line = begin_header_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		put_uint(line, 0, 6, header->clock_offset.is_applied);
+		write_header_line(obswriter, line, "RCV CLOCK OFFS APPL");
+	}
+
+	// LEAP SECONDS: I6, optional
+	if (header->has_leap_seconds) {
+		line = begin_header_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		put_format(line, 0, 6, "%6d",
+		    header->leap_seconds.leap_seconds);
+		write_header_line(obswriter, line, "LEAP SECONDS");
+	}
+
+	// # OF SATELLITES: I6, optional
+	if (header->has_satellite_count) {
+		line = begin_header_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		put_format(line, 0, 6, "%6d",
+		    header->satellite_count.sat_count);
+		write_header_line(obswriter, line, "# OF SATELLITES");
+	}
+
+	line = begin_header_line(obswriter);
+	if (line == NULL) return obswriter->err;
+	write_header_line(obswriter, line, "END OF HEADER");
+
+	obswriter->num_types = size;
+
+	return obswriter->err;
+}
+
+/**
+ * Tells whether the epoch has a time. The time of an event record
+ * may be blank, which the reader leaves as zeros; there is no month
+ * zero otherwise.
+ */
+static int has_time(const rrnx_meas_epoch *epoch) {
+	return (epoch->event < 2) || (epoch->event > 5)
+	    || (epoch->t.month != 0);
+}
+
+/**
+ * Writes the epoch record with the given count (I3),
+ * including the continuation lines of the satellite list.
+ */
+static void write_epoch_record(
+    rrnx_obswriter *obswriter,
+    const rrnx_meas_epoch *epoch,
+    unsigned int count,
+    unsigned int num_sats
+) {
+	// For convenience
+	const rrnx_datetime *t = &epoch->t;
+
+	char *line = begin_line(obswriter);
+	if (line == NULL) return;
+
+	// 1X, I2.2, 4(1X, I2), F11.7, 2X, I1, I3
+	memset(line, ' ', 80);
+	if (has_time(epoch)) {
+		put_uint(line, 1, 2, (t->year % 100) + 100);
+		put_uint(line, 4, 2, t->month);
+		put_uint(line, 7, 2, t->day);
+		put_uint(line, 10, 2, t->hour);
+		put_uint(line, 13, 2, t->min);
+		put_format(line, 15, 11, "%11.7f", t->sec);
+	}
+	put_uint(line, 28, 1, epoch->event);
+	put_uint(line, 29, 3, count);
+
+	// Receiver clock offset (F12.9), optional
+	int len = 32;
+	if (!isnan(epoch->clock_offset)) {
+		put_format(line, 68, 12, "%12.9f", epoch->clock_offset);
+		len = 80;
+	}
+
+	for (unsigned int i = 0; i < num_sats; i++) {
+		int col = i % SATS_PER_LINE;
+		if ((i > 0) && (col == 0)) {
+			// Continuation line: 32X, 12(A1, I2)
+			end_line(obswriter, line, len);
+			line = begin_line(obswriter);
+			if (line == NULL) return;
+			memset(line, ' ', 80);
+			len = 32;
+		}
+
+		// Satellite (A1, I2.2)
+		const rrnx_satellite_id *sat = &epoch->sat[i];
+		int offset = 32 + (3*col);
+		line[offset] = (char) sat->system;
+		put_uint(line, offset+1, 2, (sat->id % 100) + 100);
+		if (len < offset+3) {
+			len = offset+3;
+		}
+	}
+
+	end_line(obswriter, line, len);
+}
+
+static void write_flag(char *dest, int flag) {
+	*dest = (flag == RRNX_OBSR_FLAG_BLANK) ? ' ' : (char) ('0' + flag);
+}
+
+/**
+ * Writes the observation records of the satellites.
+ */
+static void write_observations(
+    rrnx_obswriter *obswriter,
+    const rrnx_obs_block *block,
+    unsigned int num_sats
+) {
+	// For convenience
+	unsigned int num_types = block->num_types;
+	unsigned int capacity = block->capacity;
+
+	for (unsigned int i = 0; i < num_sats; i++) {
+		for (unsigned int t = 0; t < num_types; t += OBS_PER_LINE) {
+			char *line = begin_line(obswriter);
+			if (line == NULL) return;
+
+			char *p = line;
+			for (unsigned int u = t; (u < num_types)
+			    && (u < t + OBS_PER_LINE); u++)
+			{
+				size_t slot = ((size_t) u * capacity) + i;
+
+				// Observation (F14.3, I1, I1)
+				if (!block->valid[slot]) {
+					memset(p, ' ', 14);
+				}
+				else if (!rrnx_num_format_fixed(
+				    p, 14, 3, block->value[slot]))
+				{
+					const rrnx_satellite_id *sat
+					    = &block->epoch.sat[i];
+					errmsg_format(obswriter, RRNX_E_OVERFLOW,
+					    "%s: observation %g of satellite %c%02d "
+					    "does not fit into F14.3",
+					    obswriter->filename, block->value[slot],
+					    sat->system, sat->id);
+					return;
+				}
+				write_flag(p+14, block->lli[slot]);
+				write_flag(p+15, block->ssi[slot]);
+				p += OBS_WIDTH;
+			}
+
+			end_line(obswriter, line, p - line);
+		}
+	}
+}
+
+/**
+ * Returns the number of observation types (I6) of the header record,
+ * or 0 if it is not the first "# / TYPES OF OBSERV" record.
+ */
+static unsigned int parse_num_types(const char *record, int len) {
+	static const char label[] = "# / TYPES OF OBSERV";
+	if ((len < LABEL_OFFSET + (int) sizeof(label) - 1)
+	    || (memcmp(record + LABEL_OFFSET, label, sizeof(label) - 1) != 0))
+	{
+		return 0;
+	}
+
+	unsigned int value = 0;
+	for (int i = 0; i < 6; i++) {
+		char c = record[i];
+		if ((c >= '0') && (c <= '9')) {
+			value = (value * 10) + (c - '0');
+		}
+	}
+	return value;
+}
+
+/**
+ * Writes an event (flags 2-5): the epoch record with the number of
+ * special records, and the records themselves. A new set of
+ * observation types in the records applies to the following epochs.
+ */
+static int write_event(
+    rrnx_obswriter *obswriter,
+    const rrnx_obs_block *block
+) {
+	unsigned int count = block->epoch.size;
+	const char *records = (block->records != NULL) ? block->records : "";
+
+	// Check the records before writing anything.
+	const char *p = records;
+	unsigned int found = 0;
+	for (; (found < count) && (*p != '\0'); found++) {
+		const char *end = strchr(p, '\n');
+		p = (end != NULL) ? end + 1 : p + strlen(p);
+	}
+	if (found < count) {
+		return errmsg_format(obswriter, RRNX_E_SYNTAX,
+		    "%s: the event has %u special records, but only %u are given",
+		    obswriter->filename, count, found);
+	}
+
+	write_epoch_record(obswriter, &block->epoch, count, 0);
+
+	p = records;
+	for (unsigned int i = 0; i < count; i++) {
+		const char *end = strchr(p, '\n');
+		int len = (end != NULL) ? (int) (end - p) : (int) strlen(p);
+		int width = (len < RECORD_WIDTH) ? len : RECORD_WIDTH;
+
+		char *line = begin_line(obswriter);
+		if (line == NULL) return obswriter->err;
+		memcpy(line, p, width);
+		end_line(obswriter, line, width);
+
+		unsigned int num_types = parse_num_types(p, len);
+		if (num_types > 0) {
+			obswriter->num_types = num_types;
+		}
+
+		p += (end != NULL) ? len + 1 : len;
+	}
+
+	return obswriter->err;
+}
+
+int rrnx_obsw_write_epoch(
+    rrnx_obswriter *obswriter,
+    const rrnx_obs_block *block
+) {
+	if (obswriter->err) {
+		// Already failed, and reported.
+		return obswriter->err;
+	}
+
+	unsigned int event = block->epoch.event;
+	if ((event >= 2) && (event <= 5)) {
+		// Special records follow
+		return write_event(obswriter, block);
+	}
+
+	if (block->num_types != obswriter->num_types) {
+		return errmsg_format(obswriter, RRNX_E_SYNTAX,
+		    "%s: the epoch has %u observation types, "
+		    "but the header has %u",
+		    obswriter->filename, block->num_types,
+		    obswriter->num_types);
+	}
+
+	write_epoch_record(obswriter, &block->epoch,
+	    block->num_sats, block->num_sats);
+	write_observations(obswriter, block, block->num_sats);
+
+	return obswriter->err;
+}
+
+int rrnx_obsw_close(rrnx_obswriter *obswriter) {
+	// For convenience
+	rrnx_outbuf *ob = obswriter->ob;
+
+	if (ob->fp == NULL) {
+		// No file
+		return obswriter->err;
+	}
+
+	int errnum = rrnx_outbuf_flush(ob);
+	if ((errnum != 0) && (!obswriter->err)) {
+		errmsg_syscall(obswriter, "fwrite", errnum);
+	}
+
+	if ((fclose(ob->fp) != 0) && (!obswriter->err)) {
+		errmsg_syscall(obswriter, "fclose", errno);
+	}
+	ob->fp = NULL;
+	ob->len = 0;
+
+	return obswriter->err;
+}
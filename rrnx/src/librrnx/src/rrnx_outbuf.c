@@ -0,0 +1,79 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include "rrnx_outbuf.h"
+#include "rrnx/rrnx_error.h"
+
+#include <stdlib.h> // malloc, realloc, free
+#include <errno.h>
+
+int rrnx_outbuf_init(rrnx_outbuf *ob, size_t size) {
+	ob->fp = NULL;
+	ob->len = 0;
+	ob->errnum = 0;
+	ob->data = malloc(size);
+	ob->size = (ob->data != NULL) ? size : 0;
+	return (ob->data != NULL) ? RRNX_E_OK : RRNX_E_NOMEM;
+}
+
+void rrnx_outbuf_deinit(rrnx_outbuf *ob) {
+	free(ob->data);
+	ob->data = NULL;
+	ob->size = 0;
+	ob->len = 0;
+}
+
+int rrnx_outbuf_flush(rrnx_outbuf *ob) {
+	if ((ob->fp != NULL) && (ob->len > 0) && (ob->errnum == 0)) {
+		if (fwrite(ob->data, 1, ob->len, ob->fp) != ob->len) {
+			ob->errnum = (errno != 0) ? errno : EIO;
+		}
+		ob->len = 0;
+	}
+	return ob->errnum;
+}
+
+char *rrnx_outbuf_reserve(rrnx_outbuf *ob, size_t n) {
+	if (ob->size - ob->len >= n) {
+		return ob->data + ob->len;
+	}
+
+	if (ob->fp != NULL) {
+		// Make room by writing out
+		if (rrnx_outbuf_flush(ob) != 0) {
+			return NULL;
+		}
+		if (ob->size >= n) {
+			return ob->data;
+		}
+	}
+
+	// Grow
+	size_t size = (ob->size > 0) ? ob->size : 0x1000;
+	while (size - ob->len < n) {
+		size *= 2;
+	}
+	char *data = realloc(ob->data, size);
+	if (data == NULL) {
+		ob->errnum = ENOMEM;
+		return NULL;
+	}
+	ob->data = data;
+	ob->size = size;
+
+	return ob->data + ob->len;
+}
@@ -0,0 +1,80 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#ifndef RRNX_OUTBUF_H
+#define RRNX_OUTBUF_H
+
+#include <stdio.h> // FILE
+#include <stddef.h> // size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Output buffer for the writers. The text is formatted directly
+ * into the buffer, which is written to the file when it fills up.
+ * Without a file, the buffer grows instead, and the text is
+ * collected into memory.
+ */
+struct rrnx_outbuf {
+	/** Destination file, or NULL. */
+	FILE *fp;
+
+	/** The buffer. */
+	char *data;
+
+	/** Size of the buffer. */
+	size_t size;
+
+	/** Number of chars in the buffer. */
+	size_t len;
+
+	/** errno of the failed write, or 0. */
+	int errnum;
+};
+
+typedef struct rrnx_outbuf rrnx_outbuf;
+
+/**
+ * Initializes the buffer. Returns error code.
+ */
+int rrnx_outbuf_init(rrnx_outbuf *ob, size_t size);
+void rrnx_outbuf_deinit(rrnx_outbuf *ob);
+
+/**
+ * Returns room for at least n chars at the end of the buffer,
+ * or NULL if the write or the allocation failed. The chars
+ * are added to the buffer with rrnx_outbuf_commit().
+ */
+char *rrnx_outbuf_reserve(rrnx_outbuf *ob, size_t n);
+
+static inline void rrnx_outbuf_commit(rrnx_outbuf *ob, size_t n) {
+	ob->len += n;
+}
+
+/**
+ * Writes the buffer to the file, if any.
+ * Returns errno of the failed write, or 0.
+ */
+int rrnx_outbuf_flush(rrnx_outbuf *ob);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
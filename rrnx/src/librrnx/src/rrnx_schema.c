@@ -0,0 +1,99 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+// These are internal
+#include "rrnx_schema.h"
+
+#include "rrnx/rrnx_basetypes_nav.h" // rrnx_navmsg
+
+#include <stddef.h> // offsetof
+
+// Shorthands for the tables
+#define NAVMSG(member) offsetof(rrnx_navmsg, member)
+#define INT                      RRNX_FIELD_INT
+#define DOUBLE                   RRNX_FIELD_DOUBLE
+#define ZERO                     RRNX_BLANK_ZERO
+#define REQUIRED                 RRNX_BLANK_ERROR
+
+/**
+ * Broadcast orbit fields (D19.12) begin at the column 3.
+ */
+#define BCO(n)                   (3 + (19 * (n))), 19
+
+static const rrnx_schema_field GPS_NAV_FIELDS[] = {
+	// PRN / EPOCH / SV CLK
+	{0, 0,  0, 2,  INT,    NAVMSG(sv_id),     ZERO},
+	{0, 0,  3, 2,  INT,    NAVMSG(toc.year),  ZERO},
+	{0, 0,  6, 2,  INT,    NAVMSG(toc.month), ZERO},
+	{0, 0,  9, 2,  INT,    NAVMSG(toc.day),   ZERO},
+	{0, 0, 12, 2,  INT,    NAVMSG(toc.hour),  ZERO},
+	{0, 0, 15, 2,  INT,    NAVMSG(toc.min),   ZERO},
+	{0, 0, 17, 5,  DOUBLE, NAVMSG(toc.sec),   ZERO},
+	{0, 2, BCO(1), DOUBLE, NAVMSG(af0),       REQUIRED},
+	{0, 3, BCO(2), DOUBLE, NAVMSG(af1),       REQUIRED},
+	{0, 4, BCO(3), DOUBLE, NAVMSG(af2),       NAVMSG(valid_af2)},
+
+	// BROADCAST ORBIT - 1
+	{1, 1, BCO(0), DOUBLE, NAVMSG(IODE),      REQUIRED},
+	{1, 2, BCO(1), DOUBLE, NAVMSG(Crs),       REQUIRED},
+	{1, 3, BCO(2), DOUBLE, NAVMSG(delta_n),   REQUIRED},
+	{1, 4, BCO(3), DOUBLE, NAVMSG(M0),        REQUIRED},
+
+	// BROADCAST ORBIT - 2
+	{2, 1, BCO(0), DOUBLE, NAVMSG(Cuc),       REQUIRED},
+	{2, 2, BCO(1), DOUBLE, NAVMSG(e),         REQUIRED},
+	{2, 3, BCO(2), DOUBLE, NAVMSG(Cus),       REQUIRED},
+	{2, 4, BCO(3), DOUBLE, NAVMSG(sqrtA),     REQUIRED},
+
+	// BROADCAST ORBIT - 3
+	{3, 1, BCO(0), DOUBLE, NAVMSG(toe),       REQUIRED},
+	{3, 2, BCO(1), DOUBLE, NAVMSG(Cic),       REQUIRED},
+	{3, 3, BCO(2), DOUBLE, NAVMSG(OMEGA0),    REQUIRED},
+	{3, 4, BCO(3), DOUBLE, NAVMSG(Cis),       REQUIRED},
+
+	// BROADCAST ORBIT - 4
+	{4, 1, BCO(0), DOUBLE, NAVMSG(i0),        REQUIRED},
+	{4, 2, BCO(1), DOUBLE, NAVMSG(Crc),       REQUIRED},
+	{4, 3, BCO(2), DOUBLE, NAVMSG(w),         REQUIRED},
+	{4, 4, BCO(3), DOUBLE, NAVMSG(OMEGADOT),  REQUIRED},
+
+	// BROADCAST ORBIT - 5
+	{5, 1, BCO(0), DOUBLE, NAVMSG(idot),      REQUIRED},
+	{5, 2, BCO(1), DOUBLE, NAVMSG(L2_codes),  REQUIRED},
+	{5, 3, BCO(2), DOUBLE, NAVMSG(toe_week),  REQUIRED},
+	{5, 4, BCO(3), DOUBLE, NAVMSG(L2P_dataflag), REQUIRED},
+
+	// BROADCAST ORBIT - 6
+	{6, 1, BCO(0), DOUBLE, NAVMSG(accuracy),  REQUIRED},
+	{6, 2, BCO(1), DOUBLE, NAVMSG(health),    REQUIRED},
+	{6, 3, BCO(2), DOUBLE, NAVMSG(Tgd),       REQUIRED},
+	{6, 4, BCO(3), DOUBLE, NAVMSG(IODC),      REQUIRED},
+
+	// BROADCAST ORBIT - 7
+	{7, 1, BCO(0), DOUBLE, NAVMSG(tow),       REQUIRED},
+	{7, 2, BCO(1), DOUBLE, NAVMSG(fit_interval),
+	    NAVMSG(valid_fit_interval)},
+	{7, 3, BCO(2), DOUBLE, NAVMSG(spare1),    NAVMSG(valid_spare1)},
+	{7, 4, BCO(3), DOUBLE, NAVMSG(spare2),    NAVMSG(valid_spare2)},
+};
+
+const rrnx_schema rrnx_schema_gps_nav = {
+	"broadcast orbit",
+	8,
+	GPS_NAV_FIELDS,
+	sizeof(GPS_NAV_FIELDS) / sizeof(GPS_NAV_FIELDS[0])
+};
@@ -0,0 +1,92 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#ifndef RRNX_SCHEMA_H
+#define RRNX_SCHEMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Field types
+#define RRNX_FIELD_INT           1
+#define RRNX_FIELD_DOUBLE        2
+
+// Blank field handling, when the field has no validity flag
+#define RRNX_BLANK_ZERO          -1
+#define RRNX_BLANK_ERROR         -2
+
+/**
+ * Layout of a single fixed-width field within a record.
+ */
+struct rrnx_schema_field {
+	/** Line within the record, starting from 0. */
+	unsigned char line;
+
+	/** Field number on the line, starting from 1 (for messages). */
+	unsigned char fieldnum;
+
+	/** Column of the first char, starting from 0. */
+	unsigned short column;
+
+	/** Width of the field (chars). */
+	unsigned short width;
+
+	/** Field type, RRNX_FIELD_xxx. */
+	unsigned short type;
+
+	/** Offset of the destination member within the record. */
+	int offset;
+
+	/**
+	 * Offset of the int member which tells whether the field
+	 * is non-blank, or RRNX_BLANK_xxx.
+	 */
+	int valid_offset;
+};
+
+typedef struct rrnx_schema_field rrnx_schema_field;
+
+/**
+ * Layout of a multi-line data record.
+ */
+struct rrnx_schema {
+	/** Name of the lines, used in the error messages. */
+	const char *linename;
+
+	/** Number of lines in a record. */
+	int num_lines;
+
+	/** Fields ordered by the line and the column. */
+	const rrnx_schema_field *fields;
+
+	/** Number of fields. */
+	int num_fields;
+};
+
+typedef struct rrnx_schema rrnx_schema;
+
+/**
+ * GPS navigation message record of RINEX 2, parsed into rrnx_navmsg.
+ */
+extern const rrnx_schema rrnx_schema_gps_nav;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
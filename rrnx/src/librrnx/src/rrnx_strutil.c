@@ -17,7 +17,7 @@
 
 #include "rrnx_strutil.h"
 
-#include <string.h> // strlen()
+#include <string.h> // strlen(), memcpy()
 #include <ctype.h> // isdigit()
 
 int rrnx_substr(
@@ -79,42 +79,92 @@ int rrnx_substr_trimmed(
 	int offset,
 	int len
 ) {
-	// Determine the line length
-	int linelen = strlen(line);
+	return rrnx_substr_trimmed_n(
+	    buffer, line, strlen(line), offset, len);
+}
+
+int rrnx_substr_trimmed2_n(
+    char *dest,
+    const char *src,
+    int srclen,
+    int offset,
+    int len
+) {
+	int i = 0;
+
+	// If the source is too short, the destination
+	// will be made an empty string.
+	if (offset < srclen) {
+		// Clip the length to the source
+		if (len > srclen - offset) {
+			len = srclen - offset;
+		}
+		// Copy
+		memcpy(dest, src+offset, len);
+		i = len;
+	}
 
+	// Trim trailing whitespaces
+	while ((i > 0) && (dest[i-1] == ' ')) {
+		i--;
+	}
+
+	// Terminate string
+	dest[i] = '\0';
+
+	return i;
+}
+
+int rrnx_substr_trimmed_n(
+	char *buffer,
+	const char *line,
+	int linelen,
+	int offset,
+	int len
+) {
+	const char *field;
+	len = rrnx_field_span(&field, line, linelen, offset, len);
+
+	// Copy and terminate string
+	memcpy(buffer, field, len);
+	buffer[len] = '\0';
+
+	return len;
+}
+
+int rrnx_field_span(
+	const char **field,
+	const char *line,
+	int linelen,
+	int offset,
+	int len
+) {
 	// Line too short?
 	if (linelen < offset) {
-		buffer[0] = '\0';
+		*field = line;
 		return 0;
 	}
 
-	// Otherwise trim leading spaces before substr
+	// Clip the length to the line
+	if (len > linelen - offset) {
+		len = linelen - offset;
+	}
+
 	const char *cptr = line+offset;
 
+	// Trim leading spaces
 	while ((len > 0) && (*cptr == ' ')) {
 		len--;
 		cptr++;
 	}
 
-	// Copy as much as possible.
-	// Halt when the length is consumed or the string terminated
-	int i = 0;
-	while ((len > 0) && (*cptr != '\0')) {
-		buffer[i] = *cptr;
-		i++;
-		cptr++;
+	// Trim trailing spaces
+	while ((len > 0) && (cptr[len-1] == ' ')) {
 		len--;
 	}
 
-	// Trim trailing whitespaces
-	while ((i > 0) && (buffer[i-1] == ' ')) {
-		i--;
-	}
-
-	// Terminate string
-	buffer[i] = '\0';
-
-	return i;
+	*field = cptr;
+	return len;
 }
 
 void rrnx_replace_fortran_exponent(char *s) {
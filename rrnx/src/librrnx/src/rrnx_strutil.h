@@ -45,6 +45,44 @@ int rrnx_substr_trimmed(
         int len
 );
 
+/**
+ * Same as rrnx_substr_trimmed2(), but the source is a span
+ * of srclen chars which need not to be terminated.
+ */
+int rrnx_substr_trimmed2_n(
+    char *dest,
+    const char *src,
+    int srclen,
+    int offset,
+    int len
+);
+
+/**
+ * Same as rrnx_substr_trimmed(), but the line is a span
+ * of linelen chars which need not to be terminated.
+ */
+int rrnx_substr_trimmed_n(
+        char *buffer,
+        const char *line,
+        int linelen,
+        int offset,
+        int len
+);
+
+/**
+ * Locates a fixed-width field within a span of linelen chars,
+ * and trims the blanks around it. Stores the start of the field
+ * into "field", and returns the length of the trimmed field.
+ * Nothing is copied.
+ */
+int rrnx_field_span(
+        const char **field,
+        const char *line,
+        int linelen,
+        int offset,
+        int len
+);
+
 void rrnx_replace_fortran_exponent(char *s);
 
 
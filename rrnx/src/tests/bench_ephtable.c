@@ -0,0 +1,314 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h> // clock
+
+#include "rrnx/rrnx.h"
+#include "rrnx/rrnx_ephtable.h"
+
+/**
+ * Deterministic pseudo-random numbers (xorshift64).
+ */
+static unsigned long long rand_state = 88172645463325252ULL;
+
+static double rand_uniform(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (double)(rand_state >> 11) / 9007199254740992.0;
+}
+
+/**
+ * A lookup: satellite and time.
+ */
+struct query {
+	int sv_id;
+	int week;
+	double tow;
+};
+
+/**
+ * The nearest navmsg by scanning the whole list,
+ * as the propagation loops have done.
+ */
+static const rrnx_navmsg *scan_nearest(
+    const rrnx_list *list,
+    const struct query *q
+) {
+	const rrnx_navmsg *best = NULL;
+	double best_dt = 0.0;
+	double t = (q->week * RRNX_ET_SECONDS_IN_WEEK) + q->tow;
+
+	const rrnx_list_item *iter = list->first;
+	for (; iter != NULL; iter = iter->next) {
+		const rrnx_navmsg *navmsg = iter->data;
+		if (navmsg->sv_id != q->sv_id) {
+			continue;
+		}
+		double toe = (navmsg->toe_week * RRNX_ET_SECONDS_IN_WEEK)
+		    + navmsg->toe;
+		double dt = (toe > t) ? toe - t : t - toe;
+		// Ties go to the earlier
+		if ((best == NULL) || (dt < best_dt)
+		    || ((dt == best_dt) && (toe < t)))
+		{
+			best = navmsg;
+			best_dt = dt;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * The best navmsg by scanning the whole list: healthy, within the fit
+ * interval, nearest toe, and the latest transmission of the same toe.
+ */
+static const rrnx_navmsg *scan_best(
+    const rrnx_list *list,
+    int sv_id,
+    double t
+) {
+	const rrnx_navmsg *best = NULL;
+	double best_dt = 0.0;
+	double best_toe = 0.0;
+
+	const rrnx_list_item *iter = list->first;
+	for (; iter != NULL; iter = iter->next) {
+		const rrnx_navmsg *navmsg = iter->data;
+		if ((navmsg->sv_id != sv_id) || (navmsg->health != 0.0)) {
+			continue;
+		}
+		double fit = RRNX_ET_DEFAULT_FIT_INTERVAL;
+		if (navmsg->valid_fit_interval && (navmsg->fit_interval > 0.0)) {
+			fit = navmsg->fit_interval;
+		}
+		double toe = (navmsg->toe_week * RRNX_ET_SECONDS_IN_WEEK)
+		    + navmsg->toe;
+		double dt = (toe > t) ? toe - t : t - toe;
+		if (dt > fit * 1800.0) {
+			continue;
+		}
+		int better = (best == NULL) || (dt < best_dt)
+		    || ((dt == best_dt) && (toe < best_toe))
+		    || ((toe == best_toe) && (navmsg->tow >= best->tow));
+		if (better) {
+			best = navmsg;
+			best_dt = dt;
+			best_toe = toe;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Queries the best navmsgs of all satellites at every epoch from t0
+ * to t1 with a cursor, and compares them to a scan of the list.
+ * Returns the number of mismatches.
+ */
+static int bench_cursor(
+    const rrnx_file_nav *nav,
+    const rrnx_ephtable *table,
+    double t0,
+    double t1,
+    double interval
+) {
+	long epochs = 0;
+	long found = 0;
+	double secs_scan = 0.0;
+	double secs_cursor = 0.0;
+	int mismatches = 0;
+
+	rrnx_et_cursor cursor;
+	rrnx_et_cursor_init(&cursor, table);
+
+	for (double t = t0; t <= t1; t += interval) {
+		int week = (int) (t / RRNX_ET_SECONDS_IN_WEEK);
+		double tow = t - (week * RRNX_ET_SECONDS_IN_WEEK);
+		const rrnx_navmsg *expected[32];
+		long actual[32];
+
+		clock_t start = clock();
+		for (int sv = 1; sv <= 32; sv++) {
+			expected[sv-1] = scan_best(nav->navmsg_list, sv, t);
+		}
+		secs_scan += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		start = clock();
+		for (int sv = 1; sv <= 32; sv++) {
+			actual[sv-1] = rrnx_et_cursor_find(&cursor, sv, week, tow);
+		}
+		secs_cursor += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		for (int i = 0; i < 32; i++) {
+			const rrnx_navmsg *a = expected[i];
+			const rrnx_navmsg *b = (actual[i] >= 0)
+			    ? &table->navmsgs[actual[i]] : NULL;
+			int same = ((a == NULL) && (b == NULL))
+			    || ((a != NULL) && (b != NULL)
+			    && (a->toe_week == b->toe_week) && (a->toe == b->toe)
+			    && (a->tow == b->tow) && (a->IODE == b->IODE));
+			if (!same) {
+				if (mismatches < 10) {
+					printf("Mismatch: PRN %d, week %d, tow %.3f\n",
+					    i+1, week, tow);
+				}
+				mismatches++;
+			}
+			found += (b != NULL);
+		}
+		epochs++;
+	}
+
+	double total = (double) epochs * 32;
+	printf("\n");
+	printf("Epochs:              %ld x 32 satellites, %.0f s apart\n",
+	    epochs, interval);
+	printf("Found:               %.1f %%\n", 100.0 * found / total);
+	printf("List scan:           %.1f ns/lookup\n", 1e9 * secs_scan / total);
+	printf("rrnx_et_cursor:      %.1f ns/lookup\n",
+	    1e9 * secs_cursor / total);
+	printf("Mismatches:          %d\n", mismatches);
+
+	return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    bench_ephtable <rinex_nav> [<lookups> [<interval>]]\n");
+		printf("\n");
+		printf("Looks up the nearest ephemerides of random satellites and\n");
+		printf("times by scanning the navmsg list, and from rrnx_ephtable.\n");
+		printf("Then looks up the best ephemerides of all satellites at\n");
+		printf("every epoch (default 30 s apart) with a cursor.\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *filename = argv[1];
+	int count = (argc > 2) ? atoi(argv[2]) : 100000;
+	double interval = (argc > 3) ? atof(argv[3]) : 30.0;
+	if ((count <= 0) || (interval <= 0.0)) {
+		printf("Error: invalid number of lookups or interval\n");
+		return EXIT_FAILURE;
+	}
+
+	rrnx_file_nav *nav = NULL;
+	int err = rrnx_read_navfile(filename, &nav);
+	if (err) {
+		printf("%s: unable to parse (rrnx error code %d)\n", filename, err);
+		return EXIT_FAILURE;
+	}
+
+	clock_t start = clock();
+	rrnx_ephtable *table = NULL;
+	err = rrnx_et_build(nav, &table);
+	double secs_build = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if (err) {
+		printf("rrnx_et_build: error code %d\n", err);
+		rrnx_free_navfile(nav);
+		return EXIT_FAILURE;
+	}
+
+	if (table->count == 0) {
+		printf("%s: no navigation messages\n", filename);
+		rrnx_et_free(table);
+		rrnx_free_navfile(nav);
+		return EXIT_FAILURE;
+	}
+
+	// The queries span the time of the file, with a margin.
+	double t0 = table->toe[0];
+	double t1 = table->toe[0];
+	for (size_t i = 0; i < table->count; i++) {
+		if (table->toe[i] < t0) t0 = table->toe[i];
+		if (table->toe[i] > t1) t1 = table->toe[i];
+	}
+	t0 -= 7200.0;
+	t1 += 7200.0;
+
+	struct query *queries = malloc(count * sizeof(struct query));
+	const rrnx_navmsg **expected = malloc(count * sizeof(rrnx_navmsg *));
+	long *actual = malloc(count * sizeof(long));
+	if ((queries == NULL) || (expected == NULL) || (actual == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	for (int i = 0; i < count; i++) {
+		double t = t0 + ((t1 - t0) * rand_uniform());
+		queries[i].sv_id = 1 + (int) (32.0 * rand_uniform());
+		queries[i].week = (int) (t / RRNX_ET_SECONDS_IN_WEEK);
+		queries[i].tow = t - (queries[i].week * RRNX_ET_SECONDS_IN_WEEK);
+	}
+
+	start = clock();
+	for (int i = 0; i < count; i++) {
+		expected[i] = scan_nearest(nav->navmsg_list, &queries[i]);
+	}
+	double secs_scan = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (int i = 0; i < count; i++) {
+		actual[i] = rrnx_et_find_nearest(table, queries[i].sv_id,
+		    queries[i].week, queries[i].tow);
+	}
+	double secs_table = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	// Messages with the same time are equally near;
+	// compare the satellite and the time only.
+	int mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		const rrnx_navmsg *a = expected[i];
+		const rrnx_navmsg *b = (actual[i] >= 0)
+		    ? &table->navmsgs[actual[i]] : NULL;
+		int same = ((a == NULL) && (b == NULL))
+		    || ((a != NULL) && (b != NULL)
+		    && (a->sv_id == b->sv_id)
+		    && (a->toe_week == b->toe_week)
+		    && (a->toe == b->toe));
+		if (!same) {
+			if (mismatches < 10) {
+				printf("Mismatch: PRN %d, week %d, tow %.3f\n",
+				    queries[i].sv_id, queries[i].week,
+				    queries[i].tow);
+			}
+			mismatches++;
+		}
+	}
+
+	printf("Navigation messages: %zu\n", table->count);
+	printf("Table build:         %.3f s\n", secs_build);
+	printf("List scan:           %.1f ns/lookup\n", 1e9 * secs_scan / count);
+	printf("rrnx_ephtable:       %.1f ns/lookup\n", 1e9 * secs_table / count);
+	printf("Mismatches:          %d\n", mismatches);
+
+	mismatches += bench_cursor(nav, table, t0, t1, interval);
+
+	free(queries);
+	free(expected);
+	free(actual);
+	rrnx_et_free(table);
+	rrnx_free_navfile(nav);
+
+	return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
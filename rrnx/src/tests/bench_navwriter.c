@@ -0,0 +1,302 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcmp
+#include <stdarg.h> // va_list
+#include <time.h> // clock
+
+#include "rrnx/rrnx.h"
+#include "rrnx/rrnx_ephstore.h" // rrnx_es_record
+
+/**
+ * Reference output buffer.
+ */
+struct refbuf {
+	char *data;
+	size_t len;
+	size_t size;
+};
+
+/**
+ * Appends a line formatted with snprintf(). The exponent markers
+ * are replaced with 'D', and the trailing blanks are trimmed.
+ */
+static void ref_line(struct refbuf *rb, const char *fmt, ...) {
+	char line[128];
+
+	va_list args;
+	va_start(args, fmt);
+	int len = vsnprintf(line, sizeof(line), fmt, args);
+	va_end(args);
+
+	for (int i = 1; i+1 < len; i++) {
+		if ((line[i] == 'E') && ((line[i+1] == '+') || (line[i+1] == '-'))
+		    && (line[i-1] >= '0') && (line[i-1] <= '9'))
+		{
+			line[i] = 'D';
+		}
+	}
+	while ((len > 0) && (line[len-1] == ' ')) {
+		len--;
+	}
+
+	if (rb->size - rb->len < (size_t) len + 1) {
+		rb->size = 2 * (rb->size + len + 1);
+		rb->data = realloc(rb->data, rb->size);
+		if (rb->data == NULL) {
+			printf("Out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memcpy(rb->data + rb->len, line, len);
+	rb->len += len;
+	rb->data[rb->len++] = '\n';
+}
+
+/**
+ * Formats a blank field, or D19.12, into the string s.
+ */
+static char *ref_field(char *s, int valid, double value) {
+	if (valid) {
+		sprintf(s, "%19.12E", value);
+	} else {
+		sprintf(s, "%19s", "");
+	}
+	return s;
+}
+
+/**
+ * The reference formatter, which uses snprintf() for everything.
+ * Labels are written in the same place with %-20s, which relies on
+ * the trimming; they are the last field on the line.
+ */
+static void ref_serialize(struct refbuf *rb, const rrnx_file_nav *nav) {
+	rb->len = 0;
+
+	const char *version = nav->format.version;
+	ref_line(rb, "%9s%11s%-20s%20s%-20s", version[0] ? version : "2.11",
+	    "", "N: GPS NAV DATA", "", "RINEX VERSION / TYPE");
+	ref_line(rb, "%-20s%-20s%-20s%-20s", nav->info.program,
+	    nav->info.agency, nav->info.date, "PGM / RUN BY / DATE");
+
+	const double *a = nav->iono.alpha;
+	const double *b = nav->iono.beta;
+	if (nav->has_iono_alpha) {
+		ref_line(rb, "  %12.4E%12.4E%12.4E%12.4E%10s%-20s",
+		    a[0], a[1], a[2], a[3], "", "ION ALPHA");
+	}
+	if (nav->has_iono_beta) {
+		ref_line(rb, "  %12.4E%12.4E%12.4E%12.4E%10s%-20s",
+		    b[0], b[1], b[2], b[3], "", "ION BETA");
+	}
+	if (nav->has_delta_utc) {
+		ref_line(rb, "   %19.12E%19.12E%9d%9d %-20s",
+		    nav->utc.a0, nav->utc.a1, nav->utc.tot, nav->utc.tot_week,
+		    "DELTA-UTC: A0,A1,T,W");
+	}
+	if (nav->has_leap_seconds) {
+		ref_line(rb, "%6d%54s%-20s", nav->utc.delta_ls, "",
+		    "LEAP SECONDS");
+	}
+	ref_line(rb, "%60s%-20s", "", "END OF HEADER");
+
+	const rrnx_list_item *iter = nav->navmsg_list->first;
+	for (; iter != NULL; iter = iter->next) {
+		const rrnx_navmsg *m = iter->data;
+		char f1[32], f2[32], f3[32], f4[32];
+		ref_line(rb, "%2d %02d %2d %2d %2d %2d%5.1f%19.12E%19.12E%s",
+		    m->sv_id, m->toc.year % 100, m->toc.month, m->toc.day,
+		    m->toc.hour, m->toc.min, m->toc.sec, m->af0, m->af1,
+		    ref_field(f1, m->valid_af2, m->af2));
+		ref_line(rb, "   %19.12E%19.12E%19.12E%19.12E",
+		    m->IODE, m->Crs, m->delta_n, m->M0);
+		ref_line(rb, "   %19.12E%19.12E%19.12E%19.12E",
+		    m->Cuc, m->e, m->Cus, m->sqrtA);
+		ref_line(rb, "   %19.12E%19.12E%19.12E%19.12E",
+		    m->toe, m->Cic, m->OMEGA0, m->Cis);
+		ref_line(rb, "   %19.12E%19.12E%19.12E%19.12E",
+		    m->i0, m->Crc, m->w, m->OMEGADOT);
+		ref_line(rb, "   %19.12E%19.12E%19.12E%19.12E",
+		    m->idot, m->L2_codes, m->toe_week, m->L2P_dataflag);
+		ref_line(rb, "   %19.12E%19.12E%19.12E%19.12E",
+		    m->accuracy, m->health, m->Tgd, m->IODC);
+		ref_line(rb, "   %19.12E%s%s%s",
+		    m->tow, ref_field(f2, m->valid_fit_interval, m->fit_interval),
+		    ref_field(f3, m->valid_spare1, m->spare1),
+		    ref_field(f4, m->valid_spare2, m->spare2));
+	}
+}
+
+/**
+ * Converts a navmsg into a record for comparison.
+ * The values of blank fields are undefined, so they are cleared.
+ */
+static void to_record(rrnx_es_record *record, const rrnx_navmsg *navmsg) {
+	rrnx_es_from_navmsg(record, navmsg);
+	if (!navmsg->valid_af2) record->af2 = 0.0;
+	if (!navmsg->valid_fit_interval) record->fit_interval = 0.0;
+	if (!navmsg->valid_spare1) record->spare1 = 0.0;
+	if (!navmsg->valid_spare2) record->spare2 = 0.0;
+}
+
+/**
+ * Compares the navmsgs of two files bit for bit.
+ * Returns the number of mismatches.
+ */
+static int compare(const rrnx_file_nav *nav1, const rrnx_file_nav *nav2) {
+	int mismatches = 0;
+
+	const rrnx_list_item *iter1 = nav1->navmsg_list->first;
+	const rrnx_list_item *iter2 = nav2->navmsg_list->first;
+	while ((iter1 != NULL) && (iter2 != NULL)) {
+		rrnx_es_record record1;
+		rrnx_es_record record2;
+		to_record(&record1, iter1->data);
+		to_record(&record2, iter2->data);
+		if (memcmp(&record1, &record2, sizeof(record1)) != 0) {
+			if (mismatches < 10) {
+				printf("Mismatch: PRN %d, toe %.0f\n",
+				    record1.sv_id, record1.toe);
+			}
+			mismatches++;
+		}
+		iter1 = iter1->next;
+		iter2 = iter2->next;
+	}
+	if ((iter1 != NULL) || (iter2 != NULL)) {
+		printf("Record count differs\n");
+		mismatches++;
+	}
+
+	const rrnx_utc *utc1 = &nav1->utc;
+	const rrnx_utc *utc2 = &nav2->utc;
+	if ((memcmp(&nav1->iono, &nav2->iono, sizeof(nav1->iono)) != 0)
+	    || (memcmp(&utc1->a0, &utc2->a0, sizeof(double)) != 0)
+	    || (memcmp(&utc1->a1, &utc2->a1, sizeof(double)) != 0)
+	    || (utc1->tot != utc2->tot) || (utc1->tot_week != utc2->tot_week)
+	    || (utc1->delta_ls != utc2->delta_ls))
+	{
+		printf("Header differs\n");
+		mismatches++;
+	}
+
+	return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    bench_navwriter <rinex_nav> <dest> [<rounds>]\n");
+		printf("\n");
+		printf("The NAV file is formatted into memory repeatedly with\n");
+		printf("rrnx_fnav_serialize() and with a snprintf() reference,\n");
+		printf("and the outputs are compared. Then it is written into\n");
+		printf("dest, which is read back and compared with the original.\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *filename = argv[1];
+	const char *dest = argv[2];
+	int rounds = 10;
+	if (argc > 3) {
+		rounds = atoi(argv[3]);
+	}
+
+	rrnx_file_nav *nav = NULL;
+	int err = rrnx_read_navfile(filename, &nav);
+	if (err) {
+		printf("%s: unable to parse (rrnx error code %d)\n", filename, err);
+		return EXIT_FAILURE;
+	}
+
+	int records = 0;
+	const rrnx_list_item *iter = nav->navmsg_list->first;
+	for (; iter != NULL; iter = iter->next) {
+		records++;
+	}
+
+	// The same string is reused in every round.
+	rrnx_string *text = rrnx_str_alloc();
+	size_t len = 0;
+	clock_t start = clock();
+	for (int round = 0; (round < rounds) && (err == RRNX_E_OK); round++) {
+		err = rrnx_fnav_serialize(nav, text, &len);
+	}
+	double secs_serialize = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if (err) {
+		printf("rrnx_fnav_serialize: rrnx error code %d\n", err);
+		return EXIT_FAILURE;
+	}
+
+	struct refbuf rb = {NULL, 0, 0};
+	start = clock();
+	for (int round = 0; round < rounds; round++) {
+		ref_serialize(&rb, nav);
+	}
+	double secs_reference = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	int mismatches = 0;
+	if ((len != rb.len) || (memcmp(text->text, rb.data, len) != 0)) {
+		size_t i = 0;
+		while ((i < len) && (i < rb.len) && (text->text[i] == rb.data[i])) {
+			i++;
+		}
+		printf("Output differs from the reference at offset %zu\n", i);
+		mismatches++;
+	}
+
+	// Round trip
+	err = rrnx_fnav_write(nav, dest);
+	if (err) {
+		if (err == RRNX_E_SYSCALL) {
+			perror(dest);
+		} else {
+			printf("%s: unable to write (rrnx error code %d)\n", dest, err);
+		}
+		return EXIT_FAILURE;
+	}
+
+	rrnx_file_nav *nav2 = NULL;
+	err = rrnx_read_navfile(dest, &nav2);
+	if (err) {
+		printf("%s: unable to parse (rrnx error code %d)\n", dest, err);
+		return EXIT_FAILURE;
+	}
+	mismatches += compare(nav, nav2);
+
+	double total = (double) rounds * len;
+	printf("Records:           %d\n", records);
+	printf("Output:            %zu bytes x %d rounds\n", len, rounds);
+	printf("rrnx_fnav_serialize: %.1f MB/s, %.0f records/s\n",
+	    total / 1e6 / secs_serialize,
+	    (double) rounds * records / secs_serialize);
+	printf("snprintf reference:  %.1f MB/s, %.0f records/s\n",
+	    total / 1e6 / secs_reference,
+	    (double) rounds * records / secs_reference);
+	printf("Mismatches:        %d\n", mismatches);
+
+	rrnx_free_navfile(nav2);
+	rrnx_free_navfile(nav);
+	rrnx_str_free(text);
+	free(rb.data);
+
+	return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,263 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <time.h> // clock
+
+#include "rrnx/rrnx_numconv.h"
+
+// Width of a D19.12 field
+#define FIELD_WIDTH 19
+
+/**
+ * Deterministic pseudo-random numbers (xorshift64).
+ */
+static unsigned long long rand_state = 88172645463325252ULL;
+
+static double rand_uniform(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (double)(rand_state >> 11) / 9007199254740992.0;
+}
+
+/**
+ * Generates D19.12 fields with magnitudes typical to
+ * broadcast ephemerides (from 1e-20 to 1e+8).
+ */
+static char *generate_fields(int count) {
+	char *fields = malloc((size_t) count * (FIELD_WIDTH+1));
+	if (fields == NULL) {
+		return NULL;
+	}
+
+	for (int i = 0; i < count; i++) {
+		char *field = &fields[i * (FIELD_WIDTH+1)];
+
+		double mantissa = (rand_uniform() * 2.0) - 1.0;
+		int exponent = (int)(rand_uniform() * 29.0) - 20;
+		double value = mantissa;
+		for (int j = 0; j < exponent; j++) value *= 10.0;
+		for (int j = 0; j > exponent; j--) value /= 10.0;
+
+		// Every 16th field is a zero, which are frequent in practice.
+		if ((i % 16) == 0) {
+			value = 0.0;
+		}
+
+		snprintf(field, FIELD_WIDTH+1, "%19.12E", value);
+
+		// Use the Fortran exponent marker
+		char *e = strchr(field, 'E');
+		if (e != NULL) {
+			*e = 'D';
+		}
+	}
+
+	return fields;
+}
+
+/**
+ * The conversion path used by the navreader before rrnx_numconv:
+ * trimmed copy, exponent replacement, and strtod with errno.
+ */
+static int convert_reference(const char *field, double *result) {
+	char workbuf[FIELD_WIDTH+1];
+
+	// Trimmed copy
+	const char *s = field;
+	while (*s == ' ') s++;
+	int len = strlen(s);
+	while ((len > 0) && (s[len-1] == ' ')) len--;
+	memmove(workbuf, s, len);
+	workbuf[len] = '\0';
+
+	// Replace the fortran exponent
+	int i = len;
+	while ((i > 0) && (isdigit(workbuf[i-1]))) i--;
+	if ((i > 0) && ((workbuf[i-1] == '+') || (workbuf[i-1] == '-'))) i--;
+	if ((i > 0) && ((workbuf[i-1] == 'd') || (workbuf[i-1] == 'D'))) {
+		workbuf[i-1] = 'e';
+	}
+
+	errno = 0;
+	char *endptr;
+	*result = strtod(workbuf, &endptr);
+	return (*endptr == '\0') && (errno == 0);
+}
+
+/**
+ * The conversion path used by the navreader now: the field is
+ * located within the line, and converted without copies.
+ * The reference path is the fallback.
+ */
+static int convert_numconv(const char *field, double *result, int *fast) {
+	const char *s = field;
+	int len = FIELD_WIDTH;
+	while ((len > 0) && (*s == ' ')) {
+		s++;
+		len--;
+	}
+	while ((len > 0) && (s[len-1] == ' ')) {
+		len--;
+	}
+
+	if (rrnx_num_parse_fortran(s, len, result)) {
+		(*fast)++;
+		return 1;
+	}
+
+	return convert_reference(field, result);
+}
+
+/**
+ * Formats the values with rrnx_num_format_shortest() and with "%.17g",
+ * and verifies that the former converts back to the same double.
+ * Returns the number of mismatches.
+ */
+static int bench_format(const double *values, int count, int rounds) {
+	char buf[RRNX_NUM_SHORTEST_MAX+1];
+	clock_t start;
+	size_t chars_shortest = 0;
+	size_t chars_printf = 0;
+
+	start = clock();
+	for (int round = 0; round < rounds; round++) {
+		for (int i = 0; i < count; i++) {
+			chars_printf += snprintf(buf, sizeof(buf), "%.17g", values[i]);
+		}
+	}
+	double secs_printf = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (int round = 0; round < rounds; round++) {
+		for (int i = 0; i < count; i++) {
+			chars_shortest += rrnx_num_format_shortest(buf, values[i]);
+		}
+	}
+	double secs_shortest = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	int mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		int len = rrnx_num_format_shortest(buf, values[i]);
+		buf[len] = '\0';
+		double value = strtod(buf, NULL);
+		if (memcmp(&value, &values[i], sizeof(double)) != 0) {
+			if (mismatches < 10) {
+				printf("Mismatch: %a: \"%s\"\n", values[i], buf);
+			}
+			mismatches++;
+		}
+	}
+
+	double total = (double) count * rounds;
+	printf("\n");
+	printf("%%.17g:             %.1f ns/number, %.1f chars\n",
+	    1e9 * secs_printf / total, chars_printf / total);
+	printf("Shortest:          %.1f ns/number, %.1f chars\n",
+	    1e9 * secs_shortest / total, chars_shortest / total);
+	printf("Round-trip errors: %d\n", mismatches);
+
+	return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+	int count = 1000000;
+	int rounds = 5;
+
+	if (argc > 1) {
+		count = atoi(argv[1]);
+	}
+	if (argc > 2) {
+		rounds = atoi(argv[2]);
+	}
+	if ((count <= 0) || (rounds <= 0)) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    bench_numconv [<fields> [<rounds>]]\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	char *fields = generate_fields(count);
+	double *expected = malloc(count * sizeof(double));
+	double *actual = malloc(count * sizeof(double));
+	if ((fields == NULL) || (expected == NULL) || (actual == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	clock_t start;
+	double secs_reference = 0.0;
+	double secs_numconv = 0.0;
+	int fast = 0;
+
+	for (int round = 0; round < rounds; round++) {
+		start = clock();
+		for (int i = 0; i < count; i++) {
+			convert_reference(
+			    &fields[i * (FIELD_WIDTH+1)], &expected[i]);
+		}
+		secs_reference += (double)(clock() - start) / CLOCKS_PER_SEC;
+
+		fast = 0;
+		start = clock();
+		for (int i = 0; i < count; i++) {
+			convert_numconv(
+			    &fields[i * (FIELD_WIDTH+1)], &actual[i], &fast);
+		}
+		secs_numconv += (double)(clock() - start) / CLOCKS_PER_SEC;
+	}
+
+	// Verify bit-for-bit equality
+	int mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		if (memcmp(&expected[i], &actual[i], sizeof(double)) != 0) {
+			if (mismatches < 10) {
+				printf("Mismatch: \"%s\": %a != %a\n",
+				    &fields[i * (FIELD_WIDTH+1)],
+				    expected[i], actual[i]);
+			}
+			mismatches++;
+		}
+	}
+
+	double total = (double) count * rounds;
+	printf("Fields:            %d x %d rounds\n", count, rounds);
+	printf("Fast path:         %.1f %%\n", 100.0 * fast / count);
+	printf("strtod path:       %.1f ns/field\n",
+	    1e9 * secs_reference / total);
+	printf("rrnx_numconv path: %.1f ns/field\n",
+	    1e9 * secs_numconv / total);
+	if (secs_numconv > 0.0) {
+		printf("Speed-up:          %.2fx\n",
+		    secs_reference / secs_numconv);
+	}
+	printf("Mismatches:        %d\n", mismatches);
+
+	mismatches += bench_format(expected, count, rounds);
+
+	free(fields);
+	free(expected);
+	free(actual);
+
+	return (mismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,431 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h> // clock
+
+#include "rrnx/rrnx_obsreader.h"
+#include "rrnx/rrnx_obswriter.h"
+
+// Satellites per epoch
+#define NUM_SATS 12
+
+// Observation types
+#define NUM_TYPES 6
+static const char *TYPE_CODES[NUM_TYPES] = {
+	"C1", "L1", "D1", "S1", "P2", "L2"
+};
+
+/**
+ * Deterministic pseudo-random numbers (xorshift64).
+ */
+static unsigned long long rand_state = 88172645463325252ULL;
+
+static double rand_uniform(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (double)(rand_state >> 11) / 9007199254740992.0;
+}
+
+static void init_header(rrnx_obs_header *header) {
+	rrnx_fobs_init_header(header);
+	strcpy(header->format.version, "2.11");
+	header->format.type = 'O';
+	header->format.system = 'G';
+	strcpy(header->info.program, "bench_obswriter");
+	strcpy(header->marker_name, "SIM");
+	header->has_interval = 1;
+	header->interval.interval = 0.02;
+
+	rrnx_fobs_resize_layout(header, NUM_TYPES);
+	for (int t = 0; t < NUM_TYPES; t++) {
+		rrnx_fobs_code2type(&header->layout.item[t], 'G', TYPE_CODES[t]);
+	}
+}
+
+/**
+ * Allocates a block with the same layout as the obsreader's.
+ */
+static int init_block(rrnx_obs_block *block) {
+	size_t slots = NUM_TYPES * NUM_SATS;
+	memset(block, 0, sizeof(rrnx_obs_block));
+	block->value = malloc(slots * sizeof(double));
+	block->valid = malloc(slots);
+	block->lli = malloc(slots);
+	block->ssi = malloc(slots);
+	block->epoch.sat = malloc(NUM_SATS * sizeof(rrnx_satellite_id));
+	block->num_types = NUM_TYPES;
+	block->num_sats = NUM_SATS;
+	block->capacity = NUM_SATS;
+	return (block->value != NULL) && (block->valid != NULL)
+	    && (block->lli != NULL) && (block->ssi != NULL)
+	    && (block->epoch.sat != NULL);
+}
+
+static void free_block(rrnx_obs_block *block) {
+	free(block->value);
+	free(block->valid);
+	free(block->lli);
+	free(block->ssi);
+	free(block->epoch.sat);
+}
+
+/**
+ * Fills the block with the simulated measurements of epoch n at 50 Hz.
+ */
+static void simulate_epoch(rrnx_obs_block *block, long n) {
+	rrnx_meas_epoch *epoch = &block->epoch;
+	double t = n * 0.02;
+	long days = (long) (t / 86400.0);
+	double sod = t - (days * 86400.0);
+	epoch->t.year = 14;
+	epoch->t.month = 2;
+	epoch->t.day = 1 + (int) days;
+	epoch->t.hour = (int) (sod / 3600.0);
+	epoch->t.min = (int) ((sod - (epoch->t.hour * 3600.0)) / 60.0);
+	epoch->t.sec = sod - (epoch->t.hour * 3600.0) - (epoch->t.min * 60.0);
+	epoch->event = 0;
+	epoch->size = NUM_SATS;
+	epoch->clock_offset = ((n % 2) == 0) ? 1e-4 * rand_uniform() : 0.0/0.0;
+
+	for (int i = 0; i < NUM_SATS; i++) {
+		epoch->sat[i].system = 'G';
+		epoch->sat[i].id = 1 + ((i * 3 + n / 1000) % 32);
+	}
+
+	for (int t = 0; t < NUM_TYPES; t++) {
+		for (int i = 0; i < NUM_SATS; i++) {
+			size_t slot = (t * block->capacity) + i;
+			double r = rand_uniform();
+			double value;
+			switch (TYPE_CODES[t][0]) {
+			case 'L': value = (r - 0.5) * 2e8; break;
+			case 'D': value = (r - 0.5) * 1e4; break;
+			case 'S': value = 20.0 + (r * 35.0); break;
+			default: value = 2e7 + (r * 6e6); break;
+			}
+			block->value[slot] = value;
+			block->valid[slot] = (rand_uniform() > 0.02);
+			block->lli[slot] = (rand_uniform() > 0.9)
+			    ? (signed char) (rand_uniform() * 8)
+			    : RRNX_OBSR_FLAG_BLANK;
+			block->ssi[slot] = (signed char) (1 + rand_uniform() * 9);
+		}
+	}
+}
+
+//--- reference writer -----------------------------------------------------//
+
+static void append_line(char **text, size_t *len, char *line) {
+	int n = strlen(line);
+	while ((n > 0) && (line[n-1] == ' ')) n--;
+	line[n++] = '\n';
+	memcpy(*text + *len, line, n);
+	*len += n;
+}
+
+static char flag_char(int flag) {
+	return (flag == RRNX_OBSR_FLAG_BLANK) ? ' ' : (char) ('0' + flag);
+}
+
+/**
+ * Formats the data records with snprintf().
+ */
+static void format_reference(char **text, size_t *len,
+    const rrnx_obs_block *block)
+{
+	const rrnx_meas_epoch *epoch = &block->epoch;
+	char line[128];
+	int at = snprintf(line, sizeof(line), " %02d %2d %2d %2d %2d%11.7f  %1u%3u",
+	    epoch->t.year % 100, epoch->t.month, epoch->t.day,
+	    epoch->t.hour, epoch->t.min, epoch->t.sec,
+	    epoch->event, block->num_sats);
+	for (unsigned int i = 0; i < block->num_sats; i++) {
+		at += snprintf(line + at, sizeof(line) - at, "%c%02d",
+		    epoch->sat[i].system, epoch->sat[i].id);
+	}
+	if (epoch->clock_offset == epoch->clock_offset) {
+		snprintf(line + at, sizeof(line) - at, "%*s%12.9f",
+		    68 - at, "", epoch->clock_offset);
+	}
+	append_line(text, len, line);
+
+	for (unsigned int i = 0; i < block->num_sats; i++) {
+		at = 0;
+		for (unsigned int t = 0; t < block->num_types; t++) {
+			size_t slot = (t * block->capacity) + i;
+			if (block->valid[slot]) {
+				at += snprintf(line + at, sizeof(line) - at, "%14.3f",
+				    block->value[slot]);
+			} else {
+				at += snprintf(line + at, sizeof(line) - at, "%14s", "");
+			}
+			line[at++] = flag_char(block->lli[slot]);
+			line[at++] = flag_char(block->ssi[slot]);
+			line[at] = '\0';
+			if (((t % 5) == 4) || (t+1 == block->num_types)) {
+				append_line(text, len, line);
+				at = 0;
+			}
+		}
+	}
+}
+
+//--- verification ---------------------------------------------------------//
+
+static char *read_file(const char *filename, size_t *size) {
+	*size = 0;
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL) return NULL;
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	char *data = malloc(*size + 1);
+	if ((data != NULL) && (fread(data, 1, *size, fp) != *size)) {
+		free(data);
+		data = NULL;
+	}
+	fclose(fp);
+	return data;
+}
+
+/**
+ * Reads the file back, and compares the epochs against
+ * the simulation rounded to three decimals.
+ * Returns the number of mismatches.
+ */
+static long verify_roundtrip(const char *filename, long epochs,
+    rrnx_obs_block *expected)
+{
+	rrnx_obsreader *obsreader = rrnx_obsr_alloc();
+	if (obsreader == NULL) return 1;
+	rrnx_obsr_set_mmap(obsreader, 1);
+
+	long mismatches = 0;
+	long n = 0;
+
+	if (rrnx_obsr_open(obsreader, filename) == RRNX_E_OK) {
+		const rrnx_obs_block *block;
+		while (rrnx_obsr_next(obsreader, &block)) {
+			simulate_epoch(expected, n++);
+			if (block->num_sats != expected->num_sats) {
+				mismatches++;
+				continue;
+			}
+			for (unsigned int t = 0; t < NUM_TYPES; t++) {
+				for (unsigned int i = 0; i < NUM_SATS; i++) {
+					size_t es = (t * expected->capacity) + i;
+					size_t bs = (t * block->capacity) + i;
+					char text[32];
+					snprintf(text, sizeof(text), "%.3f",
+					    expected->value[es]);
+					double value = expected->valid[es]
+					    ? strtod(text, NULL) : 0.0;
+					if ((block->value[bs] != value)
+					    || (!block->valid[bs] != !expected->valid[es])
+					    || (block->lli[bs] != expected->lli[es])
+					    || (block->ssi[bs] != expected->ssi[es]))
+					{
+						mismatches++;
+					}
+				}
+			}
+		}
+	}
+
+	if (rrnx_obsr_errno(obsreader)) {
+		printf("%s\n", rrnx_obsr_strerror(obsreader));
+		mismatches++;
+	}
+	if (n != epochs) {
+		printf("Epochs read back: %ld != %ld\n", n, epochs);
+		mismatches++;
+	}
+
+	rrnx_obsr_close(obsreader);
+	rrnx_obsr_free(obsreader);
+
+	return mismatches;
+}
+
+//--- copy mode ------------------------------------------------------------//
+
+static int copy_file(const char *src, const char *dest) {
+	rrnx_obsreader *obsreader = rrnx_obsr_alloc();
+	rrnx_obswriter *obswriter = rrnx_obsw_alloc();
+	if ((obsreader == NULL) || (obswriter == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+	rrnx_obsr_set_mmap(obsreader, 1);
+
+	int err = 0;
+	do {
+		if (rrnx_obsr_open(obsreader, src)) {
+			printf("%s\n", rrnx_obsr_strerror(obsreader));
+			err = 1;
+			break;
+		}
+		if (rrnx_obsw_open(obswriter, dest)
+		    || rrnx_obsw_write_header(obswriter, &obsreader->header))
+		{
+			printf("%s\n", rrnx_obsw_strerror(obswriter));
+			err = 1;
+			break;
+		}
+
+		const rrnx_obs_block *block;
+		while (rrnx_obsr_next(obsreader, &block)) {
+			if (rrnx_obsw_write_epoch(obswriter, block)) {
+				break;
+			}
+		}
+
+		if (rrnx_obsr_errno(obsreader)) {
+			printf("%s\n", rrnx_obsr_strerror(obsreader));
+			err = 1;
+		}
+		if (rrnx_obsw_close(obswriter)) {
+			printf("%s\n", rrnx_obsw_strerror(obswriter));
+			err = 1;
+		}
+	} while(0);
+
+	rrnx_obsr_close(obsreader);
+	rrnx_obsr_free(obsreader);
+	rrnx_obsw_free(obswriter);
+
+	return err ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//--- main -----------------------------------------------------------------//
+
+int main(int argc, char *argv[]) {
+	if ((argc == 4) && (strcmp(argv[1], "-copy") == 0)) {
+		return copy_file(argv[2], argv[3]);
+	}
+
+	if (argc != 3) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    bench_obswriter <epochs> <dest_file>\n");
+		printf("    bench_obswriter -copy <rinex_obs> <dest_file>\n");
+		printf("\n");
+		printf("Writes simulated 50 Hz observations of %d satellites,\n",
+		    NUM_SATS);
+		printf("compares them to snprintf(), and reads them back.\n");
+		printf("The second form rewrites an observation file.\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	long epochs = atol(argv[1]);
+	const char *filename = argv[2];
+
+	rrnx_obs_header header;
+	rrnx_obs_block block;
+	init_header(&header);
+	rrnx_obswriter *obswriter = rrnx_obsw_alloc();
+	if ((!init_block(&block)) || (obswriter == NULL)) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	// The library writer
+	unsigned long long seed = rand_state;
+	clock_t start = clock();
+
+	if (rrnx_obsw_open(obswriter, filename) == RRNX_E_OK) {
+		rrnx_obsw_write_header(obswriter, &header);
+		for (long n = 0; n < epochs; n++) {
+			simulate_epoch(&block, n);
+			if (rrnx_obsw_write_epoch(obswriter, &block)) {
+				break;
+			}
+		}
+		rrnx_obsw_close(obswriter);
+	}
+
+	double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+	if (rrnx_obsw_errno(obswriter)) {
+		printf("%s\n", rrnx_obsw_strerror(obswriter));
+		return EXIT_FAILURE;
+	}
+	unsigned long lines = obswriter->lines;
+
+	// The reference, into memory. Each epoch takes at most
+	// a line per satellite and type, and the epoch record.
+	size_t ref_size = (size_t) epochs * (NUM_SATS * NUM_TYPES + 2) * 82;
+	char *ref = malloc(ref_size);
+	size_t ref_len = 0;
+	if (ref == NULL) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	rand_state = seed;
+	start = clock();
+	for (long n = 0; n < epochs; n++) {
+		simulate_epoch(&block, n);
+		format_reference(&ref, &ref_len, &block);
+	}
+	double ref_secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	// Compare the data sections
+	size_t size = 0;
+	char *data = read_file(filename, &size);
+	int identical = 0;
+	if (data != NULL) {
+		data[size] = '\0';
+		char *body = strstr(data, "END OF HEADER");
+		body = (body != NULL) ? strchr(body, '\n') : NULL;
+		if (body != NULL) {
+			body++;
+			identical = ((size_t) (data + size - body) == ref_len)
+			    && (memcmp(body, ref, ref_len) == 0);
+		}
+	}
+
+	rand_state = seed;
+	long mismatches = verify_roundtrip(filename, epochs, &block);
+
+	printf("Epochs:            %ld x %d satellites x %d types\n",
+	    epochs, NUM_SATS, NUM_TYPES);
+	printf("Lines:             %lu\n", lines);
+	if (data != NULL) {
+		printf("Bytes:             %lu\n", (unsigned long) size);
+	} else {
+		printf("Bytes:             cannot read %s\n", filename);
+	}
+	printf("rrnx_obswriter:    %.3f s, %.0f lines/s\n",
+	    secs, (secs > 0.0) ? lines / secs : 0.0);
+	printf("snprintf():        %.3f s, %.0f lines/s (in memory)\n",
+	    ref_secs, (ref_secs > 0.0) ? lines / ref_secs : 0.0);
+	printf("Same as snprintf:  %s\n", identical ? "yes" : "NO");
+	printf("Round-trip errors: %ld\n", mismatches);
+
+	free(data);
+	free(ref);
+	free_block(&block);
+	rrnx_obsw_free(obswriter);
+	rrnx_fobs_deinit_header(&header);
+
+	return (identical && (mismatches == 0)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,657 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+// For getrusage(), stat(), mkdir()
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h> // clock_gettime
+#include <sys/resource.h> // getrusage
+#include <sys/stat.h> // stat
+#include <unistd.h> // rmdir
+
+#include "rrnx/rrnx.h"
+#include "rrnx/rrnx_navreader.h"
+#include "rrnx/rrnx_obsreader.h"
+#include "rrnx/rrnx_obswriter.h"
+#include "rrnx/rrnx_numconv.h"
+
+// Navigation messages per satellite and day (every two hours)
+#define NAVMSGS_PER_DAY 12
+
+// Length of a navigation message in the generated file
+#define NAVMSG_BYTES (7*80 + 42)
+
+// Satellites per epoch in the generated observation file
+#define OBS_SATS 10
+
+// Observation types
+#define NUM_TYPES 6
+static const char *TYPE_CODES[NUM_TYPES] = {
+	"C1", "L1", "D1", "S1", "P2", "L2"
+};
+
+// Length of an epoch in the generated observation file (approximately)
+#define EPOCH_BYTES (33 + 3*OBS_SATS + OBS_SATS*(81+17))
+
+//--- allocation counting --------------------------------------------------//
+
+static unsigned long num_allocs = 0;
+
+#ifdef __GLIBC__
+// The allocations of the library are counted by interposing
+// the allocator of glibc.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+	num_allocs++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+	num_allocs++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+	num_allocs++;
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+	__libc_free(ptr);
+}
+#define HAVE_ALLOC_COUNT
+#endif
+
+//--- measurements ---------------------------------------------------------//
+
+/**
+ * Wall clock time in seconds.
+ */
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+/**
+ * Peak resident set size of the process in MB.
+ */
+static double peak_rss_mb(void) {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0.0;
+	}
+	// Kilobytes on Linux
+	return usage.ru_maxrss / 1024.0;
+}
+
+static long file_size(const char *filename) {
+	struct stat st;
+	if (stat(filename, &st) != 0) {
+		return -1;
+	}
+	return (long) st.st_size;
+}
+
+static void report(
+    const char *what,
+    double secs,
+    long bytes,
+    double records,
+    const char *unit,
+    unsigned long allocs
+) {
+	printf("  %-22s %8.3f s %8.1f MB/s %11.0f %s/s",
+	    what, secs, bytes / 1e6 / secs, records / secs, unit);
+#ifdef HAVE_ALLOC_COUNT
+	printf(" %9lu allocs", allocs);
+#endif
+	printf("\n");
+}
+
+//--- synthetic data -------------------------------------------------------//
+
+/**
+ * Deterministic pseudo-random numbers (xorshift64).
+ */
+static unsigned long long rand_state = 88172645463325252ULL;
+
+static double rand_uniform(void) {
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (double)(rand_state >> 11) / 9007199254740992.0;
+}
+
+/** Uniform random number within [lo, hi). */
+static double rand_range(double lo, double hi) {
+	return lo + ((hi - lo) * rand_uniform());
+}
+
+/**
+ * Converts days since 2014-01-01 to a date.
+ */
+static void day_to_date(long day, rrnx_datetime *t) {
+	static const int DAYS_IN_MONTH[12] = {
+		31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+	};
+	int year = 2014;
+	for (;;) {
+		int leap = ((year % 4) == 0)
+		    && (((year % 100) != 0) || ((year % 400) == 0));
+		int days = 365 + leap;
+		if (day < days) {
+			break;
+		}
+		day -= days;
+		year++;
+	}
+	int leap = ((year % 4) == 0)
+	    && (((year % 100) != 0) || ((year % 400) == 0));
+	int month = 0;
+	for (;;) {
+		int days = DAYS_IN_MONTH[month] + ((month == 1) ? leap : 0);
+		if (day < days) {
+			break;
+		}
+		day -= days;
+		month++;
+	}
+	t->year = year;
+	t->month = month + 1;
+	t->day = (int) day + 1;
+	t->hour = 0;
+	t->min = 0;
+	t->sec = 0.0;
+}
+
+/**
+ * Formats a D19.12 field.
+ */
+static void put_d19(char *dest, double value) {
+	if (!rrnx_num_format_fortran(dest, 19, 12, value)) {
+		char buf[32];
+		snprintf(buf, sizeof(buf), "%19.12E", value);
+		*strchr(buf, 'E') = 'D';
+		memcpy(dest, buf, 19);
+	}
+}
+
+static void put_orbit_line(FILE *fp, const double *values) {
+	char line[81];
+	memset(line, ' ', 3);
+	for (int i = 0; i < 4; i++) {
+		put_d19(&line[3 + (19*i)], values[i]);
+	}
+	line[79] = '\n';
+	fwrite(line, 1, 80, fp);
+}
+
+/**
+ * Writes a GPS navigation file of num_sats satellites and num_days
+ * days, with a navigation message every two hours.
+ */
+static int generate_nav(const char *filename, int num_sats, long num_days) {
+	FILE *fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		perror(filename);
+		return 0;
+	}
+	setvbuf(fp, NULL, _IOFBF, 0x100000);
+
+	fprintf(fp,
+	    "     2.11           N: GPS NAV DATA                         RINEX VERSION / TYPE\n"
+	    "bench_reader                            01-JAN-14 00:00     PGM / RUN BY / DATE\n"
+	    "    1.1180D-08  7.4510D-09 -5.9600D-08 -5.9600D-08          ION ALPHA\n"
+	    "    9.0110D+04  1.6380D+04 -1.9660D+05 -6.5540D+04          ION BETA\n"
+	    "    1.862645149230D-09 7.993605777300D-15    61440     1780 DELTA-UTC: A0,A1,T,W\n"
+	    "    16                                                      LEAP SECONDS\n"
+	    "                                                            END OF HEADER\n");
+
+	// 2014-01-01 is the day 3 of the GPS week 1773
+	const long first_day = (1773 * 7) + 3;
+
+	for (long day = 0; day < num_days; day++) {
+		rrnx_datetime t;
+		day_to_date(day, &t);
+		long gps_day = first_day + day;
+		double week = (double) (gps_day / 7);
+
+		for (int n = 0; n < NAVMSGS_PER_DAY; n++) {
+			double toe = ((gps_day % 7) * 86400.0) + (n * 7200.0);
+
+			for (int sv = 1; sv <= num_sats; sv++) {
+				char line[81];
+				snprintf(line, sizeof(line), "%2d %02d %2d %2d %2d %2d%5.1f",
+				    sv, t.year % 100, t.month, t.day, 2*n, 0, 0.0);
+				put_d19(&line[22], rand_range(-1e-3, 1e-3));
+				put_d19(&line[41], rand_range(-1e-11, 1e-11));
+				put_d19(&line[60], 0.0);
+				line[79] = '\n';
+				fwrite(line, 1, 80, fp);
+
+				double orbit[7][4] = {
+				    {(double) (n + 1), rand_range(-100, 100),
+				     rand_range(3e-9, 6e-9), rand_range(-3.14, 3.14)},
+				    {rand_range(-1e-5, 1e-5), rand_range(0, 0.02),
+				     rand_range(-1e-5, 1e-5), rand_range(5153.5, 5153.8)},
+				    {toe, rand_range(-1e-7, 1e-7),
+				     rand_range(-3.14, 3.14), rand_range(-1e-7, 1e-7)},
+				    {rand_range(0.9, 1.0), rand_range(150, 350),
+				     rand_range(-3.14, 3.14), rand_range(-9e-9, -7e-9)},
+				    {rand_range(-5e-10, 5e-10), 1.0, week, 0.0},
+				    {2.0, 0.0, rand_range(-1e-8, 1e-8), (double) (n + 1)},
+				    {toe - 18.0, 4.0, 0.0, 0.0}
+				};
+				for (int i = 0; i < 6; i++) {
+					put_orbit_line(fp, orbit[i]);
+				}
+				// The last line has two fields
+				memset(line, ' ', 3);
+				put_d19(&line[3], orbit[6][0]);
+				put_d19(&line[22], orbit[6][1]);
+				line[41] = '\n';
+				fwrite(line, 1, 42, fp);
+			}
+		}
+	}
+
+	int ok = !ferror(fp);
+	if (fclose(fp) != 0) {
+		ok = 0;
+	}
+	if (!ok) {
+		perror(filename);
+	}
+	return ok;
+}
+
+/**
+ * Writes a GPS observation file of num_epochs epochs at the given
+ * interval, OBS_SATS of num_sats satellites in each.
+ */
+static int generate_obs(
+    const char *filename,
+    int num_sats,
+    long num_epochs,
+    double interval
+) {
+	rrnx_obs_header header;
+	rrnx_fobs_init_header(&header);
+	strcpy(header.format.version, "2.11");
+	header.format.type = 'O';
+	header.format.system = 'G';
+	strcpy(header.info.program, "bench_reader");
+	strcpy(header.marker_name, "SIM");
+	header.has_interval = 1;
+	header.interval.interval = interval;
+	rrnx_fobs_resize_layout(&header, NUM_TYPES);
+	for (int t = 0; t < NUM_TYPES; t++) {
+		rrnx_fobs_code2type(&header.layout.item[t], 'G', TYPE_CODES[t]);
+	}
+
+	// A block with the same layout as the obsreader's
+	rrnx_obs_block block;
+	memset(&block, 0, sizeof(block));
+	block.value = malloc(NUM_TYPES * OBS_SATS * sizeof(double));
+	block.valid = malloc(NUM_TYPES * OBS_SATS);
+	block.lli = malloc(NUM_TYPES * OBS_SATS);
+	block.ssi = malloc(NUM_TYPES * OBS_SATS);
+	block.epoch.sat = malloc(OBS_SATS * sizeof(rrnx_satellite_id));
+	block.num_types = NUM_TYPES;
+	block.num_sats = OBS_SATS;
+	block.capacity = OBS_SATS;
+
+	rrnx_obswriter *obswriter = rrnx_obsw_alloc();
+	int err = RRNX_E_NOMEM;
+	if ((obswriter != NULL) && (block.value != NULL)
+	    && (block.valid != NULL) && (block.lli != NULL)
+	    && (block.ssi != NULL) && (block.epoch.sat != NULL))
+	{
+		err = rrnx_obsw_open(obswriter, filename);
+	}
+	if (err == RRNX_E_OK) {
+		err = rrnx_obsw_write_header(obswriter, &header);
+	}
+
+	for (long n = 0; (n < num_epochs) && (err == RRNX_E_OK); n++) {
+		rrnx_meas_epoch *epoch = &block.epoch;
+		double t = n * interval;
+		long day = (long) (t / 86400.0);
+		double sod = t - (day * 86400.0);
+		day_to_date(day, &epoch->t);
+		epoch->t.hour = (int) (sod / 3600.0);
+		epoch->t.min = (int) ((sod - (epoch->t.hour * 3600.0)) / 60.0);
+		epoch->t.sec = sod - (epoch->t.hour * 3600.0)
+		    - (epoch->t.min * 60.0);
+		epoch->event = 0;
+		epoch->size = OBS_SATS;
+		epoch->clock_offset = 0.0/0.0;
+
+		for (int i = 0; i < OBS_SATS; i++) {
+			epoch->sat[i].system = 'G';
+			epoch->sat[i].id = 1 + ((i * 3 + n / 120) % num_sats);
+		}
+		for (int k = 0; k < NUM_TYPES; k++) {
+			for (int i = 0; i < OBS_SATS; i++) {
+				size_t slot = (k * block.capacity) + i;
+				double value;
+				switch (TYPE_CODES[k][0]) {
+				case 'L': value = rand_range(-1e8, 1e8); break;
+				case 'D': value = rand_range(-5e3, 5e3); break;
+				case 'S': value = rand_range(20, 55); break;
+				default: value = rand_range(2e7, 2.6e7); break;
+				}
+				block.value[slot] = value;
+				block.valid[slot] = 1;
+				block.lli[slot] = RRNX_OBSR_FLAG_BLANK;
+				block.ssi[slot] = (signed char) rand_range(1, 10);
+			}
+		}
+
+		err = rrnx_obsw_write_epoch(obswriter, &block);
+	}
+
+	if (obswriter != NULL) {
+		int close_err = rrnx_obsw_close(obswriter);
+		if (err == RRNX_E_OK) {
+			err = close_err;
+		}
+		if (err != RRNX_E_OK) {
+			printf("%s: %s\n", filename, rrnx_obsw_strerror(obswriter));
+		}
+		rrnx_obsw_free(obswriter);
+	}
+
+	free(block.value);
+	free(block.valid);
+	free(block.lli);
+	free(block.ssi);
+	free(block.epoch.sat);
+	rrnx_fobs_deinit_header(&header);
+
+	return err == RRNX_E_OK;
+}
+
+//--- benchmarks -----------------------------------------------------------//
+
+static int bench_nav(const char *filename) {
+	long bytes = file_size(filename);
+	printf("%s: %.1f MB\n", filename, bytes / 1e6);
+
+	unsigned long allocs = num_allocs;
+	double start = now();
+
+	rrnx_navreader *navreader = rrnx_navr_alloc();
+	if (navreader == NULL) {
+		printf("Out of memory\n");
+		return 0;
+	}
+	rrnx_navr_readfile(navreader, filename);
+	int err = rrnx_navr_errno(navreader);
+	if (err) {
+		printf("%s\n", rrnx_navr_strerror(navreader));
+		rrnx_navr_free(navreader);
+		return 0;
+	}
+	rrnx_list *nodelist = rrnx_navr_release_nodelist(navreader);
+	rrnx_navr_free(navreader);
+
+	double secs_read = now() - start;
+	unsigned long allocs_read = num_allocs - allocs;
+
+	allocs = num_allocs;
+	start = now();
+	rrnx_file_nav *nav = rrnx_fnav_deserialize(nodelist);
+	double secs_deserialize = now() - start;
+	unsigned long allocs_deserialize = num_allocs - allocs;
+
+	if (nav == NULL) {
+		printf("rrnx_fnav_deserialize: out of memory\n");
+		rrnx_list_free(nodelist);
+		return 0;
+	}
+
+	long records = 0;
+	const rrnx_list_item *iter = nav->navmsg_list->first;
+	for (; iter != NULL; iter = iter->next) {
+		records++;
+	}
+
+	report("rrnx_navr_readfile", secs_read, bytes,
+	    records, "records", allocs_read);
+	report("rrnx_fnav_deserialize", secs_deserialize, bytes,
+	    records, "records", allocs_deserialize);
+	printf("  %-22s %8ld\n", "Records", records);
+	printf("  %-22s %8.1f MB\n", "Peak RSS", peak_rss_mb());
+
+	rrnx_fnav_free(nav);
+	rrnx_list_free(nodelist);
+
+	return 1;
+}
+
+static int bench_obs(const char *filename) {
+	long bytes = file_size(filename);
+	printf("%s: %.1f MB\n", filename, bytes / 1e6);
+
+	unsigned long allocs = num_allocs;
+	double start = now();
+
+	rrnx_obsreader *obsreader = rrnx_obsr_alloc();
+	if (obsreader == NULL) {
+		printf("Out of memory\n");
+		return 0;
+	}
+
+	if (rrnx_obsr_open(obsreader, filename)) {
+		printf("%s\n", rrnx_obsr_strerror(obsreader));
+		rrnx_obsr_free(obsreader);
+		return 0;
+	}
+
+	long epochs = 0;
+	double values = 0;
+	const rrnx_obs_block *block;
+	while (rrnx_obsr_next(obsreader, &block)) {
+		epochs++;
+		values += (double) block->num_sats * block->num_types;
+	}
+	int err = rrnx_obsr_errno(obsreader);
+	if (err) {
+		printf("%s\n", rrnx_obsr_strerror(obsreader));
+	}
+	rrnx_obsr_close(obsreader);
+	rrnx_obsr_free(obsreader);
+
+	double secs = now() - start;
+	allocs = num_allocs - allocs;
+
+	report("rrnx_obsr_next", secs, bytes, epochs, "epochs", allocs);
+	printf("  %-22s %8.0f obs/s\n", "Observations", values / secs);
+	printf("  %-22s %8ld\n", "Epochs", epochs);
+	printf("  %-22s %8.1f MB\n", "Peak RSS", peak_rss_mb());
+
+	return err == RRNX_E_OK;
+}
+
+//--- main -----------------------------------------------------------------//
+
+static void display_usage(void) {
+	printf("Usage:\n");
+	printf("\n");
+	printf("    bench_reader [<options>]\n");
+	printf("\n");
+	printf("Generates a synthetic navigation file and an observation file,\n");
+	printf("and measures the speed of reading them. The files are the same\n");
+	printf("for the same options.\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("    -sats <n>        satellites (default 32)\n");
+	printf("    -days <n>        days of data (default 1)\n");
+	printf("    -size <MB>       approximate size of each file instead of days\n");
+	printf("    -interval <s>    observation interval (default 30)\n");
+	printf("    -dir <dir>       where the files are generated, created if missing\n");
+	printf("                     (default a new temporary directory, removed\n");
+	printf("                     on exit)\n");
+	printf("    -nav, -obs       only the navigation or the observation file\n");
+	printf("    -keep            keep the files\n");
+	printf("\n");
+	printf("The peak RSS is the high-water mark of the whole process.\n");
+#ifndef HAVE_ALLOC_COUNT
+	printf("Allocations are counted only with glibc.\n");
+#endif
+	printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+	int num_sats = 32;
+	double days = 1.0;
+	double size_mb = 0.0;
+	double interval = 30.0;
+	const char *dir = NULL;
+	int do_nav = 1;
+	int do_obs = 1;
+	int keep = 0;
+
+	for (int i = 1; i < argc; i++) {
+		const char *carg = argv[i];
+		const char *next = (i+1 < argc) ? argv[i+1] : NULL;
+		if ((strcmp(carg, "-sats") == 0) && (next != NULL)) {
+			num_sats = atoi(next);
+			i++;
+		} else if ((strcmp(carg, "-days") == 0) && (next != NULL)) {
+			days = atof(next);
+			i++;
+		} else if ((strcmp(carg, "-size") == 0) && (next != NULL)) {
+			size_mb = atof(next);
+			i++;
+		} else if ((strcmp(carg, "-interval") == 0) && (next != NULL)) {
+			interval = atof(next);
+			i++;
+		} else if ((strcmp(carg, "-dir") == 0) && (next != NULL)) {
+			dir = next;
+			i++;
+		} else if (strcmp(carg, "-nav") == 0) {
+			do_obs = 0;
+		} else if (strcmp(carg, "-obs") == 0) {
+			do_nav = 0;
+		} else if (strcmp(carg, "-keep") == 0) {
+			keep = 1;
+		} else {
+			display_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ((num_sats < OBS_SATS) || (num_sats > 32) || (days <= 0.0)
+	    || (size_mb < 0.0) || (interval < 0.1))
+	{
+		printf("Error: invalid options (%d to 32 satellites)\n", OBS_SATS);
+		return EXIT_FAILURE;
+	}
+
+	// Sizes of the files
+	long nav_days = (long) (days + 0.5);
+	long obs_epochs = (long) ((days * 86400.0) / interval);
+	if (size_mb > 0.0) {
+		double bytes = size_mb * 1e6;
+		nav_days = (long) (bytes
+		    / ((double) NAVMSG_BYTES * NAVMSGS_PER_DAY * num_sats));
+		obs_epochs = (long) (bytes / EPOCH_BYTES);
+	}
+	if (nav_days < 1) nav_days = 1;
+	if (obs_epochs < 1) obs_epochs = 1;
+
+	// Without -dir, the files go to a temporary directory
+	char tmp_dir[] = "/tmp/bench_reader.XXXXXX";
+	int own_dir = 0;
+	if (dir == NULL) {
+		dir = mkdtemp(tmp_dir);
+		if (dir == NULL) {
+			printf("Error: cannot create a temporary directory\n");
+			return EXIT_FAILURE;
+		}
+		own_dir = 1;
+	} else {
+		// Create the directory if it is missing.
+		struct stat st;
+		if (stat(dir, &st) != 0) {
+			if (mkdir(dir, 0777) != 0) {
+				printf("Error: cannot create the directory %s: %s\n",
+				    dir, strerror(errno));
+				return EXIT_FAILURE;
+			}
+		} else if (!S_ISDIR(st.st_mode)) {
+			printf("Error: %s is not a directory\n", dir);
+			return EXIT_FAILURE;
+		}
+	}
+
+	char nav_filename[1024];
+	char obs_filename[1024];
+	snprintf(nav_filename, sizeof(nav_filename), "%s/bench_reader.14n", dir);
+	snprintf(obs_filename, sizeof(obs_filename), "%s/bench_reader.14o", dir);
+
+	int ok = 1;
+
+	if (do_nav) {
+		double start = now();
+		ok = generate_nav(nav_filename, num_sats, nav_days);
+		printf("Generated %ld days of navigation messages in %.1f s\n",
+		    nav_days, now() - start);
+		if (ok) {
+			ok = bench_nav(nav_filename);
+		}
+		if (!keep) {
+			remove(nav_filename);
+		}
+		printf("\n");
+	}
+
+	if (do_obs && ok) {
+		double start = now();
+		ok = generate_obs(obs_filename, num_sats, obs_epochs, interval);
+		printf("Generated %ld epochs of observations in %.1f s\n",
+		    obs_epochs, now() - start);
+		if (ok) {
+			ok = bench_obs(obs_filename);
+		}
+		if (!keep) {
+			remove(obs_filename);
+		}
+		printf("\n");
+	}
+
+	if (own_dir) {
+		if (keep) {
+			printf("The files are in %s\n", dir);
+		} else {
+			rmdir(dir);
+		}
+	}
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
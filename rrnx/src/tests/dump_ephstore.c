@@ -0,0 +1,151 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memcmp
+#include <errno.h>
+#include <time.h> // clock
+
+#include "rrnx/rrnx.h"
+#include "rrnx/rrnx_ephstore.h"
+
+static void dump_record(const rrnx_es_record *record) {
+	printf("  %02d  %6d %6d  %4d %9.2f    %02d:%02d:%02d %02d.%02d.%02d\n",
+		record->sv_id, (int) record->IODE, (int) record->IODC,
+		(int) record->toe_week, record->toe,
+		record->toc_hour, record->toc_min, (int) record->toc_sec,
+		record->toc_day, record->toc_month, record->toc_year
+	);
+}
+
+/**
+ * Look up every navmsg of the NAV file from the store,
+ * and compare the records bit for bit.
+ * Returns the number of mismatches.
+ */
+static int verify(const rrnx_ephstore *store, const rrnx_file_nav *nav) {
+	int total = 0;
+	int mismatches = 0;
+
+	const rrnx_list_item *iter = nav->navmsg_list->first;
+	for (; iter != NULL; iter = iter->next) {
+		const rrnx_navmsg *navmsg = iter->data;
+		total++;
+
+		rrnx_es_record expected;
+		rrnx_es_from_navmsg(&expected, navmsg);
+
+		// Duplicate keys are stored adjacent; any of them will do.
+		int found = 0;
+		long i = rrnx_es_find(store, navmsg->sv_id,
+		    (int) navmsg->toe_week, navmsg->toe);
+		for (; (i >= 0) && ((size_t) i < store->count); i++) {
+			const rrnx_es_record *record = &store->records[i];
+			if ((record->sv_id != expected.sv_id)
+			    || (record->toe_week != expected.toe_week)
+			    || (record->toe != expected.toe))
+			{
+				break;
+			}
+			if (memcmp(record, &expected, sizeof(expected)) == 0) {
+				found = 1;
+				break;
+			}
+		}
+
+		if (!found) {
+			if (mismatches < 10) {
+				printf("Not found:\n");
+				dump_record(&expected);
+			}
+			mismatches++;
+		}
+	}
+
+	if ((size_t) total != store->count) {
+		printf("Record count differs: %d != %zu\n", total, store->count);
+		mismatches++;
+	}
+
+	printf("Verified:          %d records\n", total);
+	printf("Mismatches:        %d\n", mismatches);
+
+	return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    dump_ephstore <store> [<rinex_nav>]\n");
+		printf("\n");
+		printf("When a NAV file is given, its records are looked up\n");
+		printf("from the store and compared instead of listing them.\n");
+		printf("Create the store with nav2bin -store.\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *filename = argv[1];
+
+	clock_t start = clock();
+	rrnx_ephstore *store = NULL;
+	int err = rrnx_es_open(filename, &store);
+	double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	if (err) {
+		if (err == RRNX_E_SYSCALL) {
+			perror(filename);
+		} else {
+			printf("%s: unable to open (rrnx error code %d)\n",
+			    filename, err);
+		}
+		return EXIT_FAILURE;
+	}
+
+	printf("%s\n", filename);
+	printf("Records:           %zu\n", store->count);
+	printf("Open time:         %.3f ms\n", 1e3 * secs);
+
+	int exitcode = EXIT_SUCCESS;
+
+	if (argc > 2) {
+		rrnx_file_nav *nav = NULL;
+		err = rrnx_read_navfile(argv[2], &nav);
+		if (err) {
+			printf("%s: unable to parse (rrnx error code %d)\n",
+			    argv[2], err);
+			exitcode = EXIT_FAILURE;
+		} else {
+			if (verify(store, nav) != 0) {
+				exitcode = EXIT_FAILURE;
+			}
+			rrnx_free_navfile(nav);
+		}
+	} else {
+		printf("\n");
+		printf("  Sat   IODE   IODC  week       toe                  toc\n");
+		for (size_t i = 0; i < store->count; i++) {
+			dump_record(&store->records[i]);
+		}
+	}
+
+	rrnx_es_close(store);
+
+	return exitcode;
+}
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h> // strcmp
 
 #include "rrnx/rrnx.h"
 
@@ -36,10 +37,11 @@ static void dump_navfile_info(const rrnx_file_info *info) {
 
 static void dump_navfile_navmsg(const rrnx_navmsg *navmsg) {
 	//printf("  Sat   IODE   IODC            toe                  toc\n");
-	printf("  %02d  %6d %6d      %9.2f    %02d:%02d:%02d %02d.%02d.%02d\n",
+	printf("  %02d  %6d %6d      %9.2f    %02d:%02d:%02d %02d.%02d.%02d%s\n",
 		navmsg->sv_id, (int) navmsg->IODE, (int) navmsg->IODC, navmsg->toe,
 		navmsg->toc.hour, navmsg->toc.min, (int) navmsg->toc.sec,
-		navmsg->toc.day, navmsg->toc.month, navmsg->toc.year
+		navmsg->toc.day, navmsg->toc.month, navmsg->toc.year,
+		navmsg->conflict ? "  conflict" : ""
 	);
 
 }
@@ -114,25 +116,84 @@ static void dump_navfile(const rrnx_file_nav *nav) {
 }
 
 int main(int argc, char *argv[]) {
-	if (argc < 2) {
+	int num_threads = 0;
+	int dedup = 0;
+	int argi = 1;
+
+	if ((argc > argi+1) && (strcmp(argv[argi], "-j") == 0)) {
+		num_threads = atoi(argv[argi+1]);
+		argi += 2;
+	}
+	if ((argc > argi) && (strcmp(argv[argi], "-dedup") == 0)) {
+		dedup = 1;
+		argi++;
+	}
+
+	if (argc <= argi) {
 		printf("Usage:\n");
 		printf("\n");
-		printf("    dump_navfile <rinex_nav>\n");
+		printf("    dump_navfile [-j <threads>] [-dedup] <rinex_nav> ...\n");
+		printf("\n");
+		printf("Multiple files are read in parallel, and merged.\n");
+		printf("With -dedup, the duplicate records are removed, and the\n");
+		printf("conflicting ones are marked.\n");
 		printf("\n");
 		return EXIT_FAILURE;
 	}
 
-	const char *filename = argv[1];
-	printf("%s\n", filename);
+	const char *const *filenames = (const char *const *) &argv[argi];
+	int count = argc - argi;
 
 	rrnx_file_nav *nav = NULL;
-	int err = rrnx_read_navfile(filename, &nav);
+	int err;
+
+	if (count == 1) {
+		const char *filename = filenames[0];
+		printf("%s\n", filename);
+
+		err = rrnx_read_navfile(filename, &nav);
+	} else {
+		rrnx_navfile_result *results = malloc(
+		    count * sizeof(rrnx_navfile_result));
+		if (results == NULL) {
+			printf("Out of memory\n");
+			return EXIT_FAILURE;
+		}
+
+		err = rrnx_read_navfiles(
+		    filenames, count, num_threads, &nav, results);
+
+		for (int i = 0; i < count; i++) {
+			if (results[i].err) {
+				printf("%s: unable to parse (rrnx error code %d): %s\n",
+				    filenames[i], results[i].err, results[i].errmsg);
+			} else {
+				printf("%s\n", filenames[i]);
+			}
+		}
+
+		free(results);
+	}
 
 	if (err) {
 		printf("Unable to parse (rrnx error code %d)\n", err);
 		return EXIT_FAILURE;
 	}
 
+	if (dedup) {
+		rrnx_fnav_dedup_stats stats;
+		err = rrnx_fnav_dedup(nav, &stats);
+		if (err) {
+			printf("Unable to de-duplicate (rrnx error code %d)\n", err);
+			rrnx_free_navfile(nav);
+			return EXIT_FAILURE;
+		}
+		printf("Records:           %zu\n", stats.input);
+		printf("Unique:            %zu\n", stats.unique);
+		printf("Duplicates:        %zu\n", stats.duplicates);
+		printf("Conflicts:         %zu\n", stats.conflicts);
+	}
+
 	dump_navfile(nav);
 
 	rrnx_free_navfile(nav);
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h> // strcmp
 #include "rrnx/rrnx_navreader.h"
 
 // For working with nodes
@@ -203,22 +204,131 @@ static void dump_nodelist(const rrnx_list *nodelist) {
 
 }
 
+static int dump_streamed_node(void *userdata, const rrnx_node *node) {
+	dump_node(node);
+	// Continue
+	return 0;
+}
+
+/**
+ * Follows the file until it has not grown for idle_secs seconds.
+ */
+static void follow_file(
+    rrnx_navreader *navreader,
+    const char *filename,
+    int idle_secs
+) {
+	if (rrnx_navr_follow_open(navreader, filename)) {
+		return;
+	}
+
+	do {
+		if (rrnx_navr_follow_poll(navreader, dump_streamed_node, NULL)) {
+			break;
+		}
+		fflush(stdout);
+	} while (rrnx_navr_follow_wait(navreader, idle_secs * 1000));
+
+	rrnx_navr_follow_close(navreader);
+}
+
+/**
+ * Reads the file into memory, and feeds it to the parser
+ * in blocks of the given size.
+ */
+static void consume_blocks(
+    rrnx_navreader *navreader,
+    const char *filename,
+    size_t block_size
+) {
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		perror(filename);
+		return;
+	}
+
+	char *buf = malloc(block_size);
+	if (buf == NULL) {
+		printf("Out of memory\n");
+		fclose(fp);
+		return;
+	}
+
+	size_t len;
+	int err = RRNX_E_OK;
+	while ((err == RRNX_E_OK)
+	    && ((len = fread(buf, 1, block_size, fp)) > 0))
+	{
+		err = rrnx_navr_consume_block(navreader, buf, len);
+	}
+	if (err == RRNX_E_OK) {
+		// End of input
+		rrnx_navr_consume_block(navreader, NULL, 0);
+	}
+
+	free(buf);
+	fclose(fp);
+}
+
 int main(int argc, char *argv[]) {
-	if (argc < 2) {
+	int streaming = 0;
+	int follow_secs = 0;
+	int block_size = 0;
+	int num_threads = 1;
+	int argi = 1;
+
+	if ((argc > 1) && (strcmp(argv[1], "-stream") == 0)) {
+		streaming = 1;
+		argi++;
+	} else if ((argc > 2) && (strcmp(argv[1], "-follow") == 0)) {
+		streaming = 1;
+		follow_secs = atoi(argv[2]);
+		argi += 2;
+	} else if ((argc > 2) && (strcmp(argv[1], "-block") == 0)) {
+		block_size = atoi(argv[2]);
+		argi += 2;
+	} else if ((argc > 2) && (strcmp(argv[1], "-j") == 0)) {
+		num_threads = atoi(argv[2]);
+		argi += 2;
+	}
+
+	if (argc <= argi) {
 		printf("Usage:\n");
 		printf("\n");
-		printf("    dump_navnodes <rinex_nav>\n");
+		printf("    dump_navnodes [-stream | -follow <s> | -block <bytes>"
+		    " | -j <threads>] <rinex_nav>\n");
+		printf("\n");
+		printf("With -stream, the nodes are dumped while reading.\n");
+		printf("With -follow, the file is followed as it grows, until\n");
+		printf("it has not grown for the given number of seconds.\n");
+		printf("With -block, the file is parsed from memory in blocks.\n");
+		printf("With -j, the data records are parsed in parallel.\n");
 		printf("\n");
 		return EXIT_FAILURE;
 	}
 
+	const char *filename = argv[argi];
+
 	// Allocate a new navreader
 	rrnx_navreader *navreader = rrnx_navr_alloc();
 
 	// Try to read and parse the file specified
 	// on the command line.
-	printf("%s\n", argv[1]);
-	rrnx_navr_readfile(navreader, argv[1]);
+	printf("%s\n", filename);
+	if (follow_secs > 0) {
+		printf("\n");
+		follow_file(navreader, filename, follow_secs);
+	} else if (streaming) {
+		printf("\n");
+		rrnx_navr_readfile_cb(
+		    navreader, filename, dump_streamed_node, NULL);
+	} else if (block_size > 0) {
+		consume_blocks(navreader, filename, block_size);
+	} else if (num_threads != 1) {
+		rrnx_navr_readfile_parallel(navreader, filename, num_threads);
+	} else {
+		rrnx_navr_readfile(navreader, filename);
+	}
 	int exitcode = EXIT_SUCCESS;
 
 	// If an error, halt now
@@ -227,7 +337,7 @@ int main(int argc, char *argv[]) {
         	printf("Parse failed (err=%d):\n", err);
 		printf("%s\n", rrnx_navr_strerror(navreader));
 		exitcode = EXIT_FAILURE;
-	} else {
+	} else if (!streaming) {
 		printf("\n");
 
 		// Pop nodelist
@@ -0,0 +1,175 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // strcmp
+#include <time.h> // clock
+
+#include "rrnx/rrnx_obsreader.h"
+
+static void dump_header(const rrnx_obs_header *header) {
+	printf("File format:\n");
+	printf("  version:           \"%s\"\n", header->format.version);
+	printf("  type:              \"%c\"\n", header->format.type);
+	printf("  system:            \"%c\"\n", header->format.system);
+	printf("File origin:\n");
+	printf("  program:           \"%s\"\n", header->info.program);
+	printf("  agency:            \"%s\"\n", header->info.agency);
+	printf("  date:              \"%s\"\n", header->info.date);
+	printf("Marker:\n");
+	printf("  name:              \"%s\"\n", header->marker_name);
+	printf("  number:            \"%s\"\n", header->marker_number);
+	if (header->has_marker_xyz) {
+		printf("  position:          %.4f %.4f %.4f\n",
+		    header->marker_xyz.x, header->marker_xyz.y,
+		    header->marker_xyz.z);
+	}
+	printf("Receiver:            \"%s\" \"%s\" \"%s\"\n",
+	    header->receiver_number, header->receiver_type,
+	    header->receiver_version);
+	printf("Antenna:             \"%s\" \"%s\"\n",
+	    header->antenna_number, header->antenna_type);
+	if (header->has_interval) {
+		printf("Interval:            %.3f\n", header->interval.interval);
+	}
+
+	printf("Observation types:  ");
+	for (unsigned int i = 0; i < header->layout.size; i++) {
+		char code[3];
+		rrnx_fobs_type2code(&header->layout.item[i], code);
+		printf(" %s", code);
+	}
+	printf("\n");
+}
+
+static void dump_flag(int flag) {
+	if (flag == RRNX_OBSR_FLAG_BLANK) {
+		printf(" ");
+	} else {
+		printf("%d", flag);
+	}
+}
+
+/**
+ * One line per epoch, and one line per satellite.
+ * Blank observations are shown as "-".
+ */
+static void dump_block(const rrnx_obs_block *block) {
+	const rrnx_meas_epoch *epoch = &block->epoch;
+	printf("%02d %02d %02d %02d %02d %10.7f  %u %3u",
+	    epoch->t.year, epoch->t.month, epoch->t.day,
+	    epoch->t.hour, epoch->t.min, epoch->t.sec,
+	    epoch->event, epoch->size);
+	if (epoch->clock_offset == epoch->clock_offset) {
+		printf(" %.9f", epoch->clock_offset);
+	}
+	printf("\n");
+
+	for (unsigned int i = 0; i < block->num_sats; i++) {
+		printf("  %c%02d", epoch->sat[i].system, epoch->sat[i].id);
+		for (unsigned int t = 0; t < block->num_types; t++) {
+			size_t slot = (t * block->capacity) + i;
+			if (block->valid[slot]) {
+				printf(" %.3f", block->value[slot]);
+			} else {
+				printf(" -");
+			}
+			printf("/");
+			dump_flag(block->lli[slot]);
+			dump_flag(block->ssi[slot]);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char *argv[]) {
+	int stats = 0;
+	int argi = 1;
+
+	if ((argc > 1) && (strcmp(argv[1], "-stats") == 0)) {
+		stats = 1;
+		argi++;
+	}
+
+	if (argc <= argi) {
+		printf("Usage:\n");
+		printf("\n");
+		printf("    dump_obsfile [-stats] <rinex_obs>\n");
+		printf("\n");
+		printf("With -stats, the epochs are only counted and timed.\n");
+		printf("\n");
+		return EXIT_FAILURE;
+	}
+
+	const char *filename = argv[argi];
+
+	rrnx_obsreader *obsreader = rrnx_obsr_alloc();
+	if (obsreader == NULL) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+	rrnx_obsr_set_mmap(obsreader, 1);
+
+	clock_t start = clock();
+
+	if (rrnx_obsr_open(obsreader, filename)) {
+		printf("%s\n", rrnx_obsr_strerror(obsreader));
+		rrnx_obsr_free(obsreader);
+		return EXIT_FAILURE;
+	}
+
+	if (!stats) {
+		dump_header(&obsreader->header);
+	}
+
+	long epochs = 0;
+	long sats = 0;
+	long observations = 0;
+
+	const rrnx_obs_block *block;
+	while (rrnx_obsr_next(obsreader, &block)) {
+		epochs++;
+		sats += block->num_sats;
+		observations += (long) block->num_sats * block->num_types;
+		if (!stats) {
+			dump_block(block);
+		}
+	}
+
+	double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	int err = rrnx_obsr_errno(obsreader);
+	if (err) {
+		printf("%s\n", rrnx_obsr_strerror(obsreader));
+	}
+
+	if (stats) {
+		printf("Epochs:            %ld\n", epochs);
+		printf("Satellites:        %ld\n", sats);
+		printf("Observations:      %ld\n", observations);
+		printf("Time:              %.3f s\n", secs);
+		if (secs > 0.0) {
+			printf("Observations/s:    %.0f\n", observations / secs);
+		}
+	}
+
+	rrnx_obsr_close(obsreader);
+	rrnx_obsr_free(obsreader);
+
+	return err ? EXIT_FAILURE : EXIT_SUCCESS;
+}
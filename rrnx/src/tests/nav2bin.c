@@ -15,17 +15,23 @@
 //
 //********************************{end:header}******************************//
 
+// For sysconf()
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// va_list, va_start, va_end
-#include <stdarg.h>
+#include <pthread.h>
+#include <unistd.h> // sysconf
 
 #include "rrnx/rrnx.h"
+#include "rrnx/rrnx_ephstore.h"
+#include "rrnx/rrnx_numconv.h"
 
 #define MODE_BINARY 1
 #define MODE_CSV 2
+#define MODE_STORE 3
 
 
 /*
@@ -178,32 +184,6 @@ static int bytebuffer_flush_to_file(bytebuffer *bb, FILE *fp) {
 	return success;
 }
 
-static int bytebuffer_printf(bytebuffer *bb, const char *fmt, ...) {
-	// use va_args
-        va_list args;
-
-	size_t avail = bb->size - bb->len;
-
-        va_start(args, fmt);
-	int len = vsnprintf((char *) &bb->data[bb->len], avail, fmt, args);
-        va_end(args);
-
-	// According to the man page of vsnprintf,
-	// "a return value of size or more means
-	//  that the output was  truncated."
-	int success = len < avail;
-
-	if (success) {
-		// Update length (terminating null byte excluded)
-		bb->len += len;
-	} else {
-		bb->err = 1;
-	} // if-else
-
-	return success;
-}
-
-
 static int write_navmsg_bin(bytebuffer *bb, const rrnx_navmsg *navmsg) {
 	int ok = 1;
 	if (navmsg != NULL) {
@@ -264,56 +244,76 @@ static int write_navmsg_bin(bytebuffer *bb, const rrnx_navmsg *navmsg) {
 	return ok;
 }
 
+/**
+ * Formats a number with the shortest text that converts back
+ * to the same double, followed by the separator.
+ */
+static int bytebuffer_write_number(
+    bytebuffer *bb,
+    double value,
+    const char *sep
+) {
+	size_t seplen = strlen(sep);
+	size_t avail = bb->size - bb->len;
+	if (avail < RRNX_NUM_SHORTEST_MAX + seplen) {
+		bb->err = 1;
+		return 0;
+	}
+
+	char *dest = (char *) &bb->data[bb->len];
+	int len = rrnx_num_format_shortest(dest, value);
+	memcpy(dest + len, sep, seplen);
+	bb->len += len + seplen;
+
+	return 1;
+}
+
 static int write_navmsg_csv(bytebuffer *bb, const rrnx_navmsg *navmsg) {
 	int ok = 1;
 	if (navmsg != NULL) {
-		bytebuffer_printf(
-		    bb, "%d, %d, %g, %g, ",
-                    navmsg->sv_id,
+		// The columns of the binary format.
+		// The integer columns are truncated.
+		const double columns[] = {
+		    navmsg->sv_id,
 		    (int) navmsg->IODE,
 		    navmsg->toe_week,
-		    navmsg->toe
-		);
-		bytebuffer_printf(
-		    bb, "%g, %g, %g, %g, %g, %g, ",
+		    navmsg->toe,
+		    // Keplerian elements
 		    navmsg->sqrtA,
 		    navmsg->e,
 		    navmsg->i0,
 		    navmsg->w,
 		    navmsg->OMEGA0,
-		    navmsg->M0
-		);
-		bytebuffer_printf(
-		    bb, "%g, %g, %g, ",
+		    navmsg->M0,
+		    // Linear perturbations
 		    navmsg->delta_n,
 		    navmsg->OMEGADOT,
-		    navmsg->idot
-		);
-		bytebuffer_printf(
-		    bb, "%g, %g, %g, %g, %g, %g, ",
+		    navmsg->idot,
+		    // Periodic perturbations
 		    navmsg->Crs,
 		    navmsg->Crc,
 		    navmsg->Cus,
 		    navmsg->Cuc,
-		    navmsg->Crs,
-		    navmsg->Crc
-		);
-		bytebuffer_printf(
-		    bb, "%d, %g, %g, %g, ",
+		    navmsg->Cis,
+		    navmsg->Cic,
+		    // Clock correction parameters
 		    (int) navmsg->IODC,
 		    navmsg->af0,
 		    navmsg->af1,
-		    navmsg->af2
-		);
-		bytebuffer_printf(
-		    bb, "%g, %d, %d, %d, %d",
+		    navmsg->af2,
+		    // Miscellaneous parameters
 		    navmsg->Tgd,
 		    (int) navmsg->health,
 		    (int) navmsg->accuracy,
 		    (int) navmsg->fit_interval,
-		    (int) navmsg->valid_af2
-		);
-		bytebuffer_printf(bb, "\n");
+		    navmsg->valid_af2
+		};
+		const int count = sizeof(columns) / sizeof(columns[0]);
+
+		for (int i = 0; i < count; i++) {
+			bytebuffer_write_number(
+			    bb, columns[i], (i < count-1) ? ", " : "\n");
+		}
 
 		ok = !bytebuffer_error(bb);
 	}
@@ -363,8 +363,6 @@ static int write_binfile(FILE *fp, const rrnx_file_nav *nav, int mode) {
 		const rrnx_navmsg *navmsg = iter->data;
 
 		// Write single navmsg struct
-		int ok;
-
 		ok = write_navmsg(bb, navmsg);
 		if (!ok) {
 			perror("bytebuffer");
@@ -392,6 +390,13 @@ struct run_params {
 	const char *output_filename;
 
 	int mode;
+
+	/** Number of worker threads in the multi-file mode, or -1. */
+	int num_jobs;
+
+	/** Input files of the multi-file mode. */
+	const char **input_filenames;
+	int num_inputs;
 };
 
 typedef struct run_params run_params;
@@ -406,12 +411,29 @@ static int parse_args(run_params *params, int argc, char *argv[]) {
 		else if (strcmp(carg, "-bin") == 0) {
 			params->mode = MODE_BINARY;
 		}
+		else if (strcmp(carg, "-store") == 0) {
+			params->mode = MODE_STORE;
+		}
+		else if (strcmp(carg, "-jobs") == 0) {
+			if ((i+1 >= argc) || (sscanf(argv[i+1], "%d",
+			    &params->num_jobs) != 1) || (params->num_jobs < 0))
+			{
+				success = 0;
+				fprintf(stderr,
+				    "Error: -jobs requires a non-negative number\n");
+				break;
+			}
+			i++;
+		}
 		else if (carg[0] == '-') {
 			success = 0;
 			fprintf(stderr,
 			    "Error: unrecognized switch: %s\n", carg);
 			break;
 		}
+		else if (params->num_jobs >= 0) {
+			params->input_filenames[params->num_inputs++] = carg;
+		}
 		else if (params->input_filename == NULL) {
 			params->input_filename = carg;
 		}
@@ -430,15 +452,21 @@ static int parse_args(run_params *params, int argc, char *argv[]) {
 
 static void display_usage(void) {
 	printf("nav2bin <rinex_nav> [<dest_file>] [<options>]\n");
+	printf("nav2bin [<options>] -jobs <n> <rinex_nav> ...\n");
 	printf("\n");
 	printf("where options is one of the following\n");
 	printf("    -csv       format as csv (default)\n");
 	printf("    -bin       format as binary (must have dest file)\n");
+	printf("    -store     write an indexed ephemeris store (must have dest file)\n");
 	printf("\n");
 	printf("When dest file is not specified, stdout is used\n");
 	printf("\n");
+	printf("With -jobs, all the files after it are converted by n worker\n");
+	printf("threads (0 means one per processor). Each dest file is named\n");
+	printf("after its input with the suffix .csv, .bin or .eph.\n");
+	printf("\n");
 	printf("Example:\n");
-	printf("find -iname \"*.??n\" | xargs -l1 -I \"{}\" nav2bin {} {}.csv\n");
+	printf("find -iname \"*.??n\" | xargs nav2bin -csv -jobs 0\n");
 	//printf("Rename afterwards:\n");
 	//printf("find -iname \"*.csv\" | sed \"s/[^\\/]*\\/\\(....\\)\\(...\\)..\\(..\\).*/\\0 \\1_20\\3_\\2.csv/\" | xargs -l1 mv\n");
 	//printf("Combine files:\n");
@@ -446,20 +474,214 @@ static void display_usage(void) {
 
 }
 
+/**
+ * Converts a single file. Returns 1 on success.
+ */
+static int convert_file(
+    const char *input_filename,
+    const char *output_filename,
+    int mode
+) {
+	rrnx_file_nav *nav = NULL;
+	int err = rrnx_read_navfile(input_filename, &nav);
+	if (err) {
+		fprintf(stderr, "%s: parse error (rrnx error code %d)\n",
+		    input_filename, err);
+		return 0;
+	}
+
+	if (mode == MODE_STORE) {
+		err = rrnx_es_write(output_filename, nav);
+		rrnx_free_navfile(nav);
+		if (err) {
+			if (err == RRNX_E_SYSCALL) {
+				perror(output_filename);
+			} else {
+				fprintf(stderr, "%s: write error (rrnx error code %d)\n",
+				    output_filename, err);
+			}
+			return 0;
+		}
+		return 1;
+	}
+
+	FILE *fp = NULL;
+
+	if (output_filename != NULL) {
+		fp = fopen(output_filename, "wb");
+		if (fp == NULL) {
+			perror(output_filename);
+			rrnx_free_navfile(nav);
+			return 0;
+		}
+	} else {
+		fp = stdout;
+	}
+
+	int ok = write_binfile(fp, nav, mode);
+
+	if (fp != stdout) {
+		fclose(fp);
+	}
+
+	rrnx_free_navfile(nav);
+
+	return ok;
+}
+
+/**
+ * State shared by the worker threads of the multi-file mode.
+ */
+struct convert_job {
+	const char **filenames;
+	int count;
+	int mode;
+
+	/** Number of files that failed. */
+	int failed;
+
+	/** Index of the next file to convert. */
+	int next;
+	pthread_mutex_t lock;
+};
+
+static const char *get_suffix(int mode) {
+	switch(mode) {
+	case MODE_BINARY:
+		return ".bin";
+	case MODE_STORE:
+		return ".eph";
+	default:
+		break;
+	}
+	return ".csv";
+}
+
+static void *convert_worker(void *arg) {
+	struct convert_job *job = arg;
+	const char *suffix = get_suffix(job->mode);
+
+	for (;;) {
+		// Take the next file
+		pthread_mutex_lock(&job->lock);
+		int i = job->next;
+		if (i < job->count) {
+			job->next++;
+		}
+		pthread_mutex_unlock(&job->lock);
+
+		if (i >= job->count) {
+			// No more files
+			break;
+		}
+
+		const char *input_filename = job->filenames[i];
+		char *output_filename = malloc(
+		    strlen(input_filename) + strlen(suffix) + 1);
+
+		int ok = 0;
+		if (output_filename != NULL) {
+			strcpy(output_filename, input_filename);
+			strcat(output_filename, suffix);
+			ok = convert_file(input_filename, output_filename, job->mode);
+			free(output_filename);
+		} else {
+			fprintf(stderr, "%s: out of memory\n", input_filename);
+		}
+
+		if (!ok) {
+			pthread_mutex_lock(&job->lock);
+			job->failed++;
+			pthread_mutex_unlock(&job->lock);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Converts the files with worker threads, each file to a file
+ * of its own. Returns the number of files that failed.
+ */
+static int convert_files(
+    const char **filenames,
+    int count,
+    int mode,
+    int num_threads
+) {
+	struct convert_job job;
+	job.filenames = filenames;
+	job.count = count;
+	job.mode = mode;
+	job.failed = 0;
+	job.next = 0;
+
+	if (num_threads <= 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		num_threads = (cpus > 0) ? (int) cpus : 1;
+	}
+	if (num_threads > count) {
+		num_threads = count;
+	}
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+
+	pthread_t *threads = calloc(num_threads, sizeof(pthread_t));
+	int num_started = 0;
+
+	pthread_mutex_init(&job.lock, NULL);
+
+	// The files are handed out one at a time,
+	// which balances the load when the file sizes differ.
+	for (int t = 0; (threads != NULL) && (t < num_threads); t++) {
+		if (pthread_create(&threads[t], NULL,
+		    convert_worker, &job) != 0)
+		{
+			break;
+		}
+		num_started++;
+	}
+
+	if (num_started == 0) {
+		// Convert in this thread instead
+		convert_worker(&job);
+	}
+
+	for (int t = 0; t < num_started; t++) {
+		pthread_join(threads[t], NULL);
+	}
+
+	pthread_mutex_destroy(&job.lock);
+	free(threads);
+
+	return job.failed;
+}
+
 int main(int argc, char *argv[]) {
 	int exitcode = EXIT_FAILURE;
 
-	do {
-		run_params params;
-		params.input_filename = NULL;
-		params.output_filename = NULL;
-		params.mode = MODE_CSV;
+	run_params params;
+	params.input_filename = NULL;
+	params.output_filename = NULL;
+	params.mode = MODE_CSV;
+	params.num_jobs = -1;
+	params.input_filenames = NULL;
+	params.num_inputs = 0;
 
+	do {
 		if (argc < 2) {
 			display_usage();
 			break;
 		}
 
+		// Room for the input files of the multi-file mode
+		params.input_filenames = malloc(argc * sizeof(const char *));
+		if (params.input_filenames == NULL) {
+			fprintf(stderr, "Error: out of memory\n");
+			break;
+		}
+
 		if (!parse_args(&params, argc, argv)) {
 			break;
 		}
@@ -473,6 +695,23 @@ int main(int argc, char *argv[]) {
 		    = params.output_filename;
 		int mode = params.mode;
 
+		if (params.num_jobs >= 0) {
+			if ((input_filename != NULL) || (params.num_inputs == 0)) {
+				fprintf(stderr,
+				    "Error: with -jobs, the input files must follow it\n");
+				break;
+			}
+			int failed = convert_files(params.input_filenames,
+			    params.num_inputs, mode, params.num_jobs);
+			if (failed > 0) {
+				fprintf(stderr, "%d of %d files failed\n",
+				    failed, params.num_inputs);
+				break;
+			}
+			exitcode = EXIT_SUCCESS;
+			break;
+		}
+
 		if (input_filename == NULL) {
 			fprintf(stderr,
 			    "Error: input filename not specified\n");
@@ -484,39 +723,21 @@ int main(int argc, char *argv[]) {
 			    "Error: when binary format is specified, it is not allowed to use stdout for output\n");
 			break;
 		}
-
-		rrnx_file_nav *nav = NULL;
-		int err = rrnx_read_navfile(input_filename, &nav);
-		if (err) {
-			printf("%s: parse error (rrnx error code %d)\n",
-			    input_filename, err);
+		if ((mode == MODE_STORE) && (output_filename == NULL)) {
+			fprintf(stderr,
+			    "Error: when ephemeris store is specified, it is not allowed to use stdout for output\n");
 			break;
 		}
 
-		FILE *fp = NULL;
-
-		if (output_filename != NULL) {
-			fp = fopen(output_filename, "wb");
-			if (fp == NULL) {
-				perror("fopen");
-				break;
-			}
-		} else {
-			fp = stdout;
-		}
-
-		write_binfile(fp, nav, mode);
-
-		if (fp != stdout) {
-			fclose(fp);
+		if (!convert_file(input_filename, output_filename, mode)) {
+			break;
 		}
 
-		rrnx_free_navfile(nav);
-
 		exitcode = EXIT_SUCCESS;
 
 	} while(0);
 
+	free(params.input_filenames);
 
 	return exitcode;
 }
@@ -0,0 +1,126 @@
+//******************************{begin:header}******************************//
+//                      rrnx - The Robust RINEX Library
+//**************************************************************************//
+//
+//      Part of the GPS/INS measurement simulation system GSIM
+//      https://github.com/jani-hautamaki/gsim
+//
+//      Copyright (C) 2013-2015 Jani Hautamaki <jani.hautamaki@hotmail.com>
+//
+//      Licensed under the terms of GNU General Public License v3.
+//
+//      You should have received a copy of the GNU General Public License v3
+//      along with this program as the file LICENSE.txt; if not, please see
+//      http://www.gnu.org/licenses/gpl-3.0.html
+//
+//********************************{end:header}******************************//
+
+// Checks rrnx_fnav_dedup() with duplicates and a conflicting pair,
+// which share the key (sv_id, toe_week, toe, IODE, IODC).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h> // memset
+
+#include "rrnx/rrnx_file_nav.h"
+#include "rrnx/rrnx_error.h"
+
+static int failures = 0;
+
+static void check(int cond, const char *what) {
+	if (!cond) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+static void init_navmsg(rrnx_navmsg *navmsg, int sv_id, double tow) {
+	memset(navmsg, 0, sizeof(rrnx_navmsg));
+	navmsg->sv_id = sv_id;
+	navmsg->toe_week = 1790;
+	navmsg->toe = 302400.0;
+	navmsg->IODE = 12;
+	navmsg->IODC = 12;
+	navmsg->af0 = 1.0e-5;
+	navmsg->sqrtA = 5153.7;
+	navmsg->tow = tow;
+}
+
+static int append(rrnx_file_nav *nav, const rrnx_navmsg *navmsg) {
+	return rrnx_fnav_append(nav, navmsg) == RRNX_E_OK;
+}
+
+int main(void) {
+	rrnx_file_nav *nav = rrnx_fnav_alloc();
+	if (nav == NULL) {
+		printf("Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	rrnx_navmsg a, a_dup, b, b_dup, c;
+
+	// a_dup was received by another station; only tow differs.
+	init_navmsg(&a, 5, 300000.0);
+	init_navmsg(&a_dup, 5, 300006.0);
+
+	// b has the key of a, but a different clock bias.
+	init_navmsg(&b, 5, 300012.0);
+	b.af0 = 2.0e-5;
+	init_navmsg(&b_dup, 5, 300018.0);
+	b_dup.af0 = 2.0e-5;
+
+	init_navmsg(&c, 7, 300000.0);
+
+	int ok = append(nav, &a) && append(nav, &a_dup) && append(nav, &b)
+	    && append(nav, &c) && append(nav, &b_dup);
+	if (!ok) {
+		printf("Out of memory\n");
+		rrnx_fnav_free(nav);
+		return EXIT_FAILURE;
+	}
+
+	rrnx_fnav_dedup_stats stats;
+	int err = rrnx_fnav_dedup(nav, &stats);
+	check(err == 0, "rrnx_fnav_dedup() succeeds");
+
+	check(stats.input == 5, "5 input records");
+	check(stats.unique == 3, "3 unique records");
+	check(stats.duplicates == 2, "2 duplicates");
+	check(stats.conflicts == 1, "1 conflict");
+
+	// Expected order: a, b, c; a and b conflict.
+	const rrnx_list_item *iter = nav->navmsg_list->first;
+	const rrnx_navmsg *kept[3] = {NULL, NULL, NULL};
+	int count = 0;
+	for (; iter != NULL; iter = iter->next) {
+		if (count < 3) kept[count] = iter->data;
+		count++;
+	}
+	check(count == 3, "3 records are kept");
+
+	if (count == 3) {
+		check(kept[0]->tow == a.tow, "the first occurrence of a is kept");
+		check(kept[1]->af0 == b.af0, "b is kept");
+		check(kept[2]->sv_id == c.sv_id, "c is kept");
+
+		check(kept[0]->conflict, "a is flagged as a conflict");
+		check(kept[1]->conflict, "b is flagged as a conflict");
+		check(!kept[2]->conflict, "c is not flagged");
+	}
+
+	// The flags are recomputed, and nothing else is removed.
+	err = rrnx_fnav_dedup(nav, &stats);
+	check(err == 0, "the second rrnx_fnav_dedup() succeeds");
+	check((stats.unique == 3) && (stats.duplicates == 0)
+	    && (stats.conflicts == 1), "the second pass keeps all");
+
+	rrnx_fnav_free(nav);
+
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("All checks passed\n");
+	return EXIT_SUCCESS;
+}